@@ -24,6 +24,9 @@
 #include "chat-adapter/contactinfo.h"
 #include "common/random.h"
 #include "common/globalstrings.h"
+#include "common/tracer.h"
+#include "common/metrics.h"
+#include "common/logger.h"
 
 #include <QDateTime>
 #include <QReadWriteLock>
@@ -39,6 +42,28 @@
 namespace
 {
 
+Lvk::Cmn::Counter *g_received = Lvk::Cmn::Metrics::counter(
+        "chatbot_messages_received_total", "Messages received by the chatbot");
+
+Lvk::Cmn::Counter *g_answered = Lvk::Cmn::Metrics::counter(
+        "chatbot_messages_answered_total", "Messages answered with a matching rule");
+
+Lvk::Cmn::Counter *g_evaded = Lvk::Cmn::Metrics::counter(
+        "chatbot_messages_evaded_total", "Messages without a matching rule");
+
+Lvk::Cmn::Gauge *g_inFlight = Lvk::Cmn::Metrics::gauge(
+        "chatbot_messages_in_flight", "Messages waiting for or being processed by the engine");
+
+// Keeps the in-flight gauge up to date on every return path
+class InFlightGuard
+{
+public:
+    InFlightGuard()  { g_inFlight->inc(); }
+    ~InFlightGuard() { g_inFlight->dec(); }
+};
+
+//--------------------------------------------------------------------------------------------------
+
 QString getFromString(const Lvk::CA::ContactInfo &contact)
 {
     return contact.fullname.size() > 0
@@ -69,33 +94,38 @@ Lvk::BE::AIAdapter::~AIAdapter()
 Lvk::Cmn::Conversation::Entry Lvk::BE::AIAdapter::getEntry(const QString &input,
                                                            const CA::ContactInfo &contact)
 {
+    TRACE_SPAN("ai.getEntry");
+
+    g_received->inc();
+    InFlightGuard inFlight;
+
     QWriteLocker locker(m_rwLock);
 
     if (m_engine) {
-        qDebug() << "AIAdapter: Getting response for input" << input
-                 << "and username" << contact.username;
+        LOG_DEBUG(Chat) << "AIAdapter: Getting response for input" << input
+                        << "and username" << contact.username;
 
         quint64 ruleId = 0;
-        Nlp::Engine::MatchList matches;
-        QString response = m_engine->getResponse(input, contact.username, matches);
-        bool matched = !response.isEmpty() && matches.size() > 0;
-
+        QString response;
+        Nlp::Result result;
+        bool matched = m_engine->getBestResult(input, contact.username, result) &&
+                       !result.output.isEmpty();
 
         if (matched) {
-            qDebug() << "AIAdapter: Got response" << response;
+            LOG_DEBUG(Chat) << "AIAdapter: Got response" << result.output;
 
-            if (matches.size() > 0) {
-                ruleId = matches.first().first;
-            } else {
-                qWarning() << "AIAdapter: Got response but empty match list";
-            }
+            ruleId = result.ruleId;
+            qSwap(response, result.output);
+
+            g_answered->inc();
         } else {
+            g_evaded->inc();
+
             if (m_evasives.size() > 0) {
                 response = m_evasives[Cmn::Random::getInt(0, m_evasives.size() - 1)];
-                qDebug() << "AIAdapter: No match. Using evasive" << response;
+                LOG_DEBUG(Chat) << "AIAdapter: No match. Using evasive" << response;
             } else {
-                response.clear();
-                qDebug() << "AIAdapter: No match and no evasives found";
+                LOG_DEBUG(Chat) << "AIAdapter: No match and no evasives found";
             }
         }
 
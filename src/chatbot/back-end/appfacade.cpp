@@ -55,13 +55,6 @@
 namespace
 {
 
-inline QString idToNlpTopic(quint64 id)
-{
-    return id != 0 ? QString::number(id) : "";
-}
-
-//--------------------------------------------------------------------------------------------------
-
 inline quint64 nlpTopicToId(const QString &topic)
 {
     return !topic.isEmpty() ? topic.toULongLong() : 0;
@@ -69,29 +62,6 @@ inline quint64 nlpTopicToId(const QString &topic)
 
 //--------------------------------------------------------------------------------------------------
 
-// Make Nlp::Rule from BE::Rule
-inline Lvk::Nlp::Rule toNlpRule(const Lvk::BE::Rule *rule)
-{
-    Lvk::Nlp::Rule nlpRule(rule->id(), rule->input(), rule->output());
-
-    if (rule->parent()) {
-        nlpRule.setTopic(idToNlpTopic(rule->parent()->id()));
-    }
-
-    QStringList targets;
-    foreach (const Lvk::BE::Target &t, rule->target()) {
-        targets.append(t.username);
-    }
-
-    nlpRule.setTarget(targets);
-    nlpRule.setRandomOutput(true);
-    nlpRule.setNextTopic(idToNlpTopic(rule->nextCategory()));
-
-    return nlpRule;
-}
-
-//--------------------------------------------------------------------------------------------------
-
 inline Lvk::CA::ContactInfoList toChatbotRoster(const Lvk::BE::Roster &roster)
 {
     Lvk::CA::ContactInfoList infoList;
@@ -139,6 +109,9 @@ void Lvk::BE::AppFacade::init()
     qRegisterMetaTypeStreamOperators<BE::RosterItem>("Lvk::BEk::RosterItem");
     qRegisterMetaTypeStreamOperators<BE::Roster>("Lvk::BEk::Roster");
 
+    // Small edits are appended to the journal instead of rewriting the whole file
+    m_rules.setJournalEnabled(true);
+
     connect(Stats::StatsManager::manager(),
             SIGNAL(scoreRemainingTime(int)),
             SIGNAL(scoreRemainingTime(int)));
@@ -398,9 +371,9 @@ void Lvk::BE::AppFacade::close()
     Stats::StatsManager::manager()->stopTicking();
 
     m_rlogh.clear();
-    m_targets.clear();
     m_rules.close();
     m_evasivesRule = 0;
+    m_nlpSync.reset();
 
     Stats::StatsManager::manager()->setFilename("");
 
@@ -478,13 +451,11 @@ QString Lvk::BE::AppFacade::getResponse(const QString &input, const QString &tar
     QString response;
 
     if (m_nlpEngine) {
-        Nlp::Engine::MatchList nlpRulesMatched;
-        response = m_nlpEngine->getResponse(input, target, nlpRulesMatched);
+        Nlp::Result result;
 
-        if (!nlpRulesMatched.isEmpty()) {
-            Nlp::RuleId ruleId = nlpRulesMatched.first().first;
-            int inputNumber = nlpRulesMatched.first().second;
-            matches.append(qMakePair(ruleId, inputNumber));
+        if (m_nlpEngine->getBestResult(input, target, result)) {
+            matches.append(qMakePair(result.ruleId, result.inputIdx));
+            qSwap(response, result.output);
         } else {
             QStringList evasives = getEvasives();
             response = !evasives.isEmpty() ?
@@ -514,57 +485,22 @@ quint64 Lvk::BE::AppFacade::getCurrentCategory(const QString &target) const
 
 void Lvk::BE::AppFacade::refreshNlpEngine()
 {
-
-    m_evasivesRule = 0;
-    m_targets.clear();
-
-    if (m_nlpEngine) {
-        Nlp::RuleList nlpRules;
-        buildNlpRulesOf(m_rules.rootRule(), nlpRules);
-        m_nlpEngine->setRules(nlpRules);
-        refreshEvasives();
-    } else {
+    if (!m_nlpEngine) {
         qCritical("NLP engine not set");
-    }
-}
-
-//--------------------------------------------------------------------------------------------------
-
-void Lvk::BE::AppFacade::buildNlpRulesOf(const BE::Rule *parentRule, Nlp::RuleList &nlpRules)
-{
-    if (!parentRule) {
         return;
     }
 
-    for (int i = 0; i < parentRule->childCount(); ++i) {
-        const BE::Rule *child = parentRule->child(i);
-
-        if (!child->id()) {
-            const_cast<BE::Rule *>(child)->setId(m_rules.nextRuleId());
-        }
+    if (m_nlpSync.sync(m_rules, m_nlpEngine)) {
+        m_evasivesRule = m_nlpSync.evasivesRule();
 
-        if (child->type() == Rule::OrdinaryRule) {
-            storeTargets(child->target());
-            nlpRules.append(toNlpRule(child));
-        } else if (child->type() == Rule::EvasiveRule) {
-            m_evasivesRule = const_cast<BE::Rule *>(child);
-        } else if (child->type() == BE::Rule::ContainerRule) {
-            buildNlpRulesOf(child, nlpRules);
+        if (m_chatbot && m_nlpSync.evasivesChanged()) {
+            refreshEvasives();
         }
     }
 }
 
 //--------------------------------------------------------------------------------------------------
 
-void Lvk::BE::AppFacade::storeTargets(const TargetList &targets)
-{
-    foreach (const Target &t, targets) {
-        m_targets.insert(t.username);
-    }
-}
-
-//--------------------------------------------------------------------------------------------------
-
 void Lvk::BE::AppFacade::refreshEvasives()
 {
     dynamic_cast<AIAdapter *>(m_chatbot->AI())->setEvasives(getEvasives());
@@ -889,6 +825,29 @@ const Lvk::Cmn::Conversation & Lvk::BE::AppFacade::chatHistory()
 
 //--------------------------------------------------------------------------------------------------
 
+Lvk::Cmn::Conversation Lvk::BE::AppFacade::chatHistory(const QDate &date, const QString &user)
+{
+    return m_chatbot->chatHistory(date, user);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+Lvk::Cmn::Conversation Lvk::BE::AppFacade::chatHistory(const QDateTime &start,
+                                                       const QDateTime &end, int offset,
+                                                       int limit)
+{
+    return m_chatbot->chatHistory(start, end, offset, limit);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+Lvk::Cmn::Conversation::DateContactList Lvk::BE::AppFacade::chatHistoryContacts()
+{
+    return m_chatbot->chatHistoryContacts();
+}
+
+//--------------------------------------------------------------------------------------------------
+
 void Lvk::BE::AppFacade::clearChatHistory()
 {
     m_chatbot->clearHistory();
@@ -898,14 +857,7 @@ void Lvk::BE::AppFacade::clearChatHistory()
 
 void Lvk::BE::AppFacade::clearChatHistory(const QDate &date, const QString &user)
 {
-    Cmn::Conversation conv;
-    foreach (const Cmn::Conversation::Entry &entry, m_chatbot->chatHistory().entries()) {
-        if (entry.from != user || entry.dateTime.date() != date) {
-            conv.append(entry);
-        }
-    }
-
-    m_chatbot->setChatHistory(conv);
+    m_chatbot->clearHistory(date, user);
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -914,7 +866,7 @@ void Lvk::BE::AppFacade::clearChatHistory(const QDate &date, const QString &user
 
 Lvk::Stats::Score Lvk::BE::AppFacade::currentScore()
 {
-    // TODO improve performance, do not update all the time
+    // Rule stats are incremental, only changed rules are recounted
     Stats::StatsManager::manager()->updateScoreWith(rootRule());
 
     return Stats::StatsManager::manager()->currentScore();
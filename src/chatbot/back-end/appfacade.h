@@ -30,6 +30,7 @@
 #include <QSet>
 
 #include "back-end/chatbotrulesfile.h"
+#include "back-end/nlpsync.h"
 #include "nlp-engine/rule.h"
 #include "back-end/chattype.h"
 #include "back-end/roster.h"
@@ -208,7 +209,8 @@ public:
 
     /**
      * Refreshes the NLP engine. Invoke this method if the root rule or any other child rule has
-     * been changed.
+     * been changed. Only the rules that changed since the last refresh are sent to the engine,
+     * so if nothing changed this method is cheap.
      */
     void refreshNlpEngine();
 
@@ -348,11 +350,30 @@ public:
     void setBlackRoster(const Roster &roster);
 
     /**
-     * Returns the chat history of the current chatbot. Before calling this method you
-     * must \a load() a chatbot file.
+     * Returns the most recent entries of the chat history of the current chatbot. Before
+     * calling this method you must \a load() a chatbot file.
      */
     const Cmn::Conversation &chatHistory();
 
+    /**
+     * Returns the chat history held with \a user on \a date. If \a user is empty, returns the
+     * chat history of all users on \a date.
+     */
+    Cmn::Conversation chatHistory(const QDate &date, const QString &user = QString());
+
+    /**
+     * Returns at most \a limit chat history entries with date-time in the range
+     * [\a start, \a end) skipping the first \a offset entries. Null date-times are unbounded and
+     * a negative \a limit returns all entries.
+     */
+    Cmn::Conversation chatHistory(const QDateTime &start, const QDateTime &end, int offset = 0,
+                                  int limit = -1);
+
+    /**
+     * Returns the date and user of every conversation in the chat history of the current chatbot.
+     */
+    Cmn::Conversation::DateContactList chatHistoryContacts();
+
     /**
      * Clears the chat history of the current chatbot. All persisted data is also deleted.
      */
@@ -495,8 +516,8 @@ private:
     Nlp::Engine *m_nlpEngine;
     CA::Chatbot *m_chatbot;
     ChatType m_currentChatbotType;
-    QSet<QString> m_targets;
     unsigned m_nlpOptions;
+    NlpSync m_nlpSync;
     RlogHelper m_rlogh;
     AccountVerifier m_account;
 #ifdef DA_CONTEST
@@ -511,8 +532,6 @@ private:
     QString getExtrasPath();
     QString getStatsFilename();
     QString getHistoryFilename();
-    void buildNlpRulesOf(const Rule* parentRule, Nlp::RuleList &nlpRules);
-    void storeTargets(const TargetList &targets);
     void refreshEvasives();
     QStringList getEvasives() const;
     void setupChatbot();
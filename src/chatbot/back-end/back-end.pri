@@ -10,6 +10,7 @@ HEADERS += \
     $$PROJECT_PATH/back-end/roster.h \
     $$PROJECT_PATH/back-end/target.h \
     $$PROJECT_PATH/back-end/chatbotrulesfile.h \
+    $$PROJECT_PATH/back-end/compactrulesfile.h \
     $$PROJECT_PATH/back-end/aiadapter.h \
     $$PROJECT_PATH/back-end/rloghelper.h \
     $$PROJECT_PATH/back-end/accountverifier.h \
@@ -17,13 +18,18 @@ HEADERS += \
     $$PROJECT_PATH/back-end/chatbotfactory.h \
     $$PROJECT_PATH/back-end/chatbottempfile.h \
     $$PROJECT_PATH/back-end/filemetadata.h \
+    $$PROJECT_PATH/back-end/nlpsync.h \
+    $$PROJECT_PATH/back-end/hostedbot.h \
 
 SOURCES += \
     $$PROJECT_PATH/back-end/appfacade.cpp \
     $$PROJECT_PATH/back-end/rule.cpp \
     $$PROJECT_PATH/back-end/chatbotrulesfile.cpp \
+    $$PROJECT_PATH/back-end/compactrulesfile.cpp \
     $$PROJECT_PATH/back-end/aiadapter.cpp \
     $$PROJECT_PATH/back-end/rloghelper.cpp \
     $$PROJECT_PATH/back-end/accountverifier.cpp \
     $$PROJECT_PATH/back-end/chatbotfactory.cpp \
     $$PROJECT_PATH/back-end/chatbottempfile.cpp \
+    $$PROJECT_PATH/back-end/nlpsync.cpp \
+    $$PROJECT_PATH/back-end/hostedbot.cpp \
@@ -20,15 +20,26 @@
  */
 
 #include "back-end/chatbotrulesfile.h"
+#include "common/fileutils.h"
+#include "common/hash.h"
 
 #include <QUuid>
 #include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
 #include <QDataStream>
+#include <QSet>
 #include <QtDebug>
 #include <exception>
 
 #define CRF_MAGIC_NUMBER            (('c'<<0) | ('r'<<8) | ('f'<<16) | ('\0'<<24))
-#define CRF_FILE_FORMAT_VERSION     2
+#define CRF_FILE_FORMAT_VERSION     3
+#define CRF_COMPACT_FORMAT_VERSION  3     // First version using CompactRulesFile
+#define CRF_HEADER_SIZE             8     // Magic number and version
+
+#define CRJ_MAGIC_NUMBER            (('c'<<0) | ('r'<<8) | ('j'<<16) | ('\0'<<24))
+#define CRJ_FILE_FORMAT_VERSION     1
+#define CRJ_MIN_COMPACT_SIZE        (256*1024)  // Journals are never compacted below this size
 
 #define CEF_MAGIC_NUMBER            (('c'<<0) | ('e'<<8) | ('f'<<16) | ('\0'<<24))
 #define CEF_FILE_FORMAT_VERSION     2
@@ -57,6 +68,74 @@ inline QString newChatbotId()
     return id;
 }
 
+//--------------------------------------------------------------------------------------------------
+
+// Journal records
+enum JournalRecord
+{
+    RuleRecord = 1,     // Rule ID and attributes. Creates the rule if it does not exist.
+    ChildrenRecord,     // Rule ID and the IDs of its children in order
+    HeaderRecord        // Chatbot ID, metadata and next rule ID
+};
+
+//--------------------------------------------------------------------------------------------------
+
+QByteArray ruleRecord(const Lvk::BE::Rule *rule)
+{
+    QByteArray data;
+    QDataStream ostream(&data, QIODevice::WriteOnly);
+    ostream.setVersion(QDataStream::Qt_4_7);
+
+    ostream << static_cast<quint8>(RuleRecord) << rule->id() << rule->name()
+            << static_cast<qint32>(rule->type()) << rule->target() << rule->input()
+            << rule->output() << rule->nextCategory();
+
+    return data;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+QList<quint64> childrenIds(const Lvk::BE::Rule *rule)
+{
+    QList<quint64> ids;
+
+    foreach (const Lvk::BE::Rule *child, rule->children()) {
+        ids.append(child->id());
+    }
+
+    return ids;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool readJournalHeader(QFile &file, quint32 generation)
+{
+    QDataStream istream(&file);
+
+    quint32 magicNumber = 0;
+    quint32 version = 0;
+    quint32 journalGeneration = 0;
+
+    istream >> magicNumber >> version >> journalGeneration;
+
+    return istream.status() == QDataStream::Ok &&
+           magicNumber == CRJ_MAGIC_NUMBER &&
+           version <= CRJ_FILE_FORMAT_VERSION &&
+           journalGeneration == generation;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool isAncestor(const Lvk::BE::Rule *ancestor, const Lvk::BE::Rule *rule)
+{
+    for (; rule; rule = rule->parent()) {
+        if (rule == ancestor) {
+            return true;
+        }
+    }
+    return false;
+}
+
 } // namespace
 
 
@@ -68,7 +147,11 @@ Lvk::BE::ChatbotRulesFile::ChatbotRulesFile()
     : m_dirty(false),
       m_rootRule(new Rule()),
       m_nextRuleId(1),
-      m_chatbotId(newChatbotId())
+      m_chatbotId(newChatbotId()),
+      m_journalEnabled(false),
+      m_generation(0),
+      m_savedValid(false),
+      m_savedNextRuleId(0)
 {
 }
 
@@ -78,7 +161,11 @@ Lvk::BE::ChatbotRulesFile::ChatbotRulesFile(const QString &filename)
     : m_dirty(false),
       m_rootRule(new Rule()),
       m_nextRuleId(1),
-      m_chatbotId(nullChatbotId())
+      m_chatbotId(nullChatbotId()),
+      m_journalEnabled(false),
+      m_generation(0),
+      m_savedValid(false),
+      m_savedNextRuleId(0)
 {
     if (!load(filename)) {
         throw std::exception();
@@ -118,12 +205,26 @@ bool Lvk::BE::ChatbotRulesFile::load(const QString &filename)
 
 bool Lvk::BE::ChatbotRulesFile::save()
 {
+    // The file is about to be replaced, it cannot be mapped anymore
+    materialize();
+
     bool success = false;
 
-    QFile file(m_filename);
+    if (m_journalEnabled && m_generation != 0 && m_savedValid && QFile::exists(m_filename)) {
+        success = appendJournal();
+
+        qint64 journalSize = QFileInfo(journalFilename(m_filename)).size();
+        qint64 fileSize = QFileInfo(m_filename).size();
 
-    if (file.open(QFile::WriteOnly)) {
-        success = write(file);
+        if (success && journalSize > qMax<qint64>(CRJ_MIN_COMPACT_SIZE, fileSize)) {
+            if (!writeSnapshot()) {
+                qWarning() << "Cannot compact rules journal of file" << m_filename;
+            }
+        }
+    }
+
+    if (!success) {
+        success = writeSnapshot();
     }
 
     if (success) {
@@ -139,18 +240,21 @@ bool Lvk::BE::ChatbotRulesFile::saveAs(const QString &filename)
 {
     QString filenameBak = m_filename;
     QString chatbotIdBak = m_chatbotId;
+    quint32 generationBak = m_generation;
 
     if (m_filename.size() > 0 /*&& m_filename != filename*/) {
         m_chatbotId = newChatbotId();
     }
 
     m_filename = filename;
+    m_generation = 0;
 
     bool success = save();
 
     if (!success) {
         m_filename = filenameBak;
         m_chatbotId = chatbotIdBak;
+        m_generation = generationBak;
     }
 
     return success;
@@ -158,12 +262,41 @@ bool Lvk::BE::ChatbotRulesFile::saveAs(const QString &filename)
 
 //--------------------------------------------------------------------------------------------------
 
+void Lvk::BE::ChatbotRulesFile::setJournalEnabled(bool enabled)
+{
+    m_journalEnabled = enabled;
+
+    // If rules are already materialized, changes since the last save are unknown
+    m_savedValid = false;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool Lvk::BE::ChatbotRulesFile::journalEnabled() const
+{
+    return m_journalEnabled;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+QString Lvk::BE::ChatbotRulesFile::journalFilename(const QString &filename)
+{
+    return filename + ".journal";
+}
+
+//--------------------------------------------------------------------------------------------------
+
 bool Lvk::BE::ChatbotRulesFile::hasUnsavedChanges() const
 {
     if (m_dirty) {
         return true;
     }
 
+    // Rules not materialized cannot have changes
+    if (m_compactFile.get()) {
+        return false;
+    }
+
     for (Rule::iterator it = m_rootRule->begin(); it != m_rootRule->end(); ++it) {
         if ((*it)->status() == Rule::Unsaved) {
             return true;
@@ -179,6 +312,10 @@ void Lvk::BE::ChatbotRulesFile::setAsSaved()
 {
     m_dirty = false;
 
+    if (m_compactFile.get()) {
+        return;
+    }
+
     for (Rule::iterator it = m_rootRule->begin(); it != m_rootRule->end(); ++it) {
         (*it)->setStatus(Rule::Saved);
     }
@@ -192,9 +329,13 @@ void Lvk::BE::ChatbotRulesFile::close()
 
     m_chatbotId = newChatbotId();
     m_rootRule = std::auto_ptr<Rule>(new Rule());
+    m_compactFile.reset();
     m_filename = "";
     m_nextRuleId = 1;
     m_metadata.clear();
+    m_generation = 0;
+    m_savedValid = false;
+    m_savedRules.clear();
     setAsSaved();
 
     qDebug() << "File closed!";
@@ -232,6 +373,35 @@ bool Lvk::BE::ChatbotRulesFile::read(QFile &file)
     }
 
     m_rootRule = std::auto_ptr<Rule>(new Rule());
+    m_compactFile.reset();
+
+    if (version >= CRF_COMPACT_FORMAT_VERSION) {
+        std::auto_ptr<CompactRulesFile> compactFile(new CompactRulesFile());
+
+        if (!compactFile->open(file.fileName(), CRF_HEADER_SIZE) ||
+                !compactFile->readMetadata(m_metadata)) {
+            qCritical() << "Cannot read rules: Invalid file format in file" << file.fileName();
+            return false;
+        }
+
+        m_chatbotId = compactFile->chatbotId();
+        m_nextRuleId = compactFile->nextRuleId();
+        m_generation = compactFile->generation();
+        m_compactFile = compactFile;
+
+        if (m_generation != 0 && QFile::exists(journalFilename(file.fileName()))) {
+            materialize();
+            bool replayed = replayJournal();
+            captureSavedState();
+
+            // Do not append to a journal with a damaged tail, next save writes a new snapshot
+            m_savedValid = m_savedValid && replayed;
+        }
+
+        return true;
+    }
+
+    m_generation = 0;
 
     istream >> m_chatbotId;
     istream >> *m_rootRule;
@@ -248,7 +418,363 @@ bool Lvk::BE::ChatbotRulesFile::read(QFile &file)
 
 //--------------------------------------------------------------------------------------------------
 
-bool Lvk::BE::ChatbotRulesFile::write(QFile &file)
+void Lvk::BE::ChatbotRulesFile::materialize()
+{
+    if (!m_compactFile.get()) {
+        return;
+    }
+
+    m_rootRule = std::auto_ptr<Rule>(m_compactFile->rootRule());
+    m_compactFile.reset();
+
+    for (Rule::iterator it = m_rootRule->begin(); it != m_rootRule->end(); ++it) {
+        (*it)->setStatus(Rule::Saved);
+    }
+
+    captureSavedState();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool Lvk::BE::ChatbotRulesFile::writeSnapshot()
+{
+    QString tmpFilename = m_filename + ".tmp";
+
+    quint32 generation = m_generation + 1;
+    if (m_generation == 0) {
+        // Do not match journals left by other files with the same name
+        generation = QDateTime::currentDateTime().toTime_t() | 1;
+    }
+
+    QFile file(tmpFilename);
+
+    if (!file.open(QFile::WriteOnly)) {
+        qCritical() << "Cannot save rules: Cannot open file" << tmpFilename;
+        return false;
+    }
+
+    bool success = write(file, generation) && file.flush() && Cmn::FileUtils::syncFile(&file);
+
+    file.close();
+
+    if (!success || !Cmn::FileUtils::replaceFile(tmpFilename, m_filename)) {
+        qCritical() << "Cannot save rules in file" << m_filename;
+        QFile::remove(tmpFilename);
+        return false;
+    }
+
+    // The journal does not match the new generation anymore
+    QFile::remove(journalFilename(m_filename));
+
+    m_generation = generation;
+
+    captureSavedState();
+
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool Lvk::BE::ChatbotRulesFile::appendJournal()
+{
+    QByteArray records;
+    SavedRules savedRules;
+
+    if (!diff(records, savedRules)) {
+        return false;
+    }
+
+    if (!records.isEmpty()) {
+        QFile file(journalFilename(m_filename));
+
+        if (!file.open(QFile::ReadWrite)) {
+            qCritical() << "Cannot save rules: Cannot open journal" << file.fileName();
+            return false;
+        }
+
+        QDataStream ostream(&file);
+        ostream.setVersion(QDataStream::Qt_4_7);
+
+        // Start a new journal if there is none or it belongs to a previous generation
+        if (!readJournalHeader(file, m_generation)) {
+            file.resize(0);
+            file.seek(0);
+            ostream << (quint32)CRJ_MAGIC_NUMBER << (quint32)CRJ_FILE_FORMAT_VERSION
+                    << m_generation;
+        }
+
+        qint64 pos = file.size();
+        file.seek(pos);
+
+        ostream << static_cast<quint32>(records.size())
+                << qChecksum(records.constData(), records.size());
+
+        bool success = ostream.writeRawData(records.constData(), records.size()) == records.size()
+                && file.flush() && Cmn::FileUtils::syncFile(&file);
+
+        if (!success) {
+            qCritical() << "Cannot save rules: Cannot write journal" << file.fileName();
+            file.resize(pos);
+            return false;
+        }
+    }
+
+    m_savedRules = savedRules;
+    m_savedNextRuleId = m_nextRuleId;
+    m_savedChatbotId = m_chatbotId;
+
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool Lvk::BE::ChatbotRulesFile::diff(QByteArray &records, SavedRules &savedRules)
+{
+    QByteArray childrenRecords;
+
+    QDataStream ostream(&records, QIODevice::WriteOnly);
+    ostream.setVersion(QDataStream::Qt_4_7);
+
+    QDataStream costream(&childrenRecords, QIODevice::WriteOnly);
+    costream.setVersion(QDataStream::Qt_4_7);
+
+    if (!diffRule(m_rootRule.get(), ostream, costream, savedRules)) {
+        return false;
+    }
+
+    // Children lists go after all rules so new rules already exist when replayed
+
+    ostream.writeRawData(childrenRecords.constData(), childrenRecords.size());
+
+    if (m_dirty || m_nextRuleId != m_savedNextRuleId || m_chatbotId != m_savedChatbotId) {
+        ostream << static_cast<quint8>(HeaderRecord) << m_chatbotId << m_metadata
+                << m_nextRuleId;
+    }
+
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool Lvk::BE::ChatbotRulesFile::diffRule(const Rule *rule, QDataStream &ostream,
+                                         QDataStream &costream, SavedRules &savedRules)
+{
+    quint64 id = rule->id();
+
+    // Rules are identified by ID in the journal
+    if ((id == 0 && rule != m_rootRule.get()) || savedRules.contains(id)) {
+        return false;
+    }
+
+    SavedRules::const_iterator prev = m_savedRules.constFind(id);
+
+    // Nothing changed in the subtree since the last save
+    if (prev != m_savedRules.constEnd() && prev->subtreeRevision == rule->subtreeRevision()) {
+        return copySavedSubtree(id, savedRules);
+    }
+
+    SavedRule &saved = savedRules[id];
+    saved.revision = rule->revision();
+    saved.subtreeRevision = rule->subtreeRevision();
+    saved.children = childrenIds(rule);
+
+    // Only rules with a new revision are serialized. Their record can still be the same, for
+    // instance after the rules are materialized from the compact file.
+    if (prev != m_savedRules.constEnd() && prev->revision == saved.revision) {
+        saved.hash = prev->hash;
+    } else {
+        QByteArray record = ruleRecord(rule);
+        saved.hash = Cmn::hash64(record);
+
+        if (prev == m_savedRules.constEnd() || prev->hash != saved.hash) {
+            ostream.writeRawData(record.constData(), record.size());
+        }
+    }
+
+    if (prev == m_savedRules.constEnd() ? !saved.children.isEmpty()
+                                        : prev->children != saved.children) {
+        costream << static_cast<quint8>(ChildrenRecord) << id << saved.children;
+    }
+
+    // saved is not used below, inserting children can rehash savedRules
+    for (int i = 0; i < rule->childCount(); ++i) {
+        if (!diffRule(rule->child(i), ostream, costream, savedRules)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool Lvk::BE::ChatbotRulesFile::copySavedSubtree(quint64 id, SavedRules &savedRules)
+{
+    SavedRules::const_iterator prev = m_savedRules.constFind(id);
+
+    if (prev == m_savedRules.constEnd() || savedRules.contains(id)) {
+        return false;
+    }
+
+    savedRules.insert(id, *prev);
+
+    foreach (quint64 childId, prev->children) {
+        if (!copySavedSubtree(childId, savedRules)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool Lvk::BE::ChatbotRulesFile::replayJournal()
+{
+    QFile file(journalFilename(m_filename));
+
+    if (!file.open(QFile::ReadOnly) || !readJournalHeader(file, m_generation)) {
+        qWarning() << "Ignoring rules journal" << file.fileName();
+        return false;
+    }
+
+    qDebug() << "Replaying rules journal" << file.fileName();
+
+    Rule *root = m_rootRule.get();
+
+    QHash<quint64, Rule *> rules;
+    for (Rule::iterator it = root->begin(); it != root->end(); ++it) {
+        rules.insert((*it)->id(), *it);
+    }
+    rules.insert(0, root);
+
+    QSet<Rule *> detached;
+
+    QDataStream istream(&file);
+    istream.setVersion(QDataStream::Qt_4_7);
+
+    bool success = true;
+
+    while (!istream.atEnd() && success) {
+        quint32 size = 0;
+        quint16 checksum = 0;
+        istream >> size >> checksum;
+
+        QByteArray records = file.read(size);
+
+        // A torn write at the end of the journal is expected after a crash
+        if (istream.status() != QDataStream::Ok || records.size() != static_cast<int>(size) ||
+                qChecksum(records.constData(), records.size()) != checksum) {
+            qWarning() << "Incomplete record in rules journal" << file.fileName();
+            success = false;
+            break;
+        }
+
+        QDataStream rstream(records);
+        rstream.setVersion(QDataStream::Qt_4_7);
+
+        while (!rstream.atEnd() && success) {
+            quint8 type = 0;
+            rstream >> type;
+
+            if (type == RuleRecord) {
+                quint64 id;
+                QString name;
+                qint32 ruleType;
+                TargetList target;
+                QStringList input;
+                QStringList output;
+                quint64 nextCatId;
+
+                rstream >> id >> name >> ruleType >> target >> input >> output >> nextCatId;
+
+                Rule *rule = rules.value(id);
+                if (!rule) {
+                    rule = new Rule();
+                    rule->setId(id);
+                    rules.insert(id, rule);
+                    detached.insert(rule);
+                }
+
+                rule->setName(name);
+                rule->setType(static_cast<Rule::Type>(ruleType));
+                rule->setTarget(target);
+                rule->setInput(input);
+                rule->setOutput(output);
+                rule->setNextCategory(nextCatId);
+            } else if (type == ChildrenRecord) {
+                quint64 id;
+                QList<quint64> childrenIds;
+
+                rstream >> id >> childrenIds;
+
+                Rule *parent = rules.value(id);
+                if (!parent) {
+                    continue;
+                }
+
+                while (parent->childCount() > 0) {
+                    detached.insert(parent->takeChild(parent->childCount() - 1));
+                }
+
+                foreach (quint64 childId, childrenIds) {
+                    Rule *child = rules.value(childId);
+                    if (!child || isAncestor(child, parent)) {
+                        continue;
+                    }
+                    if (child->parent()) {
+                        child->parent()->takeChild(child->row());
+                    }
+                    parent->appendChild(child);
+                    detached.remove(child);
+                }
+            } else if (type == HeaderRecord) {
+                rstream >> m_chatbotId >> m_metadata >> m_nextRuleId;
+            } else {
+                success = false;
+            }
+
+            success = success && rstream.status() == QDataStream::Ok;
+
+            if (!success) {
+                qCritical() << "Invalid record in rules journal" << file.fileName();
+            }
+        }
+    }
+
+    // Rules that were not attached again were removed
+    QList<Rule *> removed;
+    foreach (Rule *rule, detached) {
+        if (!rule->parent()) {
+            removed.append(rule);
+        }
+    }
+    qDeleteAll(removed);
+
+    return success;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::BE::ChatbotRulesFile::captureSavedState()
+{
+    if (!m_journalEnabled || m_compactFile.get()) {
+        return;
+    }
+
+    QByteArray records;
+    SavedRules savedRules;
+
+    m_savedRules.clear();
+    m_savedValid = diff(records, savedRules);
+    m_savedRules = savedRules;
+    m_savedNextRuleId = m_nextRuleId;
+    m_savedChatbotId = m_chatbotId;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool Lvk::BE::ChatbotRulesFile::write(QFile &file, quint32 generation)
 {
     qDebug() << "Writing rules file" << file.fileName();
 
@@ -258,12 +784,9 @@ bool Lvk::BE::ChatbotRulesFile::write(QFile &file)
 
     ostream << (quint32)CRF_MAGIC_NUMBER;
     ostream << (quint32)CRF_FILE_FORMAT_VERSION;
-    ostream << m_chatbotId;
-    ostream << *m_rootRule;
-    ostream << m_metadata;
-    ostream << m_nextRuleId;
 
-    return true;
+    return CompactRulesFile::write(&file, m_chatbotId, m_rootRule.get(), m_metadata,
+                                   m_nextRuleId, generation);
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -366,6 +889,8 @@ bool Lvk::BE::ChatbotRulesFile::exportRules(const BE::Rule *container, const QSt
 
 bool Lvk::BE::ChatbotRulesFile::mergeRules(BE::Rule *container)
 {
+    materialize();
+
     Lvk::BE::Rule *evasivesRule = findEvasivesRule();
 
     foreach (Lvk::BE::Rule *rule, container->children()) {
@@ -395,6 +920,8 @@ bool Lvk::BE::ChatbotRulesFile::mergeRules(BE::Rule *container)
 
 Lvk::BE::Rule * Lvk::BE::ChatbotRulesFile::rootRule()
 {
+    materialize();
+
     return m_rootRule.get();
 }
 
@@ -23,6 +23,7 @@
 #define LVK_BE_CHATBOTRULESFILE_H
 
 #include "back-end/rule.h"
+#include "back-end/compactrulesfile.h"
 
 #include <QString>
 #include <QHash>
@@ -30,6 +31,7 @@
 #include <memory>
 
 class QFile;
+class QDataStream;
 
 namespace Lvk
 {
@@ -47,6 +49,18 @@ namespace BE
 /**
  * \brief The ChatbotRulesFile class provides methods to load, save, import and export chatbot
  *         rules files.
+ *
+ * Files are saved in the compact format provided by CompactRulesFile. Files saved by older
+ * versions with QDataStream are still loaded. Compact files are memory-mapped on load and
+ * the rule tree is materialized the first time it is needed, so reading only the metadata is
+ * cheap.
+ *
+ * If the journal is enabled with setJournalEnabled(), save() appends only the rules, children
+ * lists and metadata that changed since the last save to a journal next to the file. The
+ * journal is synced to disk on each save and it is replayed on load. When the journal grows
+ * larger than the file, it is compacted into a new file that is written to a temporary file
+ * and renamed into place. Full saves are always written that way, so a crash never leaves a
+ * partially written file.
  */
 class ChatbotRulesFile
 {
@@ -83,6 +97,22 @@ public:
      */
     bool save();
 
+    /**
+     * Enables or disables the journal. The journal is disabled by default. It should be
+     * enabled before loading or creating a file.
+     */
+    void setJournalEnabled(bool enabled);
+
+    /**
+     * Returns true if the journal is enabled. Otherwise; returns false.
+     */
+    bool journalEnabled() const;
+
+    /**
+     * Returns the name of the journal of the rules file \a filename
+     */
+    static QString journalFilename(const QString &filename);
+
     /**
      * Returns true if there are unsaved changes in the current file. Otherwise; false.
      */
@@ -159,15 +189,44 @@ private:
 
     typedef QHash<QString, QVariant> FileMetadata;
 
+    // State of a rule as of the last save. Used to find what changed.
+    struct SavedRule
+    {
+        SavedRule() : hash(0), revision(0), subtreeRevision(0) { }
+
+        quint64 hash;               // Hash of the rule record
+        quint64 revision;           // Rule::revision() when the hash was computed
+        quint64 subtreeRevision;    // Rule::subtreeRevision() when the rule was saved
+        QList<quint64> children;    // Children IDs
+    };
+
+    typedef QHash<quint64, SavedRule> SavedRules;
+
     QString m_filename;
     FileMetadata m_metadata;
     bool m_dirty;
     std::auto_ptr<Rule> m_rootRule;
+    std::auto_ptr<CompactRulesFile> m_compactFile; // Rules not materialized yet
     quint64 m_nextRuleId;
     QString m_chatbotId;
-
+    bool m_journalEnabled;
+    quint32 m_generation;       // Generation of the file on disk, 0 if it has no journal
+    bool m_savedValid;
+    SavedRules m_savedRules;
+    quint64 m_savedNextRuleId;
+    QString m_savedChatbotId;
+
+    void materialize();
     bool read(QFile &file);
-    bool write(QFile &file);
+    bool writeSnapshot();
+    bool appendJournal();
+    bool diff(QByteArray &records, SavedRules &savedRules);
+    bool diffRule(const Rule *rule, QDataStream &ostream, QDataStream &costream,
+                  SavedRules &savedRules);
+    bool copySavedSubtree(quint64 id, SavedRules &savedRules);
+    bool replayJournal();
+    void captureSavedState();
+    bool write(QFile &file, quint32 generation);
     Rule *findEvasivesRule();
     bool loadDefaultRules();
 };
@@ -58,6 +58,16 @@ QString Lvk::BE::ChatbotTempFile::getTempFileForUpload(const QString &origFilena
             throw QString("Retries exceded");
         }
 
+        // Pending changes in the journal are merged into the temp file when it is saved
+        QString origJournal = BE::ChatbotRulesFile::journalFilename(origFilename);
+        QString tmpJournal = BE::ChatbotRulesFile::journalFilename(tmpFile);
+
+        QFile::remove(tmpJournal);
+
+        if (QFile::exists(origJournal) && !QFile::copy(origJournal, tmpJournal)) {
+            throw QString("Cannot copy rules journal");
+        }
+
         BE::ChatbotRulesFile rules;
 
         if (!rules.load(tmpFile)) {
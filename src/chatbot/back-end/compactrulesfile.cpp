@@ -0,0 +1,545 @@
+/*
+ * Copyright (C) 2012 Andres Pagliano, Gabriel Miretti, Gonzalo Buteler,
+ * Nestor Bustamante, Pablo Perez de Angelis
+ *
+ * This file is part of LVK Chatbot.
+ *
+ * LVK Chatbot is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LVK Chatbot is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LVK Chatbot.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "back-end/compactrulesfile.h"
+#include "back-end/rule.h"
+
+#include <QIODevice>
+#include <QDataStream>
+#include <QVector>
+#include <QtEndian>
+#include <QtDebug>
+
+// Body layout. Offsets are relative to the beginning of the body.
+//
+// Header:
+#define CRB_STRING_COUNT        0
+#define CRB_STRINGS_OFFSET      4       // u32 offsets[count + 1] followed by UTF-16 chars
+#define CRB_RULE_COUNT          8
+#define CRB_RULES_OFFSET        12      // Rule records, depth-first order, root first
+#define CRB_INDEX_COUNT         16
+#define CRB_INDEX_OFFSET        20      // u32 string and rule indexes referenced by records
+#define CRB_METADATA_OFFSET     24      // Metadata serialized with QDataStream
+#define CRB_METADATA_SIZE       28
+#define CRB_NEXT_RULE_ID        32      // u64
+#define CRB_CHATBOT_ID          40      // String index
+#define CRB_GENERATION          44
+#define CRB_HEADER_SIZE         48
+//
+// Rule record:
+#define CRB_RULE_ID             0       // u64
+#define CRB_RULE_NEXT_CAT_ID    8       // u64
+#define CRB_RULE_NAME           16      // String index
+#define CRB_RULE_TYPE           20
+#define CRB_RULE_INPUT          24      // First index and count of input strings
+#define CRB_RULE_OUTPUT         32      // First index and count of output strings
+#define CRB_RULE_TARGET         40      // First index and count of targets. Two strings each.
+#define CRB_RULE_CHILDREN       48      // First index and count of children rules
+#define CRB_RULE_SIZE           56
+
+
+//--------------------------------------------------------------------------------------------------
+// Helpers
+//--------------------------------------------------------------------------------------------------
+
+namespace
+{
+
+inline void putU32(QByteArray &data, quint32 value)
+{
+    uchar buf[4];
+    qToLittleEndian(value, buf);
+    data.append(reinterpret_cast<const char *>(buf), sizeof(buf));
+}
+
+//--------------------------------------------------------------------------------------------------
+
+inline void putU64(QByteArray &data, quint64 value)
+{
+    uchar buf[8];
+    qToLittleEndian(value, buf);
+    data.append(reinterpret_cast<const char *>(buf), sizeof(buf));
+}
+
+//--------------------------------------------------------------------------------------------------
+
+inline void setU32(QByteArray &data, int offset, quint32 value)
+{
+    qToLittleEndian(value, reinterpret_cast<uchar *>(data.data() + offset));
+}
+
+//--------------------------------------------------------------------------------------------------
+
+// Builds the string table and the index array while writing
+class BodyBuilder
+{
+public:
+    quint32 string(const QString &s)
+    {
+        QHash<QString, quint32>::const_iterator it = m_stringIds.find(s);
+        if (it != m_stringIds.end()) {
+            return *it;
+        }
+
+        quint32 id = m_strings.size();
+        m_stringIds.insert(s, id);
+        m_strings.append(s);
+        return id;
+    }
+
+    quint32 appendStrings(const QStringList &l)
+    {
+        quint32 first = m_indexes.size();
+        foreach (const QString &s, l) {
+            m_indexes.append(string(s));
+        }
+        return first;
+    }
+
+    quint32 appendTargets(const Lvk::BE::TargetList &l)
+    {
+        quint32 first = m_indexes.size();
+        foreach (const Lvk::BE::Target &t, l) {
+            m_indexes.append(string(t.username));
+            m_indexes.append(string(t.fullname));
+        }
+        return first;
+    }
+
+    quint32 appendIndex(quint32 i)
+    {
+        m_indexes.append(i);
+        return m_indexes.size() - 1;
+    }
+
+    const QList<QString> &strings() const { return m_strings; }
+    const QVector<quint32> &indexes() const { return m_indexes; }
+
+private:
+    QHash<QString, quint32> m_stringIds;
+    QList<QString> m_strings;
+    QVector<quint32> m_indexes;
+};
+
+//--------------------------------------------------------------------------------------------------
+
+void collectRules(const Lvk::BE::Rule *rule, QList<const Lvk::BE::Rule *> &rules)
+{
+    rules.append(rule);
+    foreach (const Lvk::BE::Rule *child, rule->children()) {
+        collectRules(child, rules);
+    }
+}
+
+} // namespace
+
+
+//--------------------------------------------------------------------------------------------------
+// CompactRulesFile
+//--------------------------------------------------------------------------------------------------
+
+Lvk::BE::CompactRulesFile::CompactRulesFile()
+    : m_data(0), m_size(0), m_stringCount(0), m_stringsOffset(0), m_ruleCount(0),
+      m_rulesOffset(0), m_indexCount(0), m_indexOffset(0)
+{
+}
+
+//--------------------------------------------------------------------------------------------------
+
+Lvk::BE::CompactRulesFile::~CompactRulesFile()
+{
+    close();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool Lvk::BE::CompactRulesFile::open(const QString &filename, qint64 offset)
+{
+    close();
+
+    m_file.setFileName(filename);
+
+    if (!m_file.open(QFile::ReadOnly)) {
+        qCritical() << "CompactRulesFile: Cannot open file" << filename;
+        return false;
+    }
+
+    qint64 size = m_file.size() - offset;
+
+    if (size < CRB_HEADER_SIZE || size > 0x7fffffff) {
+        qCritical() << "CompactRulesFile: Invalid size in file" << filename;
+        close();
+        return false;
+    }
+
+    m_data = m_file.map(offset, size);
+
+    if (!m_data) {
+        qWarning() << "CompactRulesFile: Cannot map file" << filename << m_file.errorString();
+
+        m_file.seek(offset);
+        m_buffer = m_file.read(size);
+        m_data = reinterpret_cast<const uchar *>(m_buffer.constData());
+
+        if (m_buffer.size() != size) {
+            close();
+            return false;
+        }
+    }
+
+    m_size = static_cast<quint32>(size);
+
+    if (!validate()) {
+        qCritical() << "CompactRulesFile: Invalid file format in file" << filename;
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::BE::CompactRulesFile::close()
+{
+    if (m_data && m_buffer.isEmpty()) {
+        m_file.unmap(const_cast<uchar *>(m_data));
+    }
+
+    m_file.close();
+    m_buffer.clear();
+    m_data = 0;
+    m_size = 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool Lvk::BE::CompactRulesFile::isOpen() const
+{
+    return m_data != 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool Lvk::BE::CompactRulesFile::validate()
+{
+    m_stringCount   = u32(CRB_STRING_COUNT);
+    m_stringsOffset = u32(CRB_STRINGS_OFFSET);
+    m_ruleCount     = u32(CRB_RULE_COUNT);
+    m_rulesOffset   = u32(CRB_RULES_OFFSET);
+    m_indexCount    = u32(CRB_INDEX_COUNT);
+    m_indexOffset   = u32(CRB_INDEX_OFFSET);
+
+    quint64 charsOffset = m_stringsOffset + 4*(quint64(m_stringCount) + 1);
+
+    if (charsOffset > m_size ||
+            m_rulesOffset + quint64(m_ruleCount)*CRB_RULE_SIZE > m_size ||
+            m_indexOffset + quint64(m_indexCount)*4 > m_size ||
+            quint64(u32(CRB_METADATA_OFFSET)) + u32(CRB_METADATA_SIZE) > m_size ||
+            u32(CRB_CHATBOT_ID) >= m_stringCount ||
+            m_ruleCount == 0) {
+        return false;
+    }
+
+    // String offsets must be sorted and within the file
+
+    quint32 prev = 0;
+    for (quint32 i = 0; i <= m_stringCount; ++i) {
+        quint32 cur = u32(m_stringsOffset + 4*i);
+        if (cur < prev) {
+            return false;
+        }
+        prev = cur;
+    }
+
+    if (charsOffset + 2*quint64(prev) > m_size) {
+        return false;
+    }
+
+    // Rule records must reference valid strings and rules. Children must come after
+    // their parent so the tree has no cycles.
+
+    for (quint32 i = 0; i < m_ruleCount; ++i) {
+        quint32 rec = m_rulesOffset + i*CRB_RULE_SIZE;
+
+        if (u32(rec + CRB_RULE_NAME) >= m_stringCount ||
+                u32(rec + CRB_RULE_TYPE) > Rule::ContainerRule) {
+            return false;
+        }
+
+        const int lists[] = { CRB_RULE_INPUT, CRB_RULE_OUTPUT, CRB_RULE_TARGET, CRB_RULE_CHILDREN };
+
+        for (int l = 0; l < 4; ++l) {
+            quint64 first = u32(rec + lists[l]);
+            quint64 count = u32(rec + lists[l] + 4);
+
+            if (lists[l] == CRB_RULE_TARGET) {
+                count *= 2;
+            }
+            if (first + count > m_indexCount) {
+                return false;
+            }
+
+            for (quint64 j = first; j < first + count; ++j) {
+                if (lists[l] == CRB_RULE_CHILDREN) {
+                    if (index(j) <= i || index(j) >= m_ruleCount) {
+                        return false;
+                    }
+                } else if (index(j) >= m_stringCount) {
+                    return false;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+inline quint32 Lvk::BE::CompactRulesFile::u32(quint32 offset) const
+{
+    return qFromLittleEndian<quint32>(m_data + offset);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+inline quint64 Lvk::BE::CompactRulesFile::u64(quint32 offset) const
+{
+    return qFromLittleEndian<quint64>(m_data + offset);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+inline quint32 Lvk::BE::CompactRulesFile::index(quint32 i) const
+{
+    return u32(m_indexOffset + 4*i);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+QString Lvk::BE::CompactRulesFile::string(quint32 i) const
+{
+    quint32 begin = u32(m_stringsOffset + 4*i);
+    quint32 end = u32(m_stringsOffset + 4*(i + 1));
+    const uchar *chars = m_data + m_stringsOffset + 4*(m_stringCount + 1) + 2*begin;
+
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    return QString(reinterpret_cast<const QChar *>(chars), end - begin);
+#else
+    QString s(end - begin, Qt::Uninitialized);
+    for (quint32 j = 0; j < end - begin; ++j) {
+        s[j] = QChar(qFromLittleEndian<quint16>(chars + 2*j));
+    }
+    return s;
+#endif
+}
+
+//--------------------------------------------------------------------------------------------------
+
+Lvk::BE::Rule * Lvk::BE::CompactRulesFile::rule(quint32 i) const
+{
+    quint32 rec = m_rulesOffset + i*CRB_RULE_SIZE;
+
+    QStringList input;
+    quint32 first = u32(rec + CRB_RULE_INPUT);
+    for (quint32 j = first; j < first + u32(rec + CRB_RULE_INPUT + 4); ++j) {
+        input.append(string(index(j)));
+    }
+
+    QStringList output;
+    first = u32(rec + CRB_RULE_OUTPUT);
+    for (quint32 j = first; j < first + u32(rec + CRB_RULE_OUTPUT + 4); ++j) {
+        output.append(string(index(j)));
+    }
+
+    TargetList target;
+    first = u32(rec + CRB_RULE_TARGET);
+    for (quint32 j = first; j < first + 2*u32(rec + CRB_RULE_TARGET + 4); j += 2) {
+        target.append(Target(string(index(j)), string(index(j + 1))));
+    }
+
+    Rule *r = new Rule(string(u32(rec + CRB_RULE_NAME)),
+                       static_cast<Rule::Type>(u32(rec + CRB_RULE_TYPE)), input, output);
+    r->setTarget(target);
+    r->setNextCategory(u64(rec + CRB_RULE_NEXT_CAT_ID));
+    r->setId(u64(rec + CRB_RULE_ID));
+
+    first = u32(rec + CRB_RULE_CHILDREN);
+    for (quint32 j = first; j < first + u32(rec + CRB_RULE_CHILDREN + 4); ++j) {
+        r->appendChild(rule(index(j)));
+    }
+
+    return r;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+QString Lvk::BE::CompactRulesFile::chatbotId() const
+{
+    return m_data ? string(u32(CRB_CHATBOT_ID)) : QString();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+quint64 Lvk::BE::CompactRulesFile::nextRuleId() const
+{
+    return m_data ? u64(CRB_NEXT_RULE_ID) : 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+quint32 Lvk::BE::CompactRulesFile::generation() const
+{
+    return m_data ? u32(CRB_GENERATION) : 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool Lvk::BE::CompactRulesFile::readMetadata(FileMetadata &metadata) const
+{
+    if (!m_data) {
+        return false;
+    }
+
+    QByteArray data = QByteArray::fromRawData(
+                reinterpret_cast<const char *>(m_data + u32(CRB_METADATA_OFFSET)),
+                u32(CRB_METADATA_SIZE));
+
+    QDataStream istream(data);
+    istream.setVersion(QDataStream::Qt_4_7);
+    istream >> metadata;
+
+    return istream.status() == QDataStream::Ok;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+Lvk::BE::Rule * Lvk::BE::CompactRulesFile::rootRule() const
+{
+    return m_data ? rule(0) : 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool Lvk::BE::CompactRulesFile::write(QIODevice *device, const QString &chatbotId,
+                                      const Rule *root, const FileMetadata &metadata,
+                                      quint64 nextRuleId, quint32 generation)
+{
+    BodyBuilder builder;
+
+    quint32 chatbotIdIndex = builder.string(chatbotId);
+
+    // Rule records
+
+    QList<const Rule *> rules;
+    collectRules(root, rules);
+
+    QHash<const Rule *, quint32> ruleIndex;
+    for (int i = 0; i < rules.size(); ++i) {
+        ruleIndex.insert(rules[i], i);
+    }
+
+    QByteArray records;
+    records.reserve(rules.size()*CRB_RULE_SIZE);
+
+    foreach (const Rule *rule, rules) {
+        quint32 input = builder.appendStrings(rule->input());
+        quint32 output = builder.appendStrings(rule->output());
+        quint32 target = builder.appendTargets(rule->target());
+        quint32 children = builder.indexes().size();
+        foreach (const Rule *child, rule->children()) {
+            builder.appendIndex(ruleIndex.value(child));
+        }
+
+        putU64(records, rule->id());
+        putU64(records, rule->nextCategory());
+        putU32(records, builder.string(rule->name()));
+        putU32(records, rule->type());
+        putU32(records, input);
+        putU32(records, rule->input().size());
+        putU32(records, output);
+        putU32(records, rule->output().size());
+        putU32(records, target);
+        putU32(records, rule->target().size());
+        putU32(records, children);
+        putU32(records, rule->children().size());
+    }
+
+    // String table
+
+    QByteArray strings;
+    QByteArray chars;
+    quint32 charCount = 0;
+
+    putU32(strings, 0);
+    foreach (const QString &s, builder.strings()) {
+        for (int i = 0; i < s.size(); ++i) {
+            uchar buf[2];
+            qToLittleEndian<quint16>(s[i].unicode(), buf);
+            chars.append(reinterpret_cast<const char *>(buf), sizeof(buf));
+        }
+        charCount += s.size();
+        putU32(strings, charCount);
+    }
+
+    // Metadata
+
+    QByteArray meta;
+    {
+        QDataStream ostream(&meta, QIODevice::WriteOnly);
+        ostream.setVersion(QDataStream::Qt_4_7);
+        ostream << metadata;
+    }
+
+    // Header
+
+    QByteArray body(CRB_HEADER_SIZE, '\0');
+
+    quint32 stringsOffset = body.size();
+    body.append(strings);
+    body.append(chars);
+
+    quint32 rulesOffset = body.size();
+    body.append(records);
+
+    quint32 indexOffset = body.size();
+    foreach (quint32 i, builder.indexes()) {
+        putU32(body, i);
+    }
+
+    quint32 metadataOffset = body.size();
+    body.append(meta);
+
+    setU32(body, CRB_STRING_COUNT,    builder.strings().size());
+    setU32(body, CRB_STRINGS_OFFSET,  stringsOffset);
+    setU32(body, CRB_RULE_COUNT,      rules.size());
+    setU32(body, CRB_RULES_OFFSET,    rulesOffset);
+    setU32(body, CRB_INDEX_COUNT,     builder.indexes().size());
+    setU32(body, CRB_INDEX_OFFSET,    indexOffset);
+    setU32(body, CRB_METADATA_OFFSET, metadataOffset);
+    setU32(body, CRB_METADATA_SIZE,   meta.size());
+    qToLittleEndian(nextRuleId, reinterpret_cast<uchar *>(body.data() + CRB_NEXT_RULE_ID));
+    setU32(body, CRB_CHATBOT_ID,      chatbotIdIndex);
+    setU32(body, CRB_GENERATION,      generation);
+
+    return device->write(body) == body.size();
+}
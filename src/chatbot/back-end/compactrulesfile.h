@@ -0,0 +1,157 @@
+/*
+ * Copyright (C) 2012 Andres Pagliano, Gabriel Miretti, Gonzalo Buteler,
+ * Nestor Bustamante, Pablo Perez de Angelis
+ *
+ * This file is part of LVK Chatbot.
+ *
+ * LVK Chatbot is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LVK Chatbot is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LVK Chatbot.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef LVK_BE_COMPACTRULESFILE_H
+#define LVK_BE_COMPACTRULESFILE_H
+
+#include <QString>
+#include <QHash>
+#include <QVariant>
+#include <QFile>
+#include <QByteArray>
+
+class QIODevice;
+
+namespace Lvk
+{
+
+/// \addtogroup Lvk
+/// @{
+
+namespace BE
+{
+
+class Rule;
+
+/// \ingroup Lvk
+/// \addtogroup BE
+/// @{
+
+/**
+ * \brief The CompactRulesFile class provides the compact body of chatbot rules files.
+ *
+ * The body has a table of unique strings, an array of fixed-size rule records in depth-first
+ * order and an array of indexes with the inputs, outputs, targets and children of each rule.
+ * Metadata is stored in its own section. All integers are little endian.
+ *
+ * Reading memory-maps the body and validates it without allocating. Metadata, chatbot ID and
+ * next rule ID are cheap to read. The rule tree is only materialized when rootRule() is called.
+ */
+class CompactRulesFile
+{
+public:
+
+    typedef QHash<QString, QVariant> FileMetadata;
+
+    /**
+     * Constructs a closed CompactRulesFile
+     */
+    CompactRulesFile();
+
+    /**
+     * Destroys the object and unmaps the file
+     */
+    ~CompactRulesFile();
+
+    /**
+     * Maps the body of \a filename that starts at \a offset and validates it.
+     * Returns true on success. Otherwise; false.
+     */
+    bool open(const QString &filename, qint64 offset);
+
+    /**
+     * Unmaps the file
+     */
+    void close();
+
+    /**
+     * Returns true if a file is mapped. Otherwise; false.
+     */
+    bool isOpen() const;
+
+    /**
+     * Returns the chatbot ID
+     */
+    QString chatbotId() const;
+
+    /**
+     * Returns the next rule ID
+     */
+    quint64 nextRuleId() const;
+
+    /**
+     * Returns the generation of the file. The generation is a number that changes each time
+     * the file is rewritten. It is used to match the file with its journal.
+     */
+    quint32 generation() const;
+
+    /**
+     * Reads the metadata into \a metadata. Returns true on success. Otherwise; false.
+     */
+    bool readMetadata(FileMetadata &metadata) const;
+
+    /**
+     * Materializes the rule tree. The caller takes ownership of the returned rule.
+     */
+    Rule *rootRule() const;
+
+    /**
+     * Writes the body for \a chatbotId, \a root, \a metadata, \a nextRuleId and
+     * \a generation to \a device. Returns true on success. Otherwise; false.
+     */
+    static bool write(QIODevice *device, const QString &chatbotId, const Rule *root,
+                      const FileMetadata &metadata, quint64 nextRuleId,
+                      quint32 generation = 0);
+
+private:
+    CompactRulesFile(CompactRulesFile&);
+    CompactRulesFile& operator=(CompactRulesFile&);
+
+    QFile m_file;
+    QByteArray m_buffer;        // Used only if the file cannot be mapped
+    const uchar *m_data;
+    quint32 m_size;
+
+    quint32 m_stringCount;
+    quint32 m_stringsOffset;
+    quint32 m_ruleCount;
+    quint32 m_rulesOffset;
+    quint32 m_indexCount;
+    quint32 m_indexOffset;
+
+    bool validate();
+    quint32 u32(quint32 offset) const;
+    quint64 u64(quint32 offset) const;
+    quint32 index(quint32 i) const;
+    QString string(quint32 i) const;
+    Rule *rule(quint32 i) const;
+};
+
+/// @}
+
+} // namespace BE
+
+/// @}
+
+} // namespace Lvk
+
+
+#endif // LVK_BE_COMPACTRULESFILE_H
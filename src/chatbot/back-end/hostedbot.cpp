@@ -0,0 +1,388 @@
+/*
+ * Copyright (C) 2012 Andres Pagliano, Gabriel Miretti, Gonzalo Buteler,
+ * Nestor Bustamante, Pablo Perez de Angelis
+ *
+ * This file is part of LVK Chatbot.
+ *
+ * LVK Chatbot is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LVK Chatbot is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LVK Chatbot.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "back-end/hostedbot.h"
+#include "back-end/appfacade.h"
+#include "back-end/aiadapter.h"
+#include "back-end/chatbotfactory.h"
+#include "back-end/filemetadata.h"
+#include "back-end/roster.h"
+#include "back-end/rule.h"
+#include "nlp-engine/engine.h"
+#include "nlp-engine/enginefactory.h"
+#include "nlp-engine/lemmatizerfactory.h"
+#include "nlp-engine/sanitizerfactory.h"
+#include "nlp-engine/nlpproperties.h"
+#include "chat-adapter/chatbot.h"
+#include "common/globalstrings.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QTimer>
+#include <QtDebug>
+
+#define RECONNECT_INTERVAL      30*1000
+
+//--------------------------------------------------------------------------------------------------
+// Helpers
+//--------------------------------------------------------------------------------------------------
+
+namespace
+{
+
+inline QString fileInfoStamp(const QFileInfo &info)
+{
+    return info.exists() ? QString::number(info.size()) + "@"
+                           + QString::number(info.lastModified().toTime_t())
+                         : QString("-");
+}
+
+//--------------------------------------------------------------------------------------------------
+
+inline Lvk::CA::ContactInfoList toChatbotRoster(const Lvk::BE::Roster &roster)
+{
+    Lvk::CA::ContactInfoList infoList;
+    foreach (const Lvk::BE::RosterItem &item, roster) {
+        infoList.append(Lvk::CA::ContactInfo(item.username, item.username));
+    }
+    return infoList;
+}
+
+} // namespace
+
+
+//--------------------------------------------------------------------------------------------------
+// HostedBot
+//--------------------------------------------------------------------------------------------------
+
+Lvk::BE::HostedBot::HostedBot(const QString &name, QObject *parent)
+    : QObject(parent),
+      m_name(name),
+      m_rules(new ChatbotRulesFile()),
+      m_engine(Nlp::EngineFactory().createEngine()),
+      m_nlpOptions(0),
+      m_chatbot(0),
+      m_ai(0),
+      m_chatType(FbChat),
+      m_autoReconnect(false),
+      m_reconnectTimer(new QTimer(this))
+{
+    m_reconnectTimer->setSingleShot(true);
+    m_reconnectTimer->setInterval(RECONNECT_INTERVAL);
+
+    connect(m_reconnectTimer, SIGNAL(timeout()), SLOT(onReconnectTimeout()));
+}
+
+//--------------------------------------------------------------------------------------------------
+
+Lvk::BE::HostedBot::~HostedBot()
+{
+    m_autoReconnect = false;
+
+    deleteChatbot();
+
+    delete m_engine;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+const QString & Lvk::BE::HostedBot::name() const
+{
+    return m_name;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool Lvk::BE::HostedBot::load(const QString &filename)
+{
+    // Load into a new object so the current rules are kept if the file cannot be loaded
+    std::auto_ptr<ChatbotRulesFile> rules(new ChatbotRulesFile());
+
+    if (!rules->load(filename)) {
+        qCritical() << "HostedBot:" << m_name << "Cannot load rules file" << filename;
+        return false;
+    }
+
+    QString prevChatbotId = m_rules->chatbotId();
+
+    // Rules of the current file are about to be deleted, forget them before
+    m_nlpSync.reset();
+    m_rules = rules;
+
+    m_filename = filename;
+    m_stamp = fileStamp();
+
+    setupNlpEngine();
+
+    // The sync was reset, so the new rules replace the old ones in a single setRules(). Clearing
+    // the engine first would leave workers answering without rules in between.
+    refreshNlpEngine();
+
+    if (m_chatbot) {
+        if (m_rules->chatbotId() != prevChatbotId) {
+            // Chatbot IDs are bound to history files and AI adapters, start over
+            qWarning() << "HostedBot:" << m_name << "Chatbot ID changed, reconnecting...";
+            deleteChatbot();
+            setupChatbot();
+        } else {
+            m_chatbot->setBlackListRoster(toChatbotRoster(
+                    m_rules->metadata(FILE_METADATA_BLACK_ROSTER).value<BE::Roster>()));
+            refreshEvasives();
+        }
+    }
+
+    qDebug() << "HostedBot:" << m_name << "Loaded rules file" << filename;
+
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool Lvk::BE::HostedBot::reload()
+{
+    return load(m_filename);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+QString Lvk::BE::HostedBot::filename() const
+{
+    return m_filename;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool Lvk::BE::HostedBot::isOutdated() const
+{
+    return !m_filename.isEmpty() && fileStamp() != m_stamp;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+QString Lvk::BE::HostedBot::fileStamp() const
+{
+    // Saves replace the rules file or append to its journal, either way size or time changes
+    return fileInfoStamp(QFileInfo(m_filename)) + " "
+            + fileInfoStamp(QFileInfo(ChatbotRulesFile::journalFilename(m_filename)));
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::BE::HostedBot::setupNlpEngine()
+{
+    unsigned options = m_rules->metadata(FILE_METADATA_NLP_OPTIONS).toUInt();
+    unsigned changed = options ^ m_nlpOptions;
+
+    // Only the tools whose option changed are replaced
+    if (changed & AppFacade::RemoveDupChars) {
+        m_engine->setPreSanitizer((options & AppFacade::RemoveDupChars) ?
+                                      Nlp::SanitizerFactory().createPreSanitizer() : 0);
+    }
+    if (changed & AppFacade::LemmatizeSentence) {
+        m_engine->setLemmatizer((options & AppFacade::LemmatizeSentence) ?
+                                    Nlp::LemmatizerFactory().createLemmatizer() : 0);
+    }
+    if (changed & AppFacade::SanitizePostLemma) {
+        m_engine->setPostSanitizer((options & AppFacade::SanitizePostLemma) ?
+                                       Nlp::SanitizerFactory().createPostSanitizer() : 0);
+    }
+
+    m_engine->setProperty(NLP_PROP_EXACT_MATCH, (options & AppFacade::ExactMatchSupport) != 0);
+    m_engine->setProperty(NLP_PROP_PREFER_CUR_TOPIC,
+                          (options & AppFacade::PreferCurCategory) != 0);
+
+    m_nlpOptions = options;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::BE::HostedBot::refreshNlpEngine()
+{
+    if (m_nlpSync.sync(*m_rules, m_engine) && m_nlpSync.evasivesChanged()) {
+        refreshEvasives();
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::BE::HostedBot::refreshEvasives()
+{
+    if (m_ai) {
+        Rule *evasivesRule = m_nlpSync.evasivesRule();
+        m_ai->setEvasives(evasivesRule ? evasivesRule->output() : QStringList());
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+Lvk::BE::ChatType Lvk::BE::HostedBot::chatType() const
+{
+    return static_cast<BE::ChatType>(m_rules->metadata(FILE_METADATA_CHAT_TYPE).toInt());
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::BE::HostedBot::connectToChat(BE::ChatType type, const QString &user,
+                                       const QString &passwd)
+{
+    if (type != FbChat && type != GTalkChat) {
+        qWarning() << "HostedBot:" << m_name << "Invalid chat type, defaulting to FbChat!";
+        type = FbChat;
+    }
+
+    if (m_chatbot && m_chatType != type) {
+        deleteChatbot();
+    }
+
+    m_chatType = type;
+    m_user = !user.isEmpty() ? user : m_rules->metadata(FILE_METADATA_CHAT_USERNAME).toString();
+    m_passwd = passwd;
+    m_autoReconnect = true;
+
+    setupChatbot();
+
+    qDebug() << "HostedBot:" << m_name << "Connecting as" << m_user;
+
+    m_chatbot->connectToServer(m_user, m_passwd);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::BE::HostedBot::disconnectFromChat()
+{
+    m_autoReconnect = false;
+    m_reconnectTimer->stop();
+
+    if (m_chatbot) {
+        m_chatbot->disconnectFromServer();
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool Lvk::BE::HostedBot::isConnected() const
+{
+    return m_chatbot && m_chatbot->isConnected();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+Lvk::Nlp::Engine * Lvk::BE::HostedBot::nlpEngine()
+{
+    return m_engine;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::BE::HostedBot::setupChatbot()
+{
+    if (m_chatbot) {
+        return;
+    }
+
+    m_ai = new AIAdapter(m_rules->chatbotId(), m_engine);
+
+    m_chatbot = BE::ChatbotFactory().createChatbot(m_rules->chatbotId(), m_chatType);
+    m_chatbot->setAI(m_ai); // Chatbot owns the adapter
+    m_chatbot->setBlackListRoster(toChatbotRoster(
+            m_rules->metadata(FILE_METADATA_BLACK_ROSTER).value<BE::Roster>()));
+    m_chatbot->setHistoryFilename(historyFilename());
+
+    refreshEvasives();
+
+    connect(m_chatbot, SIGNAL(error(int)),     SLOT(onConnectionError(int)));
+    connect(m_chatbot, SIGNAL(connected()),    SLOT(onConnected()));
+    connect(m_chatbot, SIGNAL(disconnected()), SLOT(onDisconnected()));
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::BE::HostedBot::deleteChatbot()
+{
+    if (m_chatbot && m_chatbot->isConnected()) {
+        m_chatbot->disconnectFromServer();
+    }
+
+    delete m_chatbot;
+    m_chatbot = 0;
+    m_ai = 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+QString Lvk::BE::HostedBot::historyFilename() const
+{
+    QFileInfo info(m_filename);
+    QString extrasPath = info.canonicalPath() + QDir::separator() + info.baseName()
+            + EXTRAS_DIR_SUFFIX;
+
+    QDir().mkpath(extrasPath);
+
+    return extrasPath + QDir::separator() + m_rules->chatbotId() + ".hist";
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::BE::HostedBot::onConnected()
+{
+    qDebug() << "HostedBot:" << m_name << "Connected";
+
+    m_reconnectTimer->stop();
+
+    emit connected();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::BE::HostedBot::onDisconnected()
+{
+    qWarning() << "HostedBot:" << m_name << "Disconnected";
+
+    if (m_autoReconnect) {
+        m_reconnectTimer->start();
+    }
+
+    emit disconnected();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::BE::HostedBot::onConnectionError(int err)
+{
+    qWarning() << "HostedBot:" << m_name << "Connection error" << err;
+
+    if (m_autoReconnect) {
+        m_reconnectTimer->start();
+    }
+
+    emit connectionError(err);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::BE::HostedBot::onReconnectTimeout()
+{
+    if (m_autoReconnect && m_chatbot && !m_chatbot->isConnected()) {
+        qDebug() << "HostedBot:" << m_name << "Reconnecting...";
+        m_chatbot->connectToServer(m_user, m_passwd);
+    }
+}
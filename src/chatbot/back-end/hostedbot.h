@@ -0,0 +1,202 @@
+/*
+ * Copyright (C) 2012 Andres Pagliano, Gabriel Miretti, Gonzalo Buteler,
+ * Nestor Bustamante, Pablo Perez de Angelis
+ *
+ * This file is part of LVK Chatbot.
+ *
+ * LVK Chatbot is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LVK Chatbot is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LVK Chatbot.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef LVK_BE_HOSTEDBOT_H
+#define LVK_BE_HOSTEDBOT_H
+
+#include <QObject>
+#include <QString>
+#include <memory>
+
+#include "back-end/chatbotrulesfile.h"
+#include "back-end/chattype.h"
+#include "back-end/nlpsync.h"
+
+class QTimer;
+
+namespace Lvk
+{
+
+/// \addtogroup Lvk
+/// @{
+
+namespace Nlp
+{
+    class Engine;
+}
+
+namespace CA
+{
+    class Chatbot;
+}
+
+namespace BE
+{
+
+/// \ingroup Lvk
+/// \addtogroup BE
+/// @{
+
+class AIAdapter;
+
+/**
+ * \brief The HostedBot class provides a chatbot that runs without user interface.
+ *
+ * A HostedBot owns a rules file, a NLP engine and a chat connection. Unlike AppFacade, many
+ * HostedBot objects can live in the same process. The engine is set up with the NLP options of
+ * the rules file. Statistics are not tracked.
+ *
+ * If the connection is lost or fails, the bot tries to reconnect every 30 seconds until
+ * disconnectFromChat() is called.
+ *
+ * \see BotHost
+ */
+class HostedBot : public QObject
+{
+    Q_OBJECT
+
+public:
+
+    /**
+     * Constructs a HostedBot with name \a name and parent object \a parent. The name is only
+     * used in log messages.
+     */
+    explicit HostedBot(const QString &name, QObject *parent = 0);
+
+    /**
+     * Destroys the object. If the bot is connected, the connection is closed.
+     */
+    ~HostedBot();
+
+    /**
+     * Returns the name of the bot
+     */
+    const QString &name() const;
+
+    /**
+     * Loads the rules file \a filename. Returns true on success. Otherwise; returns false.
+     * If the bot is connected, it starts answering with the new rules right away. On failure
+     * the bot keeps its current rules.
+     */
+    bool load(const QString &filename);
+
+    /**
+     * Loads again the current rules file. Returns true on success. Otherwise; returns false.
+     */
+    bool reload();
+
+    /**
+     * Returns the filename of the current rules file
+     */
+    QString filename() const;
+
+    /**
+     * Returns true if the rules file or its journal were modified since they were loaded.
+     * Otherwise; returns false.
+     */
+    bool isOutdated() const;
+
+    /**
+     * Returns the chat type stored in the rules file
+     */
+    BE::ChatType chatType() const;
+
+    /**
+     * Connects the bot to the chat server of type \a type with username \a user and password
+     * \a passwd. If \a user is empty, the chat username stored in the rules file is used.
+     */
+    void connectToChat(BE::ChatType type, const QString &user, const QString &passwd);
+
+    /**
+     * Disconnects the bot from the chat server
+     */
+    void disconnectFromChat();
+
+    /**
+     * Returns true if the bot is connected. Otherwise; returns false.
+     */
+    bool isConnected() const;
+
+    /**
+     * Returns the NLP engine of the bot
+     */
+    Nlp::Engine *nlpEngine();
+
+signals:
+
+    /**
+     * This signal is emitted when the bot is connected to the chat server
+     */
+    void connected();
+
+    /**
+     * This signal is emitted when the bot is disconnected from the chat server
+     */
+    void disconnected();
+
+    /**
+     * This signal is emitted if there was an error while connecting to the chat server
+     */
+    void connectionError(int err);
+
+private slots:
+    void onConnected();
+    void onDisconnected();
+    void onConnectionError(int err);
+    void onReconnectTimeout();
+
+private:
+    HostedBot(HostedBot&);
+    HostedBot& operator=(HostedBot&);
+
+    QString m_name;
+    std::auto_ptr<ChatbotRulesFile> m_rules;
+    QString m_filename;
+    QString m_stamp;
+    Nlp::Engine *m_engine;
+    unsigned m_nlpOptions;
+    NlpSync m_nlpSync;
+    CA::Chatbot *m_chatbot;
+    AIAdapter *m_ai;
+    BE::ChatType m_chatType;
+    QString m_user;
+    QString m_passwd;
+    bool m_autoReconnect;
+    QTimer *m_reconnectTimer;
+
+    QString fileStamp() const;
+    void setupNlpEngine();
+    void refreshNlpEngine();
+    void refreshEvasives();
+    void setupChatbot();
+    void deleteChatbot();
+    QString historyFilename() const;
+};
+
+/// @}
+
+} // namespace BE
+
+/// @}
+
+} // namespace Lvk
+
+#endif // LVK_BE_HOSTEDBOT_H
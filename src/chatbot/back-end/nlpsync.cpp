@@ -0,0 +1,198 @@
+/*
+ * Copyright (C) 2012 Andres Pagliano, Gabriel Miretti, Gonzalo Buteler,
+ * Nestor Bustamante, Pablo Perez de Angelis
+ *
+ * This file is part of LVK Chatbot.
+ *
+ * LVK Chatbot is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LVK Chatbot is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LVK Chatbot.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "back-end/nlpsync.h"
+#include "back-end/rule.h"
+#include "back-end/chatbotrulesfile.h"
+#include "nlp-engine/engine.h"
+
+#include <QStringList>
+
+//--------------------------------------------------------------------------------------------------
+// Helpers
+//--------------------------------------------------------------------------------------------------
+
+namespace
+{
+
+inline QString idToNlpTopic(quint64 id)
+{
+    return id != 0 ? QString::number(id) : "";
+}
+
+//--------------------------------------------------------------------------------------------------
+
+// Make Nlp::Rule from BE::Rule
+inline Lvk::Nlp::Rule toNlpRule(const Lvk::BE::Rule *rule)
+{
+    Lvk::Nlp::Rule nlpRule(rule->id(), rule->input(), rule->output());
+
+    if (rule->parent()) {
+        nlpRule.setTopic(idToNlpTopic(rule->parent()->id()));
+    }
+
+    QStringList targets;
+    foreach (const Lvk::BE::Target &t, rule->target()) {
+        targets.append(t.username);
+    }
+
+    nlpRule.setTarget(targets);
+    nlpRule.setRandomOutput(true);
+    nlpRule.setNextTopic(idToNlpTopic(rule->nextCategory()));
+
+    return nlpRule;
+}
+
+} // namespace
+
+//--------------------------------------------------------------------------------------------------
+// NlpSync
+//--------------------------------------------------------------------------------------------------
+
+Lvk::BE::NlpSync::NlpSync()
+    : m_revision(0), m_full(true), m_evasivesRule(0), m_evasivesRevision(0),
+      m_evasivesChanged(false)
+{
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool Lvk::BE::NlpSync::sync(ChatbotRulesFile &rules, Nlp::Engine *engine)
+{
+    const Rule *root = rules.rootRule();
+
+    m_evasivesChanged = false;
+
+    // Revisions change on every edit, if the tree revision did not change there is nothing to do
+    if (!m_full && root->subtreeRevision() == m_revision) {
+        return false;
+    }
+
+    QList<const Rule *> ordinary;
+
+    m_evasivesRule = 0;
+    collect(rules, root, ordinary);
+
+    RevisionMap revisions;
+    PositionMap positions;
+    Nlp::RuleList changed;
+    QList<int> changedPositions;
+
+    // A rule is sent again if it is new, if its revision changed or if it is out of order with
+    // respect to the rules kept in the engine. Kept rules must preserve their old relative order.
+    int lastKept = -1;
+
+    for (int i = 0; i < ordinary.size(); ++i) {
+        const Rule *rule = ordinary[i];
+
+        revisions.insert(rule->id(), rule->revision());
+        positions.insert(rule->id(), i);
+
+        RevisionMap::const_iterator it = m_revisions.find(rule->id());
+        int oldPos = m_positions.value(rule->id(), -1);
+
+        if (it == m_revisions.constEnd() || *it != rule->revision() || oldPos < lastKept) {
+            changed.append(toNlpRule(rule));
+            changedPositions.append(i);
+        } else {
+            lastKept = oldPos;
+        }
+    }
+
+    if (m_full) {
+        // A single call, so the engine never runs without rules
+        engine->setRules(changed);
+    } else {
+        QList<Nlp::RuleId> removed;
+        for (RevisionMap::const_iterator it = m_revisions.constBegin();
+             it != m_revisions.constEnd(); ++it) {
+            if (!revisions.contains(it.key())) {
+                removed.append(it.key());
+            }
+        }
+
+        if (!changed.isEmpty() || !removed.isEmpty()) {
+            engine->updateRules(changed, changedPositions, removed);
+        }
+    }
+
+    m_revisions = revisions;
+    m_positions = positions;
+    m_revision = root->subtreeRevision();
+    m_full = false;
+
+    quint64 evasivesRevision = m_evasivesRule ? m_evasivesRule->revision() : 0;
+
+    m_evasivesChanged = evasivesRevision != m_evasivesRevision;
+    m_evasivesRevision = evasivesRevision;
+
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::BE::NlpSync::collect(ChatbotRulesFile &rules, const Rule *parentRule,
+                               QList<const Rule *> &ordinary)
+{
+    for (int i = 0; i < parentRule->childCount(); ++i) {
+        const Rule *child = parentRule->child(i);
+
+        if (!child->id()) {
+            const_cast<Rule *>(child)->setId(rules.nextRuleId());
+        }
+
+        if (child->type() == Rule::OrdinaryRule) {
+            ordinary.append(child);
+        } else if (child->type() == Rule::EvasiveRule) {
+            m_evasivesRule = const_cast<Rule *>(child);
+        } else if (child->type() == Rule::ContainerRule) {
+            collect(rules, child, ordinary);
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+Lvk::BE::Rule * Lvk::BE::NlpSync::evasivesRule() const
+{
+    return m_evasivesRule;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool Lvk::BE::NlpSync::evasivesChanged() const
+{
+    return m_evasivesChanged;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::BE::NlpSync::reset()
+{
+    m_revisions.clear();
+    m_positions.clear();
+    m_revision = 0;
+    m_full = true;
+    m_evasivesRule = 0;
+    m_evasivesRevision = 0;
+    m_evasivesChanged = false;
+}
+
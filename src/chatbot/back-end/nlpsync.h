@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2012 Andres Pagliano, Gabriel Miretti, Gonzalo Buteler,
+ * Nestor Bustamante, Pablo Perez de Angelis
+ *
+ * This file is part of LVK Chatbot.
+ *
+ * LVK Chatbot is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LVK Chatbot is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LVK Chatbot.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef LVK_BE_NLPSYNC_H
+#define LVK_BE_NLPSYNC_H
+
+#include "nlp-engine/rule.h"
+
+#include <QHash>
+
+namespace Lvk
+{
+
+/// \addtogroup Lvk
+/// @{
+
+namespace Nlp
+{
+    class Engine;
+}
+
+namespace BE
+{
+
+/// \ingroup Lvk
+/// \addtogroup BE
+/// @{
+
+class Rule;
+class ChatbotRulesFile;
+
+/**
+ * \brief The NlpSync class keeps the rules of a NLP engine in sync with a rules file.
+ *
+ * The first sync() sets all rules in the engine. Following calls compare the rule revisions
+ * with the ones sent before and only add, update or remove the rules that changed. Rules that
+ * did not change but were moved relative to other rules are sent again, so the engine ends up
+ * with the same rules in the same order as with a full setRules(). If the rule tree did not
+ * change, sync() does nothing.
+ *
+ * \see Rule::revision(), Nlp::Engine::updateRules()
+ */
+class NlpSync
+{
+public:
+
+    /**
+     * Constructs a NlpSync object that has not synced any rule yet.
+     */
+    NlpSync();
+
+    /**
+     * Sends to \a engine the rules of \a rules that changed since the last call. Rules without
+     * ID get a new one from \a rules. Returns true if there were changes. Otherwise; returns
+     * false.
+     */
+    bool sync(ChatbotRulesFile &rules, Nlp::Engine *engine);
+
+    /**
+     * Returns the evasives rule found in the last sync, or 0 if there is none.
+     */
+    Rule *evasivesRule() const;
+
+    /**
+     * Returns true if the evasives rule was added, changed or removed in the last sync.
+     * Otherwise; returns false.
+     */
+    bool evasivesChanged() const;
+
+    /**
+     * Forgets the rules synced so far. The next sync() sets all rules in the engine, replacing
+     * the ones it had, even if the rules file has no rules.
+     */
+    void reset();
+
+private:
+    NlpSync(NlpSync&);
+    NlpSync& operator=(NlpSync&);
+
+    typedef QHash<quint64, quint64> RevisionMap;
+    typedef QHash<quint64, int> PositionMap;
+
+    RevisionMap m_revisions;        // Revision of each rule in the engine
+    PositionMap m_positions;        // Position of each rule in the engine
+    quint64 m_revision;             // Revision of the rule tree in the engine
+    bool m_full;                    // The next sync sets all rules
+    Rule *m_evasivesRule;
+    quint64 m_evasivesRevision;
+    bool m_evasivesChanged;
+
+    void collect(ChatbotRulesFile &rules, const Rule *parentRule, QList<const Rule *> &ordinary);
+};
+
+/// @}
+
+} // namespace BE
+
+/// @}
+
+} // namespace Lvk
+
+#endif // LVK_BE_NLPSYNC_H
@@ -23,14 +23,37 @@
 
 #include <QtAlgorithms>
 #include <QIcon>
+#include <QMutex>
+#include <QMutexLocker>
 #include <assert.h>
 
 #define LVK_BE_RULE_VERSION     4
 
+//--------------------------------------------------------------------------------------------------
+// Helpers
+//--------------------------------------------------------------------------------------------------
+
+namespace
+{
+
+QMutex g_revisionMutex;
+quint64 g_lastRevision = 0;
+
+// Revisions are unique among all rules, so rules moved between trees are still detected
+inline quint64 nextRevision()
+{
+    QMutexLocker locker(&g_revisionMutex);
+
+    return ++g_lastRevision;
+}
+
+} // namespace
+
 
 Lvk::BE::Rule::Rule()
     : m_name(""), m_input(), m_output(), m_parentItem(0), m_type(OrdinaryRule),
-      m_enabled(false), m_status(Unsaved), m_checkState(Qt::Unchecked), m_id(0), m_nextCatId(0)
+      m_enabled(false), m_status(Unsaved), m_checkState(Qt::Unchecked), m_id(0), m_nextCatId(0),
+      m_row(0), m_idIndex(0), m_revision(0), m_subtreeRevision(0)
 {
 }
 
@@ -38,7 +61,8 @@ Lvk::BE::Rule::Rule()
 
 Lvk::BE::Rule::Rule(const QString &name)
     : m_name(name), m_input(), m_output(), m_parentItem(0), m_type(OrdinaryRule),
-      m_enabled(false), m_status(Unsaved), m_checkState(Qt::Unchecked), m_id(0), m_nextCatId(0)
+      m_enabled(false), m_status(Unsaved), m_checkState(Qt::Unchecked), m_id(0), m_nextCatId(0),
+      m_row(0), m_idIndex(0), m_revision(0), m_subtreeRevision(0)
 {
 }
 
@@ -46,7 +70,8 @@ Lvk::BE::Rule::Rule(const QString &name)
 
 Lvk::BE::Rule::Rule(const QString &name, Type type)
     : m_name(name), m_input(), m_output(), m_parentItem(0), m_type(type),
-      m_enabled(false), m_status(Unsaved), m_checkState(Qt::Unchecked), m_id(0), m_nextCatId(0)
+      m_enabled(false), m_status(Unsaved), m_checkState(Qt::Unchecked), m_id(0), m_nextCatId(0),
+      m_row(0), m_idIndex(0), m_revision(0), m_subtreeRevision(0)
 {
 }
 
@@ -54,7 +79,8 @@ Lvk::BE::Rule::Rule(const QString &name, Type type)
 
 Lvk::BE::Rule::Rule(const QString &name, const QStringList &input, const QStringList &ouput)
     : m_name(name), m_input(input), m_output(ouput), m_parentItem(0), m_type(OrdinaryRule),
-      m_enabled(false), m_status(Unsaved), m_checkState(Qt::Unchecked), m_id(0), m_nextCatId(0)
+      m_enabled(false), m_status(Unsaved), m_checkState(Qt::Unchecked), m_id(0), m_nextCatId(0),
+      m_row(0), m_idIndex(0), m_revision(0), m_subtreeRevision(0)
 {
 }
 
@@ -63,7 +89,8 @@ Lvk::BE::Rule::Rule(const QString &name, const QStringList &input, const QString
 Lvk::BE::Rule::Rule(const QString &name, Type type, const QStringList &input,
                     const QStringList &ouput)
     : m_name(name), m_input(input), m_output(ouput), m_parentItem(0), m_type(type),
-      m_enabled(false), m_status(Unsaved), m_checkState(Qt::Unchecked), m_id(0), m_nextCatId(0)
+      m_enabled(false), m_status(Unsaved), m_checkState(Qt::Unchecked), m_id(0), m_nextCatId(0),
+      m_row(0), m_idIndex(0), m_revision(0), m_subtreeRevision(0)
 {
 }
 
@@ -72,7 +99,8 @@ Lvk::BE::Rule::Rule(const QString &name, Type type, const QStringList &input,
 Lvk::BE::Rule::Rule(const Rule &other, bool deepCopy /*= false*/)
     : m_name(other.m_name), m_input(other.m_input), m_output(other.m_output),
       m_target(other.m_target), m_parentItem(0), m_type(other.m_type), m_enabled(other.m_enabled),
-      m_status(Unsaved), m_checkState(Qt::Unchecked), m_id(0), m_nextCatId(0)
+      m_status(Unsaved), m_checkState(Qt::Unchecked), m_id(0), m_nextCatId(0),
+      m_row(0), m_idIndex(0), m_revision(0), m_subtreeRevision(0)
 {
     if (deepCopy) {
         foreach (const Rule *rule, other.m_childItems) {
@@ -86,6 +114,7 @@ Lvk::BE::Rule::Rule(const Rule &other, bool deepCopy /*= false*/)
 Lvk::BE::Rule::~Rule()
 {
     qDeleteAll(m_childItems);
+    delete m_idIndex;
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -162,11 +191,19 @@ bool Lvk::BE::Rule::appendChild(Rule *item)
     //assert(item->m_parentItem == 0 || item->m_parentItem == this);
     assert(!m_childItems.contains(item));
 
+    // If item was a root, its index is no longer needed
+    delete item->m_idIndex;
+    item->m_idIndex = 0;
+
     item->m_parentItem = this;
+    item->m_row = m_childItems.size();
 
     m_childItems.append(item);
 
+    indexSubtree(item);
+
     m_status = Unsaved;
+    item->touch();
 
     return true;
 }
@@ -183,8 +220,11 @@ bool Lvk::BE::Rule::insertChildren(int position, int count)
         Rule *rule = new Rule();
         rule->m_parentItem = this;
         m_childItems.insert(position, rule);
+        rule->touch();
     }
 
+    updateRows(position);
+
     m_status = Unsaved;
 
     return true;
@@ -199,16 +239,41 @@ bool Lvk::BE::Rule::removeChildren(int position, int count)
     }
 
     for (int i = 0; i < count; ++i) {
-        delete m_childItems.takeAt(position);
+        Rule *child = m_childItems.takeAt(position);
+        unindexSubtree(child);
+        delete child;
     }
 
+    updateRows(position);
+
     m_status = Unsaved;
+    touchSubtree();
 
     return true;
 }
 
 //--------------------------------------------------------------------------------------------------
 
+Lvk::BE::Rule * Lvk::BE::Rule::takeChild(int position)
+{
+    if (position < 0 || position >= m_childItems.size()) {
+        return 0;
+    }
+
+    Rule *child = m_childItems.takeAt(position);
+    unindexSubtree(child);
+    child->m_parentItem = 0;
+
+    updateRows(position);
+
+    m_status = Unsaved;
+    touchSubtree();
+
+    return child;
+}
+
+//--------------------------------------------------------------------------------------------------
+
 void Lvk::BE::Rule::removeAllChild()
 {
     removeChildren(0, childCount());
@@ -223,9 +288,15 @@ bool Lvk::BE::Rule::moveChildren(int position, int count, Lvk::BE::Rule *newPare
     }
 
     for (int i = 0; i < count; ++i) {
-        newParent->appendChild(m_childItems.takeAt(position));
+        Rule *child = m_childItems.takeAt(position);
+        unindexSubtree(child);
+        newParent->appendChild(child);
     }
 
+    updateRows(position);
+
+    touchSubtree();
+
     return true;
 }
 
@@ -261,10 +332,15 @@ int Lvk::BE::Rule::childCount() const
 
 Lvk::BE::Rule * Lvk::BE::Rule::nextSibling()
 {
-    if (m_parentItem != 0) {
-        // TODO consider not using indexOf to improve performance. Instead store the sibling number
-        //      as a class atribute
-        int i = m_parentItem->m_childItems.indexOf(const_cast<Rule *>(this));
+    return const_cast<Rule *>(static_cast<const Rule *>(this)->nextSibling());
+}
+
+//--------------------------------------------------------------------------------------------------
+
+const Lvk::BE::Rule * Lvk::BE::Rule::nextSibling() const
+{
+    if (m_parentItem) {
+        int i = row();
 
         if (i + 1 <  m_parentItem->m_childItems.size()) {
             return m_parentItem->m_childItems[i + 1];
@@ -275,18 +351,141 @@ Lvk::BE::Rule * Lvk::BE::Rule::nextSibling()
 
 //--------------------------------------------------------------------------------------------------
 
-const Lvk::BE::Rule * Lvk::BE::Rule::nextSibling() const
+int Lvk::BE::Rule::row() const
 {
-    if (m_parentItem) {
-        // TODO consider not using indexOf to improve performance. Instead store the sibling number
-        //      as a class atribute
-        int i = m_parentItem->m_childItems.indexOf(const_cast<Rule *>(this));
+    if (!m_parentItem) {
+        return 0;
+    }
 
-        if (i + 1 <  m_parentItem->m_childItems.size()) {
-            return m_parentItem->m_childItems[i + 1];
+    const QList<Rule *> &siblings = m_parentItem->m_childItems;
+
+    // m_row is stale only if children() was used to modify the list
+    if (m_row >= siblings.size() || siblings[m_row] != this) {
+        m_parentItem->updateRows(0);
+    }
+
+    return m_row;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+Lvk::BE::Rule * Lvk::BE::Rule::findById(quint64 id)
+{
+    return id ? idIndex()->value(id, 0) : 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+const Lvk::BE::Rule * Lvk::BE::Rule::findById(quint64 id) const
+{
+    return id ? idIndex()->value(id, 0) : 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+Lvk::BE::Rule * Lvk::BE::Rule::root() const
+{
+    const Rule *rule = this;
+    while (rule->m_parentItem) {
+        rule = rule->m_parentItem;
+    }
+    return const_cast<Rule *>(rule);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+Lvk::BE::Rule::IdIndex * Lvk::BE::Rule::idIndex() const
+{
+    Rule *r = root();
+
+    if (!r->m_idIndex) {
+        r->m_idIndex = new IdIndex();
+
+        for (iterator it = r->begin(); it != r->end(); ++it) {
+            if ((*it)->m_id) {
+                r->m_idIndex->insert((*it)->m_id, *it);
+            }
+        }
+    }
+
+    return r->m_idIndex;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+quint64 Lvk::BE::Rule::revision() const
+{
+    return m_revision;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+quint64 Lvk::BE::Rule::subtreeRevision() const
+{
+    return m_subtreeRevision;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::BE::Rule::touch()
+{
+    m_revision = nextRevision();
+
+    for (Rule *r = this; r; r = r->m_parentItem) {
+        r->m_subtreeRevision = m_revision;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::BE::Rule::touchSubtree()
+{
+    quint64 revision = nextRevision();
+
+    for (Rule *r = this; r; r = r->m_parentItem) {
+        r->m_subtreeRevision = revision;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::BE::Rule::updateRows(int from)
+{
+    for (int i = from; i < m_childItems.size(); ++i) {
+        m_childItems[i]->m_row = i;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::BE::Rule::indexSubtree(Rule *subtree)
+{
+    IdIndex *index = root()->m_idIndex;
+
+    if (index) {
+        if (subtree->m_id) {
+            index->insert(subtree->m_id, subtree);
+        }
+        foreach (Rule *child, subtree->m_childItems) {
+            indexSubtree(child);
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::BE::Rule::unindexSubtree(Rule *subtree)
+{
+    IdIndex *index = root()->m_idIndex;
+
+    if (index) {
+        if (subtree->m_id) {
+            index->remove(subtree->m_id, subtree);
+        }
+        foreach (Rule *child, subtree->m_childItems) {
+            unindexSubtree(child);
         }
     }
-    return 0;
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -299,8 +498,14 @@ void Lvk::BE::Rule::clear()
     m_target.clear();
     m_childItems.clear();
     m_status = Unsaved;
+    touch();
     m_checkState = Qt::Unchecked;
     m_nextCatId = 0;
+
+    // Children were detached, the index is rebuilt on the next lookup
+    Rule *r = root();
+    delete r->m_idIndex;
+    r->m_idIndex = 0;
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -310,6 +515,7 @@ void Lvk::BE::Rule::setType(Rule::Type type)
     if (m_type != type) {
         m_type = type;
         m_status = Unsaved;
+        touch();
     }
 }
 
@@ -325,6 +531,7 @@ Lvk::BE::Rule::Type Lvk::BE::Rule::type() const
 Lvk::BE::TargetList &Lvk::BE::Rule::target()
 {
     m_status = Unsaved;
+    touch();
 
     return m_target;
 }
@@ -341,6 +548,7 @@ const Lvk::BE::TargetList &Lvk::BE::Rule::target() const
 void Lvk::BE::Rule::setTarget(const TargetList &target)
 {
     m_status = Unsaved;
+    touch();
 
     m_target = target;
 }
@@ -350,6 +558,7 @@ void Lvk::BE::Rule::setTarget(const TargetList &target)
 QStringList &Lvk::BE::Rule::input()
 {
     m_status = Unsaved;
+    touch();
 
     return m_input;
 }
@@ -366,6 +575,7 @@ const QStringList &Lvk::BE::Rule::input() const
 void Lvk::BE::Rule::setInput(const QStringList &input)
 {
     m_status = Unsaved;
+    touch();
 
     m_input = input;
 }
@@ -375,6 +585,7 @@ void Lvk::BE::Rule::setInput(const QStringList &input)
 QStringList &Lvk::BE::Rule::output()
 {
     m_status = Unsaved;
+    touch();
 
     return m_output;
 }
@@ -391,6 +602,7 @@ const QStringList &Lvk::BE::Rule::output() const
 void Lvk::BE::Rule::setOutput(const QStringList &output)
 {
     m_status = Unsaved;
+    touch();
 
     m_output = output;
 }
@@ -410,6 +622,7 @@ void Lvk::BE::Rule::setNextCategory(quint64 catId)
         m_nextCatId = catId;
 
         m_status = Unsaved;
+        touch();
     }
 }
 
@@ -428,6 +641,7 @@ void Lvk::BE::Rule::setName(const QString &name)
         m_name = name;
 
         m_status = Unsaved;
+        touch();
     }
 }
 
@@ -538,6 +752,7 @@ void Lvk::BE::Rule::setEnabled(bool enabled)
     if (m_enabled != enabled) {
         m_enabled = enabled;
         m_status = Unsaved;
+        touch();
     }
 }
 
@@ -580,5 +795,22 @@ quint64 Lvk::BE::Rule::id() const
 
 void Lvk::BE::Rule::setId(quint64 id)
 {
+    if (m_id == id) {
+        return;
+    }
+
+    IdIndex *index = root()->m_idIndex;
+
+    if (index) {
+        if (m_id) {
+            index->remove(m_id, this);
+        }
+        if (id) {
+            index->insert(id, this);
+        }
+    }
+
     m_id = id;
+
+    touch();
 }
@@ -23,6 +23,7 @@
 #define LVK_BE_RULE_H
 
 #include <QList>
+#include <QMultiHash>
 #include <QString>
 #include <QStringList>
 #include <QVariant>
@@ -53,7 +54,8 @@ namespace BE
  * constructor or by adding children with appendChild() or insertChildren().
  *
  * Given a root rule it can be iterated using STL-like iterator classes Rule::iterator and
- * Rule::const_iterator
+ * Rule::const_iterator. Each rule knows its position among its siblings, so a full traversal
+ * is linear. Rules can be looked up by ID with findById().
  */
 class Rule
 {
@@ -181,6 +183,9 @@ public:
 
     /**
      * Returns a reference to the list of children.
+     *
+     * The list must not be used to add or remove children, use appendChild(),
+     * insertChildren(), removeChildren() or moveChildren() instead.
      */
     QList<Rule*> &children();
 
@@ -204,6 +209,12 @@ public:
      */
     bool removeChildren(int position, int count);
 
+    /**
+     * Removes the child at \a position and returns it. The caller takes ownership of the
+     * returned rule. If \a position is not valid, returns 0.
+     */
+    Rule *takeChild(int position);
+
     /**
      * Removes all child.
      */
@@ -247,6 +258,26 @@ public:
      */
     const Rule *nextSibling() const;
 
+    /**
+     * Returns the position of the rule in the parent's list of children. If the rule has no
+     * parent, it returns 0.
+     */
+    int row() const;
+
+    /**
+     * Returns the rule with the given \a id in the tree this rule belongs to. If there is no
+     * such rule or \a id is 0, it returns 0.
+     *
+     * The first lookup builds an index on the root rule. Afterwards the index is kept up to
+     * date as children are added, removed or moved and IDs are changed.
+     */
+    Rule *findById(quint64 id);
+
+    /**
+     * \copydoc findById()
+     */
+    const Rule *findById(quint64 id) const;
+
 
 
     /**
@@ -400,6 +431,19 @@ public:
      */
     void setId(quint64 id);
 
+    /**
+     * Returns the revision of the rule. The revision changes each time the ID or an attribute
+     * of the rule changes, or the rule is added to a parent. Revisions are never repeated, even
+     * among different trees. By default is 0.
+     */
+    quint64 revision() const;
+
+    /**
+     * Returns the revision of the subtree rooted at this rule. It changes each time a rule in
+     * the subtree changes or is removed. If it has not changed, nothing in the subtree has.
+     */
+    quint64 subtreeRevision() const;
+
     /**
      * Clears the rule by setting all attribures to the default value.
      */
@@ -453,6 +497,8 @@ private:
     //Rule(const Rule &other);
     Rule& operator=(Rule &other);
 
+    typedef QMultiHash<quint64, Rule *> IdIndex;
+
     QList<Rule*> m_childItems;
     QString m_name;
     QStringList m_input;
@@ -465,6 +511,18 @@ private:
     Qt::CheckState m_checkState;
     quint64 m_id;
     quint64 m_nextCatId;
+    mutable int m_row;              // Position in parent's children, might be stale
+    mutable IdIndex *m_idIndex;     // Only used by the root rule, built lazily
+    quint64 m_revision;
+    quint64 m_subtreeRevision;      // Latest revision in the subtree
+
+    Rule *root() const;
+    IdIndex *idIndex() const;
+    void updateRows(int from);
+    void indexSubtree(Rule *subtree);
+    void unindexSubtree(Rule *subtree);
+    void touch();
+    void touchSubtree();
 };
 
 /**
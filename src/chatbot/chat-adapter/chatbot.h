@@ -142,10 +142,29 @@ public:
     virtual QString historyFilename() const = 0;
 
     /**
-     * Returns the chat history of the chatbot
+     * Returns the most recent entries of the chat history of the chatbot
      */
     virtual const Cmn::Conversation &chatHistory() const = 0;
 
+    /**
+     * Returns the chat history entries of the given \a date from the user \a from. If \a from
+     * is empty, returns the entries from all users.
+     */
+    virtual Cmn::Conversation chatHistory(const QDate &date, const QString &from) const = 0;
+
+    /**
+     * Returns at most \a limit chat history entries with date-time in the range
+     * [\a start, \a end) skipping the first \a offset entries. Null date-times are unbounded and
+     * a negative \a limit returns all entries.
+     */
+    virtual Cmn::Conversation chatHistory(const QDateTime &start, const QDateTime &end,
+                                          int offset, int limit) const = 0;
+
+    /**
+     * Returns the date and user of every conversation in the chat history
+     */
+    virtual Cmn::Conversation::DateContactList chatHistoryContacts() const = 0;
+
     /**
      * Sets the chat history of the chatbot.
      */
@@ -156,6 +175,11 @@ public:
      */
     virtual void clearHistory() = 0;
 
+    /**
+     * Clears the chat history of the given \a date from the user \a from.
+     */
+    virtual void clearHistory(const QDate &date, const QString &from) = 0;
+
 signals:
 
     /**
@@ -20,21 +20,33 @@
  */
 
 #include "chat-adapter/chatcorpus.h"
-#include "common/csvdocument.h"
+#include "common/csvrow.h"
+#include "common/csvreader.h"
 #include "common/globalstrings.h"
 #include "common/settings.h"
 #include "common/settingskeys.h"
+#include "common/metrics.h"
+#include "common/fileutils.h"
 
 #include <QFile>
 #include <QDir>
 #include <QStringList>
-#include <QRegExp>
 #include <QMutex>
 #include <QMutexLocker>
+#include <QWaitCondition>
+#include <QThreadPool>
+#include <QRunnable>
 #include <QDateTime>
+#include <QCoreApplication>
+#include <QtEndian>
 #include <QtDebug>
 
-#define CORPUS_FILE     "corpus.dat"
+#define CORPUS_FILE             "corpus.dat"
+#define CORPUS_SEGMENT_PREFIX   "corpus."
+#define CORPUS_SEGMENT_SUFFIX   ".dat"
+#define CORPUS_COMPRESSED_EXT   ".z"
+#define CORPUS_TMP_EXT          ".tmp"
+#define COMPRESS_BLOCK_SIZE     256*1024
 
 //--------------------------------------------------------------------------------------------------
 // Helpers
@@ -43,14 +55,243 @@
 namespace
 {
 
+Lvk::Cmn::Counter *g_corpusEntries = Lvk::Cmn::Metrics::counter(
+        "chatbot_corpus_entries_total", "Entries appended to the chat corpus");
+
+Lvk::Cmn::Histogram *g_corpusWriteLatency = Lvk::Cmn::Metrics::histogram(
+        "chatbot_corpus_write_duration_seconds", "Time spent appending to the chat corpus");
+
+Lvk::Cmn::Histogram *g_corpusFlushLatency = Lvk::Cmn::Metrics::histogram(
+        "chatbot_corpus_flush_duration_seconds", "Time spent writing the chat corpus to disk");
+
+//--------------------------------------------------------------------------------------------------
+
 QString sanitize(const QString &str)
 {
     return str.simplified();
 }
 
+//--------------------------------------------------------------------------------------------------
+
+inline QString corpusPath()
+{
+    return Lvk::Cmn::Settings().value(SETTING_DATA_PATH).toString();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+inline bool isCompressed(const QString &segment)
+{
+    return segment.endsWith(CORPUS_COMPRESSED_EXT);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+// Rotated segments sorted from oldest to newest. If a segment was compressed but the plain
+// file could not be removed, only the compressed one is returned.
+
+QStringList corpusSegments(const QString &path)
+{
+    QStringList filters;
+    filters << (CORPUS_SEGMENT_PREFIX "*" CORPUS_SEGMENT_SUFFIX)
+            << (CORPUS_SEGMENT_PREFIX "*" CORPUS_SEGMENT_SUFFIX CORPUS_COMPRESSED_EXT);
+
+    QStringList names = QDir(path).entryList(filters, QDir::Files, QDir::Name);
+    QStringList segments;
+
+    foreach (const QString &name, names) {
+        if (!isCompressed(name) && names.contains(name + CORPUS_COMPRESSED_EXT)) {
+            continue;
+        }
+        segments.append(path + QDir::separator() + name);
+    }
+
+    return segments;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+// Compresses the segment block by block into <segment>.z and removes the segment.
+// The output is written to a temporary file and renamed once it is complete.
+
+void compressSegment(const QString &segment)
+{
+    QString target = segment + CORPUS_COMPRESSED_EXT;
+    QFile in(segment);
+    QFile out(target + CORPUS_TMP_EXT);
+
+    if (!in.open(QFile::ReadOnly) || !out.open(QFile::WriteOnly)) {
+        qWarning() << QObject::tr("Warning: cannot compress corpus segment") << segment;
+        return;
+    }
+
+    bool ok = true;
+
+    while (ok && !in.atEnd()) {
+        QByteArray block = qCompress(in.read(COMPRESS_BLOCK_SIZE));
+
+        uchar size[4];
+        qToBigEndian<quint32>(block.size(), size);
+
+        ok = out.write(reinterpret_cast<const char *>(size), 4) == 4 &&
+                out.write(block) == block.size();
+    }
+
+    ok = ok && in.error() == QFile::NoError && Lvk::Cmn::FileUtils::syncFile(&out);
+
+    out.close();
+
+    if (ok && QFile::rename(out.fileName(), target)) {
+        in.close();
+        in.remove();
+    } else {
+        qWarning() << QObject::tr("Warning: cannot compress corpus segment") << segment;
+        out.remove();
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+// Sequential device that uncompresses a segment written by compressSegment() one block at a time
+
+class CompressedSegment : public QIODevice
+{
+public:
+    CompressedSegment(QFile *file)
+        : m_file(file), m_pos(0)
+    {
+        open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+    }
+
+    ~CompressedSegment()
+    {
+        delete m_file;
+    }
+
+    virtual bool isSequential() const
+    {
+        return true;
+    }
+
+    virtual bool atEnd() const
+    {
+        return m_pos >= m_block.size() && m_file->atEnd();
+    }
+
+    virtual qint64 bytesAvailable() const
+    {
+        return m_block.size() - m_pos + QIODevice::bytesAvailable();
+    }
+
+protected:
+    virtual qint64 readData(char *data, qint64 maxSize)
+    {
+        if (m_pos >= m_block.size() && !nextBlock()) {
+            return -1;
+        }
+
+        qint64 n = qMin(maxSize, static_cast<qint64>(m_block.size() - m_pos));
+        memcpy(data, m_block.constData() + m_pos, n);
+        m_pos += n;
+
+        return n;
+    }
+
+    virtual qint64 writeData(const char *, qint64)
+    {
+        return -1;
+    }
+
+private:
+    QFile *m_file;
+    QByteArray m_block;
+    int m_pos;
+
+    bool nextBlock()
+    {
+        m_block.clear();
+        m_pos = 0;
+
+        if (m_file->atEnd()) {
+            return false;
+        }
+
+        uchar size[4];
+
+        if (m_file->read(reinterpret_cast<char *>(size), 4) == 4) {
+            m_block = qUncompress(m_file->read(qFromBigEndian<quint32>(size)));
+        }
+
+        if (m_block.isEmpty()) {
+            qWarning() << QObject::tr("Warning: corrupt corpus segment") << m_file->fileName();
+            m_file->seek(m_file->size());
+            return false;
+        }
+
+        return true;
+    }
+};
+
+//--------------------------------------------------------------------------------------------------
+
+void flushAtExit()
+{
+    Lvk::CA::ChatCorpus().sync();
+}
+
 } // namespace
 
 
+//--------------------------------------------------------------------------------------------------
+// ChatCorpus::WriteTask
+//--------------------------------------------------------------------------------------------------
+
+class Lvk::CA::ChatCorpus::WriteTask : public QRunnable
+{
+public:
+    virtual void run()
+    {
+        m_mutex->lock();
+
+        m_writeQueued = false;
+
+        // flush() may be writing, or may have written everything already
+        while (m_writing) {
+            m_written->wait(m_mutex);
+        }
+
+        if (m_buffer.isEmpty()) {
+            m_mutex->unlock();
+            return;
+        }
+
+        m_writing = true;
+        m_mutex->unlock();
+
+        ChatCorpus().write();
+    }
+};
+
+//--------------------------------------------------------------------------------------------------
+// ChatCorpus::CompressTask
+//--------------------------------------------------------------------------------------------------
+
+class Lvk::CA::ChatCorpus::CompressTask : public QRunnable
+{
+public:
+    CompressTask(const QString &segment)
+        : m_segment(segment) { }
+
+    virtual void run()
+    {
+        compressSegment(m_segment);
+    }
+
+private:
+    QString m_segment;
+};
+
+
 //--------------------------------------------------------------------------------------------------
 // ChatCorpus
 //--------------------------------------------------------------------------------------------------
@@ -59,10 +300,28 @@ bool Lvk::CA::ChatCorpus::m_init = false;
 
 QFile Lvk::CA::ChatCorpus::m_corpusFile;
 
-QList<Lvk::CA::ChatCorpus::CorpusEntry> Lvk::CA::ChatCorpus::m_corpus;
+QByteArray Lvk::CA::ChatCorpus::m_buffer;
+
+QElapsedTimer Lvk::CA::ChatCorpus::m_bufferAge;
+
+int Lvk::CA::ChatCorpus::m_maxBufferSize = 0;
+
+int Lvk::CA::ChatCorpus::m_flushInterval = 0;
+
+qint64 Lvk::CA::ChatCorpus::m_maxFileSize = 0;
+
+bool Lvk::CA::ChatCorpus::m_compress = false;
+
+bool Lvk::CA::ChatCorpus::m_writeQueued = false;
+
+bool Lvk::CA::ChatCorpus::m_writing = false;
 
 QMutex *Lvk::CA::ChatCorpus::m_mutex = new QMutex();
 
+QWaitCondition *Lvk::CA::ChatCorpus::m_written = new QWaitCondition();
+
+QThreadPool *Lvk::CA::ChatCorpus::m_pool = 0;
+
 //--------------------------------------------------------------------------------------------------
 
 Lvk::CA::ChatCorpus::ChatCorpus()
@@ -78,16 +337,34 @@ void Lvk::CA::ChatCorpus::init()
         QMutexLocker locker(m_mutex);
         if (!m_init) {
             Cmn::Settings settings;
-            QString dataPath = settings.value(SETTING_DATA_PATH).toString();
+            m_maxBufferSize = settings.value(SETTING_CORPUS_BUFFER_SIZE).toInt();
+            m_flushInterval = settings.value(SETTING_CORPUS_FLUSH_INTERVAL).toInt();
+            m_maxFileSize = settings.value(SETTING_CORPUS_MAX_SIZE).toLongLong();
+            m_compress = settings.value(SETTING_CORPUS_COMPRESS).toBool();
+
+            // A single thread, so writes and compression never compete for the disk
+            m_pool = new QThreadPool();
+            m_pool->setMaxThreadCount(1);
 
-            m_corpusFile.setFileName(dataPath + QDir::separator() + CORPUS_FILE);
+            QString path = corpusPath();
 
-            load();
+            m_corpusFile.setFileName(path + QDir::separator() + CORPUS_FILE);
 
             if (!m_corpusFile.open(QFile::Append)) {
                 qWarning() << QObject::tr("Warning: cannot open corpus file for writing");
             }
 
+            // Segments rotated before the application stopped
+            if (m_compress) {
+                foreach (const QString &segment, corpusSegments(path)) {
+                    if (!isCompressed(segment)) {
+                        m_pool->start(new CompressTask(segment));
+                    }
+                }
+            }
+
+            qAddPostRoutine(flushAtExit);
+
             m_init = true;
         }
     }
@@ -110,67 +387,221 @@ void Lvk::CA::ChatCorpus::add(const QString &user, const QString &message, const
 
 void Lvk::CA::ChatCorpus::add(const CorpusEntry &entry)
 {
+    Cmn::ScopedLatency latency(g_corpusWriteLatency);
+
+    g_corpusEntries->inc();
+
+    // Format the row before taking the lock
+    Cmn::CsvRow row;
+    row.append(entry.timestamp.toString(STR_CHAT_CORPUS_DATE_TIME_FORMAT));
+    row.append(sanitize(entry.thread));
+    row.append(sanitize(entry.username));
+    row.append(sanitize(entry.message));
+
+    QByteArray data = row.toString().toUtf8();
+    data.append('\n');
+
     QMutexLocker locker(m_mutex);
 
-    m_corpus.append(entry);
+    if (m_buffer.isEmpty()) {
+        m_bufferAge.start();
+    }
+
+    m_buffer.append(data);
 
-    if (m_corpusFile.isOpen()) {
-        Cmn::CsvRow row;
-        row.append(entry.timestamp.toString(STR_CHAT_CORPUS_DATE_TIME_FORMAT));
-        row.append(sanitize(entry.thread));
-        row.append(sanitize(entry.username));
-        row.append(sanitize(entry.message));
+    bool full = m_buffer.size() >= m_maxBufferSize || m_bufferAge.elapsed() >= m_flushInterval;
 
-        m_corpusFile.write(row.toString().toUtf8());
-        m_corpusFile.write("\n");
-        m_corpusFile.flush();
+    if (full && !m_writeQueued && !m_writing) {
+        m_writeQueued = true;
+        m_pool->start(new WriteTask());
     }
 }
 
 //--------------------------------------------------------------------------------------------------
 
-QList<Lvk::CA::ChatCorpus::CorpusEntry> Lvk::CA::ChatCorpus::corpus()
+void Lvk::CA::ChatCorpus::flush()
 {
-    QMutexLocker locker(m_mutex);
-    return m_corpus;
+    m_mutex->lock();
+
+    while (m_writing) {
+        m_written->wait(m_mutex);
+    }
+
+    if (m_buffer.isEmpty()) {
+        m_mutex->unlock();
+        return;
+    }
+
+    m_writing = true;
+    m_mutex->unlock();
+
+    write();
 }
 
 //--------------------------------------------------------------------------------------------------
 
-void Lvk::CA::ChatCorpus::load()
+void Lvk::CA::ChatCorpus::write()
 {
-    if (!m_corpusFile.exists()) {
-        // Nothing to do
-        return;
+    // The caller set m_writing, so no other thread touches the file until it is cleared.
+    // Entries added while a batch is written are taken in the next iteration.
+
+    QByteArray data;
+
+    for (;;) {
+        m_mutex->lock();
+
+        if (m_buffer.isEmpty()) {
+            m_writing = false;
+            m_written->wakeAll();
+            m_mutex->unlock();
+            return;
+        }
+
+        data.clear();
+        qSwap(data, m_buffer);
+
+        m_mutex->unlock();
+
+        Cmn::ScopedLatency latency(g_corpusFlushLatency);
+
+        if (m_corpusFile.isOpen()) {
+            if (m_corpusFile.write(data) != data.size() || !m_corpusFile.flush()) {
+                qWarning() << QObject::tr("Warning: cannot write corpus file");
+            }
+
+            if (m_maxFileSize > 0 && m_corpusFile.size() >= m_maxFileSize) {
+                rotate();
+            }
+        }
     }
-    if (!m_corpusFile.open(QFile::ReadOnly)) {
-        qWarning() << QObject::tr("Warning: cannot open corpus file for reading");
-        return;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::CA::ChatCorpus::rotate()
+{
+    QString base = corpusPath() + QDir::separator() + CORPUS_SEGMENT_PREFIX
+            + QDateTime::currentDateTime().toString("yyyyMMdd-hhmmsszzz");
+
+    // Several rotations in the same millisecond. '_' sorts after the '.' of the first segment
+    QString segment = base + CORPUS_SEGMENT_SUFFIX;
+
+    for (int i = 1; QFile::exists(segment) ||
+                    QFile::exists(segment + CORPUS_COMPRESSED_EXT); ++i) {
+        segment = base + "_" + QString::number(i).rightJustified(3, '0') + CORPUS_SEGMENT_SUFFIX;
     }
 
-    char buf[10*1024];
-    qint64 len = 0;
-    QString line;
-    Cmn::CsvRow row;
+    m_corpusFile.close();
 
-    do {
-        len = m_corpusFile.readLine(buf, sizeof(buf));
-        if (len > 0) {
-            line = QString::fromUtf8(buf);
-            row = Cmn::CsvRow(line);
+    if (QFile::rename(m_corpusFile.fileName(), segment)) {
+        if (m_compress) {
+            m_pool->start(new CompressTask(segment));
+        }
+    } else {
+        qWarning() << QObject::tr("Warning: cannot rotate corpus file");
+    }
+
+    if (!m_corpusFile.open(QFile::Append)) {
+        qWarning() << QObject::tr("Warning: cannot open corpus file for writing");
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::CA::ChatCorpus::sync()
+{
+    flush();
+
+    m_pool->waitForDone();
+}
+
+//--------------------------------------------------------------------------------------------------
+// ChatCorpus::Reader
+//--------------------------------------------------------------------------------------------------
 
+Lvk::CA::ChatCorpus::Reader::Reader()
+    : m_next(0), m_device(0), m_csvReader(0)
+{
+    ChatCorpus().flush();
+
+    QString path = corpusPath();
+
+    m_segments = corpusSegments(path);
+    m_segments.append(path + QDir::separator() + CORPUS_FILE);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+Lvk::CA::ChatCorpus::Reader::~Reader()
+{
+    close();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool Lvk::CA::ChatCorpus::Reader::read(CorpusEntry *entry)
+{
+    Cmn::CsvRow row;
+
+    while (m_csvReader || openNext()) {
+        while (m_csvReader->readRow(row)) {
             if (row.size() == 4) {
-                CorpusEntry entry;
-                entry.timestamp = QDateTime::fromString(row[0], STR_CHAT_CORPUS_DATE_TIME_FORMAT);
-                entry.thread    = row[1];
-                entry.username  = row[2];
-                entry.message   = row[3];
+                entry->timestamp = QDateTime::fromString(row[0], STR_CHAT_CORPUS_DATE_TIME_FORMAT);
+                entry->thread    = row[1];
+                entry->username  = row[2];
+                entry->message   = row[3];
 
-                m_corpus.append(entry);
+                return true;
             }
         }
-    } while (len != -1);
 
-    m_corpusFile.close();
+        close();
+    }
+
+    return false;
 }
 
+//--------------------------------------------------------------------------------------------------
+
+bool Lvk::CA::ChatCorpus::Reader::openNext()
+{
+    while (m_next < m_segments.size()) {
+        QString filename = m_segments[m_next++];
+
+        QFile *file = new QFile(filename);
+
+        // The segment may have been compressed after the reader was created
+        if (!file->open(QFile::ReadOnly) && !isCompressed(filename)) {
+            filename += CORPUS_COMPRESSED_EXT;
+            file->setFileName(filename);
+            file->open(QFile::ReadOnly);
+        }
+
+        if (!file->isOpen()) {
+            delete file;
+            continue;
+        }
+
+        if (isCompressed(filename)) {
+            m_device = new CompressedSegment(file);
+        } else {
+            m_device = file;
+        }
+
+        m_csvReader = new Cmn::CsvReader(m_device);
+
+        return true;
+    }
+
+    return false;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::CA::ChatCorpus::Reader::close()
+{
+    delete m_csvReader;
+    m_csvReader = 0;
+    delete m_device;
+    m_device = 0;
+}
@@ -25,14 +25,25 @@
 #include <QList>
 #include <QPair>
 #include <QString>
+#include <QStringList>
 #include <QFile>
 #include <QDateTime>
+#include <QByteArray>
+#include <QElapsedTimer>
 
 class QMutex;
+class QWaitCondition;
+class QThreadPool;
+class QIODevice;
 
 namespace Lvk
 {
 
+namespace Cmn
+{
+    class CsvReader;
+}
+
 /// \addtogroup Lvk
 /// @{
 
@@ -53,7 +64,21 @@ namespace CA
  * Currently, only FbChatbot class uses ChatCorpus. FbChatbot can "hear" chat conversations
  * from the real user but GtalkChatbot does not.
  *
- * TODO explain log format
+ * The corpus is an append-only CSV file with one entry per row: timestamp, thread, username and
+ * message. Entries are not kept in memory. New entries are buffered and appended to the file
+ * when the buffer is full (setting "Corpus/BufferSize"), when the oldest buffered entry is older
+ * than "Corpus/FlushInterval" milliseconds, on flush() or when the application exits.
+ *
+ * add() never touches the file. A full buffer is handed to a background thread that owns the
+ * file while it writes; flush() waits for that thread and then writes the rest itself. Only one
+ * thread writes at a time and each one takes the whole buffer, so entries keep their order.
+ *
+ * If the "Corpus/MaxSize" setting is not zero, the corpus file is rotated when it reaches that
+ * size. Rotated segments are named corpus.<timestamp>.dat and, if "Corpus/Compress" is true, they
+ * are compressed in the background and renamed corpus.<timestamp>.dat.z. Compressed segments are
+ * a sequence of blocks, each one a big-endian 32-bit size followed by the qCompress() output of
+ * up to 256 KB of the segment, so neither side holds a whole segment in memory. Use
+ * ChatCorpus::Reader to iterate over all segments.
  */
 
 class ChatCorpus
@@ -71,6 +96,45 @@ public:
         QString message;     ///< Message
     };
 
+    /**
+     * \brief The Reader class reads the entries of the corpus one at a time.
+     *
+     * Entries are read from the oldest segment to the current corpus file. Only one segment
+     * is open at a time, so memory usage does not depend on the size of the corpus.
+     */
+    class Reader
+    {
+    public:
+
+        /**
+         * Constructs a Reader for the whole corpus. Buffered entries are flushed first.
+         */
+        Reader();
+
+        /**
+         * Destroys the object
+         */
+        ~Reader();
+
+        /**
+         * Reads the next corpus entry in \a entry. Returns true on success. If there are no more
+         * entries, returns false.
+         */
+        bool read(CorpusEntry *entry);
+
+    private:
+        Reader(const Reader&);
+        Reader& operator=(const Reader&);
+
+        QStringList m_segments;
+        int m_next;
+        QIODevice *m_device;
+        Cmn::CsvReader *m_csvReader;
+
+        bool openNext();
+        void close();
+    };
+
     /**
      * Constructs a ChatCorpus object initialized with the default data file.
      */
@@ -88,9 +152,15 @@ public:
     void add(const QString &username, const QString &message, const QString &thread);
 
     /**
-     * Returns all the entries in the corpus.
+     * Appends the buffered entries to the corpus file.
+     */
+    void flush();
+
+    /**
+     * Appends the buffered entries to the corpus file and waits until rotated segments are
+     * compressed.
      */
-    QList<CorpusEntry> corpus();
+    void sync();
 
 private:
     ChatCorpus(const ChatCorpus&);
@@ -98,11 +168,24 @@ private:
 
     static bool m_init;
     static QFile m_corpusFile;
-    static QList<CorpusEntry> m_corpus;
-    static QMutex *m_mutex;
+    static QByteArray m_buffer;
+    static QElapsedTimer m_bufferAge;
+    static int m_maxBufferSize;
+    static int m_flushInterval;
+    static qint64 m_maxFileSize;
+    static bool m_compress;
+    static bool m_writeQueued;          // A WriteTask is waiting for the pool
+    static bool m_writing;              // Some thread owns the corpus file
+    static QMutex *m_mutex;             // Guards the buffer and the flags above
+    static QWaitCondition *m_written;   // Signaled when a thread releases the corpus file
+    static QThreadPool *m_pool;         // Writes the buffer and compresses segments
+
+    class WriteTask;
+    class CompressTask;
 
     void init();
-    void load();
+    void write();
+    void rotate();
 };
 
 /// @}
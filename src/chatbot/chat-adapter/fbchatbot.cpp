@@ -28,6 +28,7 @@
 #include "common/globalstrings.h"
 
 #include <QDomElement>
+#include <QTimer>
 #include <QtDebug>
 
 #include "QXmppClient.h"
@@ -84,6 +85,12 @@ Lvk::CA::FbChatbot::FbChatbot(const QString &chatbotId, QObject *parent)
             SLOT(onOwnMessageReceived(QXmppMessage)));
 
     m_xmppClient->addExtension(m_ownMsgExtension);
+
+    // Buffered corpus entries are written at most FlushInterval ms after being added
+    Cmn::Settings settings;
+    QTimer *corpusFlushTimer = new QTimer(this);
+    connect(corpusFlushTimer, SIGNAL(timeout()), SLOT(onCorpusFlushTimeout()));
+    corpusFlushTimer->start(qMax(settings.value(SETTING_CORPUS_FLUSH_INTERVAL).toInt(), 1));
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -131,3 +138,10 @@ void Lvk::CA::FbChatbot::onOwnMessageReceived(const QXmppMessage &msg)
 
     emit newConversationEntry(makeEntry(OWN_MESSAGE_TOKEN, msg.to(), msg.body()));
 }
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::CA::FbChatbot::onCorpusFlushTimeout()
+{
+    CA::ChatCorpus().flush();
+}
@@ -79,6 +79,9 @@ protected slots:
     virtual void onMessageReceived(const QXmppMessage &msg);
     virtual void onOwnMessageReceived(const QXmppMessage &msg);
 
+private slots:
+    void onCorpusFlushTimeout();
+
 private:
     FbChatbot(const FbChatbot&);
     FbChatbot & operator=(const FbChatbot&);
@@ -22,14 +22,91 @@
 #include "chat-adapter/historyhelper.h"
 #include "common/conversationreader.h"
 #include "common/conversationwriter.h"
+#include "common/conversationindex.h"
+#include "common/conversationrecord.h"
+#include "common/fileutils.h"
+#include "common/tracer.h"
+#include "common/metrics.h"
+#include "common/settings.h"
+#include "common/settingskeys.h"
 
 #include <QFile>
 #include <QDir>
 #include <QReadWriteLock>
+#include <QMutex>
+#include <QMutexLocker>
 #include <QReadLocker>
 #include <QWriteLocker>
+#include <QSet>
 #include <QtDebug>
 
+#include <climits>
+
+//--------------------------------------------------------------------------------------------------
+// Helpers
+//--------------------------------------------------------------------------------------------------
+
+namespace
+{
+
+Lvk::Cmn::Histogram *g_writeLatency = Lvk::Cmn::Metrics::histogram(
+        "chatbot_history_write_duration_seconds", "Time spent appending to the chat history");
+
+Lvk::Cmn::Counter *g_writeErrors = Lvk::Cmn::Metrics::counter(
+        "chatbot_history_write_errors_total", "Chat history entries that could not be written");
+
+Lvk::Cmn::Counter *g_commitErrors = Lvk::Cmn::Metrics::counter(
+        "chatbot_history_commit_errors_total", "Chat history commits that failed");
+
+//--------------------------------------------------------------------------------------------------
+
+// Creates a writer for the history file using the configured format and commit policy.
+// Existing files keep their own format.
+
+Lvk::Cmn::ConversationWriter *newHistoryWriter(const QString &filename)
+{
+    Lvk::Cmn::Settings settings;
+    QString format = settings.value(SETTING_HISTORY_FORMAT).toString().toLower();
+
+    Lvk::Cmn::ConversationWriter *writer = new Lvk::Cmn::ConversationWriter(filename,
+            format == "binary" ? Lvk::Cmn::ConversationWriter::BinaryFormat
+                               : Lvk::Cmn::ConversationWriter::CsvFormat);
+
+    writer->setGroupCommit(settings.value(SETTING_HISTORY_BUFFER_SIZE).toInt(),
+                           settings.value(SETTING_HISTORY_FLUSH_INTERVAL).toInt());
+
+    writer->setSyncPolicy(settings.value(SETTING_HISTORY_SYNC).toBool() ?
+                              Lvk::Cmn::ConversationWriter::SyncOnCommit :
+                              Lvk::Cmn::ConversationWriter::NoSync);
+
+    return writer;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+inline int historyWindowSize()
+{
+    return Lvk::Cmn::Settings().value(SETTING_HISTORY_WINDOW_SIZE).toInt();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+inline bool isBinaryFile(const QString &filename)
+{
+    QFile file(filename);
+
+    return file.open(QFile::ReadOnly) && Lvk::Cmn::ConversationRecord::isBinary(&file);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+inline bool inRange(const QDateTime &dateTime, const QDateTime &start, const QDateTime &end)
+{
+    return (start.isNull() || dateTime >= start) && (end.isNull() || dateTime < end);
+}
+
+} // namespace
+
 //--------------------------------------------------------------------------------------------------
 // HistoryHelper
 //--------------------------------------------------------------------------------------------------
@@ -37,7 +114,9 @@
 Lvk::CA::HistoryHelper::HistoryHelper()
     : m_filename(),
       m_convWriter(new Cmn::ConversationWriter()),
-      m_rwLock(new QReadWriteLock())
+      m_rwLock(new QReadWriteLock()),
+      m_commitMutex(new QMutex()),
+      m_windowSize(historyWindowSize())
 {
 }
 
@@ -45,8 +124,10 @@ Lvk::CA::HistoryHelper::HistoryHelper()
 
 Lvk::CA::HistoryHelper::HistoryHelper(const QString &filename)
     : m_filename(filename),
-      m_convWriter(new Cmn::ConversationWriter(m_filename)),
-      m_rwLock(new QReadWriteLock())
+      m_convWriter(newHistoryWriter(m_filename)),
+      m_rwLock(new QReadWriteLock()),
+      m_commitMutex(new QMutex()),
+      m_windowSize(historyWindowSize())
 {
     load();
 }
@@ -56,6 +137,7 @@ Lvk::CA::HistoryHelper::HistoryHelper(const QString &filename)
 Lvk::CA::HistoryHelper::~HistoryHelper()
 {
     delete m_rwLock;
+    delete m_commitMutex;
     delete m_convWriter;
 }
 
@@ -63,10 +145,24 @@ Lvk::CA::HistoryHelper::~HistoryHelper()
 
 void Lvk::CA::HistoryHelper::load()
 {
+    m_conv.clear();
+
     if (QFile::exists(m_filename)) {
+        // Stream the file and only keep the most recent entries
         Cmn::ConversationReader convReader(m_filename);
-        m_conv.clear();
-        if (!convReader.read(&m_conv)) {
+        Cmn::Conversation::Entry entry;
+
+        while (convReader.read(&entry)) {
+            if (!entry.isNull()) {
+                m_conv.append(entry);
+
+                if (m_windowSize > 0 && m_conv.size() > m_windowSize) {
+                    m_conv.entries().removeFirst();
+                }
+            }
+        }
+
+        if (!convReader.atEnd()) {
             qWarning() << "HistoryHelper: Cannot read the conversation history from file"
                        << m_filename;
         }
@@ -75,6 +171,30 @@ void Lvk::CA::HistoryHelper::load()
 
 //--------------------------------------------------------------------------------------------------
 
+inline void Lvk::CA::HistoryHelper::trimWindow()
+{
+    if (m_windowSize > 0 && m_conv.size() > m_windowSize) {
+        QList<Cmn::Conversation::Entry> &entries = m_conv.entries();
+        entries.erase(entries.begin(), entries.begin() + (entries.size() - m_windowSize));
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+inline void Lvk::CA::HistoryHelper::commit() const
+{
+    // Make pending entries visible to readers of the file. Readers holding the read lock may
+    // commit at the same time.
+    QMutexLocker locker(m_commitMutex);
+
+    if (!m_convWriter->commit()) {
+        g_commitErrors->inc();
+        qCritical() << "HistoryHelper: Cannot commit the chat history to file" << m_filename;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+
 void Lvk::CA::HistoryHelper::setFilename(const QString &filename)
 {
     QWriteLocker locker(m_rwLock);
@@ -84,14 +204,14 @@ void Lvk::CA::HistoryHelper::setFilename(const QString &filename)
     load();
 
     delete m_convWriter;
-    m_convWriter = new Cmn::ConversationWriter(m_filename);
+    m_convWriter = newHistoryWriter(m_filename);
 }
 
 //--------------------------------------------------------------------------------------------------
 
 QString Lvk::CA::HistoryHelper::filename() const
 {
-    QWriteLocker locker(m_rwLock);
+    QReadLocker locker(m_rwLock);
 
     return m_filename;
 }
@@ -100,17 +220,32 @@ QString Lvk::CA::HistoryHelper::filename() const
 
 void Lvk::CA::HistoryHelper::append(const Cmn::Conversation::Entry &entry)
 {
+    TRACE_SPAN("history.append");
+    Cmn::ScopedLatency latency(g_writeLatency);
+
     QWriteLocker locker(m_rwLock);
 
     m_conv.append(entry);
 
+    trimWindow();
+
     if (!m_convWriter->write(entry)) {
+        g_writeErrors->inc();
         qCritical() << "HistoryHelper: Cannot write the conversation entry to file" << m_filename;
     }
 }
 
 //--------------------------------------------------------------------------------------------------
 
+void Lvk::CA::HistoryHelper::flush()
+{
+    QWriteLocker locker(m_rwLock);
+
+    commit();
+}
+
+//--------------------------------------------------------------------------------------------------
+
 const Lvk::Cmn::Conversation & Lvk::CA::HistoryHelper::history() const
 {
     QReadLocker locker(m_rwLock);
@@ -120,6 +255,120 @@ const Lvk::Cmn::Conversation & Lvk::CA::HistoryHelper::history() const
 
 //--------------------------------------------------------------------------------------------------
 
+Lvk::Cmn::Conversation Lvk::CA::HistoryHelper::history(const QDate &date,
+                                                       const QString &from) const
+{
+    QReadLocker locker(m_rwLock);
+
+    Cmn::Conversation conv;
+
+    if (QFile::exists(m_filename)) {
+        commit();
+
+        if (!Cmn::ConversationReader(m_filename).read(&conv, date, from)) {
+            qWarning() << "HistoryHelper: Cannot read the conversation history from file"
+                       << m_filename;
+        }
+    }
+
+    return conv;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+Lvk::Cmn::Conversation Lvk::CA::HistoryHelper::history(const QDateTime &start,
+                                                       const QDateTime &end, int offset,
+                                                       int limit) const
+{
+    QReadLocker locker(m_rwLock);
+
+    Cmn::Conversation conv;
+
+    if (limit == 0 || !QFile::exists(m_filename)) {
+        return conv;
+    }
+
+    commit();
+
+    Cmn::ConversationReader convReader(m_filename);
+    Cmn::Conversation::Entry entry;
+
+    while (convReader.read(&entry)) {
+        if (entry.isNull() || !inRange(entry.dateTime, start, end)) {
+            continue;
+        }
+        if (offset > 0) {
+            --offset;
+            continue;
+        }
+
+        conv.append(entry);
+
+        if (limit > 0 && conv.size() == limit) {
+            break;
+        }
+    }
+
+    return conv;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+Lvk::Cmn::Conversation::DateContactList Lvk::CA::HistoryHelper::dateContacts() const
+{
+    QReadLocker locker(m_rwLock);
+
+    Cmn::Conversation::DateContactList list;
+
+    if (!QFile::exists(m_filename)) {
+        return list;
+    }
+
+    commit();
+
+    QSet<QString> seen;
+    Cmn::ConversationReader convReader(m_filename);
+    Cmn::Conversation::Entry entry;
+
+    while (convReader.read(&entry)) {
+        if (entry.isNull()) {
+            continue;
+        }
+
+        QDate date = entry.dateTime.date();
+        QString key = QString::number(date.toJulianDay()) + " " + entry.from;
+
+        if (!seen.contains(key)) {
+            seen.insert(key);
+            list.append(Cmn::Conversation::DateContact(date, entry.from));
+        }
+    }
+
+    return list;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::CA::HistoryHelper::setWindowSize(int size)
+{
+    QWriteLocker locker(m_rwLock);
+
+    m_windowSize = qMax(0, size);
+
+    trimWindow();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+int Lvk::CA::HistoryHelper::windowSize() const
+{
+    QReadLocker locker(m_rwLock);
+
+    return m_windowSize;
+}
+
+//--------------------------------------------------------------------------------------------------
+
 void Lvk::CA::HistoryHelper::setHistory(const Cmn::Conversation &conv)
 {
     QWriteLocker locker(m_rwLock);
@@ -128,6 +377,8 @@ void Lvk::CA::HistoryHelper::setHistory(const Cmn::Conversation &conv)
 
     m_conv = conv;
 
+    trimWindow();
+
     if (!m_convWriter->write(conv)) {
         qCritical() << "HistoryHelper: Cannot write the conversation to file" << m_filename;
     }
@@ -144,6 +395,83 @@ void Lvk::CA::HistoryHelper::clear()
 
 //--------------------------------------------------------------------------------------------------
 
+void Lvk::CA::HistoryHelper::remove(const QDate &date, const QString &from)
+{
+    QWriteLocker locker(m_rwLock);
+
+    if (!QFile::exists(m_filename)) {
+        return;
+    }
+
+    commit();
+
+    // Stream the entries to keep into a new file and replace the current one
+
+    QString tmpFilename = m_filename + ".tmp";
+    QString tmpIndexFilename = Cmn::ConversationIndex::indexFilename(tmpFilename);
+    QFile::remove(tmpFilename);
+    QFile::remove(tmpIndexFilename);
+
+    bool ok = true;
+
+    {
+        Cmn::ConversationWriter tmpWriter(tmpFilename, isBinaryFile(m_filename) ?
+                                              Cmn::ConversationWriter::BinaryFormat :
+                                              Cmn::ConversationWriter::CsvFormat);
+        tmpWriter.setGroupCommit(64*1024, INT_MAX);
+
+        Cmn::ConversationReader convReader(m_filename);
+        Cmn::Conversation::Entry entry;
+
+        while (ok && convReader.read(&entry)) {
+            if (entry.isNull() || (entry.dateTime.date() == date && entry.from == from)) {
+                continue;
+            }
+            ok = tmpWriter.write(entry);
+        }
+
+        ok = tmpWriter.commit() && ok;
+    }
+
+    // The new file must be on disk before it replaces the current one
+    if (ok) {
+        QFile tmpFile(tmpFilename);
+        ok = tmpFile.open(QFile::ReadWrite) && Cmn::FileUtils::syncFile(&tmpFile);
+    }
+
+    if (!ok) {
+        qCritical() << "HistoryHelper: Cannot write the conversation to file" << tmpFilename;
+        QFile::remove(tmpFilename);
+        QFile::remove(tmpIndexFilename);
+        return;
+    }
+
+    delete m_convWriter;
+    m_convWriter = 0;
+
+    // The current file is kept until the new one atomically replaces it. The old index is
+    // removed first, so a crash never leaves it next to the new file. If the new index cannot
+    // be moved, it is rebuilt by the new writer.
+
+    QString indexFilename = Cmn::ConversationIndex::indexFilename(m_filename);
+    QFile::remove(indexFilename);
+
+    if (!Cmn::FileUtils::replaceFile(tmpFilename, m_filename)) {
+        qCritical() << "HistoryHelper: Cannot replace" << m_filename << "with" << tmpFilename;
+        QFile::remove(tmpFilename);
+        QFile::remove(tmpIndexFilename);
+    } else if (QFile::exists(tmpIndexFilename) &&
+               !Cmn::FileUtils::replaceFile(tmpIndexFilename, indexFilename)) {
+        QFile::remove(tmpIndexFilename);
+    }
+
+    load();
+
+    m_convWriter = newHistoryWriter(m_filename);
+}
+
+//--------------------------------------------------------------------------------------------------
+
 void Lvk::CA::HistoryHelper::resetHistoryLog()
 {
     m_conv.clear();
@@ -151,7 +479,8 @@ void Lvk::CA::HistoryHelper::resetHistoryLog()
     delete m_convWriter;
 
     QFile::remove(m_filename);
+    QFile::remove(Cmn::ConversationIndex::indexFilename(m_filename));
 
-    m_convWriter = new Cmn::ConversationWriter(m_filename);
+    m_convWriter = newHistoryWriter(m_filename);
 }
 
@@ -27,6 +27,9 @@
 
 class QFile;
 class QReadWriteLock;
+class QMutex;
+class QDate;
+class QDateTime;
 
 namespace Lvk
 {
@@ -53,6 +56,14 @@ namespace CA
  * Given a filename, the class loads the chat history. If the history does not
  * exits, it creates an empty one. All ChatHistory operations are persistent.
  *
+ * Only the most recent entries are kept in memory (see setWindowSize()). Older entries remain
+ * in the history file and can be queried by date, user or date-time range. Queries read the
+ * file as a stream, so memory usage does not depend on the size of the history.
+ *
+ * If the "History/BufferSize" setting is not zero, appended entries are written to the file in
+ * groups. history() always includes every appended entry. Call flush() periodically to write
+ * pending entries. Pending entries are also written on destruction.
+ *
  * This class is thread-safe.
  */
 class HistoryHelper
@@ -80,10 +91,47 @@ public:
     void append(const Cmn::Conversation::Entry &entry);
 
     /**
-     * Returns the full chat history for the current file.
+     * Writes appended entries that are still pending in memory to the history file
+     */
+    void flush();
+
+    /**
+     * Returns the most recent entries of the chat history for the current file. At most
+     * windowSize() entries are returned.
      */
     const Cmn::Conversation &history() const;
 
+    /**
+     * Returns the entries of the given \a date. If \a from is not empty, only returns the
+     * entries from that user. Entries are read from the history file.
+     */
+    Cmn::Conversation history(const QDate &date, const QString &from = QString()) const;
+
+    /**
+     * Returns the entries with date-time in the range [\a start, \a end). Null date-times
+     * are unbounded. Skips the first \a offset entries in the range and returns at most
+     * \a limit entries, or all if \a limit is negative. Entries are read from the history file.
+     */
+    Cmn::Conversation history(const QDateTime &start, const QDateTime &end, int offset = 0,
+                              int limit = -1) const;
+
+    /**
+     * Returns the date and user of every conversation in the history file, in order of first
+     * appearance.
+     */
+    Cmn::Conversation::DateContactList dateContacts() const;
+
+    /**
+     * Sets the maximum number of recent entries kept in memory. Zero means no limit.
+     * The default size is given by the "History/WindowSize" setting.
+     */
+    void setWindowSize(int size);
+
+    /**
+     * Returns the maximum number of recent entries kept in memory.
+     */
+    int windowSize() const;
+
     /**
      * Sets \a conv as the chat history for the current file.
      */
@@ -105,6 +153,11 @@ public:
      */
     void clear();
 
+    /**
+     * Removes the entries of the given \a date from the user \a from.
+     */
+    void remove(const QDate &date, const QString &from);
+
 private:
     HistoryHelper(HistoryHelper&);
     HistoryHelper& operator=(const HistoryHelper&);
@@ -113,9 +166,13 @@ private:
     Cmn::Conversation m_conv;
     Cmn::ConversationWriter *m_convWriter;
     QReadWriteLock *m_rwLock;
+    QMutex *m_commitMutex;
+    int m_windowSize;
 
     void load();
     void resetHistoryLog();
+    void trimWindow();
+    void commit() const;
 };
 
 /// @}
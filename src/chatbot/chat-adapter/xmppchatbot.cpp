@@ -24,6 +24,8 @@
 #include "common/settings.h"
 #include "common/settingskeys.h"
 #include "common/logger.h"
+#include "common/tracer.h"
+#include "common/metrics.h"
 
 #include "QXmppClient.h"
 #include "QXmppMessage.h"
@@ -37,11 +39,17 @@
 #include <QFile>
 #include <QMutex>
 #include <QMutexLocker>
+#include <QWaitCondition>
+#include <QThreadPool>
+#include <QRunnable>
 #include <QSslSocket>
 #include <QDateTime>
+#include <QTimer>
 
 #include <iostream>
 
+#define MAX_MESSAGES_PER_TASK   16
+
 //--------------------------------------------------------------------------------------------------
 // Helpers
 //--------------------------------------------------------------------------------------------------
@@ -49,6 +57,11 @@
 namespace
 {
 
+Lvk::Cmn::Gauge *g_queued = Lvk::Cmn::Metrics::gauge(
+        "chatbot_messages_queued", "Chat messages waiting for a worker");
+
+//--------------------------------------------------------------------------------------------------
+
 inline QString getBareJid(const QString &from)
 {
     return from.split("/").at(0);
@@ -71,6 +84,79 @@ inline QString normalizeDomain(const QString &domain)
 } // namespace
 
 
+//--------------------------------------------------------------------------------------------------
+// XmppChatbot::ResponseQueue
+//--------------------------------------------------------------------------------------------------
+
+// Queue state shared by the chatbot and its task. The task may still be unlocking the mutex when
+// the chatbot sees the task is done, so the state lives until the task releases it.
+struct Lvk::CA::XmppChatbot::ResponseQueue
+{
+    ResponseQueue() : running(false) { }
+
+    QMutex mutex;
+    QWaitCondition taskDone;
+    QHash<QString, QQueue<InboundMessage> > inbox;      // Only contacts with pending messages
+    QQueue<QString> contacts;                           // Contacts in the inbox, in turn order
+    QQueue<Reply> outbox;
+    bool running;                                       // A task is queued or running
+};
+
+//--------------------------------------------------------------------------------------------------
+// XmppChatbot::ResponseTask
+//--------------------------------------------------------------------------------------------------
+
+// Answers the queued messages of a chatbot in a worker thread. Contacts take turns, one message
+// each, so a chatty contact does not delay the others.
+class Lvk::CA::XmppChatbot::ResponseTask : public QRunnable
+{
+public:
+    ResponseTask(XmppChatbot *chatbot)
+        : m_chatbot(chatbot), m_queue(chatbot->m_queue) { }
+
+    virtual void run()
+    {
+        // The chatbot is not destroyed while running is set
+        for (int i = 0; ; ++i) {
+            InboundMessage msg;
+
+            {
+                QMutexLocker locker(&m_queue->mutex);
+
+                if (m_queue->contacts.isEmpty()) {
+                    m_queue->running = false;
+                    m_queue->taskDone.wakeAll();
+                    return;
+                }
+
+                if (i == MAX_MESSAGES_PER_TASK) {
+                    // Let the tasks of other chatbots run, continue at the end of the pool queue
+                    QThreadPool::globalInstance()->start(new ResponseTask(m_chatbot));
+                    return;
+                }
+
+                QString bareJid = m_queue->contacts.dequeue();
+                QQueue<InboundMessage> &queue = m_queue->inbox[bareJid];
+
+                msg = queue.dequeue();
+                g_queued->dec();
+
+                if (queue.isEmpty()) {
+                    m_queue->inbox.remove(bareJid);
+                } else {
+                    m_queue->contacts.enqueue(bareJid);
+                }
+            }
+
+            m_chatbot->processMessage(msg);
+        }
+    }
+
+private:
+    XmppChatbot *m_chatbot;
+    QSharedPointer<ResponseQueue> m_queue;
+};
+
 //--------------------------------------------------------------------------------------------------
 // XmppChatbot
 //--------------------------------------------------------------------------------------------------
@@ -83,9 +169,11 @@ Lvk::CA::XmppChatbot::XmppChatbot(const QString &/*chatbotId*/, QObject *parent)
       m_rosterMutex(new QMutex()),
       m_aiMutex(new QMutex(QMutex::Recursive)),
       m_isConnected(false),
-      m_rosterHasChanged(false)
+      m_rosterHasChanged(false),
+      m_queue(new ResponseQueue())
 {
     setupLogger();
+    setupHistoryFlush();
     connectSignals();
 }
 
@@ -97,6 +185,21 @@ Lvk::CA::XmppChatbot::~XmppChatbot()
         m_isConnected = false;
     }
 
+    // Pending messages are dropped but the running task uses the AI, wait for it
+    {
+        QMutexLocker locker(&m_queue->mutex);
+
+        foreach (const QQueue<InboundMessage> &queue, m_queue->inbox) {
+            g_queued->add(-queue.size());
+        }
+        m_queue->inbox.clear();
+        m_queue->contacts.clear();
+
+        while (m_queue->running) {
+            m_queue->taskDone.wait(&m_queue->mutex);
+        }
+    }
+
     delete m_aiMutex;
     delete m_rosterMutex;
     delete m_contactInfoMutex;
@@ -123,6 +226,24 @@ void Lvk::CA::XmppChatbot::setupLogger()
 
 //--------------------------------------------------------------------------------------------------
 
+void Lvk::CA::XmppChatbot::setupHistoryFlush()
+{
+    // Pending history entries are written at most FlushInterval ms after being appended
+    Cmn::Settings settings;
+    int bufferSize = settings.value(SETTING_HISTORY_BUFFER_SIZE).toInt();
+    int interval = settings.value(SETTING_HISTORY_FLUSH_INTERVAL).toInt();
+
+    m_historyFlushTimer = new QTimer(this);
+
+    connect(m_historyFlushTimer, SIGNAL(timeout()), SLOT(onHistoryFlushTimeout()));
+
+    if (bufferSize > 0) {
+        m_historyFlushTimer->start(qMax(interval, 1));
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+
 void Lvk::CA::XmppChatbot::connectSignals()
 {
     connect(m_xmppClient, SIGNAL(messageReceived(const QXmppMessage&)),
@@ -286,6 +407,8 @@ Lvk::CA::XmppChatbot::Error Lvk::CA::XmppChatbot::convertToLocalError(QXmppClien
 
 void Lvk::CA::XmppChatbot::onMessageReceived(const QXmppMessage& msg)
 {
+    TRACE_SPAN("xmpp.onMessageReceived");
+
     qDebug() << "XmppChatbot: Got message" << msg.body() << "from user" << msg.from()
              << "and type" << msg.type();
 
@@ -300,32 +423,97 @@ void Lvk::CA::XmppChatbot::onMessageReceived(const QXmppMessage& msg)
     QString bareJid = getBareJid(msg.from());
 
     if (!isInBlackList(bareJid)) {
-        ContactInfo info = getContactInfo(bareJid);
+        InboundMessage inbound;
+        inbound.from = msg.from();
+        inbound.body = msg.body();
+        inbound.info = getContactInfo(bareJid);
+
+        enqueueMessage(bareJid, inbound);
+    } else {
+        qDebug() << "XmppChatbot: Ignoring message" << msg.body() << "because user"
+                 << bareJid << "is in black list";
+    }
+}
 
-        Cmn::Conversation::Entry entry;
+//--------------------------------------------------------------------------------------------------
 
-        {
-            QMutexLocker locker(m_aiMutex);
+void Lvk::CA::XmppChatbot::enqueueMessage(const QString &bareJid, const InboundMessage &msg)
+{
+    QMutexLocker locker(&m_queue->mutex);
 
-            if (m_ai.get()) {
-               entry = m_ai->getEntry(msg.body(), info);
-            } else {
-                qCritical() << "XmppChatbot: No AI set";
-            }
+    QQueue<InboundMessage> &queue = m_queue->inbox[bareJid];
+
+    if (queue.isEmpty()) {
+        m_queue->contacts.enqueue(bareJid);
+    }
+
+    queue.enqueue(msg);
+    g_queued->inc();
+
+    // One task per chatbot, so a busy chatbot takes at most one worker of the pool
+    if (!m_queue->running) {
+        m_queue->running = true;
+        QThreadPool::globalInstance()->start(new ResponseTask(this));
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::CA::XmppChatbot::processMessage(const InboundMessage &msg)
+{
+    // Runs in a worker thread
+
+    TRACE_SPAN("xmpp.processMessage");
+
+    Cmn::Conversation::Entry entry;
+
+    {
+        QMutexLocker locker(m_aiMutex);
+
+        if (m_ai.get()) {
+           entry = m_ai->getEntry(msg.body, msg.info);
+        } else {
+            qCritical() << "XmppChatbot: No AI set";
         }
+    }
 
-        if (!entry.isNull()) {
-            if (!entry.response.isEmpty()) {
-                m_xmppClient->sendPacket(QXmppMessage("", msg.from(), entry.response));
-            }
+    if (!entry.isNull()) {
+        Reply reply;
+        reply.to = msg.from;
+        reply.entry = entry;
+
+        {
+            QMutexLocker locker(&m_queue->mutex);
+            m_queue->outbox.enqueue(reply);
+        }
+
+        QMetaObject::invokeMethod(this, "onRepliesReady", Qt::QueuedConnection);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::CA::XmppChatbot::onRepliesReady()
+{
+    QQueue<Reply> replies;
+
+    {
+        QMutexLocker locker(&m_queue->mutex);
+        qSwap(replies, m_queue->outbox);
+    }
 
-            m_history.append(entry);
+    // Replies of each contact were queued in order, so they are sent in order
+    while (!replies.isEmpty()) {
+        Reply reply = replies.dequeue();
 
-            emit newConversationEntry(entry);
+        if (!reply.entry.response.isEmpty()) {
+            TRACE_SPAN("xmpp.sendPacket");
+            m_xmppClient->sendPacket(QXmppMessage("", reply.to, reply.entry.response));
         }
-    } else {
-        qDebug() << "XmppChatbot: Ignoring message" << msg.body() << "because user"
-                 << bareJid << "is in black list";
+
+        m_history.append(reply.entry);
+
+        emit newConversationEntry(reply.entry);
     }
 }
 
@@ -451,6 +639,30 @@ const Lvk::Cmn::Conversation & Lvk::CA::XmppChatbot::chatHistory() const
 
 //--------------------------------------------------------------------------------------------------
 
+Lvk::Cmn::Conversation Lvk::CA::XmppChatbot::chatHistory(const QDate &date,
+                                                         const QString &from) const
+{
+    return m_history.history(date, from);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+Lvk::Cmn::Conversation Lvk::CA::XmppChatbot::chatHistory(const QDateTime &start,
+                                                         const QDateTime &end, int offset,
+                                                         int limit) const
+{
+    return m_history.history(start, end, offset, limit);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+Lvk::Cmn::Conversation::DateContactList Lvk::CA::XmppChatbot::chatHistoryContacts() const
+{
+    return m_history.dateContacts();
+}
+
+//--------------------------------------------------------------------------------------------------
+
 void Lvk::CA::XmppChatbot::setChatHistory(const Cmn::Conversation &conv)
 {
     m_history.setHistory(conv);
@@ -465,6 +677,13 @@ void Lvk::CA::XmppChatbot::clearHistory()
 
 //--------------------------------------------------------------------------------------------------
 
+void Lvk::CA::XmppChatbot::clearHistory(const QDate &date, const QString &from)
+{
+    m_history.remove(date, from);
+}
+
+//--------------------------------------------------------------------------------------------------
+
 void Lvk::CA::XmppChatbot::setHistoryFilename(const QString &filename)
 {
     m_history.setFilename(filename);
@@ -489,5 +708,12 @@ void Lvk::CA::XmppChatbot::onOnlineStateChanged(bool isOnline)
     }
 }
 
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::CA::XmppChatbot::onHistoryFlushTimeout()
+{
+    m_history.flush();
+}
+
 
 
@@ -24,6 +24,9 @@
 
 #include <QObject>
 #include <QHash>
+#include <QQueue>
+#include <QSet>
+#include <QSharedPointer>
 #include <QNetworkConfigurationManager>
 #include <memory>
 
@@ -35,7 +38,7 @@
 
 class QXmppVCardIq;
 class QMutex;
-class QWaitCondition;
+class QTimer;
 
 namespace Lvk
 {
@@ -56,6 +59,14 @@ class ContactInfo;
  * \brief The XmppChatbot class provides a chatbot for XMPP chat servers.
  *
  * XMPP is also known as Jabber.
+ *
+ * Responses are not computed in the thread that handles the connection. Inbound messages are
+ * queued per contact and processed by a task in QThreadPool::globalInstance(), so a slow
+ * match does not stall the connection and chatbots in the same process share the workers.
+ * Each chatbot has at most one task, so a busy chatbot cannot take every worker. The task
+ * answers contacts in turns and requeues itself every few messages so other chatbots can run.
+ * Replies are sent, stored in the history and emitted in the thread of the chatbot. Messages
+ * of the same contact are answered in the order they arrived.
  */
 
 class XmppChatbot : public Chatbot
@@ -151,6 +162,22 @@ public:
      */
     virtual const Cmn::Conversation &chatHistory() const;
 
+    /**
+     * \copydoc Chatbot::chatHistory(const QDate &, const QString &) const
+     */
+    virtual Cmn::Conversation chatHistory(const QDate &date, const QString &from) const;
+
+    /**
+     * \copydoc Chatbot::chatHistory(const QDateTime &, const QDateTime &, int, int) const
+     */
+    virtual Cmn::Conversation chatHistory(const QDateTime &start, const QDateTime &end,
+                                          int offset, int limit) const;
+
+    /**
+     * \copydoc Chatbot::chatHistoryContacts()
+     */
+    virtual Cmn::Conversation::DateContactList chatHistoryContacts() const;
+
     /**
      * \copydoc Chatbot::setChatHistory()
      */
@@ -161,6 +188,11 @@ public:
      */
     virtual void clearHistory();
 
+    /**
+     * \copydoc Chatbot::clearHistory(const QDate &, const QString &)
+     */
+    virtual void clearHistory(const QDate &date, const QString &from);
+
 signals:
 
     /**
@@ -200,10 +232,29 @@ protected:
 private slots:
     void emitLocalError(QXmppClient::Error);
     void onOnlineStateChanged(bool isOnline);
+    void onHistoryFlushTimeout();
+    void onRepliesReady();
+
 private:
     XmppChatbot(XmppChatbot&);
     XmppChatbot& operator=(XmppChatbot&);
 
+    class ResponseTask;
+    struct ResponseQueue;
+
+    struct InboundMessage
+    {
+        QString from;
+        QString body;
+        ContactInfo info;
+    };
+
+    struct Reply
+    {
+        QString to;
+        Cmn::Conversation::Entry entry;
+    };
+
     std::auto_ptr<ChatbotAI> m_ai;
     QHash<QString, QXmppVCardIq> m_vCards;
     QMutex *m_contactInfoMutex;
@@ -216,8 +267,11 @@ private:
     QSet<QString> m_blackListSet;
     uint m_connStartTime;
     QNetworkConfigurationManager m_netMgr;
+    QTimer *m_historyFlushTimer;
+    QSharedPointer<ResponseQueue> m_queue;              // Shared with the response task
 
     void setupLogger();
+    void setupHistoryFlush();
     void connectSignals();
     virtual void connectToServer(const QString &, const QString &) {}
 
@@ -229,6 +283,9 @@ private:
     Error convertToLocalError(QXmppClient::Error err);
 
     void rebuildLocalRoster() const;
+
+    void enqueueMessage(const QString &bareJid, const InboundMessage &msg);
+    void processMessage(const InboundMessage &msg);
 };
 
 /// @}
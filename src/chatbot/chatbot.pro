@@ -25,6 +25,7 @@ da_contest {
 # - freeling  : Enable freeling lemmatizer
 # - gelf_stats: Enable Graylog statistics on remote server
 # - openssl   : Enable cryptographic security with openssl
+# - tracing   : Compile the pipeline tracing spans. See common/tracer.h
 win32 {
     CONFIG  += qxmpp freeling
 } else:mac {
@@ -41,9 +42,15 @@ TRANSLATIONS += \
 
 HEADERS += \
     main/windowbootstrap.h \
+    main/replaytool.h \
+    main/metricsexporter.h \
+    main/bothost.h \
 
 SOURCES += \
     main/main.cpp \
+    main/replaytool.cpp \
+    main/metricsexporter.cpp \
+    main/bothost.cpp \
 
 include(common/common.pri)
 include(nlp-engine/nlp-engine.pri)
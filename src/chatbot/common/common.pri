@@ -11,22 +11,44 @@ HEADERS += \
     $$PROJECT_PATH/common/settingskeys.h \
     $$PROJECT_PATH/common/csvdocument.h \
     $$PROJECT_PATH/common/csvrow.h \
+    $$PROJECT_PATH/common/csvreader.h \
     $$PROJECT_PATH/common/globalstrings.h \
     $$PROJECT_PATH/common/conversation.h \
     $$PROJECT_PATH/common/conversationwriter.h \
     $$PROJECT_PATH/common/conversationreader.h \
+    $$PROJECT_PATH/common/conversationrecord.h \
+    $$PROJECT_PATH/common/conversationindex.h \
     $$PROJECT_PATH/common/logger.h \
+    $$PROJECT_PATH/common/logwriter.h \
     $$PROJECT_PATH/common/json.h \
     $$PROJECT_PATH/common/crashhandler.h \
+    $$PROJECT_PATH/common/latencyhistogram.h \
+    $$PROJECT_PATH/common/tracer.h \
+    $$PROJECT_PATH/common/metrics.h \
+    $$PROJECT_PATH/common/fileutils.h \
+    $$PROJECT_PATH/common/hash.h \
 
 SOURCES += \
     $$PROJECT_PATH/common/random.cpp \
     $$PROJECT_PATH/common/settings.cpp \
     $$PROJECT_PATH/common/csvdocument.cpp \
     $$PROJECT_PATH/common/csvrow.cpp \
+    $$PROJECT_PATH/common/csvreader.cpp \
     $$PROJECT_PATH/common/conversation.cpp \
     $$PROJECT_PATH/common/conversationwriter.cpp \
     $$PROJECT_PATH/common/conversationreader.cpp \
+    $$PROJECT_PATH/common/conversationrecord.cpp \
+    $$PROJECT_PATH/common/conversationindex.cpp \
     $$PROJECT_PATH/common/logger.cpp \
+    $$PROJECT_PATH/common/logwriter.cpp \
     $$PROJECT_PATH/common/json.cpp \
     $$PROJECT_PATH/common/crashhandler.cpp \
+    $$PROJECT_PATH/common/latencyhistogram.cpp \
+    $$PROJECT_PATH/common/tracer.cpp \
+    $$PROJECT_PATH/common/metrics.cpp \
+    $$PROJECT_PATH/common/fileutils.cpp \
+
+# Tracing spans are opt-in: qmake CONFIG+=tracing
+tracing {
+    DEFINES += ENABLE_TRACING
+}
@@ -26,6 +26,8 @@
 #include <QDateTime>
 #include <QString>
 #include <QList>
+#include <QPair>
+#include <QDate>
 
 namespace Lvk
 {
@@ -107,6 +109,17 @@ public:
         bool operator!=(const Entry &other) const;
     };
 
+    /**
+     * A date and the "from" entity of a conversation entry. Used to list conversations
+     * without loading their entries.
+     */
+    typedef QPair<QDate, QString> DateContact;
+
+    /**
+     * A list of DateContact
+     */
+    typedef QList<DateContact> DateContactList;
+
     /**
      * Sets the given entries to the conversation.
      */
@@ -0,0 +1,280 @@
+/*
+ * Copyright (C) 2012 Andres Pagliano, Gabriel Miretti, Gonzalo Buteler,
+ * Nestor Bustamante, Pablo Perez de Angelis
+ *
+ * This file is part of LVK Chatbot.
+ *
+ * LVK Chatbot is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LVK Chatbot is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LVK Chatbot.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/conversationindex.h"
+#include "common/conversationrecord.h"
+
+#include <QFile>
+#include <QHash>
+#include <QtEndian>
+#include <QtDebug>
+
+#define INDEX_EXTENSION     ".idx"
+#define INDEX_MAGIC         "LVKCIDX"   // Plus the null terminator, 8 bytes
+#define INDEX_MAGIC_SIZE    8
+#define ITEM_SIZE           16          // day (4) + from hash (4) + offset (8)
+
+//--------------------------------------------------------------------------------------------------
+// Helpers
+//--------------------------------------------------------------------------------------------------
+
+namespace
+{
+
+inline void writeItem(QByteArray &data, qint32 day, quint32 fromHash, qint64 offset)
+{
+    uchar buf[ITEM_SIZE];
+    qToBigEndian<qint32>(day, buf);
+    qToBigEndian<quint32>(fromHash, buf + 4);
+    qToBigEndian<qint64>(offset, buf + 8);
+    data.append(reinterpret_cast<const char *>(buf), ITEM_SIZE);
+}
+
+} // namespace
+
+
+//--------------------------------------------------------------------------------------------------
+// ConversationIndex
+//--------------------------------------------------------------------------------------------------
+
+Lvk::Cmn::ConversationIndex::ConversationIndex(const QString &logFilename)
+    : m_logFilename(logFilename), m_file(new QFile(indexFilename(logFilename))), m_logEnd(-1)
+{
+}
+
+//--------------------------------------------------------------------------------------------------
+
+Lvk::Cmn::ConversationIndex::~ConversationIndex()
+{
+    delete m_file;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+QString Lvk::Cmn::ConversationIndex::indexFilename(const QString &logFilename)
+{
+    return logFilename + INDEX_EXTENSION;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool Lvk::Cmn::ConversationIndex::load()
+{
+    m_items.clear();
+
+    QFile file(m_file->fileName());
+
+    if (file.open(QFile::ReadOnly)) {
+        QByteArray data = file.readAll();
+        file.close();
+
+        if (data.size() >= INDEX_MAGIC_SIZE &&
+                qstrncmp(data.constData(), INDEX_MAGIC, INDEX_MAGIC_SIZE) == 0) {
+            // Ignore a trailing partial item
+            int n = (data.size() - INDEX_MAGIC_SIZE)/ITEM_SIZE;
+            const uchar *p = reinterpret_cast<const uchar *>(data.constData()) + INDEX_MAGIC_SIZE;
+
+            m_items.resize(n);
+            for (int i = 0; i < n; ++i, p += ITEM_SIZE) {
+                m_items[i].day      = qFromBigEndian<qint32>(p);
+                m_items[i].fromHash = qFromBigEndian<quint32>(p + 4);
+                m_items[i].offset   = qFromBigEndian<qint64>(p + 8);
+            }
+        }
+    }
+
+    return coversLog();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool Lvk::Cmn::ConversationIndex::coversLog()
+{
+    m_logEnd = -1;
+
+    QFile log(m_logFilename);
+
+    if (!log.open(QFile::ReadOnly)) {
+        return m_items.isEmpty();
+    }
+
+    qint64 end = ConversationRecord::fileHeader().size();
+
+    // The index covers the log if the last indexed record is the last record of the log
+    if (!m_items.isEmpty()) {
+        Conversation::Entry entry;
+        if (!log.seek(m_items.last().offset) ||
+                ConversationRecord::read(&log, entry) != ConversationRecord::Ok) {
+            return false;
+        }
+        end = log.pos();
+    }
+
+    if (end < log.size()) {
+        return false;
+    }
+
+    m_logEnd = end;
+
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool Lvk::Cmn::ConversationIndex::rebuild()
+{
+    m_items.clear();
+    m_logEnd = -1;
+
+    QFile log(m_logFilename);
+
+    if (log.open(QFile::ReadOnly) && ConversationRecord::isBinary(&log)) {
+        log.seek(ConversationRecord::fileHeader().size());
+
+        Conversation::Entry entry;
+        qint64 offset = log.pos();
+
+        for (;;) {
+            ConversationRecord::Status status = ConversationRecord::read(&log, entry);
+
+            if (status != ConversationRecord::Ok) {
+                if (status == ConversationRecord::Corrupt) {
+                    qWarning() << "ConversationIndex: Corrupt record at offset" << offset
+                               << "of" << m_logFilename;
+                }
+                break;
+            }
+
+            Item item;
+            makeItem(item, entry, offset);
+            m_items.append(item);
+
+            offset = log.pos();
+        }
+
+        m_logEnd = offset;
+    }
+
+    if (!open(true)) {
+        return false;
+    }
+
+    QByteArray data;
+    data.reserve(m_items.size()*ITEM_SIZE);
+
+    foreach (const Item &item, m_items) {
+        writeItem(data, item.day, item.fromHash, item.offset);
+    }
+
+    return m_file->write(data) == data.size() && m_file->flush();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool Lvk::Cmn::ConversationIndex::open(bool truncate)
+{
+    m_file->close();
+
+    if (truncate) {
+        if (!m_file->open(QFile::WriteOnly | QFile::Truncate)) {
+            qCritical() << "ConversationIndex: Cannot open" << m_file->fileName();
+            return false;
+        }
+    } else {
+        if (!m_file->open(QFile::Append)) {
+            qCritical() << "ConversationIndex: Cannot open" << m_file->fileName();
+            return false;
+        }
+    }
+
+    if (m_file->size() == 0) {
+        m_file->write(INDEX_MAGIC, INDEX_MAGIC_SIZE);
+    }
+
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::Cmn::ConversationIndex::makeItem(Item &item, const Conversation::Entry &entry,
+                                           qint64 offset) const
+{
+    item.day = entry.dateTime.date().toJulianDay();
+    item.fromHash = qHash(entry.from);
+    item.offset = offset;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool Lvk::Cmn::ConversationIndex::append(const Conversation::Entry &entry, qint64 offset)
+{
+    if (!m_file->isOpen() && !open(false)) {
+        return false;
+    }
+
+    Item item;
+    makeItem(item, entry, offset);
+    m_items.append(item);
+
+    QByteArray data;
+    writeItem(data, item.day, item.fromHash, item.offset);
+
+    return m_file->write(data) == data.size();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool Lvk::Cmn::ConversationIndex::flush()
+{
+    return !m_file->isOpen() || m_file->flush();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+qint64 Lvk::Cmn::ConversationIndex::logEnd() const
+{
+    return m_logEnd;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+QList<qint64> Lvk::Cmn::ConversationIndex::find(const QDate &date, const QString &from) const
+{
+    QList<qint64> offsets;
+
+    qint32 day = date.toJulianDay();
+    quint32 fromHash = qHash(from);
+
+    foreach (const Item &item, m_items) {
+        if (item.day == day && (from.isEmpty() || item.fromHash == fromHash)) {
+            offsets.append(item.offset);
+        }
+    }
+
+    return offsets;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+int Lvk::Cmn::ConversationIndex::size() const
+{
+    return m_items.size();
+}
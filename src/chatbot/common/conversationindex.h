@@ -0,0 +1,152 @@
+/*
+ * Copyright (C) 2012 Andres Pagliano, Gabriel Miretti, Gonzalo Buteler,
+ * Nestor Bustamante, Pablo Perez de Angelis
+ *
+ * This file is part of LVK Chatbot.
+ *
+ * LVK Chatbot is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LVK Chatbot is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LVK Chatbot.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef LVK_CMN_CONVERSATIONINDEX_H
+#define LVK_CMN_CONVERSATIONINDEX_H
+
+#include "common/conversation.h"
+
+#include <QString>
+#include <QDate>
+#include <QList>
+#include <QVector>
+
+class QFile;
+
+namespace Lvk
+{
+
+/// \addtogroup Lvk
+/// @{
+
+namespace Cmn
+{
+
+/// \ingroup Lvk
+/// \addtogroup Cmn
+/// @{
+
+/**
+ * \brief The ConversationIndex class provides the sidecar index of a binary conversation log.
+ *
+ * For each record of the log, the index stores the day of the entry, a hash of the "from" user
+ * and the offset of the record. The index is append-only as well and it is small enough to be
+ * kept in memory, so the records of a given day or user-day can be read by seeking directly to
+ * them.
+ *
+ * The index file is named after the log file plus ".idx". If it is missing or it does not cover
+ * the whole log, it can be rebuilt with rebuild().
+ *
+ * \see ConversationRecord, ConversationReader, ConversationWriter
+ */
+class ConversationIndex
+{
+public:
+
+    /**
+     * Constructs an index for the binary conversation log \a logFilename
+     */
+    explicit ConversationIndex(const QString &logFilename);
+
+    /**
+     * Destroys the object
+     */
+    ~ConversationIndex();
+
+    /**
+     * Returns the filename of the index of \a logFilename
+     */
+    static QString indexFilename(const QString &logFilename);
+
+    /**
+     * Loads the index file. The index file is not modified.
+     * Returns true if the index covers the whole log. Otherwise; returns false and the index
+     * must be rebuilt before using it.
+     */
+    bool load();
+
+    /**
+     * Rebuilds the index scanning the whole log. Returns true on success. Otherwise; returns
+     * false.
+     */
+    bool rebuild();
+
+    /**
+     * Appends the \a entry written at \a offset of the log. Returns true on success.
+     * Otherwise; returns false.
+     */
+    bool append(const Conversation::Entry &entry, qint64 offset);
+
+    /**
+     * Flushes appended items to the index file. Returns true on success. Otherwise; returns false.
+     */
+    bool flush();
+
+    /**
+     * Returns the offsets of the records of the given \a date. If \a from is not empty, only
+     * returns records of that user. Users are compared by hash, so callers must check the
+     * "from" field of the records read.
+     */
+    QList<qint64> find(const QDate &date, const QString &from = QString()) const;
+
+    /**
+     * Returns the amount of indexed records
+     */
+    int size() const;
+
+    /**
+     * Returns the offset where the last good record of the log ends, as found by load() or
+     * rebuild(). Bytes after it belong to a torn or corrupt record. Returns -1 if the log
+     * could not be read.
+     */
+    qint64 logEnd() const;
+
+private:
+    ConversationIndex(const ConversationIndex&);
+    ConversationIndex& operator=(const ConversationIndex&);
+
+    struct Item
+    {
+        qint32 day;
+        quint32 fromHash;
+        qint64 offset;
+    };
+
+    QString m_logFilename;
+    QFile *m_file;
+    QVector<Item> m_items;
+    qint64 m_logEnd;
+
+    bool open(bool truncate);
+    bool coversLog();
+    void makeItem(Item &item, const Conversation::Entry &entry, qint64 offset) const;
+};
+
+/// @}
+
+} // namespace Cmn
+
+/// @}
+
+} // namespace Lvk
+
+
+#endif // LVK_CMN_CONVERSATIONINDEX_H
@@ -21,11 +21,14 @@
 
 #include "common/conversationreader.h"
 #include "common/csvrow.h"
-#include "common/csvdocument.h"
+#include "common/csvreader.h"
+#include "common/conversationrecord.h"
+#include "common/conversationindex.h"
 #include "common/globalstrings.h"
 
 #include <QIODevice>
 #include <QFile>
+#include <QDate>
 #include <QtDebug>
 
 //--------------------------------------------------------------------------------------------------
@@ -52,22 +55,6 @@ void makeEntry(Lvk::Cmn::Conversation::Entry & entry, const Lvk::Cmn::CsvRow & r
     }
 }
 
-//--------------------------------------------------------------------------------------------------
-
-void makeConversation(Lvk::Cmn::Conversation & conv, const Lvk::Cmn::CsvDocument & doc)
-{
-    conv.clear();
-
-    Lvk::Cmn::Conversation::Entry entry;
-
-    foreach (const Lvk::Cmn::CsvRow &row, doc.rows()) {
-        makeEntry(entry, row);
-        if (!entry.isNull()) {
-            conv.append(entry);
-        }
-    }
-}
-
 } // namespace
 
 //--------------------------------------------------------------------------------------------------
@@ -75,38 +62,45 @@ void makeConversation(Lvk::Cmn::Conversation & conv, const Lvk::Cmn::CsvDocument
 //--------------------------------------------------------------------------------------------------
 
 Lvk::Cmn::ConversationReader::ConversationReader()
-    : m_device(0)
+    : m_device(0), m_csvReader(0), m_binary(false)
 {
 }
 
 //--------------------------------------------------------------------------------------------------
 
 Lvk::Cmn::ConversationReader::ConversationReader(const QString &filename)
-    : m_device(new QFile(filename))
+    : m_device(new QFile(filename)), m_filename(filename), m_csvReader(0), m_binary(false)
 {
     qDebug() << "ConversationReader: Opening" << filename;
 
     if (!m_device->open(QIODevice::ReadOnly)) {
         qCritical() << "ConversationReader: Cannot open" << filename << "with write permissions";
     }
+
+    m_csvReader = new Cmn::CsvReader(m_device);
+    m_binary = ConversationRecord::isBinary(m_device);
 }
 
 //--------------------------------------------------------------------------------------------------
 
 Lvk::Cmn::ConversationReader::ConversationReader(QIODevice *device)
-    : m_device(device)
+    : m_device(device), m_csvReader(0), m_binary(false)
 {
     if (!m_device->isOpen()) {
         if (!m_device->open(QIODevice::ReadOnly)) {
             qCritical() << "ConversationReader: Cannot open IO device with write permissions";
         }
     }
+
+    m_csvReader = new Cmn::CsvReader(m_device);
+    m_binary = ConversationRecord::isBinary(m_device);
 }
 
 //--------------------------------------------------------------------------------------------------
 
 Lvk::Cmn::ConversationReader::~ConversationReader()
 {
+    delete m_csvReader;
     delete m_device;
 }
 
@@ -118,11 +112,24 @@ bool Lvk::Cmn::ConversationReader::read(Lvk::Cmn::Conversation *conv)
         return false;
     }
 
-    // TODO use readLine()
-    QString data = QString::fromUtf8(m_device->readAll().constData());
+    conv->clear();
+
+    Cmn::CsvRow row;
+    Cmn::Conversation::Entry entry;
+
+    if (m_binary) {
+        while (read(&entry)) {
+            conv->append(entry);
+        }
+        return true;
+    }
 
-    Cmn::CsvDocument doc(data);
-    makeConversation(*conv, doc);
+    while (m_csvReader->readRow(row)) {
+        makeEntry(entry, row);
+        if (!entry.isNull()) {
+            conv->append(entry);
+        }
+    }
 
     return true;
 }
@@ -135,20 +142,90 @@ bool Lvk::Cmn::ConversationReader::read(Conversation::Entry *entry)
         return false;
     }
 
-    char buf[10*1024];
-    qint64 len = m_device->readLine(buf, sizeof(buf));
+    if (m_binary) {
+        ConversationRecord::Status status = ConversationRecord::read(m_device, *entry);
+
+        if (status == ConversationRecord::Corrupt) {
+            qWarning() << "ConversationReader: Corrupt record at offset" << m_device->pos()
+                       << ". Ignoring the rest of the conversation";
+            m_device->seek(m_device->size());
+        }
+
+        return status == ConversationRecord::Ok;
+    }
+
+    Cmn::CsvRow row;
 
-    if (len != -1) {
-        Cmn::CsvRow row(QString::fromUtf8(buf));
-        makeEntry(*entry, row);
+    if (!m_csvReader->readRow(row)) {
+        return false;
     }
 
-    return len != -1;
+    makeEntry(*entry, row);
+
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool Lvk::Cmn::ConversationReader::read(Conversation *conv, const QDate &date,
+                                        const QString &from)
+{
+    if (!m_device) {
+        return false;
+    }
+
+    conv->clear();
+
+    if (m_binary && !m_filename.isEmpty() && readIndexed(conv, date, from)) {
+        return true;
+    }
+
+    Conversation::Entry entry;
+
+    while (read(&entry)) {
+        if (!entry.isNull() && entry.dateTime.date() == date &&
+                (from.isEmpty() || entry.from == from)) {
+            conv->append(entry);
+        }
+    }
+
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool Lvk::Cmn::ConversationReader::readIndexed(Conversation *conv, const QDate &date,
+                                               const QString &from)
+{
+    ConversationIndex index(m_filename);
+
+    if (!index.load()) {
+        return false;
+    }
+
+    Conversation::Entry entry;
+
+    foreach (qint64 offset, index.find(date, from)) {
+        if (!m_device->seek(offset) ||
+                ConversationRecord::read(m_device, entry) != ConversationRecord::Ok) {
+            conv->clear();
+            return false;
+        }
+
+        // The index compares users by hash
+        if (from.isEmpty() || entry.from == from) {
+            conv->append(entry);
+        }
+    }
+
+    m_device->seek(m_device->size());
+
+    return true;
 }
 
 //--------------------------------------------------------------------------------------------------
 
 bool Lvk::Cmn::ConversationReader::atEnd()
 {
-    return !m_device || m_device->atEnd();
+    return !m_device || (m_binary ? m_device->atEnd() : m_csvReader->atEnd());
 }
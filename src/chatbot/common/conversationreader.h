@@ -24,8 +24,10 @@
 
 #include "common/conversation.h"
 
+#include <QString>
+
 class QIODevice;
-class QString;
+class QDate;
 
 namespace Lvk
 {
@@ -40,10 +42,16 @@ namespace Cmn
 /// \addtogroup Cmn
 /// @{
 
+class CsvReader;
+
 /**
  * \brief The ConversationReader class provides a format independent interface for reading
  *        chat conversations from files or other devices.
  *
+ * Conversations are read as a stream, one entry at a time, so reading large files does not
+ * require loading them in memory. Both CSV and binary conversation logs are supported. The format
+ * is detected automatically.
+ *
  * To write a conversation see ConversationWriter class.
  */
 
@@ -84,6 +92,16 @@ public:
      */
     bool read(Conversation::Entry *entry);
 
+    /**
+     * Reads the entries of the given \a date into \a conv. If \a from is not empty, only reads
+     * the entries from that user. The given pointer must be initialized.
+     *
+     * If the reader was constructed with a file name in the binary format and the file has an
+     * up-to-date index, only the matching records are read. Otherwise, all entries are read and
+     * filtered. Returns true on success; otherwise, returns false.
+     */
+    bool read(Conversation *conv, const QDate &date, const QString &from = QString());
+
     /**
      * Returns true if the current read position is at the end of the device
      * (i.e. there is no more data available for reading on the device); otherwise returns false.
@@ -95,6 +113,11 @@ private:
     ConversationReader& operator=(const ConversationReader&);
 
     QIODevice *m_device;
+    QString m_filename;
+    CsvReader *m_csvReader;
+    bool m_binary;
+
+    bool readIndexed(Conversation *conv, const QDate &date, const QString &from);
 };
 
 /// @}
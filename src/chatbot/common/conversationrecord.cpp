@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) 2012 Andres Pagliano, Gabriel Miretti, Gonzalo Buteler,
+ * Nestor Bustamante, Pablo Perez de Angelis
+ *
+ * This file is part of LVK Chatbot.
+ *
+ * LVK Chatbot is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LVK Chatbot is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LVK Chatbot.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/conversationrecord.h"
+
+#include <QIODevice>
+#include <QDataStream>
+#include <QtEndian>
+
+#define FILE_MAGIC          "LVKCONV"   // Plus the null terminator, 8 bytes
+#define FILE_MAGIC_SIZE     8
+#define FILE_VERSION        1
+#define FILE_HEADER_SIZE    (FILE_MAGIC_SIZE + 4)
+
+#define RECORD_HEADER_SIZE  6           // Payload length (4) + checksum (2)
+#define MAX_PAYLOAD_SIZE    (16*1024*1024)
+
+#define STREAM_VERSION      QDataStream::Qt_4_6
+
+//--------------------------------------------------------------------------------------------------
+// ConversationRecord
+//--------------------------------------------------------------------------------------------------
+
+QByteArray Lvk::Cmn::ConversationRecord::fileHeader()
+{
+    QByteArray header(FILE_MAGIC, FILE_MAGIC_SIZE);
+
+    uchar version[4];
+    qToBigEndian<quint32>(FILE_VERSION, version);
+    header.append(reinterpret_cast<const char *>(version), 4);
+
+    return header;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool Lvk::Cmn::ConversationRecord::isBinary(const QByteArray &data)
+{
+    return data.size() >= FILE_MAGIC_SIZE &&
+            qstrncmp(data.constData(), FILE_MAGIC, FILE_MAGIC_SIZE) == 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool Lvk::Cmn::ConversationRecord::isBinary(QIODevice *device)
+{
+    return device && device->isReadable() && isBinary(device->peek(FILE_HEADER_SIZE));
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::Cmn::ConversationRecord::encode(const Conversation::Entry &entry, QByteArray &data)
+{
+    int start = data.size();
+
+    data.resize(start + RECORD_HEADER_SIZE);
+
+    {
+        QDataStream stream(&data, QIODevice::WriteOnly | QIODevice::Append);
+        stream.setVersion(STREAM_VERSION);
+        stream << entry.dateTime << entry.from << entry.to << entry.msg << entry.response
+               << static_cast<quint8>(entry.match) << static_cast<quint64>(entry.ruleId);
+    }
+
+    const char *payload = data.constData() + start + RECORD_HEADER_SIZE;
+    quint32 size = data.size() - start - RECORD_HEADER_SIZE;
+    quint16 checksum = qChecksum(payload, size);
+
+    uchar *header = reinterpret_cast<uchar *>(data.data() + start);
+    qToBigEndian<quint32>(size, header);
+    qToBigEndian<quint16>(checksum, header + 4);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+Lvk::Cmn::ConversationRecord::Status
+Lvk::Cmn::ConversationRecord::read(QIODevice *device, Conversation::Entry &entry)
+{
+    entry.clear();
+
+    if (device->pos() == 0 && isBinary(device)) {
+        device->read(FILE_HEADER_SIZE);
+    }
+
+    QByteArray header = device->read(RECORD_HEADER_SIZE);
+
+    if (header.isEmpty()) {
+        return End;
+    }
+    if (header.size() < RECORD_HEADER_SIZE) {
+        return Corrupt;
+    }
+
+    const uchar *h = reinterpret_cast<const uchar *>(header.constData());
+    quint32 size = qFromBigEndian<quint32>(h);
+    quint16 checksum = qFromBigEndian<quint16>(h + 4);
+
+    if (size > MAX_PAYLOAD_SIZE) {
+        return Corrupt;
+    }
+
+    QByteArray payload = device->read(size);
+
+    if (static_cast<quint32>(payload.size()) != size ||
+            qChecksum(payload.constData(), size) != checksum) {
+        return Corrupt;
+    }
+
+    QDataStream stream(payload);
+    stream.setVersion(STREAM_VERSION);
+
+    quint8 match = 0;
+    quint64 ruleId = 0;
+
+    stream >> entry.dateTime >> entry.from >> entry.to >> entry.msg >> entry.response
+           >> match >> ruleId;
+
+    if (stream.status() != QDataStream::Ok) {
+        entry.clear();
+        return Corrupt;
+    }
+
+    entry.match = match != 0;
+    entry.ruleId = ruleId;
+
+    return Ok;
+}
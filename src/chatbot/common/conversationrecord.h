@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2012 Andres Pagliano, Gabriel Miretti, Gonzalo Buteler,
+ * Nestor Bustamante, Pablo Perez de Angelis
+ *
+ * This file is part of LVK Chatbot.
+ *
+ * LVK Chatbot is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LVK Chatbot is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LVK Chatbot.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef LVK_CMN_CONVERSATIONRECORD_H
+#define LVK_CMN_CONVERSATIONRECORD_H
+
+#include "common/conversation.h"
+
+#include <QByteArray>
+
+class QIODevice;
+
+namespace Lvk
+{
+
+/// \addtogroup Lvk
+/// @{
+
+namespace Cmn
+{
+
+/// \ingroup Lvk
+/// \addtogroup Cmn
+/// @{
+
+/**
+ * \brief The ConversationRecord class encodes and decodes conversation entries in the binary
+ *        conversation log format.
+ *
+ * A binary conversation log starts with an 8-byte magic string followed by a 32-bit version.
+ * Then it has a sequence of records. Each record is a 32-bit payload length, a 16-bit checksum
+ * of the payload and the payload, that is, the entry serialized with QDataStream. All integers
+ * are big-endian.
+ *
+ * Records are only appended. A record that was partially written (for instance, because of a
+ * crash) is detected by its length or checksum and it is reported as Corrupt.
+ *
+ * \see ConversationWriter, ConversationReader, ConversationIndex
+ */
+class ConversationRecord
+{
+public:
+
+    /**
+     * Status of a read operation
+     */
+    enum Status
+    {
+        Ok,         ///< The record was successfully read
+        End,        ///< There are no more records
+        Corrupt     ///< The record is truncated or its checksum does not match
+    };
+
+    /**
+     * Returns the file header of binary conversation logs
+     */
+    static QByteArray fileHeader();
+
+    /**
+     * Returns true if \a data starts with the binary conversation log header. Otherwise;
+     * returns false.
+     */
+    static bool isBinary(const QByteArray &data);
+
+    /**
+     * Returns true if the device starts with the binary conversation log header. The read
+     * position of the device is not modified.
+     */
+    static bool isBinary(QIODevice *device);
+
+    /**
+     * Encodes \a entry as a record and appends it to \a data
+     */
+    static void encode(const Conversation::Entry &entry, QByteArray &data);
+
+    /**
+     * Reads the record at the current position of \a device into \a entry
+     */
+    static Status read(QIODevice *device, Conversation::Entry &entry);
+
+private:
+    ConversationRecord();
+    ConversationRecord(ConversationRecord&);
+};
+
+/// @}
+
+} // namespace Cmn
+
+/// @}
+
+} // namespace Lvk
+
+
+#endif // LVK_CMN_CONVERSATIONRECORD_H
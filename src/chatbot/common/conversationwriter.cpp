@@ -22,7 +22,10 @@
 #include "common/conversationwriter.h"
 #include "common/csvrow.h"
 #include "common/csvdocument.h"
+#include "common/conversationrecord.h"
+#include "common/conversationindex.h"
 #include "common/globalstrings.h"
+#include "common/fileutils.h"
 
 #include <QIODevice>
 #include <QFile>
@@ -80,21 +83,42 @@ void makeCsvDoc(Lvk::Cmn::CsvDocument & doc, const Lvk::Cmn::Conversation & conv
 //--------------------------------------------------------------------------------------------------
 
 Lvk::Cmn::ConversationWriter::ConversationWriter()
-    : m_device(0), m_init(false)
+    : m_device(0), m_format(CsvFormat), m_index(0), m_init(false),
+      m_maxBufferSize(0), m_maxDelay(0), m_syncPolicy(NoSync)
 {
 }
 
 //--------------------------------------------------------------------------------------------------
 
 Lvk::Cmn::ConversationWriter::ConversationWriter(const QString &filename)
-    : m_device(new QFile(filename)), m_init(false)
+    : m_device(new QFile(filename)), m_filename(filename), m_format(CsvFormat), m_index(0),
+      m_init(false),
+      m_maxBufferSize(0), m_maxDelay(0), m_syncPolicy(NoSync)
+{
+}
+
+//--------------------------------------------------------------------------------------------------
+
+Lvk::Cmn::ConversationWriter::ConversationWriter(const QString &filename, Format format)
+    : m_device(new QFile(filename)), m_filename(filename), m_format(format), m_index(0),
+      m_init(false),
+      m_maxBufferSize(0), m_maxDelay(0), m_syncPolicy(NoSync)
 {
 }
 
 //--------------------------------------------------------------------------------------------------
 
 Lvk::Cmn::ConversationWriter::ConversationWriter(QIODevice *device)
-    : m_device(device), m_init(false)
+    : m_device(device), m_format(CsvFormat), m_index(0), m_init(false),
+      m_maxBufferSize(0), m_maxDelay(0), m_syncPolicy(NoSync)
+{
+}
+
+//--------------------------------------------------------------------------------------------------
+
+Lvk::Cmn::ConversationWriter::ConversationWriter(QIODevice *device, Format format)
+    : m_device(device), m_format(format), m_index(0), m_init(false),
+      m_maxBufferSize(0), m_maxDelay(0), m_syncPolicy(NoSync)
 {
 }
 
@@ -102,6 +126,11 @@ Lvk::Cmn::ConversationWriter::ConversationWriter(QIODevice *device)
 
 Lvk::Cmn::ConversationWriter::~ConversationWriter()
 {
+    if (m_init && !commit()) {
+        qCritical() << "ConversationWriter: Cannot commit pending entries";
+    }
+
+    delete m_index;
     delete m_device;
 }
 
@@ -113,10 +142,21 @@ bool Lvk::Cmn::ConversationWriter::write(const Lvk::Cmn::Conversation &conv)
         return false;
     }
 
+    if (m_format == BinaryFormat) {
+        foreach (const Conversation::Entry &entry, conv.entries()) {
+            if (!entry.isNull() && !writeBinary(entry)) {
+                return false;
+            }
+        }
+        return commit();
+    }
+
     Cmn::CsvDocument doc;
     makeCsvDoc(doc, conv);
 
-    return writeln(doc.toString().toUtf8()) && flush();
+    writeln(doc.toString().toUtf8());
+
+    return commit();
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -127,10 +167,16 @@ bool Lvk::Cmn::ConversationWriter::write(const Conversation::Entry &entry)
         return false;
     }
 
+    if (m_format == BinaryFormat) {
+        return writeBinary(entry) && commitIfNeeded();
+    }
+
     Cmn::CsvRow row;
     makeCsvRow(row, entry);
 
-    return writeln(row.toString().toUtf8()) && flush();
+    writeln(row.toString().toUtf8());
+
+    return commitIfNeeded();
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -142,12 +188,83 @@ bool Lvk::Cmn::ConversationWriter::atEnd()
 
 //--------------------------------------------------------------------------------------------------
 
+Lvk::Cmn::ConversationWriter::Format Lvk::Cmn::ConversationWriter::format() const
+{
+    return m_format;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::Cmn::ConversationWriter::setGroupCommit(int maxBufferSize, int maxDelay)
+{
+    m_maxBufferSize = qMax(0, maxBufferSize);
+    m_maxDelay = qMax(0, maxDelay);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::Cmn::ConversationWriter::setSyncPolicy(SyncPolicy policy)
+{
+    m_syncPolicy = policy;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool Lvk::Cmn::ConversationWriter::commit()
+{
+    if (!m_device || !m_init) {
+        return true; // nothing written yet
+    }
+
+    bool ok = true;
+
+    if (!m_buffer.isEmpty()) {
+        ok = m_device->write(m_buffer) == m_buffer.size();
+        m_buffer.clear();
+    }
+
+    ok = flush() && ok;
+
+    if (m_syncPolicy == SyncOnCommit) {
+        QFile *file = dynamic_cast<QFile *>(m_device);
+        ok = (!file || Cmn::FileUtils::syncFile(file)) && ok;
+    }
+
+    return ok;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+inline bool Lvk::Cmn::ConversationWriter::commitIfNeeded()
+{
+    if (m_maxBufferSize == 0 || m_buffer.size() >= m_maxBufferSize ||
+            (!m_buffer.isEmpty() && m_bufferAge.elapsed() >= m_maxDelay)) {
+        return commit();
+    }
+
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+
 inline bool Lvk::Cmn::ConversationWriter::init()
 {
     if (!m_init) {
         if (m_device) {
+            // Keep the format of existing files
+            if (!m_filename.isEmpty()) {
+                QFile file(m_filename);
+                if (file.open(QFile::ReadOnly) && file.size() > 0) {
+                    m_format = ConversationRecord::isBinary(&file) ? BinaryFormat : CsvFormat;
+                }
+            }
+
             if (m_device->isOpen() || m_device->open(QIODevice::Append)) {
                 m_init = true;
+
+                if (m_format == BinaryFormat) {
+                    initBinary();
+                }
             } else {
                 qCritical() << "ConversationWriter: Cannot open IO device with append permissions";
             }
@@ -159,12 +276,62 @@ inline bool Lvk::Cmn::ConversationWriter::init()
 
 //--------------------------------------------------------------------------------------------------
 
-inline bool Lvk::Cmn::ConversationWriter::writeln(const QByteArray &data)
+void Lvk::Cmn::ConversationWriter::initBinary()
+{
+    if (m_device->size() == 0) {
+        m_device->write(ConversationRecord::fileHeader());
+        flush();
+    }
+
+    if (!m_filename.isEmpty()) {
+        m_index = new ConversationIndex(m_filename);
+
+        if (!m_index->load()) {
+            qWarning() << "ConversationWriter: Rebuilding index of" << m_filename;
+            m_index->rebuild();
+        }
+
+        // Readers stop at the first bad record, records appended after a torn tail would be lost
+        qint64 end = m_index->logEnd();
+        QFile *file = dynamic_cast<QFile *>(m_device);
+
+        if (file && end >= 0 && end < file->size()) {
+            qWarning() << "ConversationWriter: Discarding" << file->size() - end
+                       << "bytes of incomplete records at the end of" << m_filename;
+
+            if (!file->resize(end)) {
+                qCritical() << "ConversationWriter: Cannot truncate" << m_filename;
+            }
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool Lvk::Cmn::ConversationWriter::writeBinary(const Conversation::Entry &entry)
 {
-    if (data.isEmpty()) {
-        return true;
-    } else {
-        return m_device->write(data) != -1 && m_device->write("\n") != -1;
+    if (m_buffer.isEmpty()) {
+        m_bufferAge.start();
+    }
+
+    qint64 offset = m_device->pos() + m_buffer.size();
+
+    ConversationRecord::encode(entry, m_buffer);
+
+    return !m_index || m_index->append(entry, offset);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+inline void Lvk::Cmn::ConversationWriter::writeln(const QByteArray &data)
+{
+    if (!data.isEmpty()) {
+        if (m_buffer.isEmpty()) {
+            m_bufferAge.start();
+        }
+
+        m_buffer.append(data);
+        m_buffer.append('\n');
     }
 }
 
@@ -176,7 +343,10 @@ inline bool Lvk::Cmn::ConversationWriter::flush()
 
     QFile *file = dynamic_cast<QFile *>(m_device);
 
-    return file ? file->flush() : true;
+    // Flush the log first so the index never points past the end of the log
+    bool ok = file ? file->flush() : true;
+
+    return m_index ? m_index->flush() && ok : ok;
 }
 
 
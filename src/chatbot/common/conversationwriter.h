@@ -24,6 +24,11 @@
 
 #include "common/conversation.h"
 
+#include <QByteArray>
+#include <QElapsedTimer>
+
+#include <QString>
+
 class QIODevice;
 class QString;
 class QByteArray;
@@ -41,6 +46,8 @@ namespace Cmn
 /// \addtogroup Cmn
 /// @{
 
+class ConversationIndex;
+
 /**
  * \brief The ConversationWriter class provides a format independent interface for writing chat
  *        conversations to files or other devices.
@@ -49,6 +56,15 @@ namespace Cmn
  * conversations to files or other devices. By default the device or file is opened in append mode.
  * To not use default append mode you must provide a device already opened with the desired flags.
  *
+ * Conversations can be written as CSV text or in the binary conversation log format (see
+ * ConversationRecord). When writing to a file in the binary format, the writer also keeps the
+ * sidecar index of the file (see ConversationIndex). If the file already has entries, the
+ * format of the file is used regardless of the requested format.
+ *
+ * By default every entry is written and flushed immediately. With setGroupCommit() entries are
+ * buffered in memory and written together when the buffer is full, when the oldest buffered entry
+ * is too old or when commit() is called. The destructor always commits pending entries.
+ *
  * To read a conversation see the ConversationReader class.
  */
 
@@ -56,6 +72,24 @@ class ConversationWriter
 {
 public:
 
+    /**
+     * Conversation formats
+     */
+    enum Format
+    {
+        CsvFormat,          ///< CSV text, one entry per line
+        BinaryFormat        ///< Binary conversation log
+    };
+
+    /**
+     * Sync policies
+     */
+    enum SyncPolicy
+    {
+        NoSync,             ///< Leave the data in the OS cache after each commit
+        SyncOnCommit        ///< Force the data to disk after each commit
+    };
+
     /**
      * Constructs an empty ConversationWriter object.
      */
@@ -72,6 +106,18 @@ public:
      */
     ConversationWriter(const QString & filename);
 
+    /**
+     * Constructs a ConversationWriter object that will write to a file with the given name
+     * using \a format. If the file already has entries, its format is used.
+     */
+    ConversationWriter(const QString & filename, Format format);
+
+    /**
+     * Constructs a ConversationWriter object using the given device and \a format.
+     * After construction class owns the pointer.
+     */
+    ConversationWriter(QIODevice * device, Format format);
+
     /**
      * Destructs the ConversationWriter object and frees the device if was given any.
      */
@@ -95,15 +141,50 @@ public:
      */
     bool atEnd();
 
+    /**
+     * Returns the format used to write
+     */
+    Format format() const;
+
+    /**
+     * Enables group commit. Entries are buffered until there are at least \a maxBufferSize bytes
+     * pending or the oldest pending entry was written \a maxDelay milliseconds ago. Delays are
+     * only checked on write, so callers should also call commit() periodically. If
+     * \a maxBufferSize is zero, group commit is disabled and each entry is committed on write.
+     */
+    void setGroupCommit(int maxBufferSize, int maxDelay);
+
+    /**
+     * Sets the sync \a policy used on commit. The default policy is NoSync.
+     */
+    void setSyncPolicy(SyncPolicy policy);
+
+    /**
+     * Writes pending entries to the device and flushes it according to the sync policy.
+     * Returns true on success; otherwise returns false.
+     */
+    bool commit();
+
 private:
     ConversationWriter(const ConversationWriter&);
     ConversationWriter& operator=(const ConversationWriter&);
 
     QIODevice *m_device;
+    QString m_filename;
+    Format m_format;
+    ConversationIndex *m_index;
     bool m_init;
+    QByteArray m_buffer;
+    QElapsedTimer m_bufferAge;
+    int m_maxBufferSize;
+    int m_maxDelay;
+    SyncPolicy m_syncPolicy;
 
     inline bool init();
-    inline bool writeln(const QByteArray &data);
+    void initBinary();
+    bool writeBinary(const Conversation::Entry &entry);
+    inline void writeln(const QByteArray &data);
+    inline bool commitIfNeeded();
     inline bool flush();
 };
 
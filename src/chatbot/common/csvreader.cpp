@@ -0,0 +1,182 @@
+/*
+ * Copyright (C) 2012 Andres Pagliano, Gabriel Miretti, Gonzalo Buteler,
+ * Nestor Bustamante, Pablo Perez de Angelis
+ *
+ * This file is part of LVK Chatbot.
+ *
+ * LVK Chatbot is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LVK Chatbot is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LVK Chatbot.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/csvreader.h"
+#include "common/csvrow.h"
+
+#include <QIODevice>
+#include <QString>
+
+#define QUOTE   '"'
+#define COMMA   ','
+#define EOL     '\n'
+#define CR      '\r'
+
+//--------------------------------------------------------------------------------------------------
+// Helpers
+//--------------------------------------------------------------------------------------------------
+
+namespace
+{
+
+inline bool isAllSpace(const char *begin, const char *end)
+{
+    for (const char *p = begin; p != end; ++p) {
+        if (*p != ' ' && *p != '\t' && *p != CR) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+
+//--------------------------------------------------------------------------------------------------
+// CsvReader
+//--------------------------------------------------------------------------------------------------
+
+Lvk::Cmn::CsvReader::CsvReader(QIODevice *device, int chunkSize)
+    : m_device(device), m_chunkSize(chunkSize), m_pos(0)
+{
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool Lvk::Cmn::CsvReader::atEnd() const
+{
+    return m_pos >= m_buf.size() && (!m_device || m_device->atEnd());
+}
+
+//--------------------------------------------------------------------------------------------------
+
+int Lvk::Cmn::CsvReader::nextLine()
+{
+    // Returns the position of the end of the current line or -1 if there is no more data.
+    // The buffer is refilled until it has a whole line or the device is exhausted.
+    for (;;) {
+        int eol = m_buf.indexOf(EOL, m_pos);
+
+        if (eol != -1) {
+            return eol;
+        }
+
+        if (!m_device || m_device->atEnd()) {
+            return m_pos < m_buf.size() ? m_buf.size() : -1;
+        }
+
+        // Discard consumed data before reading the next chunk
+        if (m_pos > 0) {
+            m_buf.remove(0, m_pos);
+            m_pos = 0;
+        }
+
+        QByteArray chunk = m_device->read(m_chunkSize);
+
+        if (chunk.isEmpty()) {
+            return m_pos < m_buf.size() ? m_buf.size() : -1;
+        }
+
+        m_buf += chunk;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool Lvk::Cmn::CsvReader::readRow(CsvRow &row)
+{
+    row.clear();
+
+    for (;;) {
+        int eol = nextLine();
+
+        if (eol == -1) {
+            return false;
+        }
+
+        const char *begin = m_buf.constData() + m_pos;
+        const char *end = m_buf.constData() + eol;
+
+        m_pos = eol + 1;
+
+        if (!isAllSpace(begin, end)) {
+            parseLine(begin, end, row);
+            return true;
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::Cmn::CsvReader::parseLine(const char *begin, const char *end, CsvRow &row)
+{
+    if (end != begin && *(end - 1) == CR) {
+        --end;
+    }
+
+    QByteArray cell;
+    const char *p = begin;
+
+    for (;;) {
+        if (p != end && *p == QUOTE) {
+            // Quoted cell
+            cell.clear();
+            ++p;
+
+            while (p != end) {
+                if (*p == QUOTE) {
+                    if (p + 1 != end && *(p + 1) == QUOTE) {
+                        cell += QUOTE;
+                        p += 2;
+                    } else {
+                        ++p;
+                        break;
+                    }
+                } else {
+                    cell += *p++;
+                }
+            }
+
+            // Lenient: keep any text between the closing quote and the next comma
+            const char *start = p;
+            while (p != end && *p != COMMA) {
+                ++p;
+            }
+            cell.append(start, p - start);
+
+            row.append(QString::fromUtf8(cell.constData(), cell.size()));
+        } else {
+            // Unquoted cell: no copy needed
+            const char *start = p;
+            while (p != end && *p != COMMA) {
+                ++p;
+            }
+
+            row.append(QString::fromUtf8(start, p - start));
+        }
+
+        if (p == end) {
+            break;
+        }
+
+        ++p; // Skip comma
+    }
+}
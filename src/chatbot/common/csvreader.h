@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2012 Andres Pagliano, Gabriel Miretti, Gonzalo Buteler,
+ * Nestor Bustamante, Pablo Perez de Angelis
+ *
+ * This file is part of LVK Chatbot.
+ *
+ * LVK Chatbot is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LVK Chatbot is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LVK Chatbot.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef LVK_CMN_CSVREADER_H
+#define LVK_CMN_CSVREADER_H
+
+#include <QByteArray>
+
+class QIODevice;
+
+namespace Lvk
+{
+
+/// \addtogroup Lvk
+/// @{
+
+namespace Cmn
+{
+
+/// \ingroup Lvk
+/// \addtogroup Cmn
+/// @{
+
+class CsvRow;
+
+/**
+ * \brief The CsvReader class reads CSV rows from a device one at a time.
+ *
+ * Unlike CsvDocument, CsvReader does not load the whole device in memory. The device is read
+ * in chunks and each row is tokenized in a single pass over its UTF-8 bytes, so memory usage
+ * is bounded by the chunk size and the longest row.
+ *
+ * The tokenizer follows RFC 4180 with the conventions of CsvRow::toString(): rows end with
+ * "\n" or "\r\n", cells that start with a quote are quoted and "" inside a quoted cell is an
+ * escaped quote. Quoted cells cannot span rows. It is also lenient with malformed input: text
+ * after the closing quote is appended to the cell and unclosed quotes end at the end of the
+ * row.
+ *
+ * \see CsvRow, CsvDocument
+ */
+class CsvReader
+{
+public:
+
+    /**
+     * Constructs a CsvReader that reads from \a device in chunks of \a chunkSize bytes.
+     * The device must be open. CsvReader does not take ownership of the device.
+     */
+    explicit CsvReader(QIODevice *device, int chunkSize = 64*1024);
+
+    /**
+     * Reads the next row in \a row. Rows with only whitespace are skipped.
+     * Returns true on success. If there are no more rows, returns false.
+     */
+    bool readRow(CsvRow &row);
+
+    /**
+     * Returns true if there is no more data to read. Otherwise; returns false.
+     */
+    bool atEnd() const;
+
+private:
+    CsvReader(const CsvReader&);
+    CsvReader& operator=(const CsvReader&);
+
+    QIODevice *m_device;
+    int m_chunkSize;
+    QByteArray m_buf;
+    int m_pos;
+
+    int nextLine();
+    void parseLine(const char *begin, const char *end, CsvRow &row);
+};
+
+/// @}
+
+} // namespace Cmn
+
+/// @}
+
+} // namespace Lvk
+
+
+#endif // LVK_CMN_CSVREADER_H
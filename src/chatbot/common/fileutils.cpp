@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2012 Andres Pagliano, Gabriel Miretti, Gonzalo Buteler,
+ * Nestor Bustamante, Pablo Perez de Angelis
+ *
+ * This file is part of LVK Chatbot.
+ *
+ * LVK Chatbot is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LVK Chatbot is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LVK Chatbot.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/fileutils.h"
+
+#include <QString>
+#include <QFile>
+
+#ifdef Q_WS_WIN
+# include <windows.h>
+# include <io.h>
+#else
+# include <cstdio>
+# include <unistd.h>
+#endif
+
+//--------------------------------------------------------------------------------------------------
+// FileUtils
+//--------------------------------------------------------------------------------------------------
+
+bool Lvk::Cmn::FileUtils::replaceFile(const QString &from, const QString &to)
+{
+#ifdef Q_WS_WIN
+    return MoveFileExW(reinterpret_cast<LPCWSTR>(from.utf16()),
+                       reinterpret_cast<LPCWSTR>(to.utf16()),
+                       MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    return std::rename(QFile::encodeName(from).constData(),
+                       QFile::encodeName(to).constData()) == 0;
+#endif
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool Lvk::Cmn::FileUtils::syncFile(QFile *file)
+{
+#ifdef Q_WS_WIN
+    return _commit(file->handle()) == 0;
+#else
+    return fsync(file->handle()) == 0;
+#endif
+}
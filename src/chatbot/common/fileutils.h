@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2012 Andres Pagliano, Gabriel Miretti, Gonzalo Buteler,
+ * Nestor Bustamante, Pablo Perez de Angelis
+ *
+ * This file is part of LVK Chatbot.
+ *
+ * LVK Chatbot is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LVK Chatbot is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LVK Chatbot.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef LVK_CMN_FILEUTILS_H
+#define LVK_CMN_FILEUTILS_H
+
+class QString;
+class QFile;
+
+namespace Lvk
+{
+
+/// \addtogroup Lvk
+/// @{
+
+namespace Cmn
+{
+
+/// \ingroup Lvk
+/// \addtogroup Cmn
+/// @{
+
+/**
+ * \brief The FileUtils class provides file operations not available in QFile.
+ */
+class FileUtils
+{
+public:
+    /**
+     * Atomically replaces the file \a to with the file \a from. If \a to exists, readers see
+     * either the old or the new file, never a missing one. QFile::rename() does not overwrite
+     * files, so it cannot be used for this. Returns true on success. Otherwise; returns false.
+     */
+    static bool replaceFile(const QString &from, const QString &to);
+
+    /**
+     * Writes the data of \a file buffered by the operating system to disk. QFile::flush() only
+     * passes the data to the operating system. Returns true on success. Otherwise; returns false.
+     */
+    static bool syncFile(QFile *file);
+
+private:
+    FileUtils();
+    FileUtils(FileUtils&);
+};
+
+/// @}
+
+} // namespace Cmn
+
+/// @}
+
+} // namespace Lvk
+
+
+#endif // LVK_CMN_FILEUTILS_H
@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2012 Andres Pagliano, Gabriel Miretti, Gonzalo Buteler,
+ * Nestor Bustamante, Pablo Perez de Angelis
+ *
+ * This file is part of LVK Chatbot.
+ *
+ * LVK Chatbot is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LVK Chatbot is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LVK Chatbot.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef LVK_CMN_HASH_H
+#define LVK_CMN_HASH_H
+
+#include <QString>
+#include <QByteArray>
+
+namespace Lvk
+{
+
+/// \addtogroup Lvk
+/// @{
+
+namespace Cmn
+{
+
+/// \ingroup Lvk
+/// \addtogroup Cmn
+/// @{
+
+/**
+ * Returns a 64-bit FNV-1a hash of the \a size bytes pointed by \a data.
+ */
+inline quint64 hash64(const char *data, int size)
+{
+    quint64 h = Q_UINT64_C(14695981039346656037);
+
+    for (int i = 0; i < size; ++i) {
+        h ^= static_cast<uchar>(data[i]);
+        h *= Q_UINT64_C(1099511628211);
+    }
+
+    return h;
+}
+
+/**
+ * Returns a 64-bit FNV-1a hash of \a data.
+ */
+inline quint64 hash64(const QByteArray &data)
+{
+    return hash64(data.constData(), data.size());
+}
+
+/**
+ * Returns a 64-bit FNV-1a hash of the \a n characters pointed by \a p. Characters are hashed
+ * low byte first. If \a lower is true, characters are hashed in lower case.
+ */
+inline quint64 hash64(const QChar *p, int n, bool lower = false)
+{
+    quint64 h = Q_UINT64_C(14695981039346656037);
+
+    for (int i = 0; i < n; ++i) {
+        ushort c = lower ? p[i].toLower().unicode() : p[i].unicode();
+        h ^= c & 0xff;
+        h *= Q_UINT64_C(1099511628211);
+        h ^= c >> 8;
+        h *= Q_UINT64_C(1099511628211);
+    }
+
+    return h;
+}
+
+/**
+ * Returns a 64-bit FNV-1a hash of \a s.
+ */
+inline quint64 hash64(const QString &s)
+{
+    return hash64(s.constData(), s.size());
+}
+
+/// @}
+
+} // namespace Cmn
+
+/// @}
+
+} // namespace Lvk
+
+
+#endif // LVK_CMN_HASH_H
@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2012 Andres Pagliano, Gabriel Miretti, Gonzalo Buteler,
+ * Nestor Bustamante, Pablo Perez de Angelis
+ *
+ * This file is part of LVK Chatbot.
+ *
+ * LVK Chatbot is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LVK Chatbot is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LVK Chatbot.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/latencyhistogram.h"
+
+#include <QtAlgorithms>
+#include <QStringList>
+
+//--------------------------------------------------------------------------------------------------
+// LatencyHistogram
+//--------------------------------------------------------------------------------------------------
+
+Lvk::Cmn::LatencyHistogram::LatencyHistogram()
+    : m_sorted(true), m_total(0)
+{
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::Cmn::LatencyHistogram::add(qint64 nsecs)
+{
+    m_samples.append(nsecs);
+    m_total += nsecs;
+    m_sorted = false;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+int Lvk::Cmn::LatencyHistogram::count() const
+{
+    return m_samples.size();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+qint64 Lvk::Cmn::LatencyHistogram::total() const
+{
+    return m_total;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::Cmn::LatencyHistogram::sort() const
+{
+    if (!m_sorted) {
+        qSort(m_samples);
+        m_sorted = true;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+qint64 Lvk::Cmn::LatencyHistogram::percentile(double p) const
+{
+    if (m_samples.isEmpty()) {
+        return 0;
+    }
+
+    sort();
+
+    int i = qBound(0, static_cast<int>(p/100.0*m_samples.size()), m_samples.size() - 1);
+
+    return m_samples[i];
+}
+
+//--------------------------------------------------------------------------------------------------
+
+qint64 Lvk::Cmn::LatencyHistogram::max() const
+{
+    return percentile(100);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+QString Lvk::Cmn::LatencyHistogram::toString() const
+{
+    // Buckets [0,1), [1,2), [2,4), [4,8), ... in microseconds
+    QVector<int> buckets;
+
+    foreach (qint64 nsecs, m_samples) {
+        qint64 usecs = nsecs/1000;
+        int b = 0;
+        while (usecs > 0) {
+            usecs >>= 1;
+            ++b;
+        }
+        if (b >= buckets.size()) {
+            buckets.resize(b + 1);
+        }
+        ++buckets[b];
+    }
+
+    QStringList lines;
+    int maxCount = 0;
+
+    for (int b = 0; b < buckets.size(); ++b) {
+        maxCount = qMax(maxCount, buckets[b]);
+    }
+
+    for (int b = 0; b < buckets.size(); ++b) {
+        if (!buckets[b]) {
+            continue;
+        }
+        qint64 from = b == 0 ? 0 : Q_INT64_C(1) << (b - 1);
+        qint64 to = Q_INT64_C(1) << b;
+        QString bar(qMax(1, 40*buckets[b]/maxCount), '#');
+
+        lines.append(QString("  [%1, %2) us %3 %4")
+                     .arg(from, 8).arg(to, 8).arg(buckets[b], 8).arg(bar));
+    }
+
+    return lines.join("\n");
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::Cmn::LatencyHistogram::clear()
+{
+    m_samples.clear();
+    m_sorted = true;
+    m_total = 0;
+}
+
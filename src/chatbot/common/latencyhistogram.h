@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2012 Andres Pagliano, Gabriel Miretti, Gonzalo Buteler,
+ * Nestor Bustamante, Pablo Perez de Angelis
+ *
+ * This file is part of LVK Chatbot.
+ *
+ * LVK Chatbot is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LVK Chatbot is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LVK Chatbot.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef LVK_CMN_LATENCYHISTOGRAM_H
+#define LVK_CMN_LATENCYHISTOGRAM_H
+
+#include <QVector>
+#include <QString>
+
+namespace Lvk
+{
+
+/// \addtogroup Lvk
+/// @{
+
+namespace Cmn
+{
+
+/// \ingroup Lvk
+/// \addtogroup Cmn
+/// @{
+
+/**
+ * \brief The LatencyHistogram class collects latency samples and reports percentiles and a
+ *        histogram.
+ *
+ * Samples are given in nanoseconds. The histogram has power-of-two buckets in microseconds,
+ * i.e. [0,1), [1,2), [2,4), [4,8), etc.
+ */
+class LatencyHistogram
+{
+public:
+
+    /**
+     * Constructs an empty histogram
+     */
+    LatencyHistogram();
+
+    /**
+     * Adds a sample of \a nsecs nanoseconds
+     */
+    void add(qint64 nsecs);
+
+    /**
+     * Returns the amount of samples
+     */
+    int count() const;
+
+    /**
+     * Returns the sum of all samples in nanoseconds
+     */
+    qint64 total() const;
+
+    /**
+     * Returns the sample in nanoseconds of the given percentile \a p in the range [0,100]
+     */
+    qint64 percentile(double p) const;
+
+    /**
+     * Returns the highest sample in nanoseconds
+     */
+    qint64 max() const;
+
+    /**
+     * Returns the histogram as a multiline string, one line per non-empty bucket
+     */
+    QString toString() const;
+
+    /**
+     * Removes all samples
+     */
+    void clear();
+
+private:
+    mutable QVector<qint64> m_samples;
+    mutable bool m_sorted;
+    qint64 m_total;
+
+    void sort() const;
+};
+
+/// @}
+
+} // namespace Cmn
+
+/// @}
+
+} // namespace Lvk
+
+
+#endif // LVK_CMN_LATENCYHISTOGRAM_H
+
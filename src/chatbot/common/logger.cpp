@@ -20,6 +20,7 @@
  */
 
 #include "common/logger.h"
+#include "common/logwriter.h"
 #include "common/settings.h"
 #include "common/version.h"
 #include "common/settingskeys.h"
@@ -31,9 +32,9 @@
 #include <QFileInfo>
 #include <QDir>
 #include <QString>
-#include <QDateTime>
+#include <QStringList>
 #include <QSysInfo>
-#include <QCoreApplication>
+#include <QThread>
 
 #define DEBUG_STR            "Debug: "
 #define WARNING_STR          "Warning: "
@@ -41,8 +42,10 @@
 #define FATAL_STR            "Fatal: "
 
 #define LOG_FILENAME         "chatbot.log"
+#define LOG_MAX_SIZE         (1024*1024)
+#define LOG_MAX_AGE          (24*60*60)  // Seconds
 
-#define DATE_TIME_LOG_FORMAT "yyyy-MM-dd hh:mm:ss.zzz"
+#define FATAL_SYNC_TIMEOUT   2000        // Milliseconds
 
 //--------------------------------------------------------------------------------------------------
 // Helpers
@@ -78,6 +81,50 @@ inline QString chatbotLogFilename()
 
 //--------------------------------------------------------------------------------------------------
 
+inline QtMsgType logLevelFromSettings()
+{
+    Lvk::Cmn::Settings settings;
+    QString level = settings.value(SETTING_LOGGING_LEVEL).toString().toLower();
+
+    if (level == "critical") {
+        return QtCriticalMsg;
+    } else if (level == "warning") {
+        return QtWarningMsg;
+    } else {
+        return QtDebugMsg;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+inline int categoriesFromSettings()
+{
+    Lvk::Cmn::Settings settings;
+    QStringList names = settings.value(SETTING_LOGGING_CATEGORIES).toStringList();
+
+    int categories = 0;
+
+    foreach (const QString &name, names) {
+        QString szName = name.trimmed().toLower();
+
+        if (szName == "all") {
+            categories |= Lvk::Cmn::Logger::AllCategories;
+        } else if (szName == "default") {
+            categories |= Lvk::Cmn::Logger::DefaultCategory;
+        } else if (szName == "engine") {
+            categories |= Lvk::Cmn::Logger::EngineCategory;
+        } else if (szName == "nlp") {
+            categories |= Lvk::Cmn::Logger::NlpCategory;
+        } else if (szName == "chat") {
+            categories |= Lvk::Cmn::Logger::ChatCategory;
+        }
+    }
+
+    return categories;
+}
+
+//--------------------------------------------------------------------------------------------------
+
 // TODO refactor duplicated code
 inline QString getOSType()
 {
@@ -97,35 +144,39 @@ inline QString getOSType()
 // Logger
 //--------------------------------------------------------------------------------------------------
 
-QFile *   Lvk::Cmn::Logger::m_logFile = 0;
-QString   Lvk::Cmn::Logger::m_strPid;
+QAtomicPointer<Lvk::Cmn::LogWriter> Lvk::Cmn::Logger::m_writer(0);
+QAtomicInt Lvk::Cmn::Logger::m_handlers(0);
 QtMsgType Lvk::Cmn::Logger::m_verbLevel = QtDebugMsg;
+QtMsgType Lvk::Cmn::Logger::m_logLevel = QtDebugMsg;
+int       Lvk::Cmn::Logger::m_categories = Lvk::Cmn::Logger::AllCategories;
 
 //--------------------------------------------------------------------------------------------------
 
 void Lvk::Cmn::Logger::init()
 {
-    if (m_logFile) {
+    if (m_writer) {
         return; // Already initialized
     }
 
-    m_strPid = QString::number(QCoreApplication::applicationPid());
+    setLogLevel(logLevelFromSettings());
+    setCategories(categoriesFromSettings());
 
     QString logFilename = chatbotLogFilename();
 
     if (makeLogsPath()) {
-        rotateLog(logFilename);
+        rotateLog(logFilename, LOG_MAX_SIZE);
 
-        m_logFile = new QFile(logFilename);
+        LogWriter *writer = new LogWriter(logFilename, LOG_MAX_SIZE, LOG_MAX_AGE);
 
-        if (m_logFile->open(QFile::Append)) {
+        if (writer->isOpen()) {
+            writer->start();
+            m_writer.fetchAndStoreOrdered(writer);
             qInstallMsgHandler(msgHandler);
             qDebug() << "Logger initialized on"
                      << APP_NAME " v" APP_VERSION_STR " rev:" APP_VERSION_REV;
             qDebug() << "OS Type:" << getOSType();
         } else {
-            delete m_logFile;
-            m_logFile = 0;
+            delete writer;
             qCritical() << CRITICAL_STR "Cannot open" << logFilename << " in append mode.";
         }
     } else {
@@ -142,8 +193,21 @@ void Lvk::Cmn::Logger::shutdown()
 
     qInstallMsgHandler(0); // Restore handler
 
-    delete m_logFile;
-    m_logFile = 0;
+    LogWriter *writer = m_writer.fetchAndStoreOrdered(0);
+
+    if (!writer) {
+        return;
+    }
+
+    // Threads still in msgHandler() may hold the writer. Closing it drops their messages
+    // instead of touching freed memory, and the writer is deleted once they leave.
+    writer->close();
+
+    while (m_handlers.fetchAndAddOrdered(0) != 0) {
+        QThread::yieldCurrentThread();
+    }
+
+    delete writer; // Writes pending messages
 }
 
 
@@ -170,46 +234,59 @@ void Lvk::Cmn::Logger::setVerboseLevel(QtMsgType verbLevel)
 
 //--------------------------------------------------------------------------------------------------
 
+void Lvk::Cmn::Logger::setLogLevel(QtMsgType level)
+{
+    m_logLevel = qMin(level, QtCriticalMsg);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::Cmn::Logger::setCategories(int categories)
+{
+    m_categories = categories;
+}
+
+//--------------------------------------------------------------------------------------------------
+
 void Lvk::Cmn::Logger::msgHandler(QtMsgType type, const char *msg)
 {
-    m_logFile->write(QDateTime::currentDateTime().toString(DATE_TIME_LOG_FORMAT).toUtf8());
-    m_logFile->write(" ");
-    m_logFile->write(m_strPid.toAscii());
-    m_logFile->write(" ");
-
-    switch (type) {
-    case QtDebugMsg:
-        if (type >= m_verbLevel) {
-            std::cout << DEBUG_STR << msg << std::endl;
-        }
-        m_logFile->write(DEBUG_STR);
-        break;
+    if (type < m_logLevel) {
+        return;
+    }
 
-    case QtWarningMsg:
-        if (type >= m_verbLevel) {
+    if (type >= m_verbLevel) {
+        switch (type) {
+        case QtDebugMsg:
+            std::cout << DEBUG_STR << msg << std::endl;
+            break;
+        case QtWarningMsg:
             std::cerr << WARNING_STR << msg << std::endl;
-        }
-        m_logFile->write(WARNING_STR);
-        break;
-
-    case QtCriticalMsg:
-        if (type >= m_verbLevel) {
+            break;
+        case QtCriticalMsg:
             std::cerr << CRITICAL_STR << msg << std::endl;
+            break;
+        case QtFatalMsg:
+            std::cerr << FATAL_STR << msg << std::endl;
+            break;
         }
-        m_logFile->write(CRITICAL_STR);
-        break;
+    }
 
-    case QtFatalMsg:
-        if (type >= m_verbLevel) {
-            std::cerr << FATAL_STR << msg << std::endl;
+    // Register before loading the writer, shutdown() does the opposite
+    m_handlers.ref();
+
+    LogWriter *writer = m_writer.fetchAndAddOrdered(0);
+
+    if (writer) {
+        writer->append(type, msg);
+
+        if (type == QtFatalMsg) {
+            writer->sync(FATAL_SYNC_TIMEOUT);
+        } else if (type >= QtWarningMsg) {
+            writer->requestFlush();
         }
-        m_logFile->write(FATAL_STR);
-        break;
     }
 
-    m_logFile->write(msg);
-    m_logFile->write("\n");
-    m_logFile->flush();
+    m_handlers.deref();
 
     if (type == QtFatalMsg) {
         abort();
@@ -23,8 +23,28 @@
 #define LVK_CMN_LOGGER_H
 
 #include <QtGlobal>
+#include <QtDebug>
+#include <QAtomicInt>
+#include <QAtomicPointer>
 
-class QFile;
+/**
+ * \def LOG_DEBUG(category)
+ *
+ * Returns a QDebug stream for debug messages of the given \a category, i.e. one of the
+ * Logger::Category values without the "Category" suffix. For instance:
+ *
+ * \code
+ * LOG_DEBUG(Engine) << "Results found:" << results;
+ * \endcode
+ *
+ * Unlike qDebug(), if debug messages or the category are disabled the stream operands are not
+ * evaluated at all.
+ *
+ * \see Logger::isEnabled()
+ */
+#define LOG_DEBUG(category) \
+    if (!Lvk::Cmn::Logger::isEnabled(QtDebugMsg, Lvk::Cmn::Logger::category##Category)) {} \
+    else qDebug()
 
 namespace Lvk
 {
@@ -39,6 +59,8 @@ namespace Cmn
 /// \addtogroup Cmn
 /// @{
 
+class LogWriter;
+
 /**
  * \brief Logger class provides a logging features for the Chatbot application.
  *
@@ -46,21 +68,43 @@ namespace Cmn
  * qFatal(). When a message is passed to any of these functions, the message is persisted
  * in a log file (by default logs/chatbot.log) and it is also printed in the stdout or stderr.
  *
+ * The log file is written by a LogWriter in a background thread, so logging threads never block
+ * on disk I/O. The file is flushed every second, as soon as possible after warnings and
+ * synchronously after fatal messages. It is rotated when it is larger than 1 MB or older than a
+ * day.
+ *
  * If qFatal() is invoked after logging the message the application is terminated.
  *
  * To start using the logger just call init(). To stop the logger call shutdown().
+ *
+ * Messages below the log level (by default QtDebugMsg) are dropped. Debug messages logged with
+ * LOG_DEBUG() can also be filtered by category. Both the log level and the enabled categories
+ * are read from the application settings in init().
  */
 class Logger
 {
 public:
 
+    /**
+     * Log categories. Categories are flags so they can be combined.
+     */
+    enum Category
+    {
+        DefaultCategory = 0x01,     ///< Messages without a specific category
+        EngineCategory  = 0x02,     ///< NLP engines and matchers
+        NlpCategory     = 0x04,     ///< Lemmatizers, sanitizers and output parsers
+        ChatCategory    = 0x08,     ///< Chat adapters and conversation handling
+        AllCategories   = 0xff
+    };
+
     /**
      * Initializes the Chatbot application logger.
      */
     static void init();
 
     /**
-     * Shuts down the Chatbot application logger.
+     * Shuts down the Chatbot application logger. Messages logged concurrently from other threads
+     * are either written or dropped, the writer is destroyed once no thread uses it.
      */
     static void shutdown();
 
@@ -75,15 +119,38 @@ public:
      */
     static void setVerboseLevel(QtMsgType verbLevel);
 
+    /**
+     * Sets the minimum level of messages that are logged. By default QtDebugMsg.
+     * Fatal messages are always logged.
+     */
+    static void setLogLevel(QtMsgType level);
+
+    /**
+     * Sets the enabled categories. \a categories is a combination of Category flags.
+     * By default all categories are enabled.
+     */
+    static void setCategories(int categories);
+
+    /**
+     * Returns true if messages of the given \a type and \a category are logged.
+     * Otherwise; returns false.
+     */
+    static bool isEnabled(QtMsgType type, Category category)
+    {
+        return type >= m_logLevel && (m_categories & category) != 0;
+    }
+
 private:
     Logger();
     Logger(Logger&);
 
     static void msgHandler(QtMsgType type, const char *msg);
 
-    static QFile *m_logFile;
-    static QString m_strPid;
+    static QAtomicPointer<LogWriter> m_writer;
+    static QAtomicInt m_handlers;       // Calls to msgHandler() using m_writer
     static QtMsgType m_verbLevel;
+    static QtMsgType m_logLevel;
+    static int m_categories;
 };
 
 /// @}
@@ -0,0 +1,395 @@
+/*
+ * Copyright (C) 2012 Andres Pagliano, Gabriel Miretti, Gonzalo Buteler,
+ * Nestor Bustamante, Pablo Perez de Angelis
+ *
+ * This file is part of LVK Chatbot.
+ *
+ * LVK Chatbot is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LVK Chatbot is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LVK Chatbot.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/logwriter.h"
+
+#include <QFile>
+#include <QElapsedTimer>
+#include <QCoreApplication>
+#include <QtDebug>
+
+#define RING_SIZE               8192    // Must be a power of two
+#define MAX_BATCH_SIZE          1024
+#define FLUSH_INTERVAL          1000    // Milliseconds
+
+#define DEBUG_STR               "Debug: "
+#define WARNING_STR             "Warning: "
+#define CRITICAL_STR            "Critical: "
+#define FATAL_STR               "Fatal: "
+
+#define DATE_TIME_LOG_FORMAT    "yyyy-MM-dd hh:mm:ss.zzz"
+
+//--------------------------------------------------------------------------------------------------
+// Helpers
+//--------------------------------------------------------------------------------------------------
+
+namespace
+{
+
+inline const char *typeString(QtMsgType type)
+{
+    switch (type) {
+    case QtDebugMsg:
+        return DEBUG_STR;
+    case QtWarningMsg:
+        return WARNING_STR;
+    case QtCriticalMsg:
+        return CRITICAL_STR;
+    case QtFatalMsg:
+        return FATAL_STR;
+    }
+    return "";
+}
+
+//--------------------------------------------------------------------------------------------------
+
+inline void appendLine(QByteArray &batch, qint64 msecs, const QByteArray &pid, QtMsgType type,
+                       const QByteArray &msg)
+{
+    batch += QDateTime::fromMSecsSinceEpoch(msecs).toString(DATE_TIME_LOG_FORMAT).toUtf8();
+    batch += ' ';
+    batch += pid;
+    batch += ' ';
+    batch += typeString(type);
+    batch += msg;
+    batch += '\n';
+}
+
+} // namespace
+
+
+//--------------------------------------------------------------------------------------------------
+// LogWriter
+//--------------------------------------------------------------------------------------------------
+
+Lvk::Cmn::LogWriter::LogWriter(const QString &filename, qint64 maxSize, int maxAge)
+    : m_filename(filename),
+      m_maxSize(maxSize),
+      m_maxAge(maxAge),
+      m_file(new QFile(filename)),
+      m_fileSize(0),
+      m_pid(QByteArray::number(QCoreApplication::applicationPid())),
+      m_slots(new Slot[RING_SIZE]),
+      m_mask(RING_SIZE - 1),
+      m_enqueuePos(0),
+      m_dequeuePos(0),
+      m_flushedPos(0),
+      m_flushRequested(0),
+      m_dropped(0),
+      m_stop(0),
+      m_closed(0),
+      m_producers(0)
+{
+    // Slot i is free for the producer that claims position i
+    for (int i = 0; i < RING_SIZE; ++i) {
+        m_slots[i].seq = i;
+    }
+
+    open();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+Lvk::Cmn::LogWriter::~LogWriter()
+{
+    close();
+
+    delete m_file;
+    delete[] m_slots;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool Lvk::Cmn::LogWriter::open()
+{
+    if (!m_file->open(QFile::Append)) {
+        return false;
+    }
+
+    m_fileSize = m_file->size();
+    m_openTime = QDateTime::currentDateTime();
+
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool Lvk::Cmn::LogWriter::isOpen() const
+{
+    return m_file->isOpen();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool Lvk::Cmn::LogWriter::append(QtMsgType type, const char *msg)
+{
+    // Register before checking the flag, close() does the opposite
+    m_producers.ref();
+
+    if (m_closed.fetchAndAddOrdered(0) != 0) {
+        m_producers.deref();
+        return false;
+    }
+
+    qint64 msecs = QDateTime::currentMSecsSinceEpoch();
+
+    // Claim a slot. A slot is free when its sequence equals the position being claimed, and it
+    // is still in use by the writer thread when its sequence is behind.
+    int pos = m_enqueuePos;
+    Slot *slot = 0;
+
+    for (;;) {
+        slot = &m_slots[pos & m_mask];
+        int diff = slot->seq.fetchAndAddAcquire(0) - pos;
+
+        if (diff == 0) {
+            if (m_enqueuePos.testAndSetRelaxed(pos, pos + 1)) {
+                break;
+            }
+        } else if (diff < 0) {
+            m_dropped.ref();
+            m_producers.deref();
+            return false;
+        }
+
+        pos = m_enqueuePos;
+    }
+
+    slot->type = type;
+    slot->msecs = msecs;
+    slot->msg = msg;
+
+    // Publish the slot to the writer thread
+    slot->seq.fetchAndStoreRelease(pos + 1);
+
+    if (type == QtFatalMsg || (pos + 1) % MAX_BATCH_SIZE == 0) {
+        wakeWriter();
+    }
+
+    m_producers.deref();
+
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::Cmn::LogWriter::requestFlush()
+{
+    m_flushRequested.fetchAndStoreRelaxed(1);
+
+    wakeWriter();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::Cmn::LogWriter::wakeWriter()
+{
+    // Taking the mutex ensures the wake up is not lost while the writer is about to wait
+    QMutexLocker locker(&m_mutex);
+
+    m_wakeUp.wakeOne();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool Lvk::Cmn::LogWriter::sync(int msecs)
+{
+    int target = m_enqueuePos;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QMutexLocker locker(&m_mutex);
+
+    while (m_flushedPos.fetchAndAddAcquire(0) - target < 0) {
+        int remaining = msecs - timer.elapsed();
+
+        if (!isRunning() || remaining <= 0) {
+            return false;
+        }
+
+        // The writer may flush before reaching target, so keep requesting
+        m_flushRequested.fetchAndStoreRelaxed(1);
+        m_wakeUp.wakeOne();
+        m_flushed.wait(&m_mutex, remaining);
+    }
+
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::Cmn::LogWriter::stop()
+{
+    m_stop.fetchAndStoreRelease(1);
+
+    wakeWriter();
+    wait();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::Cmn::LogWriter::close()
+{
+    m_closed.fetchAndStoreOrdered(1);
+
+    // Producers that got past the flag still publish their messages
+    while (m_producers.fetchAndAddOrdered(0) != 0) {
+        yieldCurrentThread();
+    }
+
+    stop();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+int Lvk::Cmn::LogWriter::dropped() const
+{
+    return m_dropped;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::Cmn::LogWriter::run()
+{
+    QElapsedTimer flushTimer;
+    flushTimer.start();
+
+    QByteArray batch;
+    int reportedDrops = 0;
+    bool dirty = false;
+
+    for (;;) {
+        // Read the stop flag before draining so messages appended before stop() are written
+        bool stopping = m_stop.fetchAndAddAcquire(0) != 0;
+
+        batch.clear();
+
+        int drops = m_dropped;
+        if (drops != reportedDrops) {
+            QByteArray msg = "LogWriter: Log buffer full. Dropped " +
+                    QByteArray::number(drops - reportedDrops) + " messages";
+            appendLine(batch, QDateTime::currentMSecsSinceEpoch(), m_pid, QtWarningMsg, msg);
+            reportedDrops = drops;
+        }
+
+        int n = drain(batch);
+
+        if (!batch.isEmpty() && m_file->isOpen()) {
+            m_file->write(batch);
+            m_fileSize += batch.size();
+            dirty = true;
+        }
+
+        if (stopping || m_flushRequested != 0 ||
+                (dirty && flushTimer.elapsed() >= FLUSH_INTERVAL)) {
+            flush();
+            rotateIfNeeded();
+            dirty = false;
+            flushTimer.restart();
+        }
+
+        if (n == 0) {
+            if (stopping) {
+                break;
+            }
+
+            QMutexLocker locker(&m_mutex);
+
+            if (!hasPending() && m_flushRequested == 0 && m_stop == 0) {
+                int timeout = dirty ? qMax(0, FLUSH_INTERVAL - int(flushTimer.elapsed()))
+                                    : FLUSH_INTERVAL;
+                m_wakeUp.wait(&m_mutex, timeout);
+            }
+        }
+    }
+
+    m_file->close();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool Lvk::Cmn::LogWriter::hasPending()
+{
+    return m_slots[m_dequeuePos & m_mask].seq.fetchAndAddAcquire(0) - (m_dequeuePos + 1) >= 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+int Lvk::Cmn::LogWriter::drain(QByteArray &batch)
+{
+    int n = 0;
+
+    while (n < MAX_BATCH_SIZE) {
+        Slot &slot = m_slots[m_dequeuePos & m_mask];
+
+        if (slot.seq.fetchAndAddAcquire(0) - (m_dequeuePos + 1) < 0) {
+            break; // Empty or not published yet
+        }
+
+        appendLine(batch, slot.msecs, m_pid, slot.type, slot.msg);
+        slot.msg.clear();
+
+        // Free the slot for the producer that claims this position in the next round
+        slot.seq.fetchAndStoreRelease(m_dequeuePos + RING_SIZE);
+
+        ++m_dequeuePos;
+        ++n;
+    }
+
+    return n;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::Cmn::LogWriter::flush()
+{
+    if (m_file->isOpen()) {
+        m_file->flush();
+    }
+
+    m_flushRequested.fetchAndStoreRelaxed(0);
+    m_flushedPos.fetchAndStoreRelease(m_dequeuePos);
+
+    QMutexLocker locker(&m_mutex);
+    m_flushed.wakeAll();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::Cmn::LogWriter::rotateIfNeeded()
+{
+    bool tooBig = m_fileSize > m_maxSize;
+    bool tooOld = m_maxAge > 0 && m_openTime.secsTo(QDateTime::currentDateTime()) > m_maxAge;
+
+    if (!m_file->isOpen() || (!tooBig && !tooOld)) {
+        return;
+    }
+
+    QString rlogFilename = m_filename + ".1";
+
+    m_file->close();
+
+    QFile::remove(rlogFilename);
+    QFile::rename(m_filename, rlogFilename);
+
+    open();
+}
@@ -0,0 +1,178 @@
+/*
+ * Copyright (C) 2012 Andres Pagliano, Gabriel Miretti, Gonzalo Buteler,
+ * Nestor Bustamante, Pablo Perez de Angelis
+ *
+ * This file is part of LVK Chatbot.
+ *
+ * LVK Chatbot is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LVK Chatbot is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LVK Chatbot.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef LVK_CMN_LOGWRITER_H
+#define LVK_CMN_LOGWRITER_H
+
+#include <QThread>
+#include <QString>
+#include <QByteArray>
+#include <QDateTime>
+#include <QAtomicInt>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QtGlobal>
+
+class QFile;
+
+namespace Lvk
+{
+
+/// \addtogroup Lvk
+/// @{
+
+namespace Cmn
+{
+
+/// \ingroup Lvk
+/// \addtogroup Cmn
+/// @{
+
+/**
+ * \brief The LogWriter class writes log messages to a file in a background thread.
+ *
+ * Producers call append() from any thread. Messages are stored in a bounded lock-free
+ * multi-producer single-consumer ring buffer, so producers never block on the file or on other
+ * producers. If the buffer is full the message is dropped and counted; the amount of dropped
+ * messages is written to the log as soon as there is room.
+ *
+ * The writer thread formats messages, writes them in batches and flushes the file periodically
+ * or when requested with requestFlush(). It sleeps on a wait condition until a batch fills up,
+ * a flush is requested or the flush interval elapses. sync() waits until all messages appended
+ * so far are flushed, which is used before aborting on fatal errors.
+ *
+ * close() rejects new messages and waits for producers inside append() before stopping the
+ * writer, so the object can be safely destroyed afterwards.
+ *
+ * The file is rotated when it grows larger than the maximum size or when it has been open for
+ * longer than the maximum age.
+ *
+ * \see Logger
+ */
+class LogWriter : public QThread
+{
+public:
+
+    /**
+     * Constructs a LogWriter that appends to \a filename. The file is rotated if it is larger than
+     * \a maxSize bytes or if it has been open for more than \a maxAge seconds.
+     * The writer thread must be started with start().
+     */
+    LogWriter(const QString &filename, qint64 maxSize, int maxAge);
+
+    /**
+     * Stops the writer and destroys the object.
+     */
+    ~LogWriter();
+
+    /**
+     * Returns true if the log file was successfully opened. Otherwise; returns false.
+     */
+    bool isOpen() const;
+
+    /**
+     * Appends the message \a msg of type \a type. Returns true if the message was queued.
+     * Otherwise, the buffer is full, the message is dropped and returns false.
+     */
+    bool append(QtMsgType type, const char *msg);
+
+    /**
+     * Requests the writer thread to flush the file as soon as possible
+     */
+    void requestFlush();
+
+    /**
+     * Waits at most \a msecs milliseconds until all messages appended so far are written and
+     * flushed. Returns true on success. Otherwise; returns false.
+     */
+    bool sync(int msecs);
+
+    /**
+     * Writes all pending messages, closes the file and stops the writer thread
+     */
+    void stop();
+
+    /**
+     * Closes the buffer so following calls to append() return false, waits for calls to
+     * append() in progress and then stops the writer thread.
+     */
+    void close();
+
+    /**
+     * Returns the amount of dropped messages
+     */
+    int dropped() const;
+
+protected:
+    void run();
+
+private:
+    LogWriter(const LogWriter&);
+    LogWriter& operator=(const LogWriter&);
+
+    struct Slot
+    {
+        QAtomicInt seq;
+        QtMsgType type;
+        qint64 msecs;
+        QByteArray msg;
+    };
+
+    QString m_filename;
+    qint64 m_maxSize;
+    int m_maxAge;
+    QFile *m_file;
+    qint64 m_fileSize;
+    QDateTime m_openTime;
+    QByteArray m_pid;
+
+    Slot *m_slots;
+    int m_mask;
+    QAtomicInt m_enqueuePos;
+    int m_dequeuePos;           // Only accessed by the writer thread
+    QAtomicInt m_flushedPos;
+    QAtomicInt m_flushRequested;
+    QAtomicInt m_dropped;
+    QAtomicInt m_stop;
+    QAtomicInt m_closed;
+    QAtomicInt m_producers;     // Calls to append() in progress
+    QMutex m_mutex;
+    QWaitCondition m_wakeUp;    // Wakes the writer thread
+    QWaitCondition m_flushed;   // Signaled after each flush
+
+    bool open();
+    bool hasPending();
+    void wakeWriter();
+    int drain(QByteArray &batch);
+    void flush();
+    void rotateIfNeeded();
+};
+
+/// @}
+
+} // namespace Cmn
+
+/// @}
+
+} // namespace Lvk
+
+
+#endif // LVK_CMN_LOGWRITER_H
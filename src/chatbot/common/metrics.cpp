@@ -0,0 +1,369 @@
+/*
+ * Copyright (C) 2012 Andres Pagliano, Gabriel Miretti, Gonzalo Buteler,
+ * Nestor Bustamante, Pablo Perez de Angelis
+ *
+ * This file is part of LVK Chatbot.
+ *
+ * LVK Chatbot is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LVK Chatbot is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LVK Chatbot.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/metrics.h"
+#include "common/fileutils.h"
+
+#include <QMap>
+#include <QFile>
+#include <QStringList>
+#include <QTextStream>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QtDebug>
+
+#ifdef Q_CC_GNU
+# define HAVE_ATOMIC_BUILTINS
+#endif
+
+//--------------------------------------------------------------------------------------------------
+// Helpers
+//--------------------------------------------------------------------------------------------------
+
+namespace
+{
+
+#ifndef HAVE_ATOMIC_BUILTINS
+QMutex g_atomicMutex;
+#endif
+
+inline qint64 atomicAdd(volatile qint64 *ptr, qint64 n)
+{
+#ifdef HAVE_ATOMIC_BUILTINS
+    return __sync_add_and_fetch(ptr, n);
+#else
+    QMutexLocker locker(&g_atomicMutex);
+    return *ptr += n;
+#endif
+}
+
+inline void atomicSet(volatile qint64 *ptr, qint64 value)
+{
+#ifdef HAVE_ATOMIC_BUILTINS
+    qint64 old = *ptr;
+    while (!__sync_bool_compare_and_swap(ptr, old, value)) {
+        old = *ptr;
+    }
+#else
+    QMutexLocker locker(&g_atomicMutex);
+    *ptr = value;
+#endif
+}
+
+// Plain 64-bit loads are not atomic on 32-bit platforms
+inline qint64 atomicLoad(volatile qint64 *ptr)
+{
+    return atomicAdd(ptr, 0);
+}
+
+// Histogram upper bounds in nanoseconds. The last bucket is +Inf.
+const qint64 BUCKET_BOUNDS[Lvk::Cmn::Histogram::BucketCount - 1] = {
+    Q_INT64_C(100000),
+    Q_INT64_C(250000),
+    Q_INT64_C(500000),
+    Q_INT64_C(1000000),
+    Q_INT64_C(2500000),
+    Q_INT64_C(5000000),
+    Q_INT64_C(10000000),
+    Q_INT64_C(25000000),
+    Q_INT64_C(50000000),
+    Q_INT64_C(100000000),
+    Q_INT64_C(250000000),
+    Q_INT64_C(500000000),
+    Q_INT64_C(1000000000),
+    Q_INT64_C(2500000000),
+    Q_INT64_C(5000000000),
+};
+
+enum MetricType
+{
+    CounterType,
+    GaugeType,
+    HistogramType
+};
+
+struct MetricEntry
+{
+    MetricEntry() : type(CounterType), metric(0) { }
+
+    MetricType type;
+    QString help;
+    void *metric;
+};
+
+typedef QMap<QString, MetricEntry> MetricMap;
+
+// Metrics are registered during static initialization, so the registry must be constructed
+// on first use.
+struct Registry
+{
+    QMutex mutex;
+    MetricMap metrics;
+
+    ~Registry()
+    {
+        foreach (const MetricEntry &entry, metrics) {
+            switch (entry.type) {
+            case CounterType:
+                delete static_cast<Lvk::Cmn::Counter *>(entry.metric);
+                break;
+            case GaugeType:
+                delete static_cast<Lvk::Cmn::Gauge *>(entry.metric);
+                break;
+            case HistogramType:
+                delete static_cast<Lvk::Cmn::Histogram *>(entry.metric);
+                break;
+            }
+        }
+    }
+};
+
+Registry &registry()
+{
+    static Registry reg;
+    return reg;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+template<class T>
+T *findOrCreate(const QString &name, const QString &help, MetricType type)
+{
+    Registry &reg = registry();
+
+    QMutexLocker locker(&reg.mutex);
+
+    MetricMap::iterator it = reg.metrics.find(name);
+
+    if (it != reg.metrics.end()) {
+        if (it->type == type) {
+            return static_cast<T *>(it->metric);
+        }
+
+        // Do not return a metric of a different type. Callers share a metric that is not
+        // exported, so nothing is allocated per call.
+        qCritical() << "Metrics: Metric" << name << "already registered with another type";
+
+        static T unregistered;
+        return &unregistered;
+    }
+
+    MetricEntry entry;
+    entry.type = type;
+    entry.help = help;
+    entry.metric = new T();
+
+    reg.metrics.insert(name, entry);
+
+    return static_cast<T *>(entry.metric);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+inline QString escapeHelp(QString help)
+{
+    return help.replace("\\", "\\\\").replace("\n", "\\n");
+}
+
+inline QString toSeconds(qint64 nsecs)
+{
+    return QString::number(nsecs/1e9, 'g', 9);
+}
+
+void writeHistogram(QTextStream &out, const QString &name, const Lvk::Cmn::Histogram &h)
+{
+    // Prometheus buckets are cumulative. The +Inf bucket and the count are taken from the
+    // same sum so the dump is consistent even if observations happen while writing it.
+    qint64 acc = 0;
+
+    for (int i = 0; i < Lvk::Cmn::Histogram::BucketCount; ++i) {
+        acc += h.bucket(i);
+
+        qint64 bound = Lvk::Cmn::Histogram::upperBound(i);
+        QString le = bound >= 0 ? toSeconds(bound) : QString("+Inf");
+
+        out << name << "_bucket{le=\"" << le << "\"} " << acc << "\n";
+    }
+
+    out << name << "_sum " << toSeconds(h.sum()) << "\n";
+    out << name << "_count " << acc << "\n";
+}
+
+} // namespace
+
+
+//--------------------------------------------------------------------------------------------------
+// Counter
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::Cmn::Counter::inc(qint64 n)
+{
+    atomicAdd(&m_value, n);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+qint64 Lvk::Cmn::Counter::value() const
+{
+    return atomicLoad(&m_value);
+}
+
+//--------------------------------------------------------------------------------------------------
+// Gauge
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::Cmn::Gauge::add(qint64 n)
+{
+    atomicAdd(&m_value, n);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::Cmn::Gauge::set(qint64 value)
+{
+    atomicSet(&m_value, value);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+qint64 Lvk::Cmn::Gauge::value() const
+{
+    return atomicLoad(&m_value);
+}
+
+//--------------------------------------------------------------------------------------------------
+// Histogram
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::Cmn::Histogram::observe(qint64 nsecs)
+{
+    int i = 0;
+    while (i < BucketCount - 1 && nsecs > BUCKET_BOUNDS[i]) {
+        ++i;
+    }
+
+    m_buckets[i].inc();
+    m_sum.inc(nsecs);
+    m_count.inc();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+qint64 Lvk::Cmn::Histogram::upperBound(int i)
+{
+    return i < BucketCount - 1 ? BUCKET_BOUNDS[i] : -1;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Metrics
+//--------------------------------------------------------------------------------------------------
+
+Lvk::Cmn::Counter * Lvk::Cmn::Metrics::counter(const QString &name, const QString &help)
+{
+    return findOrCreate<Counter>(name, help, CounterType);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+Lvk::Cmn::Gauge * Lvk::Cmn::Metrics::gauge(const QString &name, const QString &help)
+{
+    return findOrCreate<Gauge>(name, help, GaugeType);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+Lvk::Cmn::Histogram * Lvk::Cmn::Metrics::histogram(const QString &name, const QString &help)
+{
+    return findOrCreate<Histogram>(name, help, HistogramType);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+QString Lvk::Cmn::Metrics::toPrometheusText()
+{
+    Registry &reg = registry();
+
+    QMutexLocker locker(&reg.mutex);
+
+    QString text;
+    QTextStream out(&text);
+
+    for (MetricMap::const_iterator it = reg.metrics.constBegin();
+         it != reg.metrics.constEnd(); ++it) {
+        const QString &name = it.key();
+        const MetricEntry &entry = it.value();
+
+        out << "# HELP " << name << " " << escapeHelp(entry.help) << "\n";
+
+        switch (entry.type) {
+        case CounterType:
+            out << "# TYPE " << name << " counter\n";
+            out << name << " " << static_cast<Counter *>(entry.metric)->value() << "\n";
+            break;
+        case GaugeType:
+            out << "# TYPE " << name << " gauge\n";
+            out << name << " " << static_cast<Gauge *>(entry.metric)->value() << "\n";
+            break;
+        case HistogramType:
+            out << "# TYPE " << name << " histogram\n";
+            writeHistogram(out, name, *static_cast<Histogram *>(entry.metric));
+            break;
+        }
+    }
+
+    out.flush();
+
+    return text;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool Lvk::Cmn::Metrics::writeToFile(const QString &filename)
+{
+    QString tmpFilename = filename + ".tmp";
+
+    QFile file(tmpFilename);
+
+    if (!file.open(QFile::WriteOnly | QFile::Truncate)) {
+        qWarning() << "Metrics: Cannot open file" << tmpFilename;
+        return false;
+    }
+
+    QByteArray data = toPrometheusText().toUtf8();
+
+    if (file.write(data) != data.size() || !file.flush()) {
+        qWarning() << "Metrics: Cannot write file" << tmpFilename;
+        file.close();
+        QFile::remove(tmpFilename);
+        return false;
+    }
+
+    file.close();
+
+    // Readers see either the old or the new file, never a missing one
+    if (!FileUtils::replaceFile(tmpFilename, filename)) {
+        qWarning() << "Metrics: Cannot replace file" << filename << "with" << tmpFilename;
+        QFile::remove(tmpFilename);
+        return false;
+    }
+
+    return true;
+}
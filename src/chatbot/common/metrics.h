@@ -0,0 +1,262 @@
+/*
+ * Copyright (C) 2012 Andres Pagliano, Gabriel Miretti, Gonzalo Buteler,
+ * Nestor Bustamante, Pablo Perez de Angelis
+ *
+ * This file is part of LVK Chatbot.
+ *
+ * LVK Chatbot is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LVK Chatbot is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LVK Chatbot.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef LVK_CMN_METRICS_H
+#define LVK_CMN_METRICS_H
+
+#include <QString>
+#include <QElapsedTimer>
+#include <QtGlobal>
+
+namespace Lvk
+{
+
+/// \addtogroup Lvk
+/// @{
+
+namespace Cmn
+{
+
+/// \ingroup Lvk
+/// \addtogroup Cmn
+/// @{
+
+/**
+ * \brief The Counter class provides a monotonically increasing 64-bit metric.
+ *
+ * Counters are thread-safe and lock-free on platforms with 64-bit atomic builtins.
+ *
+ * \see Metrics
+ */
+class Counter
+{
+public:
+    Counter() : m_value(0) { }
+
+    /**
+     * Increments the counter by \a n
+     */
+    void inc(qint64 n = 1);
+
+    /**
+     * Returns the current value
+     */
+    qint64 value() const;
+
+private:
+    Counter(const Counter&);
+    Counter& operator=(const Counter&);
+
+    mutable volatile qint64 m_value;
+};
+
+
+/**
+ * \brief The Gauge class provides a 64-bit metric that can go up and down.
+ *
+ * Gauges are thread-safe and lock-free on platforms with 64-bit atomic builtins.
+ *
+ * \see Metrics
+ */
+class Gauge
+{
+public:
+    Gauge() : m_value(0) { }
+
+    /**
+     * Adds \a n to the gauge. \a n can be negative.
+     */
+    void add(qint64 n);
+
+    /**
+     * Increments the gauge by one
+     */
+    void inc() { add(1); }
+
+    /**
+     * Decrements the gauge by one
+     */
+    void dec() { add(-1); }
+
+    /**
+     * Sets the gauge to \a value
+     */
+    void set(qint64 value);
+
+    /**
+     * Returns the current value
+     */
+    qint64 value() const;
+
+private:
+    Gauge(const Gauge&);
+    Gauge& operator=(const Gauge&);
+
+    mutable volatile qint64 m_value;
+};
+
+
+/**
+ * \brief The Histogram class provides a latency metric with fixed buckets.
+ *
+ * Buckets go from 100 microseconds to 5 seconds. Each observation updates the sum, the count
+ * and exactly one bucket, so observations are lock-free as well.
+ *
+ * \see Metrics, ScopedLatency
+ */
+class Histogram
+{
+public:
+    /**
+     * Number of buckets including the +Inf bucket
+     */
+    static const int BucketCount = 16;
+
+    Histogram() { }
+
+    /**
+     * Records an observation of \a nsecs nanoseconds
+     */
+    void observe(qint64 nsecs);
+
+    /**
+     * Returns the amount of observations
+     */
+    qint64 count() const { return m_count.value(); }
+
+    /**
+     * Returns the sum of all observations in nanoseconds
+     */
+    qint64 sum() const { return m_sum.value(); }
+
+    /**
+     * Returns the amount of observations in bucket \a i. Buckets are not cumulative.
+     */
+    qint64 bucket(int i) const { return m_buckets[i].value(); }
+
+    /**
+     * Returns the upper bound of bucket \a i in nanoseconds or -1 for the +Inf bucket
+     */
+    static qint64 upperBound(int i);
+
+private:
+    Histogram(const Histogram&);
+    Histogram& operator=(const Histogram&);
+
+    Counter m_count;
+    Counter m_sum;
+    Counter m_buckets[BucketCount];
+};
+
+
+/**
+ * \brief The Metrics class provides a process-wide registry of runtime metrics.
+ *
+ * Metrics are registered by name and live until the application exits. Registering an existing
+ * name returns the same metric, hence modules usually keep the returned pointer in a file-scope
+ * variable and update it without further lookups:
+ *
+ * \code
+ * Lvk::Cmn::Counter *g_received =
+ *     Lvk::Cmn::Metrics::counter("chatbot_messages_received_total", "Messages received");
+ * ...
+ * g_received->inc();
+ * \endcode
+ *
+ * The registry can be dumped in the Prometheus text exposition format with toPrometheusText().
+ */
+class Metrics
+{
+public:
+
+    /**
+     * Returns the counter named \a name. If it does not exist, it is created with \a help.
+     */
+    static Counter *counter(const QString &name, const QString &help);
+
+    /**
+     * Returns the gauge named \a name. If it does not exist, it is created with \a help.
+     */
+    static Gauge *gauge(const QString &name, const QString &help);
+
+    /**
+     * Returns the histogram named \a name. If it does not exist, it is created with \a help.
+     * Histogram names should end with "_seconds".
+     */
+    static Histogram *histogram(const QString &name, const QString &help);
+
+    /**
+     * Returns all metrics in the Prometheus text exposition format
+     */
+    static QString toPrometheusText();
+
+    /**
+     * Writes toPrometheusText() to \a filename. The dump is written to a temporary file first
+     * so readers never see a partial dump. Returns true on success. Otherwise; returns false.
+     */
+    static bool writeToFile(const QString &filename);
+
+private:
+    Metrics();
+    Metrics(Metrics&);
+};
+
+
+/**
+ * \brief The ScopedLatency class provides a scoped timer that records its lifetime in a
+ *        histogram.
+ */
+class ScopedLatency
+{
+public:
+    explicit ScopedLatency(Histogram *histogram)
+        : m_histogram(histogram)
+    {
+        m_timer.start();
+    }
+
+    ~ScopedLatency()
+    {
+#if QT_VERSION >= 0x040800
+        m_histogram->observe(m_timer.nsecsElapsed());
+#else
+        m_histogram->observe(m_timer.elapsed()*Q_INT64_C(1000000));
+#endif
+    }
+
+private:
+    ScopedLatency(const ScopedLatency&);
+    ScopedLatency& operator=(const ScopedLatency&);
+
+    Histogram *m_histogram;
+    QElapsedTimer m_timer;
+};
+
+/// @}
+
+} // namespace Cmn
+
+/// @}
+
+} // namespace Lvk
+
+
+#endif // LVK_CMN_METRICS_H
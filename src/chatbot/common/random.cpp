@@ -22,16 +22,47 @@
 #include "common/random.h"
 
 #include <QDateTime>
+#include <QThreadStorage>
+#include <QAtomicInt>
 #include <cstdlib>
 
+//--------------------------------------------------------------------------------------------------
+// Helpers
+//--------------------------------------------------------------------------------------------------
+
+namespace
+{
+
+// qrand() keeps one state per thread. Allocated on the heap so it outlives static objects that
+// still use random numbers while the application exits.
+QThreadStorage<bool *> *g_seeded = new QThreadStorage<bool *>();
+
+// Threads seeded in the same second get different seeds
+QAtomicInt g_seedCount;
+
+} // namespace
+
+
+//--------------------------------------------------------------------------------------------------
+// Random
+//--------------------------------------------------------------------------------------------------
+
 int Lvk::Cmn::Random::getInt(int min, int max)
 {
-    static unsigned int seed = 0;
+    if (!g_seeded->hasLocalData()) {
+        setSeed(QDateTime::currentDateTime().toTime_t() + 7919*g_seedCount.fetchAndAddRelaxed(1));
+    }
+
+    return min + (int)(qrand()/((double)RAND_MAX + 1)*(max - min + 1));
+}
+
+//--------------------------------------------------------------------------------------------------
 
-    if (!seed) {
-        seed = QDateTime::currentDateTime().toTime_t();
-        srand(seed);
+void Lvk::Cmn::Random::setSeed(unsigned seed)
+{
+    if (!g_seeded->hasLocalData()) {
+        g_seeded->setLocalData(new bool(true));
     }
 
-    return min + (int)(rand()/(double)(RAND_MAX - 1)*(max - min + 1));
+    qsrand(seed);
 }
@@ -37,6 +37,9 @@ namespace Cmn
 
 /**
  * \brief The Random class generares random numbers.
+ *
+ * Each thread has its own generator. It is seeded on the first call in the thread, so worker
+ * threads do not repeat the numbers of other threads.
  */
 class Random
 {
@@ -46,6 +49,12 @@ public:
      */
     static int getInt(int min, int max);
 
+    /**
+     * Seeds the generator of the calling thread with \a seed. Useful to get the same numbers
+     * again, for instance in tests.
+     */
+    static void setSeed(unsigned seed);
+
 private:
     Random();
     Random(Random&);
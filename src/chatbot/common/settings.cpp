@@ -73,6 +73,36 @@ QVariant Lvk::Cmn::Settings::value(const QString &key, const QVariant &defaultVa
             defaultValue = QString(DEFAULT_LANG);
         } else if (key == SETTING_APP_SEND_STATS) {
             defaultValue = true;
+        } else if (key == SETTING_NLP_ENGINE) {
+            defaultValue = QString("cb2");
+        } else if (key == SETTING_TRACING_ENABLED) {
+            defaultValue = false;
+        } else if (key == SETTING_LOGGING_LEVEL) {
+            defaultValue = QString("debug");
+        } else if (key == SETTING_LOGGING_CATEGORIES) {
+            defaultValue = QString("all");
+        } else if (key == SETTING_METRICS_PORT) {
+            defaultValue = 0;
+        } else if (key == SETTING_METRICS_FILE_INTERVAL) {
+            defaultValue = 0;
+        } else if (key == SETTING_HISTORY_FORMAT) {
+            defaultValue = QString("csv");
+        } else if (key == SETTING_HISTORY_BUFFER_SIZE) {
+            defaultValue = 0;
+        } else if (key == SETTING_HISTORY_FLUSH_INTERVAL) {
+            defaultValue = 1000;
+        } else if (key == SETTING_HISTORY_SYNC) {
+            defaultValue = false;
+        } else if (key == SETTING_HISTORY_WINDOW_SIZE) {
+            defaultValue = 10000;
+        } else if (key == SETTING_CORPUS_BUFFER_SIZE) {
+            defaultValue = 64*1024;
+        } else if (key == SETTING_CORPUS_FLUSH_INTERVAL) {
+            defaultValue = 1000;
+        } else if (key == SETTING_CORPUS_MAX_SIZE) {
+            defaultValue = 0;
+        } else if (key == SETTING_CORPUS_COMPRESS) {
+            defaultValue = false;
         }
     }
 
@@ -41,7 +41,27 @@
 #define SETTING_MAIN_WINDOW_RULE_EDIT_W             "MainWindow/RuleEditWidget/Width"
 
 #define SETTING_NLP_LANGUAGE                        "NlpEngine/Language"
+#define SETTING_NLP_ENGINE                          "NlpEngine/Engine"
 
 #define SETTING_CLUE_WIDGET_COLS_W                  "Clue/Columns/Width"
 
+#define SETTING_TRACING_ENABLED                     "Tracing/Enabled"
+
+#define SETTING_LOGGING_LEVEL                       "Logging/Level"
+#define SETTING_LOGGING_CATEGORIES                  "Logging/Categories"
+
+#define SETTING_METRICS_PORT                        "Metrics/Port"
+#define SETTING_METRICS_FILE_INTERVAL               "Metrics/FileInterval"
+
+#define SETTING_HISTORY_FORMAT                      "History/Format"
+#define SETTING_HISTORY_BUFFER_SIZE                 "History/BufferSize"
+#define SETTING_HISTORY_FLUSH_INTERVAL              "History/FlushInterval"
+#define SETTING_HISTORY_SYNC                        "History/Sync"
+#define SETTING_HISTORY_WINDOW_SIZE                 "History/WindowSize"
+
+#define SETTING_CORPUS_BUFFER_SIZE                  "Corpus/BufferSize"
+#define SETTING_CORPUS_FLUSH_INTERVAL               "Corpus/FlushInterval"
+#define SETTING_CORPUS_MAX_SIZE                     "Corpus/MaxSize"
+#define SETTING_CORPUS_COMPRESS                     "Corpus/Compress"
+
 #endif // LVK_CMN_SETTINGSKEYS_H
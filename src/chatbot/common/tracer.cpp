@@ -0,0 +1,478 @@
+/*
+ * Copyright (C) 2012 Andres Pagliano, Gabriel Miretti, Gonzalo Buteler,
+ * Nestor Bustamante, Pablo Perez de Angelis
+ *
+ * This file is part of LVK Chatbot.
+ *
+ * LVK Chatbot is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LVK Chatbot is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LVK Chatbot.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/tracer.h"
+#include "common/settings.h"
+#include "common/settingskeys.h"
+
+#include <QHash>
+#include <QList>
+#include <QMap>
+#include <QVector>
+#include <QFile>
+#include <QDir>
+#include <QStringList>
+#include <QTextStream>
+#include <QThread>
+#include <QThreadStorage>
+#include <QtAlgorithms>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QElapsedTimer>
+#include <QCoreApplication>
+#include <QtDebug>
+
+#define MAX_EVENTS          65536
+#define MAX_THREAD_EVENTS   16384
+#define MAX_BUCKETS         40
+#define REPORT_FILENAME     "trace.txt"
+#define TRACE_FILENAME      "trace.json"
+
+//--------------------------------------------------------------------------------------------------
+// Helpers
+//--------------------------------------------------------------------------------------------------
+
+namespace
+{
+
+struct StageStats
+{
+    StageStats() : count(0), total(0), max(0), buckets(MAX_BUCKETS) { }
+
+    qint64 count;
+    qint64 total;
+    qint64 max;
+    QVector<qint64> buckets;    // Power-of-two buckets in microseconds
+
+    void add(qint64 nsecs)
+    {
+        ++count;
+        total += nsecs;
+        max = qMax(max, nsecs);
+
+        qint64 usecs = nsecs/1000;
+        int b = 0;
+        while (usecs > 0 && b < MAX_BUCKETS - 1) {
+            usecs >>= 1;
+            ++b;
+        }
+        ++buckets[b];
+    }
+
+    void merge(const StageStats &other)
+    {
+        count += other.count;
+        total += other.total;
+        max = qMax(max, other.max);
+        for (int b = 0; b < MAX_BUCKETS; ++b) {
+            buckets[b] += other.buckets[b];
+        }
+    }
+
+    // Returns the upper bound in microseconds of the bucket of percentile p
+    qint64 percentile(double p) const
+    {
+        qint64 rank = static_cast<qint64>(p/100.0*count);
+        qint64 acc = 0;
+        for (int b = 0; b < MAX_BUCKETS; ++b) {
+            acc += buckets[b];
+            if (acc > rank) {
+                return Q_INT64_C(1) << b;
+            }
+        }
+        return max/1000;
+    }
+};
+
+struct TraceEvent
+{
+    const char *name;
+    quintptr tid;
+    qint64 start;
+    qint64 duration;
+};
+
+// Stages are keyed by the address of the name literal. The same name can have several
+// addresses, so stages are merged by name when reporting.
+typedef QHash<const char *, StageStats> StatsHash;
+
+// Fixed-size buffer of the last events
+struct EventRing
+{
+    EventRing(int capacity) : capacity(capacity), next(0) { }
+
+    int capacity;
+    int next;
+    QVector<TraceEvent> events;
+
+    void add(const TraceEvent &e)
+    {
+        if (events.size() < capacity) {
+            events.append(e);
+        } else {
+            events[next] = e;
+        }
+        next = (next + 1) % capacity;
+    }
+
+    // Appends the events to list from the oldest to the newest
+    void copyTo(QVector<TraceEvent> &list) const
+    {
+        int first = events.size() < capacity ? 0 : next;
+        for (int i = 0; i < events.size(); ++i) {
+            list.append(events[(first + i) % events.size()]);
+        }
+    }
+
+    void clear()
+    {
+        events.clear();
+        next = 0;
+    }
+};
+
+// Spans recorded by one thread. Only the owner thread records, the mutex is only contended
+// while a report or a trace is being written.
+struct ThreadBuffer
+{
+    ThreadBuffer() : events(MAX_THREAD_EVENTS) { }
+
+    QMutex mutex;
+    StatsHash stats;
+    EventRing events;
+};
+
+// Buffers of all threads. Never deleted, threads can finish after static destructors run.
+struct BufferRegistry
+{
+    BufferRegistry() : retiredEvents(MAX_EVENTS) { }
+
+    QMutex mutex;
+    QList<ThreadBuffer *> buffers;          // Buffers of live threads
+    StatsHash retiredStats;                 // Spans of finished threads
+    EventRing retiredEvents;
+};
+
+QElapsedTimer g_clock;
+BufferRegistry *g_registry = new BufferRegistry();
+
+// Registers the buffer of the current thread on creation and merges it into the retired
+// spans when the thread finishes
+struct ThreadBufferRef
+{
+    ThreadBufferRef();
+    ~ThreadBufferRef();
+
+    ThreadBuffer *buffer;
+};
+
+QThreadStorage<ThreadBufferRef *> *g_threadBuffer = new QThreadStorage<ThreadBufferRef *>();
+
+//--------------------------------------------------------------------------------------------------
+
+inline bool eventBefore(const TraceEvent &e1, const TraceEvent &e2)
+{
+    return e1.start < e2.start;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+inline QString logsPath()
+{
+    Lvk::Cmn::Settings settings;
+    return settings.value(SETTING_LOGS_PATH).toString() + QDir::separator();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+QMap<QString, StageStats> mergedStats()
+{
+    QMutexLocker locker(&g_registry->mutex);
+
+    QMap<QString, StageStats> stats;
+
+    StatsHash::const_iterator it;
+    for (it = g_registry->retiredStats.constBegin(); it != g_registry->retiredStats.constEnd();
+         ++it) {
+        stats[QString::fromLatin1(it.key())].merge(it.value());
+    }
+
+    foreach (ThreadBuffer *buffer, g_registry->buffers) {
+        QMutexLocker bufferLocker(&buffer->mutex);
+        for (it = buffer->stats.constBegin(); it != buffer->stats.constEnd(); ++it) {
+            stats[QString::fromLatin1(it.key())].merge(it.value());
+        }
+    }
+
+    return stats;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+// Returns the last MAX_EVENTS events of all threads sorted by start time
+QVector<TraceEvent> mergedEvents()
+{
+    QMutexLocker locker(&g_registry->mutex);
+
+    QVector<TraceEvent> events;
+
+    g_registry->retiredEvents.copyTo(events);
+
+    foreach (ThreadBuffer *buffer, g_registry->buffers) {
+        QMutexLocker bufferLocker(&buffer->mutex);
+        buffer->events.copyTo(events);
+    }
+
+    qStableSort(events.begin(), events.end(), eventBefore);
+
+    if (events.size() > MAX_EVENTS) {
+        events.remove(0, events.size() - MAX_EVENTS);
+    }
+
+    return events;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+ThreadBufferRef::ThreadBufferRef()
+    : buffer(new ThreadBuffer())
+{
+    QMutexLocker locker(&g_registry->mutex);
+
+    g_registry->buffers.append(buffer);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+ThreadBufferRef::~ThreadBufferRef()
+{
+    QMutexLocker locker(&g_registry->mutex);
+
+    g_registry->buffers.removeOne(buffer);
+
+    for (StatsHash::const_iterator it = buffer->stats.constBegin();
+         it != buffer->stats.constEnd(); ++it) {
+        g_registry->retiredStats[it.key()].merge(it.value());
+    }
+
+    QVector<TraceEvent> events;
+    buffer->events.copyTo(events);
+    foreach (const TraceEvent &e, events) {
+        g_registry->retiredEvents.add(e);
+    }
+
+    delete buffer;
+}
+
+} // namespace
+
+
+//--------------------------------------------------------------------------------------------------
+// Tracer
+//--------------------------------------------------------------------------------------------------
+
+volatile bool Lvk::Cmn::Tracer::m_enabled = false;
+QMutex *Lvk::Cmn::Tracer::m_mutex = new QMutex();
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::Cmn::Tracer::init()
+{
+    Cmn::Settings settings;
+
+    if (settings.value(SETTING_TRACING_ENABLED).toBool()) {
+        setEnabled(true);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::Cmn::Tracer::shutdown()
+{
+    if (!m_enabled) {
+        return;
+    }
+
+    setEnabled(false);
+
+    dump();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool Lvk::Cmn::Tracer::dump()
+{
+    bool success = true;
+
+    QFile file(logsPath() + REPORT_FILENAME);
+    if (file.open(QFile::WriteOnly | QFile::Truncate)) {
+        file.write(report().toUtf8());
+    } else {
+        qWarning() << "Tracer: Cannot write report to" << file.fileName();
+        success = false;
+    }
+
+    if (!writeChromeTrace(logsPath() + TRACE_FILENAME)) {
+        qWarning() << "Tracer: Cannot write trace events to" << logsPath() + TRACE_FILENAME;
+        success = false;
+    }
+
+    return success;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::Cmn::Tracer::setEnabled(bool enabled)
+{
+    QMutexLocker locker(m_mutex);
+
+    if (enabled && !g_clock.isValid()) {
+        g_clock.start();
+    }
+
+    m_enabled = enabled;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+qint64 Lvk::Cmn::Tracer::now()
+{
+#if QT_VERSION >= 0x040800
+    return g_clock.nsecsElapsed();
+#else
+    return g_clock.elapsed()*Q_INT64_C(1000000);
+#endif
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::Cmn::Tracer::record(const char *name, qint64 start, qint64 duration)
+{
+    if (!m_enabled) {
+        return;
+    }
+
+    if (!g_threadBuffer->hasLocalData()) {
+        g_threadBuffer->setLocalData(new ThreadBufferRef());
+    }
+
+    ThreadBuffer *buffer = g_threadBuffer->localData()->buffer;
+
+    TraceEvent e;
+    e.name = name;
+    e.tid = reinterpret_cast<quintptr>(QThread::currentThreadId());
+    e.start = start;
+    e.duration = duration;
+
+    // Uncontended unless the spans are being reported
+    QMutexLocker locker(&buffer->mutex);
+
+    buffer->stats[name].add(duration);
+    buffer->events.add(e);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+QString Lvk::Cmn::Tracer::report()
+{
+    QMutexLocker locker(m_mutex);
+
+    QStringList lines;
+    lines.append(QString("%1 %2 %3 %4 %5 %6 %7")
+                 .arg("stage", -28)
+                 .arg("count", 10)
+                 .arg("total ms", 12)
+                 .arg("avg us", 10)
+                 .arg("p50 us", 10)
+                 .arg("p99 us", 10)
+                 .arg("max us", 10));
+
+    QMap<QString, StageStats> stats = mergedStats();
+
+    for (QMap<QString, StageStats>::const_iterator it = stats.constBegin();
+         it != stats.constEnd(); ++it) {
+        const StageStats &s = it.value();
+        lines.append(QString("%1 %2 %3 %4 %5 %6 %7")
+                     .arg(it.key(), -28)
+                     .arg(s.count, 10)
+                     .arg(s.total/1e6, 12, 'f', 2)
+                     .arg(s.count ? s.total/1e3/s.count : 0.0, 10, 'f', 1)
+                     .arg(QString("<=%1").arg(s.percentile(50)), 10)
+                     .arg(QString("<=%1").arg(s.percentile(99)), 10)
+                     .arg(s.max/1e3, 10, 'f', 1));
+    }
+
+    return lines.join("\n") + "\n";
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool Lvk::Cmn::Tracer::writeChromeTrace(const QString &filename)
+{
+    QMutexLocker locker(m_mutex);
+
+    QFile file(filename);
+    if (!file.open(QFile::WriteOnly | QFile::Truncate)) {
+        return false;
+    }
+
+    QTextStream stream(&file);
+    qint64 pid = QCoreApplication::applicationPid();
+
+    QVector<TraceEvent> events = mergedEvents();
+
+    stream << "{\"traceEvents\":[\n";
+
+    for (int i = 0; i < events.size(); ++i) {
+        const TraceEvent &e = events[i];
+
+        // Chrome expects microseconds
+        stream << (i > 0 ? ",\n" : "")
+               << "{\"name\":\"" << e.name << "\",\"ph\":\"X\""
+               << ",\"ts\":" << QString::number(e.start/1e3, 'f', 3)
+               << ",\"dur\":" << QString::number(e.duration/1e3, 'f', 3)
+               << ",\"pid\":" << pid
+               << ",\"tid\":" << static_cast<quint64>(e.tid) << "}";
+    }
+
+    stream << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+    return stream.status() == QTextStream::Ok;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::Cmn::Tracer::clear()
+{
+    QMutexLocker locker(m_mutex);
+
+    QMutexLocker registryLocker(&g_registry->mutex);
+
+    g_registry->retiredStats.clear();
+    g_registry->retiredEvents.clear();
+
+    foreach (ThreadBuffer *buffer, g_registry->buffers) {
+        QMutexLocker bufferLocker(&buffer->mutex);
+        buffer->stats.clear();
+        buffer->events.clear();
+    }
+}
+
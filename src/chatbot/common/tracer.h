@@ -0,0 +1,184 @@
+/*
+ * Copyright (C) 2012 Andres Pagliano, Gabriel Miretti, Gonzalo Buteler,
+ * Nestor Bustamante, Pablo Perez de Angelis
+ *
+ * This file is part of LVK Chatbot.
+ *
+ * LVK Chatbot is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LVK Chatbot is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LVK Chatbot.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef LVK_CMN_TRACER_H
+#define LVK_CMN_TRACER_H
+
+#include <QString>
+#include <QtGlobal>
+
+/**
+ * \def TRACE_SPAN(name)
+ *
+ * Measures the time spent from this point until the end of the current scope and records it
+ * as a span of the stage \a name. \a name must be a string literal.
+ *
+ * Spans are compiled only if ENABLE_TRACING is defined, i.e. if the application is built with
+ * CONFIG += tracing. Otherwise the macro expands to nothing.
+ * When compiled, spans are recorded only if tracing is enabled at runtime.
+ *
+ * \see Tracer
+ */
+#ifdef ENABLE_TRACING
+# define TRACE_SPAN_CONCAT2(a, b)   a##b
+# define TRACE_SPAN_CONCAT(a, b)    TRACE_SPAN_CONCAT2(a, b)
+# define TRACE_SPAN(name)           Lvk::Cmn::TraceSpan TRACE_SPAN_CONCAT(traceSpan, __LINE__)(name)
+#else
+# define TRACE_SPAN(name)
+#endif
+
+class QMutex;
+
+namespace Lvk
+{
+
+/// \addtogroup Lvk
+/// @{
+
+namespace Cmn
+{
+
+/// \ingroup Lvk
+/// \addtogroup Cmn
+/// @{
+
+/**
+ * \brief The Tracer class collects timing spans of the message pipeline.
+ *
+ * Spans are recorded with the TRACE_SPAN() macro. For each stage, the tracer keeps the amount
+ * of spans, the total and the maximum time and a latency histogram with power-of-two buckets.
+ * The tracer also keeps the last spans in a fixed-size buffer that can be exported in the
+ * Chrome trace-event format (chrome://tracing).
+ *
+ * Each thread records its spans in its own buffer, so recording threads do not contend on a
+ * global lock. Buffers are merged when the report or the trace is written, and the buffer of
+ * a finished thread is merged into the tracer when the thread exits.
+ *
+ * Tracing is disabled by default. It can be enabled with setEnabled() or with the application
+ * setting SETTING_TRACING_ENABLED.
+ */
+class Tracer
+{
+public:
+
+    /**
+     * Initializes the tracer with the application settings
+     */
+    static void init();
+
+    /**
+     * If tracing is enabled, writes the report and the trace events in the logs directory.
+     */
+    static void shutdown();
+
+    /**
+     * Writes the report and the trace events in the logs directory without stopping tracing.
+     * Returns true on success. Otherwise; returns false.
+     */
+    static bool dump();
+
+    /**
+     * Enables or disables tracing
+     */
+    static void setEnabled(bool enabled);
+
+    /**
+     * Returns true if tracing is enabled. Otherwise; returns false.
+     */
+    static bool isEnabled()
+    {
+        return m_enabled;
+    }
+
+    /**
+     * Returns the amount of nanoseconds elapsed since tracing was enabled
+     */
+    static qint64 now();
+
+    /**
+     * Records a span of the stage \a name that started at \a start and lasted \a duration
+     * nanoseconds. \a name must be a string literal.
+     */
+    static void record(const char *name, qint64 start, qint64 duration);
+
+    /**
+     * Returns a human-readable report with the statistics of each stage
+     */
+    static QString report();
+
+    /**
+     * Writes the recorded spans in the Chrome trace-event JSON format to \a filename.
+     * Returns true on success. Otherwise; returns false.
+     */
+    static bool writeChromeTrace(const QString &filename);
+
+    /**
+     * Removes all recorded spans and statistics
+     */
+    static void clear();
+
+private:
+    Tracer();
+    Tracer(Tracer&);
+
+    static volatile bool m_enabled;
+    static QMutex *m_mutex;
+};
+
+
+/**
+ * \brief The TraceSpan class provides a scoped timer that records a span when it goes out of
+ *        scope.
+ *
+ * Do not use this class directly, use the TRACE_SPAN() macro instead.
+ */
+class TraceSpan
+{
+public:
+    explicit TraceSpan(const char *name)
+        : m_name(name), m_start(Tracer::isEnabled() ? Tracer::now() : -1) { }
+
+    ~TraceSpan()
+    {
+        if (m_start >= 0) {
+            Tracer::record(m_name, m_start, Tracer::now() - m_start);
+        }
+    }
+
+private:
+    TraceSpan(const TraceSpan&);
+    TraceSpan& operator=(const TraceSpan&);
+
+    const char *m_name;
+    qint64 m_start;
+};
+
+/// @}
+
+} // namespace Cmn
+
+/// @}
+
+} // namespace Lvk
+
+
+#endif // LVK_CMN_TRACER_H
+
@@ -23,6 +23,7 @@
 #include "da-clue/analyzedscript.h"
 #include "da-clue/script.h"
 #include "nlp-engine/enginefactory.h"
+#include "nlp-engine/lemmatizerfactory.h"
 #include "nlp-engine/nlpproperties.h"
 
 #include <QtDebug>
@@ -34,6 +35,8 @@
 Lvk::Clue::ClueEngine::ClueEngine()
     : m_engine(Nlp::EngineFactory().createEngine())
 {
+    // Own lemmatizer, the tools of the chatbot engine are not touched
+    m_engine->setLemmatizer(Nlp::LemmatizerFactory().createLemmatizer());
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -21,6 +21,7 @@
 
 #include "da-clue/regexp.h"
 #include "nlp-engine/enginefactory.h"
+#include "nlp-engine/lemmatizerfactory.h"
 #include "nlp-engine/rule.h"
 
 #include <QStringList>
@@ -34,6 +35,8 @@
 Lvk::Clue::RegExp::RegExp()
     : m_engine(Nlp::EngineFactory().createEngine())
 {
+    // Patterns are lemmatized the same way chatbot rules are
+    m_engine->setLemmatizer(Nlp::LemmatizerFactory().createLemmatizer());
 }
 
 //--------------------------------------------------------------------------------------------------
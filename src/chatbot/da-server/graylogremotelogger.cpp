@@ -24,6 +24,7 @@
 #include "da-server/syslog.h"
 #include "da-server/serverconfig.h"
 #include "common/version.h"
+#include "common/metrics.h"
 #include "crypto/cipher.h"
 #include "crypto/keymanagerfactory.h"
 
@@ -40,6 +41,14 @@
 namespace
 {
 
+Lvk::Cmn::Counter *g_remoteLogs = Lvk::Cmn::Metrics::counter(
+        "chatbot_remote_log_messages_total", "Messages sent to the remote logger");
+
+Lvk::Cmn::Counter *g_remoteLogErrors = Lvk::Cmn::Metrics::counter(
+        "chatbot_remote_log_errors_total", "Messages that could not be sent to the remote logger");
+
+//--------------------------------------------------------------------------------------------------
+
 // convert RemoteLogger::FieldList to Gelf::FieldList
 inline Lvk::DAS::Gelf::FieldList toGelfFields(const Lvk::DAS::RemoteLogger::FieldList &fields)
 {
@@ -190,22 +199,35 @@ int Lvk::DAS::GraylogRemoteLogger::log(const QString &msg, const FieldList &fiel
         break;
     }
 
+    g_remoteLogs->inc();
+
     if (data.isNull()) {
+        g_remoteLogErrors->inc();
         return 1;
     }
 
     // Send message with proper protocol
 
+    int err = 1;
+
     switch (m_format) {
     case GELF:
     case SyslogUDP:
-        return sendUdpMessage(data, m_host, m_udpPort);
+        err = sendUdpMessage(data, m_host, m_udpPort);
+        break;
     case SyslogTCP:
     case EncSyslogTCP:
-        return sendTcpMessage(data, m_host, m_tcpPort);
+        err = sendTcpMessage(data, m_host, m_tcpPort);
+        break;
     default:
-        return 1;
+        break;
     }
+
+    if (err != 0) {
+        g_remoteLogErrors->inc();
+    }
+
+    return err;
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -58,7 +58,8 @@ enum
     HashKeyRole = Qt::UserRole,
     EntryMatchRole,
     EntryFromRole,
-    EntryRuleIdRole
+    EntryRuleIdRole,
+    EntryDateRole
 };
 
 
@@ -249,6 +250,7 @@ void Lvk::FE::ChatHistoryWidget::clearConversations()
     ui->filter->setEnabled(false);
 
     m_entries.clear();
+    m_pending.clear();
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -262,6 +264,11 @@ void Lvk::FE::ChatHistoryWidget::addConversationEntry(const Lvk::Cmn::Conversati
 
     QString key = hashKey(entry);
 
+    // The entry will be loaded with the rest of the conversation
+    if (m_pending.contains(key)) {
+        return;
+    }
+
     if (!m_entries.contains(key)) {
         m_entries[key] = EntryList();
 
@@ -304,6 +311,13 @@ void Lvk::FE::ChatHistoryWidget::onDateContactRowChanged(const QModelIndex &curr
 
         QTableWidgetItem *selectedItem = ui->dateContactTable->item(row, current.column());
         QString key = selectedItem->data(HashKeyRole).toString();
+
+        if (m_pending.contains(key)) {
+            QTableWidgetItem *userItem = ui->dateContactTable->item(row, UsernameColumn);
+            emit conversationRequested(userItem->data(EntryDateRole).toDate(),
+                                       userItem->data(EntryFromRole).toString());
+        }
+
         const EntryList &entries = m_entries[key];
 
         for (int i = 0; i < entries.size(); ++i) {
@@ -391,6 +405,8 @@ void Lvk::FE::ChatHistoryWidget::addDateContactTableRow(const Lvk::Cmn::Conversa
     ui->dateContactTable->item(nextRow, DateColumnn)->setData(HashKeyRole, hashKey(entry));
     ui->dateContactTable->item(nextRow, UsernameColumn)->setData(HashKeyRole, hashKey(entry));
     ui->dateContactTable->item(nextRow, UsernameColumn)->setData(EntryFromRole, entry.from);
+    ui->dateContactTable->item(nextRow, UsernameColumn)->setData(EntryDateRole,
+                                                                 entry.dateTime.date());
 
     if (username.contains("@gmail.com")) {
         ui->dateContactTable->item(nextRow, UsernameColumn)->setIcon(QIcon(GMAIL_ICON));
@@ -414,6 +430,60 @@ void Lvk::FE::ChatHistoryWidget::setConversation(const Lvk::Cmn::Conversation &c
 
 //--------------------------------------------------------------------------------------------------
 
+void Lvk::FE::ChatHistoryWidget::setConversationList(
+        const Lvk::Cmn::Conversation::DateContactList &list)
+{
+    clear();
+
+    Lvk::Cmn::Conversation::Entry entry;
+
+    foreach (const Lvk::Cmn::Conversation::DateContact &dateContact, list) {
+        entry.dateTime = QDateTime(dateContact.first);
+        entry.from = dateContact.second;
+
+        // Do not display Facebook's own messages
+        if (entry.from.startsWith(OWN_MESSAGE_TOKEN)) {
+            continue;
+        }
+
+        QString key = hashKey(entry);
+
+        if (!m_entries.contains(key)) {
+            m_entries[key] = EntryList();
+            m_pending.insert(key);
+
+            addDateContactTableRow(entry);
+        }
+    }
+
+    if (ui->dateContactTable->rowCount() > 0) {
+        ui->removeHistoryButton->setEnabled(true);
+        ui->filter->setEnabled(true);
+        ui->dateContactTable->selectRow(0);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::FE::ChatHistoryWidget::setConversationEntries(const QDate &date, const QString &from,
+                                                        const Lvk::Cmn::Conversation &conv)
+{
+    QString key = hashKey(date.toString(DATE_FORMAT), from);
+
+    EntryList &entries = m_entries[key];
+    entries.clear();
+
+    foreach (const Lvk::Cmn::Conversation::Entry &entry, conv.entries()) {
+        if (!entry.from.startsWith(OWN_MESSAGE_TOKEN)) {
+            entries.append(entry);
+        }
+    }
+
+    m_pending.remove(key);
+}
+
+//--------------------------------------------------------------------------------------------------
+
 void Lvk::FE::ChatHistoryWidget::onCellDoubleClicked(int row, int /*col*/)
 {
     if (!rowHasMatchStatus(row)) {
@@ -511,13 +581,14 @@ void Lvk::FE::ChatHistoryWidget::removeSelectedWithDialog()
     QString date = ui->dateContactTable->item(row, DateColumnn)->text();
     QString user = ui->dateContactTable->item(row, UsernameColumn)->text();
     QString from = ui->dateContactTable->item(row, UsernameColumn)->data(EntryFromRole).toString();
+    QDate qdate = ui->dateContactTable->item(row, UsernameColumn)->data(EntryDateRole).toDate();
 
     QString title = tr("Remove conversation");
     QString text  = tr("Are you sure you want to remove the conversation with %1 on %2?");
 
     if (askConfirmation(title, text.arg(user, date))) {
         removeDateContactRow(row);
-        emit removed(QDate::fromString(date, DATE_FORMAT), from);
+        emit removed(qdate, from);
     }
 }
 
@@ -529,6 +600,7 @@ void Lvk::FE::ChatHistoryWidget::removeDateContactRow(int row)
     QString from = ui->dateContactTable->item(row, UsernameColumn)->data(EntryFromRole).toString();
 
     m_entries.remove(hashKey(date, from));
+    m_pending.remove(hashKey(date, from));
     ui->dateContactTable->removeRow(row);
 
     if (ui->dateContactTable->rowCount() == 0) {
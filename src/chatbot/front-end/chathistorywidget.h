@@ -25,6 +25,7 @@
 #include <QWidget>
 #include <QHash>
 #include <QList>
+#include <QSet>
 
 #include "common/conversation.h"
 
@@ -56,6 +57,10 @@ namespace FE
  *
  * The ChatHistoryWidget is used in the "History" tab.
  *
+ * Conversations can be loaded all at once with setConversation() or on demand with
+ * setConversationList(). In the latter case, the widget emits conversationRequested() the first
+ * time a conversation is selected and the receiver must call setConversationEntries().
+ *
  * \see Cmn::Conversation
  */
 class ChatHistoryWidget : public QWidget
@@ -97,6 +102,19 @@ public:
      */
     void setConversation(const Lvk::Cmn::Conversation &conv);
 
+    /**
+     * Sets the list of conversations without their entries. Entries are requested on demand.
+     *
+     * \see conversationRequested()
+     */
+    void setConversationList(const Lvk::Cmn::Conversation::DateContactList &list);
+
+    /**
+     * Sets the entries \a conv of the conversation held with \a from on \a date
+     */
+    void setConversationEntries(const QDate &date, const QString &from,
+                                const Lvk::Cmn::Conversation &conv);
+
     /**
      * Adds a single conversation \a entry
      */
@@ -126,12 +144,19 @@ signals:
      */
     void removed(const QDate &date, const QString &username);
 
+    /**
+     * This signal is emitted if the conversation held with \a from on \a date is selected and
+     * its entries have not been set yet.
+     */
+    void conversationRequested(const QDate &date, const QString &from);
+
 private:
 
     Ui::ChatHistoryWidget *ui;
 
     typedef QList<Lvk::Cmn::Conversation::Entry> EntryList;
     QHash<QString, EntryList> m_entries;
+    QSet<QString> m_pending;    // Conversations not loaded yet
 
     void setupTables();
     void setupMenus();
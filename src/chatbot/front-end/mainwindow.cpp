@@ -296,6 +296,8 @@ void Lvk::FE::MainWindow::connectSignals()
     connect(ui->chatHistory,          SIGNAL(removedAll()),      SLOT(onRemovedAllHistory()));
     connect(ui->chatHistory,          SIGNAL(removed(QDate,QString)),
             SLOT(onRemovedHistory(QDate,QString)));
+    connect(ui->chatHistory,          SIGNAL(conversationRequested(QDate,QString)),
+            SLOT(onHistoryConversationRequested(QDate,QString)));
     connect(m_appFacade,              SIGNAL(newConversationEntry(Cmn::Conversation::Entry)),
             SLOT(onNewChatConversation(Cmn::Conversation::Entry)));
 
@@ -741,7 +743,7 @@ bool Lvk::FE::MainWindow::load(const QString &filename)
     bool success = initWithFile(filename);
 
     if (success) {
-        ui->chatHistory->setConversation(m_appFacade->chatHistory());
+        ui->chatHistory->setConversationList(m_appFacade->chatHistoryContacts());
         ui->ruleEditWidget->setRoster(m_appFacade->roster());
         ui->testInputText->setRoster(m_appFacade->roster());
 
@@ -1208,14 +1210,7 @@ const Lvk::BE::Rule *Lvk::FE::MainWindow::findRule(quint64 ruleId) const
         return 0;
     }
 
-    for (BE::Rule::const_iterator it = root->begin(); it != root->end(); ++it) {
-        const BE::Rule* rule = *it;
-        if (rule->id() == ruleId /*&& rule->type() == BE::Rule::OrdinaryRule*/) {
-            return rule;
-        }
-    }
-
-    return 0;
+    return root->findById(ruleId);
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -1252,6 +1247,13 @@ void Lvk::FE::MainWindow::onRemovedHistory(const QDate &date, const QString &use
 
 //--------------------------------------------------------------------------------------------------
 
+void Lvk::FE::MainWindow::onHistoryConversationRequested(const QDate &date, const QString &from)
+{
+    ui->chatHistory->setConversationEntries(date, from, m_appFacade->chatHistory(date, from));
+}
+
+//--------------------------------------------------------------------------------------------------
+
 void Lvk::FE::MainWindow::onHistoryShowRule(quint64 ruleId)
 {
     showRule(ruleId);
@@ -218,6 +218,7 @@ private slots:
     void onHistoryShowRule(quint64 ruleId);
     void onRemovedAllHistory();
     void onRemovedHistory(const QDate &date, const QString &username);
+    void onHistoryConversationRequested(const QDate &date, const QString &from);
 
     void onRuleInputEdited(const QString &input);
     void onRuleAdded();
@@ -346,11 +346,7 @@ void Lvk::FE::RuleTreeModel::clear()
 
 int Lvk::FE::RuleTreeModel::rowForItem(const BE::Rule *item) const
 {
-    if (item->parent()) {
-        return item->parent()->children().indexOf((BE::Rule *)item);
-    }
-
-    return 0;
+    return item->row();
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -435,15 +435,13 @@ const Lvk::BE::Rule *Lvk::FE::ScriptCoverageWidget::findRule(quint64 ruleId)
         return 0;
     }
 
+    if (ruleId != 0) {
+        return m_root->findById(ruleId);
+    }
+
     for (BE::Rule::const_iterator it = m_root->begin(); it != m_root->end(); ++it) {
-        if (ruleId != 0) {
-            if ((*it)->id() == ruleId) {
-                return *it;
-            }
-        } else {
-            if ((*it)->type() == BE::Rule::EvasiveRule) {
-                return *it;
-            }
+        if ((*it)->type() == BE::Rule::EvasiveRule) {
+            return *it;
         }
     }
 
@@ -0,0 +1,275 @@
+/*
+ * Copyright (C) 2012 Andres Pagliano, Gabriel Miretti, Gonzalo Buteler,
+ * Nestor Bustamante, Pablo Perez de Angelis
+ *
+ * This file is part of LVK Chatbot.
+ *
+ * LVK Chatbot is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LVK Chatbot is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LVK Chatbot.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "main/bothost.h"
+#include "back-end/hostedbot.h"
+#include "back-end/chatbotrulesfile.h"
+#include "nlp-engine/stringpool.h"
+
+#include <QSettings>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QStringList>
+#include <QSet>
+#include <QDir>
+#include <QTimer>
+#include <QtDebug>
+#include <memory>
+
+// Editors and the chatbot app write files in several steps, wait until they are done
+#define RELOAD_DELAY        1000
+
+
+//--------------------------------------------------------------------------------------------------
+// BotConfig
+//--------------------------------------------------------------------------------------------------
+
+bool BotHost::BotConfig::operator==(const BotConfig &other) const
+{
+    return filename == other.filename && type == other.type && username == other.username
+            && password == other.password;
+}
+
+//--------------------------------------------------------------------------------------------------
+// BotHost
+//--------------------------------------------------------------------------------------------------
+
+BotHost::BotHost(const QString &filename, QObject *parent)
+    : QObject(parent),
+      m_filename(QFileInfo(filename).absoluteFilePath()),
+      m_watcher(new QFileSystemWatcher(this)),
+      m_reloadTimer(new QTimer(this))
+{
+    m_reloadTimer->setSingleShot(true);
+    m_reloadTimer->setInterval(RELOAD_DELAY);
+
+    connect(m_reloadTimer, SIGNAL(timeout()),                  SLOT(onReloadTimeout()));
+    connect(m_watcher,     SIGNAL(fileChanged(QString)),       SLOT(onFileChanged()));
+    connect(m_watcher,     SIGNAL(directoryChanged(QString)),  SLOT(onFileChanged()));
+}
+
+//--------------------------------------------------------------------------------------------------
+
+BotHost::~BotHost()
+{
+    foreach (const QString &name, m_bots.keys()) {
+        unloadBot(name);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool BotHost::start()
+{
+    QHash<QString, BotConfig> configs;
+
+    if (!readConfig(configs)) {
+        return false;
+    }
+
+    // Bots often have the same rules, share their words
+    Lvk::Nlp::StringPool::instance()->setEnabled(true);
+
+    reloadConfig();
+    refreshWatchedPaths();
+
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+QStringList BotHost::botNames() const
+{
+    return m_bots.keys();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+Lvk::BE::HostedBot * BotHost::bot(const QString &name) const
+{
+    return m_bots.value(name);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool BotHost::readConfig(QHash<QString, BotConfig> &configs)
+{
+    if (!QFileInfo(m_filename).isReadable()) {
+        qCritical() << "BotHost: Cannot read host file" << m_filename;
+        return false;
+    }
+
+    QSettings settings(m_filename, QSettings::IniFormat);
+
+    if (settings.status() != QSettings::NoError) {
+        qCritical() << "BotHost: Invalid host file" << m_filename;
+        return false;
+    }
+
+    QDir hostDir = QFileInfo(m_filename).absoluteDir();
+
+    foreach (const QString &name, settings.childGroups()) {
+        settings.beginGroup(name);
+
+        BotConfig config;
+        config.filename = QFileInfo(hostDir, settings.value("file").toString())
+                .absoluteFilePath();
+        config.type = settings.value("type").toString();
+        config.username = settings.value("username").toString();
+        config.password = settings.value("password").toString();
+
+        settings.endGroup();
+
+        if (config.type != "" && config.type != "fb" && config.type != "gtalk") {
+            qWarning() << "BotHost: Unknown chat type" << config.type << "for bot" << name;
+        }
+
+        configs[name] = config;
+    }
+
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void BotHost::reloadConfig()
+{
+    QHash<QString, BotConfig> configs;
+
+    if (!readConfig(configs)) {
+        qWarning() << "BotHost: Keeping current bots";
+        return;
+    }
+
+    foreach (const QString &name, m_bots.keys()) {
+        if (!configs.contains(name)) {
+            unloadBot(name);
+        }
+    }
+
+    for (QHash<QString, BotConfig>::const_iterator it = configs.constBegin();
+         it != configs.constEnd(); ++it) {
+        if (!m_bots.contains(it.key()) || m_configs.value(it.key()) != it.value()) {
+            unloadBot(it.key());
+            loadBot(it.key(), it.value());
+        }
+    }
+
+    qDebug() << "BotHost: Serving" << m_bots.size() << "bots";
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void BotHost::loadBot(const QString &name, const BotConfig &config)
+{
+    std::auto_ptr<Lvk::BE::HostedBot> bot(new Lvk::BE::HostedBot(name, this));
+
+    if (!bot->load(config.filename)) {
+        qWarning() << "BotHost: Skipping bot" << name;
+        return;
+    }
+
+    Lvk::BE::ChatType type = bot->chatType();
+    if (config.type == "fb") {
+        type = Lvk::BE::FbChat;
+    } else if (config.type == "gtalk") {
+        type = Lvk::BE::GTalkChat;
+    }
+
+    bot->connectToChat(type, config.username, config.password);
+
+    m_bots[name] = bot.release();
+    m_configs[name] = config;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void BotHost::unloadBot(const QString &name)
+{
+    Lvk::BE::HostedBot *bot = m_bots.take(name);
+    m_configs.remove(name);
+
+    if (bot) {
+        qDebug() << "BotHost: Unloading bot" << name;
+        bot->disconnectFromChat();
+        delete bot;
+
+        // Release the words that no other bot uses
+        Lvk::Nlp::StringPool::instance()->purge();
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void BotHost::refreshWatchedPaths()
+{
+    // Saving a file may replace it or create its journal, so directories are watched too
+    QSet<QString> paths;
+    paths << m_filename << QFileInfo(m_filename).absolutePath();
+
+    foreach (const Lvk::BE::HostedBot *bot, m_bots) {
+        QString journal = Lvk::BE::ChatbotRulesFile::journalFilename(bot->filename());
+        paths << bot->filename() << journal << QFileInfo(bot->filename()).absolutePath();
+    }
+
+    QStringList watched = m_watcher->files() + m_watcher->directories();
+
+    foreach (const QString &path, watched) {
+        if (!paths.contains(path)) {
+            m_watcher->removePath(path);
+        }
+    }
+
+    foreach (const QString &path, paths) {
+        // Files that were replaced are no longer watched, they must be added again
+        if (!watched.contains(path) && QFileInfo(path).exists()) {
+            m_watcher->addPath(path);
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void BotHost::onFileChanged()
+{
+    m_reloadTimer->start();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void BotHost::onReloadTimeout()
+{
+    reloadConfig();
+
+    foreach (Lvk::BE::HostedBot *bot, m_bots) {
+        if (bot->isOutdated()) {
+            qDebug() << "BotHost: Chatbot file of bot" << bot->name() << "changed, reloading...";
+            if (!bot->reload()) {
+                qWarning() << "BotHost: Cannot reload bot" << bot->name();
+            }
+        }
+    }
+
+    // Engines rebuild their trees lazily, words of old trees are released by later purges
+    Lvk::Nlp::StringPool::instance()->purge();
+
+    refreshWatchedPaths();
+}
@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2012 Andres Pagliano, Gabriel Miretti, Gonzalo Buteler,
+ * Nestor Bustamante, Pablo Perez de Angelis
+ *
+ * This file is part of LVK Chatbot.
+ *
+ * LVK Chatbot is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LVK Chatbot is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LVK Chatbot.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef BOTHOST_H
+#define BOTHOST_H
+
+#include <QObject>
+#include <QString>
+#include <QHash>
+#include <QStringList>
+
+class QFileSystemWatcher;
+class QTimer;
+
+namespace Lvk
+{
+    namespace BE
+    {
+        class HostedBot;
+    }
+}
+
+/**
+ * \brief The BotHost class serves many chatbot files in one process without user interface.
+ *
+ * Bots are listed in an INI host file, one group per bot:
+ *
+ * \code
+ * [support]
+ * file=/srv/chatbots/support.zbot
+ * password=secret
+ * ; Optional, by default the chat type and username stored in the chatbot file are used
+ * type=gtalk
+ * username=support@example.com
+ * \endcode
+ *
+ * Relative file paths are relative to the host file. Each bot has its own NLP engine, tools and
+ * chat connection (see Lvk::BE::HostedBot). Lemmatizer data and the string pool are loaded once
+ * and shared by all bots, and responses of all bots are computed by the workers of the global
+ * thread pool.
+ *
+ * The host watches the host file and the chatbot files. If the host file changes, removed bots
+ * are unloaded, new bots are loaded and bots whose settings changed are restarted. If a chatbot
+ * file changes, the bot reloads its rules without disconnecting.
+ */
+class BotHost : public QObject
+{
+    Q_OBJECT
+
+public:
+
+    /**
+     * Constructs a BotHost with the host file \a filename and the given \a parent
+     */
+    explicit BotHost(const QString &filename, QObject *parent = 0);
+
+    /**
+     * Destroys the object and unloads all bots
+     */
+    ~BotHost();
+
+    /**
+     * Enables the string pool and loads all bots of the host file. Returns true on
+     * success. Otherwise; returns false. Bots that cannot be loaded are skipped and do not make
+     * start() fail.
+     */
+    bool start();
+
+    /**
+     * Returns the names of the bots being served
+     */
+    QStringList botNames() const;
+
+    /**
+     * Returns the bot with name \a name, or 0 if it is not being served
+     */
+    Lvk::BE::HostedBot *bot(const QString &name) const;
+
+private slots:
+    void onFileChanged();
+    void onReloadTimeout();
+
+private:
+    BotHost(const BotHost&);
+    BotHost& operator=(const BotHost&);
+
+    struct BotConfig
+    {
+        QString filename;
+        QString type;
+        QString username;
+        QString password;
+
+        bool operator==(const BotConfig &other) const;
+        bool operator!=(const BotConfig &other) const { return !operator==(other); }
+    };
+
+    QString m_filename;
+    QHash<QString, Lvk::BE::HostedBot *> m_bots;
+    QHash<QString, BotConfig> m_configs;
+    QFileSystemWatcher *m_watcher;
+    QTimer *m_reloadTimer;
+
+    bool readConfig(QHash<QString, BotConfig> &configs);
+    void reloadConfig();
+    void loadBot(const QString &name, const BotConfig &config);
+    void unloadBot(const QString &name);
+    void refreshWatchedPaths();
+};
+
+#endif // BOTHOST_H
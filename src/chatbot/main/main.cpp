@@ -22,15 +22,24 @@
 #include <QApplication>
 #include <QTranslator>
 #include <QDir>
+#include <QFileInfo>
 #include <QDebug>
 #include <iostream>
 
 #include "main/windowbootstrap.h"
+#include "main/replaytool.h"
+#include "main/metricsexporter.h"
+#include "main/bothost.h"
 #include "common/version.h"
 #include "common/settings.h"
 #include "common/settingskeys.h"
 #include "common/logger.h"
+#include "common/tracer.h"
 #include "common/crashhandler.h"
+#include "back-end/appfacade.h"
+#include "nlp-engine/engine.h"
+#include "nlp-engine/enginefactory.h"
+#include "nlp-engine/memoryusage.h"
 
 #ifdef DA_CONTEST
 # include "da-clue/batchanalyzer.h"
@@ -43,14 +52,24 @@ struct CmdLineOptions
     QString chatbotFilename;
     bool isBatchMode;
     QString batchTarget;
+    bool isMemoryReport;
+    bool isTracing;
+    bool isReplay;
+    ReplayTool::Source replaySource;
+    ReplayTool::Pace replayPace;
+    bool isHost;
+    QString hostFilename;
 };
 
 void getCmdLineOptions(CmdLineOptions &opt);
+bool isHeadless(int argc, char *argv[]);
 void makeDirStructure();
 void showSyntax();
 void setLanguage();
 void makeDir(const QString &name);
 void showWindow(int argc, char *argv[]);
+int showMemoryReport(const QString &filename);
+void printMemoryUsage(const QString &name, const Lvk::Nlp::MemoryUsage &u);
 
 
 //--------------------------------------------------------------------------------------------------
@@ -63,7 +82,8 @@ int main(int argc, char *argv[])
     QApplication::setOrganizationDomain(ORGANIZATION_DOMAIN);
     QApplication::setApplicationName(APP_NAME);
 
-    QApplication app(argc, argv);
+    // The host runs without user interface, it does not need a display
+    QApplication app(argc, argv, !isHeadless(argc, argv));
 
     CmdLineOptions opt;
     getCmdLineOptions(opt);
@@ -75,6 +95,14 @@ int main(int argc, char *argv[])
     Lvk::Cmn::Logger::setVerboseLevel(opt.verboseLevel);
     Lvk::Cmn::Logger::init();
 
+    Lvk::Cmn::Tracer::init();
+    if (opt.isTracing) {
+        Lvk::Cmn::Tracer::setEnabled(true);
+#ifndef ENABLE_TRACING
+        qWarning() << "Tracing enabled but spans are not compiled. Build with CONFIG += tracing";
+#endif
+    }
+
     setLanguage();
 
     int exitCode = 0;
@@ -84,8 +112,17 @@ int main(int argc, char *argv[])
 #ifdef DA_CONTEST
             exitCode = Lvk::Clue::BatchAnalyzer().exec(opt.batchTarget);
 #endif // DA_CONTEST
+        } else if (opt.isMemoryReport) {
+            exitCode = showMemoryReport(opt.chatbotFilename);
+        } else if (opt.isReplay) {
+            exitCode = ReplayTool(opt.replaySource, opt.replayPace).exec(opt.chatbotFilename);
+        } else if (opt.isHost) {
+            MetricsExporter metricsExporter;
+            BotHost host(opt.hostFilename);
+            exitCode = host.start() ? app.exec() : 1;
         } else {
             Lvk::Cmn::CrashHandler::init();
+            MetricsExporter metricsExporter;
             WindowBootstrap wb(opt.chatbotFilename);
             exitCode = app.exec();
         }
@@ -94,6 +131,9 @@ int main(int argc, char *argv[])
         exitCode = 1;
     }
 
+    Lvk::Cmn::Tracer::shutdown();
+    Lvk::Cmn::Logger::shutdown();
+
     return exitCode;
 }
 
@@ -106,6 +146,12 @@ void getCmdLineOptions(CmdLineOptions & opt)
     opt.valid = true;
     opt.verboseLevel = QtWarningMsg;
     opt.isBatchMode = false;
+    opt.isMemoryReport = false;
+    opt.isTracing = false;
+    opt.isReplay = false;
+    opt.replaySource = ReplayTool::HistorySource;
+    opt.replayPace = ReplayTool::MaxPace;
+    opt.isHost = false;
 
     QStringList args = QApplication::arguments();
 
@@ -124,6 +170,44 @@ void getCmdLineOptions(CmdLineOptions & opt)
                 opt.valid = false;
             }
 #endif // DA_CONTEST
+        } else if (arg == "--memory-report") {
+            ++i;
+            if (i < args.size()) {
+                opt.isMemoryReport = true;
+                // Current dir is changed later, so we need the absolute path
+                opt.chatbotFilename = QFileInfo(args[i]).absoluteFilePath();
+            } else {
+                opt.valid = false;
+            }
+        } else if (arg == "--replay") {
+            ++i;
+            if (i < args.size()) {
+                opt.isReplay = true;
+                opt.chatbotFilename = QFileInfo(args[i]).absoluteFilePath();
+            } else {
+                opt.valid = false;
+            }
+        } else if (arg == "--host") {
+            ++i;
+            if (i < args.size()) {
+                opt.isHost = true;
+                opt.hostFilename = QFileInfo(args[i]).absoluteFilePath();
+            } else {
+                opt.valid = false;
+            }
+        } else if (arg == "--trace") {
+            opt.isTracing = true;
+        } else if (arg == "--replay-corpus") {
+            opt.replaySource = ReplayTool::CorpusSource;
+        } else if (arg.startsWith("--replay-pace=")) {
+            QString pace = arg.section("=", 1);
+            if (pace == "recorded") {
+                opt.replayPace = ReplayTool::RecordedPace;
+            } else if (pace == "max") {
+                opt.replayPace = ReplayTool::MaxPace;
+            } else {
+                opt.valid = false;
+            }
         } else if (!arg.startsWith("-")) {
             opt.chatbotFilename = arg;
         } else {
@@ -134,17 +218,96 @@ void getCmdLineOptions(CmdLineOptions & opt)
 
 //--------------------------------------------------------------------------------------------------
 
+bool isHeadless(int argc, char *argv[])
+{
+    // QApplication::arguments() is not available before constructing the application
+    for (int i = 1; i < argc; ++i) {
+        if (qstrcmp(argv[i], "--host") == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+//--------------------------------------------------------------------------------------------------
+
 void showSyntax()
 {
     QString appname = QApplication::arguments().first();
 
     std::cerr << QObject::tr("Error: Invalid command line arguments.").toUtf8().data() << std::endl;
     std::cout << QObject::tr("Syntax: ").toUtf8().data() << std::endl;
-    std::cout << QObject::tr("   %1 [chatbot_file]").arg(appname).toUtf8().data() << std::endl;
+    std::cout << QObject::tr("   %1 [--trace] [chatbot_file]").arg(appname).toUtf8().data()
+              << std::endl;
 #ifdef DA_CONTEST
     std::cout << QObject::tr("   %1 --batch-mode <dir> | <chatbot_file>").arg(appname).toUtf8()
                  .data() << std::endl;
 #endif // DA_CONTEST
+    std::cout << QObject::tr("   %1 --memory-report <chatbot_file>").arg(appname).toUtf8().data()
+              << std::endl;
+    std::cout << QObject::tr("   %1 --replay <chatbot_file> [--replay-corpus] "
+                             "[--replay-pace=max|recorded]").arg(appname).toUtf8().data()
+              << std::endl;
+    std::cout << QObject::tr("   %1 --host <host_file>").arg(appname).toUtf8().data()
+              << std::endl;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void printMemoryUsage(const QString &name, const Lvk::Nlp::MemoryUsage &u)
+{
+    QString line = QString("%1 %2 %3 %4 %5 %6 %7 %8 %9")
+            .arg(name, -20)
+            .arg(u.wordNodes, 8)
+            .arg(u.wildcardNodes, 8)
+            .arg(u.variableNodes, 8)
+            .arg(u.edges, 8)
+            .arg(u.distinctWords, 8)
+            .arg(u.omapEntries, 8)
+            .arg(u.stringBytes, 12)
+            .arg(u.outputBytes, 12);
+
+    std::cout << line.toUtf8().data() << std::endl;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+int showMemoryReport(const QString &filename)
+{
+    Lvk::Nlp::Engine *engine = Lvk::Nlp::EngineFactory().createEngine();
+
+    // AppFacade owns the engine
+    Lvk::BE::AppFacade appFacade(engine);
+
+    if (!appFacade.load(filename)) {
+        std::cerr << QObject::tr("Error: Cannot load %1").arg(filename).toUtf8().data()
+                  << std::endl;
+        return 1;
+    }
+
+    Lvk::Nlp::MemoryUsageMap targets;
+    Lvk::Nlp::MemoryUsage total = engine->memoryUsage(&targets);
+
+    std::cout << QString("%1 %2 %3 %4 %5 %6 %7 %8 %9")
+                 .arg("target", -20)
+                 .arg("words", 8)
+                 .arg("wildcard", 8)
+                 .arg("vars", 8)
+                 .arg("edges", 8)
+                 .arg("distinct", 8)
+                 .arg("omap", 8)
+                 .arg("strBytes", 12)
+                 .arg("outBytes", 12)
+                 .toUtf8().data() << std::endl;
+
+    for (Lvk::Nlp::MemoryUsageMap::const_iterator it = targets.constBegin();
+         it != targets.constEnd(); ++it) {
+        printMemoryUsage(it.key().isEmpty() ? "<any user>" : it.key(), it.value());
+    }
+
+    printMemoryUsage("<total>", total);
+
+    return 0;
 }
 
 //--------------------------------------------------------------------------------------------------
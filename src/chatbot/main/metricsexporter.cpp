@@ -0,0 +1,231 @@
+/*
+ * Copyright (C) 2012 Andres Pagliano, Gabriel Miretti, Gonzalo Buteler,
+ * Nestor Bustamante, Pablo Perez de Angelis
+ *
+ * This file is part of LVK Chatbot.
+ *
+ * LVK Chatbot is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LVK Chatbot is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LVK Chatbot.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "main/metricsexporter.h"
+#include "common/metrics.h"
+#include "common/tracer.h"
+#include "common/settings.h"
+#include "common/settingskeys.h"
+
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QHostAddress>
+#include <QTimer>
+#include <QDir>
+#include <QSocketNotifier>
+#include <QtDebug>
+
+#ifdef Q_OS_UNIX
+# include <csignal>
+# include <sys/socket.h>
+# include <unistd.h>
+#endif
+
+#define METRICS_FILENAME        "metrics.prom"
+#define MAX_REQUEST_SIZE        8192
+#define TRACE_REQUEST           "GET /trace"
+
+#ifdef Q_OS_UNIX
+
+//--------------------------------------------------------------------------------------------------
+// Helpers
+//--------------------------------------------------------------------------------------------------
+
+namespace
+{
+
+int g_dumpSocket[2] = { -1, -1 };
+
+// Only async-signal-safe calls here. The trace is written by the notifier in the event loop.
+void dumpSignalHandler(int)
+{
+    char c = 1;
+    ssize_t n = ::write(g_dumpSocket[0], &c, sizeof(c));
+    Q_UNUSED(n);
+}
+
+} // namespace
+
+#endif // Q_OS_UNIX
+
+//--------------------------------------------------------------------------------------------------
+// MetricsExporter
+//--------------------------------------------------------------------------------------------------
+
+MetricsExporter::MetricsExporter(QObject *parent)
+    : QObject(parent), m_server(0), m_timer(0), m_dumpNotifier(0)
+{
+    Lvk::Cmn::Settings settings;
+    quint16 port = settings.value(SETTING_METRICS_PORT).toUInt();
+    int interval = settings.value(SETTING_METRICS_FILE_INTERVAL).toInt();
+
+    if (port != 0) {
+        m_server = new QTcpServer(this);
+
+        connect(m_server, SIGNAL(newConnection()), SLOT(onNewConnection()));
+
+        if (m_server->listen(QHostAddress::LocalHost, port)) {
+            qDebug() << "MetricsExporter: Listening on port" << port;
+        } else {
+            qWarning() << "MetricsExporter: Cannot listen on port" << port << ":"
+                       << m_server->errorString();
+        }
+    }
+
+    if (interval > 0) {
+        m_timer = new QTimer(this);
+
+        connect(m_timer, SIGNAL(timeout()), SLOT(onTimeout()));
+
+        m_timer->start(interval*1000);
+
+        qDebug() << "MetricsExporter: Writing" << metricsFilename() << "every" << interval << "s";
+    }
+
+#ifdef Q_OS_UNIX
+    if (g_dumpSocket[0] == -1 && ::socketpair(AF_UNIX, SOCK_STREAM, 0, g_dumpSocket) == 0) {
+        m_dumpNotifier = new QSocketNotifier(g_dumpSocket[1], QSocketNotifier::Read, this);
+
+        connect(m_dumpNotifier, SIGNAL(activated(int)), SLOT(onDumpSignal()));
+
+        ::signal(SIGUSR1, dumpSignalHandler);
+    }
+#endif
+}
+
+//--------------------------------------------------------------------------------------------------
+
+MetricsExporter::~MetricsExporter()
+{
+    if (m_timer) {
+        onTimeout();
+    }
+
+#ifdef Q_OS_UNIX
+    if (m_dumpNotifier) {
+        ::signal(SIGUSR1, SIG_DFL);
+        ::close(g_dumpSocket[0]);
+        ::close(g_dumpSocket[1]);
+        g_dumpSocket[0] = g_dumpSocket[1] = -1;
+    }
+#endif
+}
+
+//--------------------------------------------------------------------------------------------------
+
+QString MetricsExporter::metricsFilename()
+{
+    Lvk::Cmn::Settings settings;
+    return settings.value(SETTING_LOGS_PATH).toString() + QDir::separator() + METRICS_FILENAME;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void MetricsExporter::onNewConnection()
+{
+    while (m_server->hasPendingConnections()) {
+        QTcpSocket *socket = m_server->nextPendingConnection();
+
+        connect(socket, SIGNAL(readyRead()),    SLOT(onReadyRead()));
+        connect(socket, SIGNAL(disconnected()), socket, SLOT(deleteLater()));
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void MetricsExporter::onReadyRead()
+{
+    QTcpSocket *socket = qobject_cast<QTcpSocket *>(sender());
+
+    if (!socket) {
+        return;
+    }
+
+    // Answer when the request headers are complete. Closing the socket with unread data
+    // makes some clients see a connection reset instead of the response.
+    QByteArray request = socket->peek(MAX_REQUEST_SIZE);
+
+    if (!request.contains("\r\n\r\n") && !request.contains("\n\n") &&
+            request.size() < MAX_REQUEST_SIZE) {
+        return;
+    }
+
+    socket->readAll();
+
+    disconnect(socket, SIGNAL(readyRead()), this, SLOT(onReadyRead()));
+
+    QByteArray body;
+    QByteArray contentType;
+
+    if (request.startsWith(TRACE_REQUEST)) {
+        dumpTrace();
+        body = Lvk::Cmn::Tracer::report().toUtf8();
+        contentType = "text/plain; charset=utf-8";
+    } else {
+        body = Lvk::Cmn::Metrics::toPrometheusText().toUtf8();
+        contentType = "text/plain; version=0.0.4; charset=utf-8";
+    }
+
+    QByteArray response;
+    response += "HTTP/1.0 200 OK\r\n";
+    response += "Content-Type: " + contentType + "\r\n";
+    response += "Content-Length: " + QByteArray::number(body.size()) + "\r\n";
+    response += "Connection: close\r\n";
+    response += "\r\n";
+    response += body;
+
+    socket->write(response);
+    socket->disconnectFromHost();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void MetricsExporter::onTimeout()
+{
+    Lvk::Cmn::Metrics::writeToFile(metricsFilename());
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void MetricsExporter::onDumpSignal()
+{
+#ifdef Q_OS_UNIX
+    char c;
+    ssize_t n = ::read(g_dumpSocket[1], &c, sizeof(c));
+    Q_UNUSED(n);
+#endif
+
+    dumpTrace();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void MetricsExporter::dumpTrace()
+{
+    if (!Lvk::Cmn::Tracer::isEnabled()) {
+        qWarning() << "MetricsExporter: Cannot dump the trace, tracing is disabled";
+        return;
+    }
+
+    if (Lvk::Cmn::Tracer::dump()) {
+        qDebug() << "MetricsExporter: Trace written to the logs directory";
+    }
+}
@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2012 Andres Pagliano, Gabriel Miretti, Gonzalo Buteler,
+ * Nestor Bustamante, Pablo Perez de Angelis
+ *
+ * This file is part of LVK Chatbot.
+ *
+ * LVK Chatbot is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LVK Chatbot is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LVK Chatbot.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef METRICSEXPORTER_H
+#define METRICSEXPORTER_H
+
+#include <QObject>
+#include <QString>
+
+class QTcpServer;
+class QTimer;
+class QSocketNotifier;
+
+/**
+ * \brief The MetricsExporter class exposes the runtime metrics registered in
+ *        Lvk::Cmn::Metrics.
+ *
+ * Metrics are exposed in the Prometheus text format in two ways, both disabled by default:
+ *
+ * - On a local HTTP endpoint. If SETTING_METRICS_PORT is not zero, the exporter listens on
+ *   127.0.0.1 at that port and answers any request with the current metrics.
+ * - In a file. If SETTING_METRICS_FILE_INTERVAL is not zero, the exporter writes the metrics
+ *   to metrics.prom in the logs directory every that many seconds.
+ *
+ * The exporter also dumps the tracer report and trace events to the logs directory on demand,
+ * without stopping the application. On Unix this is done when the process receives SIGUSR1.
+ * If the HTTP endpoint is enabled, a request to /trace also dumps them and answers with the
+ * report. See Lvk::Cmn::Tracer::dump().
+ *
+ * The exporter runs in the thread that owns it, which must have an event loop.
+ */
+class MetricsExporter : public QObject
+{
+    Q_OBJECT
+
+public:
+
+    /**
+     * Constructs a MetricsExporter with the given \a parent and starts it with the application
+     * settings.
+     */
+    explicit MetricsExporter(QObject *parent = 0);
+
+    /**
+     * Destroys the object. If the file export is enabled, writes the metrics one last time.
+     */
+    ~MetricsExporter();
+
+    /**
+     * Returns the path of the metrics file
+     */
+    static QString metricsFilename();
+
+private slots:
+    void onNewConnection();
+    void onReadyRead();
+    void onTimeout();
+    void onDumpSignal();
+
+private:
+    MetricsExporter(const MetricsExporter&);
+    MetricsExporter& operator=(const MetricsExporter&);
+
+    QTcpServer *m_server;
+    QTimer *m_timer;
+    QSocketNotifier *m_dumpNotifier;
+
+    void dumpTrace();
+};
+
+#endif // METRICSEXPORTER_H
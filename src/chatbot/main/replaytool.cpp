@@ -0,0 +1,259 @@
+/*
+ * Copyright (C) 2012 Andres Pagliano, Gabriel Miretti, Gonzalo Buteler,
+ * Nestor Bustamante, Pablo Perez de Angelis
+ *
+ * This file is part of LVK Chatbot.
+ *
+ * LVK Chatbot is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LVK Chatbot is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LVK Chatbot.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "main/replaytool.h"
+#include "back-end/appfacade.h"
+#include "nlp-engine/engine.h"
+#include "nlp-engine/enginefactory.h"
+#include "chat-adapter/chatcorpus.h"
+#include "common/conversation.h"
+#include "common/globalstrings.h"
+#include "common/latencyhistogram.h"
+#include "common/tracer.h"
+
+#include <QThread>
+#include <QElapsedTimer>
+#include <QObject>
+#include <iostream>
+
+#define MAX_REPORTED_DIFFS  10
+#define MAX_PACING_WAIT     5000  // in milliseconds
+
+//--------------------------------------------------------------------------------------------------
+// Helpers
+//--------------------------------------------------------------------------------------------------
+
+namespace
+{
+
+// QThread::msleep() is protected in Qt 4
+class Sleeper : public QThread
+{
+public:
+    static void msleep(unsigned long msecs)
+    {
+        QThread::msleep(msecs);
+    }
+};
+
+//--------------------------------------------------------------------------------------------------
+
+inline qint64 nsecsElapsed(const QElapsedTimer &timer)
+{
+#if QT_VERSION >= 0x040800
+    return timer.nsecsElapsed();
+#else
+    return timer.elapsed()*Q_INT64_C(1000000);
+#endif
+}
+
+//--------------------------------------------------------------------------------------------------
+
+// History entries store the sender as "Fullname <username>" or just "username"
+QString usernameOf(const QString &from)
+{
+    int i = from.lastIndexOf(USERNAME_START_TOKEN);
+    int j = from.lastIndexOf(USERNAME_END_TOKEN);
+
+    return i != -1 && j > i ? from.mid(i + 1, j - i - 1) : from;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void print(const QString &s)
+{
+    std::cout << s.toUtf8().data() << std::endl;
+}
+
+} // namespace
+
+//--------------------------------------------------------------------------------------------------
+// ReplayTool
+//--------------------------------------------------------------------------------------------------
+
+ReplayTool::ReplayTool(Source source /*= HistorySource*/, Pace pace /*= MaxPace*/)
+    : m_source(source), m_pace(pace)
+{
+}
+
+//--------------------------------------------------------------------------------------------------
+
+int ReplayTool::exec(const QString &filename)
+{
+    Lvk::Nlp::Engine *engine = Lvk::Nlp::EngineFactory().createEngine();
+
+    // AppFacade owns the engine
+    Lvk::BE::AppFacade appFacade(engine);
+
+    if (!appFacade.load(filename)) {
+        std::cerr << QObject::tr("Error: Cannot load %1").arg(filename).toUtf8().data()
+                  << std::endl;
+        return 1;
+    }
+
+    QList<ReplayEntry> entries;
+    readEntries(appFacade, entries);
+
+    // Trees are built lazily, so we need a first query to build them
+
+    QElapsedTimer timer;
+    timer.start();
+
+    Lvk::Nlp::Result result;
+    engine->getBestResult("", "", result);
+
+    qint64 buildNsecs = nsecsElapsed(timer);
+
+    // Replay
+
+    Lvk::Cmn::LatencyHistogram histogram;
+    int matched = 0;
+    int recorded = 0;
+    int matchDiffs = 0;
+    int ruleDiffs = 0;
+    int responseDiffs = 0;
+    QDateTime prevDateTime;
+
+    QElapsedTimer wallTimer;
+    wallTimer.start();
+
+    foreach (const ReplayEntry &entry, entries) {
+        if (m_pace == RecordedPace && prevDateTime.isValid() && entry.dateTime.isValid()) {
+            qint64 wait = qBound(Q_INT64_C(0),
+                                 static_cast<qint64>(prevDateTime.secsTo(entry.dateTime))*1000,
+                                 static_cast<qint64>(MAX_PACING_WAIT));
+            Sleeper::msleep(wait);
+        }
+        prevDateTime = entry.dateTime;
+
+        timer.start();
+        bool match = engine->getBestResult(entry.msg, entry.target, result)
+                && !result.output.isEmpty();
+        histogram.add(nsecsElapsed(timer));
+
+        if (match) {
+            ++matched;
+        }
+
+        if (!entry.recorded) {
+            continue;
+        }
+
+        ++recorded;
+
+        QString diff;
+
+        if (match != entry.match) {
+            ++matchDiffs;
+            diff = match ? "now matches" : "no longer matches";
+        } else if (match && result.ruleId != entry.ruleId) {
+            ++ruleDiffs;
+            diff = QString("rule %1 instead of %2").arg(result.ruleId).arg(entry.ruleId);
+        } else if (match && result.output != entry.response) {
+            // Might be expected with random or sequential outputs
+            ++responseDiffs;
+            diff = "different response";
+        }
+
+        if (!diff.isEmpty() && matchDiffs + ruleDiffs + responseDiffs <= MAX_REPORTED_DIFFS) {
+            print(QString("Diff: \"%1\" from %2: %3").arg(entry.msg, entry.target, diff));
+        }
+    }
+
+    qint64 wallNsecs = nsecsElapsed(wallTimer);
+    double engineSecs = histogram.total()/1e9;
+
+    print(QString("Source:           %1")
+          .arg(m_source == HistorySource ? "conversation history" : "chat corpus"));
+    print(QString("Build time:       %1 ms").arg(buildNsecs/1e6, 0, 'f', 2));
+    print(QString("Messages:         %1 (%2 matched)").arg(histogram.count()).arg(matched));
+    print(QString("Wall time:        %1 s").arg(wallNsecs/1e9, 0, 'f', 3));
+    print(QString("Throughput:       %1 messages/s")
+          .arg(histogram.count()/qMax(engineSecs, 1e-9), 0, 'f', 0));
+    print(QString("Latency (us):     p50=%1 p90=%2 p99=%3 max=%4")
+          .arg(histogram.percentile(50)/1e3, 0, 'f', 1)
+          .arg(histogram.percentile(90)/1e3, 0, 'f', 1)
+          .arg(histogram.percentile(99)/1e3, 0, 'f', 1)
+          .arg(histogram.max()/1e3, 0, 'f', 1));
+
+    if (recorded > 0) {
+        print(QString("Differences:      %1 of %2 recorded responses "
+                      "(%3 match changes, %4 rule changes, %5 response changes)")
+              .arg(matchDiffs + ruleDiffs + responseDiffs).arg(recorded)
+              .arg(matchDiffs).arg(ruleDiffs).arg(responseDiffs));
+    }
+
+    print("Latency histogram:");
+    print(histogram.toString());
+
+    if (Lvk::Cmn::Tracer::isEnabled()) {
+        print("Stages:");
+        print(Lvk::Cmn::Tracer::report());
+    }
+
+    return 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void ReplayTool::readEntries(Lvk::BE::AppFacade &appFacade, QList<ReplayEntry> &entries)
+{
+    if (m_source == HistorySource) {
+        Lvk::Cmn::Conversation history = appFacade.chatHistory(QDateTime(), QDateTime());
+
+        foreach (const Lvk::Cmn::Conversation::Entry &e, history.entries()) {
+            if (e.msg.isEmpty()) {
+                continue;
+            }
+
+            ReplayEntry entry;
+            entry.dateTime = e.dateTime;
+            entry.target = usernameOf(e.from);
+            entry.msg = e.msg;
+            entry.recorded = true;
+            entry.match = e.match;
+            entry.ruleId = e.ruleId;
+            entry.response = e.response;
+
+            entries.append(entry);
+        }
+    } else {
+        Lvk::CA::ChatCorpus::Reader corpusReader;
+        Lvk::CA::ChatCorpus::CorpusEntry e;
+
+        while (corpusReader.read(&e)) {
+            if (e.message.isEmpty()) {
+                continue;
+            }
+
+            ReplayEntry entry;
+            entry.dateTime = e.timestamp;
+            entry.target = e.username;
+            entry.msg = e.message;
+            entry.recorded = false;
+            entry.match = false;
+            entry.ruleId = 0;
+
+            entries.append(entry);
+        }
+    }
+}
+
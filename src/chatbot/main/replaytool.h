@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2012 Andres Pagliano, Gabriel Miretti, Gonzalo Buteler,
+ * Nestor Bustamante, Pablo Perez de Angelis
+ *
+ * This file is part of LVK Chatbot.
+ *
+ * LVK Chatbot is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LVK Chatbot is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LVK Chatbot.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef REPLAYTOOL_H
+#define REPLAYTOOL_H
+
+#include <QString>
+#include <QDateTime>
+#include <QList>
+
+namespace Lvk
+{
+    namespace BE
+    {
+        class AppFacade;
+    }
+}
+
+/**
+ * \brief The ReplayTool class replays recorded traffic against a chatbot and reports
+ *        throughput, latency percentiles and behavior changes.
+ *
+ * The chatbot file is loaded with BE::AppFacade::load(). Inbound messages are read either
+ * from the chatbot conversation history or from the chat corpus (corpus.dat) and sent to the
+ * NLP engine in the recorded order, as fast as possible or with the recorded pacing.
+ *
+ * Conversation history entries have the recorded response, so the tool also counts how many
+ * responses differ from the recorded ones. Corpus entries do not have responses.
+ */
+class ReplayTool
+{
+public:
+
+    /**
+     * Source of recorded messages
+     */
+    enum Source
+    {
+        HistorySource,      ///< Conversation history of the chatbot
+        CorpusSource        ///< Chat corpus
+    };
+
+    /**
+     * Pace used to send messages
+     */
+    enum Pace
+    {
+        MaxPace,            ///< Send messages as fast as possible
+        RecordedPace        ///< Wait between messages as much as it was recorded
+    };
+
+    /**
+     * Constructs a ReplayTool object that reads messages from \a source and sends them with
+     * the given \a pace
+     */
+    ReplayTool(Source source = HistorySource, Pace pace = MaxPace);
+
+    /**
+     * Replays the recorded messages against the chatbot file \a filename and prints the
+     * report to the standard output. Returns 0 on success. Otherwise; returns a non-zero value.
+     */
+    int exec(const QString &filename);
+
+private:
+
+    struct ReplayEntry
+    {
+        QDateTime dateTime;
+        QString target;
+        QString msg;
+        bool recorded;      // True if match, ruleId and response were recorded
+        bool match;
+        quint64 ruleId;
+        QString response;
+    };
+
+    Source m_source;
+    Pace m_pace;
+
+    void readEntries(Lvk::BE::AppFacade &appFacade, QList<ReplayEntry> &entries);
+};
+
+#endif // REPLAYTOOL_H
+
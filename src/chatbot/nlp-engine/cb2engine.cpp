@@ -20,12 +20,16 @@
  */
 
 #include "nlp-engine/cb2engine.h"
+#include "nlp-engine/tree.h"
 #include "nlp-engine/rule.h"
 #include "nlp-engine/nlpproperties.h"
-#include "nlp-engine/globaltools.h"
+#include "nlp-engine/nullsanitizer.h"
+#include "nlp-engine/nulllemmatizer.h"
 #include "common/settings.h"
 #include "common/settingskeys.h"
 #include "common/logger.h"
+#include "common/tracer.h"
+#include "common/metrics.h"
 
 #include <QStringList>
 #include <QFile>
@@ -43,6 +47,21 @@
 namespace
 {
 
+Lvk::Cmn::Histogram *g_matchLatency = Lvk::Cmn::Metrics::histogram(
+        "chatbot_engine_match_duration_seconds", "Time spent matching a user input");
+
+Lvk::Cmn::Counter *g_rebuilds = Lvk::Cmn::Metrics::counter(
+        "chatbot_engine_rebuilds_total", "Amount of times the matching trees were rebuilt");
+
+Lvk::Cmn::Histogram *g_rebuildLatency = Lvk::Cmn::Metrics::histogram(
+        "chatbot_engine_rebuild_duration_seconds", "Time spent rebuilding the matching trees");
+
+Lvk::Cmn::Counter *g_partialRebuilds = Lvk::Cmn::Metrics::counter(
+        "chatbot_engine_partial_rebuilds_total",
+        "Amount of times only the matching trees of updated rules were rebuilt");
+
+//--------------------------------------------------------------------------------------------------
+
 // "std::make_ptr"-like function to construct QSharedPointers
 template<class T>
 inline QSharedPointer<T> makeSharedPtr(T *p)
@@ -72,7 +91,10 @@ Lvk::Nlp::Cb2Engine::Cb2Engine()
     : m_logFile(new QFile()),
       m_mutex(new QMutex(QMutex::Recursive)),
       m_dirty(false),
-      m_preferCurTopic(false)
+      m_preferCurTopic(false),
+      m_preSanitizer(new NullSanitizer()),
+      m_lemmatizer(new NullLemmatizer()),
+      m_postSanitizer(new NullSanitizer())
 {
     initLog();
 }
@@ -83,10 +105,11 @@ Lvk::Nlp::Cb2Engine::Cb2Engine(Sanitizer *sanitizer)
     : m_logFile(new QFile()),
       m_mutex(new QMutex(QMutex::Recursive)),
       m_dirty(false),
-      m_preferCurTopic(false)
+      m_preferCurTopic(false),
+      m_preSanitizer(sanitizer ? sanitizer : new NullSanitizer()),
+      m_lemmatizer(new NullLemmatizer()),
+      m_postSanitizer(new NullSanitizer())
 {
-    Nlp::GlobalTools::instance()->setPreSanitizer(sanitizer);
-
     initLog();
 }
 
@@ -97,12 +120,11 @@ Lvk::Nlp::Cb2Engine::Cb2Engine(Sanitizer *preSanitizer, Lemmatizer *lemmatizer,
     : m_logFile(new QFile()),
       m_mutex(new QMutex(QMutex::Recursive)),
       m_dirty(false),
-      m_preferCurTopic(false)
+      m_preferCurTopic(false),
+      m_preSanitizer(preSanitizer ? preSanitizer : new NullSanitizer()),
+      m_lemmatizer(lemmatizer ? lemmatizer : new NullLemmatizer()),
+      m_postSanitizer(postSanitizer ? postSanitizer : new NullSanitizer())
 {
-    Nlp::GlobalTools::instance()->setPreSanitizer(preSanitizer);
-    Nlp::GlobalTools::instance()->setLemmatizer(lemmatizer);
-    Nlp::GlobalTools::instance()->setPostSanitizer(postSanitizer);
-
     initLog();
 }
 
@@ -143,7 +165,7 @@ Lvk::Nlp::RuleList Lvk::Nlp::Cb2Engine::rules() const
 
 void Lvk::Nlp::Cb2Engine::setRules(const Lvk::Nlp::RuleList &rules)
 {
-    qDebug() << "Cb2Engine: Setting new rules...";
+    LOG_DEBUG(Engine) << "Cb2Engine: Setting new rules...";
 
     QMutexLocker locker(m_mutex);
 
@@ -156,7 +178,7 @@ void Lvk::Nlp::Cb2Engine::setRules(const Lvk::Nlp::RuleList &rules)
 
 void Lvk::Nlp::Cb2Engine::addRule(const Lvk::Nlp::Rule &rule)
 {
-    qDebug() << "Cb2Engine: Adding new rule...";
+    LOG_DEBUG(Engine) << "Cb2Engine: Adding new rule...";
 
     QMutexLocker locker(m_mutex);
 
@@ -167,6 +189,87 @@ void Lvk::Nlp::Cb2Engine::addRule(const Lvk::Nlp::Rule &rule)
 
 //--------------------------------------------------------------------------------------------------
 
+void Lvk::Nlp::Cb2Engine::updateRule(const Lvk::Nlp::Rule &rule)
+{
+    LOG_DEBUG(Engine) << "Cb2Engine: Updating rule" << rule.id();
+
+    QMutexLocker locker(m_mutex);
+
+    int i = indexOf(rule.id());
+
+    if (i != -1) {
+        setTreesDirty(m_rules[i]);
+        m_rules[i] = rule;
+    } else {
+        m_rules.append(rule);
+    }
+
+    setTreesDirty(rule);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::Nlp::Cb2Engine::removeRule(Lvk::Nlp::RuleId ruleId)
+{
+    LOG_DEBUG(Engine) << "Cb2Engine: Removing rule" << ruleId;
+
+    QMutexLocker locker(m_mutex);
+
+    int i = indexOf(ruleId);
+
+    if (i != -1) {
+        setTreesDirty(m_rules[i]);
+        m_rules.removeAt(i);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::Nlp::Cb2Engine::updateRules(const Lvk::Nlp::RuleList &rules, const QList<int> &positions,
+                                      const QList<Lvk::Nlp::RuleId> &removed)
+{
+    LOG_DEBUG(Engine) << "Cb2Engine: Updating" << rules.size() << "rules and removing"
+                      << removed.size();
+
+    Q_ASSERT(rules.size() == positions.size());
+
+    QMutexLocker locker(m_mutex);
+
+    QSet<RuleId> dropped = removed.toSet();
+    foreach (const Nlp::Rule &rule, rules) {
+        dropped.insert(rule.id());
+    }
+
+    // First pass: drop removed rules and old versions of updated rules
+    RuleList kept;
+    kept.reserve(m_rules.size());
+    foreach (const Nlp::Rule &rule, m_rules) {
+        if (dropped.contains(rule.id())) {
+            setTreesDirty(rule);
+        } else {
+            kept.append(rule);
+        }
+    }
+
+    // Second pass: merge updated rules at their positions
+    RuleList merged;
+    merged.reserve(kept.size() + rules.size());
+    int i = 0;
+    int j = 0;
+    while (i < kept.size() || j < rules.size()) {
+        if (j < rules.size() && (i == kept.size() || positions[j] <= merged.size())) {
+            setTreesDirty(rules[j]);
+            merged.append(rules[j++]);
+        } else {
+            merged.append(kept[i++]);
+        }
+    }
+
+    m_rules = merged;
+}
+
+//--------------------------------------------------------------------------------------------------
+
 QString Lvk::Nlp::Cb2Engine::getResponse(const QString &input, MatchList &matches)
 {
     return getResponse(input, ANY_USER, matches);
@@ -179,13 +282,12 @@ QString Lvk::Nlp::Cb2Engine::getResponse(const QString &input, const QString &ta
 {
     matches.clear();
 
-    MatchList allMatches;
-    QStringList responses = getAllResponses(input, target, allMatches);
+    Nlp::Result result;
 
-    if (!allMatches.empty()) {
-        matches.append(allMatches.first());
+    if (getBestResult(input, target, result)) {
+        matches.append(RuleMatch(result.ruleId, result.inputIdx));
 
-        return responses.first();
+        return result.output;
     } else {
         return "";
     }
@@ -203,18 +305,35 @@ QStringList Lvk::Nlp::Cb2Engine::getAllResponses(const QString &input, MatchList
 QStringList Lvk::Nlp::Cb2Engine::getAllResponses(const QString &input, const QString &target,
                                                   MatchList &matches)
 {
+    Nlp::ResultList results;
+    getAllResults(input, target, results);
+
+    QStringList responses;
+    convert(results, responses, matches);
+
+    return responses;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::Nlp::Cb2Engine::getAllResults(const QString &input, const QString &target,
+                                        Nlp::ResultList &results)
+{
+    TRACE_SPAN("engine.getAllResults");
+    Cmn::ScopedLatency latency(g_matchLatency);
+
     QMutexLocker locker(m_mutex);
 
     if (m_dirty) {
-        qDebug("Cb2Engine: Dirty flag set. Refreshing trees...");
+        LOG_DEBUG(Engine) << "Cb2Engine: Dirty flag set. Refreshing trees...";
         refresh();
         m_dirty = false;
+    } else if (!m_dirtyTrees.isEmpty()) {
+        refreshDirtyTrees();
     }
 
-    qDebug() << "Cb2Engine: Getting response for input" << input
-             << "and target" << target << "...";
-
-    Nlp::ResultList results;
+    LOG_DEBUG(Engine) << "Cb2Engine: Getting response for input" << input
+                      << "and target" << target << "...";
 
     // If no response found with the given target, fallback to rules with any user
     getAllResponsesWithTree(target, input, results);
@@ -229,12 +348,27 @@ QStringList Lvk::Nlp::Cb2Engine::getAllResponses(const QString &input, const QSt
         topic = nextTopicForRule(results[0].ruleId);
     }
 
-    // TODO Avoid this convertion. In the future remove MatchList and use only ResultList
-    QStringList responses;
-    convert(results, responses, matches);
-    qDebug() << "Cb2Engine: Responses found: " << responses;
+    LOG_DEBUG(Engine) << "Cb2Engine: Results found: " << results;
+}
 
-    return responses;
+//--------------------------------------------------------------------------------------------------
+
+bool Lvk::Nlp::Cb2Engine::getBestResult(const QString &input, const QString &target,
+                                        Nlp::Result &result)
+{
+    QMutexLocker locker(m_mutex);
+
+    // m_results is a member so its buffer is reused between calls
+    getAllResults(input, target, m_results);
+
+    if (!m_results.isEmpty()) {
+        qSwap(result, m_results.first());
+        m_results.erase(m_results.begin(), m_results.end());
+        return true;
+    } else {
+        result.clear();
+        return false;
+    }
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -242,13 +376,14 @@ QStringList Lvk::Nlp::Cb2Engine::getAllResponses(const QString &input, const QSt
 void Lvk::Nlp::Cb2Engine::getAllResponsesWithTree(const QString &treeName, const QString &input,
                                                   Nlp::ResultList &results)
 {
-    results.clear();
+    // Unlike clear(), erase() keeps the list buffer so callers can reuse it
+    results.erase(results.begin(), results.end());
 
-    qDebug() << "Cb2Engine: Searching tree with name" << treeName;
+    LOG_DEBUG(Engine) << "Cb2Engine: Searching tree with name" << treeName;
 
     TreesMap::iterator it = m_trees.find(treeName);
     if (it != m_trees.end()) {
-        qDebug() << "Cb2Engine: Found!";
+        LOG_DEBUG(Engine) << "Cb2Engine: Found!";
         (*it)->getResponses(input, results);
     }
 }
@@ -262,9 +397,47 @@ QString Lvk::Nlp::Cb2Engine::getCurrentTopic(const QString &target) const
 
 //--------------------------------------------------------------------------------------------------
 
+Lvk::Nlp::MemoryUsage Lvk::Nlp::Cb2Engine::memoryUsage(Nlp::MemoryUsageMap *targets)
+{
+    QMutexLocker locker(m_mutex);
+
+    if (m_dirty) {
+        LOG_DEBUG(Engine) << "Cb2Engine: Dirty flag set. Refreshing trees...";
+        refresh();
+        m_dirty = false;
+    } else if (!m_dirtyTrees.isEmpty()) {
+        refreshDirtyTrees();
+    }
+
+    if (targets) {
+        targets->clear();
+    }
+
+    Nlp::MemoryUsage total;
+
+    for (TreesMap::const_iterator it = m_trees.constBegin(); it != m_trees.constEnd(); ++it) {
+        Nlp::MemoryUsage usage;
+        (*it)->memoryUsage(usage);
+        total += usage;
+
+        if (targets) {
+            targets->insert(it.key(), usage);
+        }
+    }
+
+    return total;
+}
+//--------------------------------------------------------------------------------------------------
+
 void Lvk::Nlp::Cb2Engine::refresh()
 {
+    TRACE_SPAN("engine.refresh");
+    Cmn::ScopedLatency latency(g_rebuildLatency);
+
+    g_rebuilds->inc();
+
     m_trees.clear();
+    m_dirtyTrees.clear();
 
     // Initialize tree for rules without targets
 
@@ -283,11 +456,66 @@ void Lvk::Nlp::Cb2Engine::refresh()
 
 //--------------------------------------------------------------------------------------------------
 
-Lvk::Nlp::Tree * Lvk::Nlp::Cb2Engine::buildTree(const QString &target)
+void Lvk::Nlp::Cb2Engine::refreshDirtyTrees()
 {
-    Nlp::Tree *tree = new Nlp::Tree();
+    TRACE_SPAN("engine.refreshDirtyTrees");
+    Cmn::ScopedLatency latency(g_rebuildLatency);
 
-    qDebug() << "Cb2Engine: Building tree for target" << target;
+    g_partialRebuilds->inc();
+
+    foreach (const QString &target, m_dirtyTrees) {
+        LOG_DEBUG(Engine) << "Cb2Engine: Rebuilding tree for target" << target;
+
+        bool used = (target == ANY_USER);
+
+        for (int i = 0; i < m_rules.size() && !used; ++i) {
+            used = m_rules[i].target().contains(target);
+        }
+
+        // Trees of targets without rules are removed, same as in a full refresh
+        if (used) {
+            m_trees[target] = makeSharedPtr(buildTree(target));
+        } else {
+            m_trees.remove(target);
+        }
+    }
+
+    m_dirtyTrees.clear();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::Nlp::Cb2Engine::setTreesDirty(const Nlp::Rule &rule)
+{
+    if (rule.target().isEmpty()) {
+        m_dirtyTrees.insert(ANY_USER);
+    } else {
+        foreach (const QString &target, rule.target()) {
+            m_dirtyTrees.insert(target);
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+int Lvk::Nlp::Cb2Engine::indexOf(Nlp::RuleId ruleId) const
+{
+    for (int i = 0; i < m_rules.size(); ++i) {
+        if (m_rules[i].id() == ruleId) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+Lvk::Nlp::Matcher * Lvk::Nlp::Cb2Engine::buildTree(const QString &target)
+{
+    Nlp::Matcher *tree = createMatcher();
+    tree->setLemmatizer(m_lemmatizer);
+
+    LOG_DEBUG(Engine) << "Cb2Engine: Building tree for target" << target;
 
     for (int i = 0; i < m_rules.size(); ++i) {
         const QStringList &targetList = m_rules[i].target();
@@ -301,6 +529,13 @@ Lvk::Nlp::Tree * Lvk::Nlp::Cb2Engine::buildTree(const QString &target)
 
 //--------------------------------------------------------------------------------------------------
 
+Lvk::Nlp::Matcher * Lvk::Nlp::Cb2Engine::createMatcher()
+{
+    return new Nlp::Tree();
+}
+
+//--------------------------------------------------------------------------------------------------
+
 void Lvk::Nlp::Cb2Engine::reorderByTopic(const QString &topic, Nlp::ResultList &results)
 {
     if (topic.isEmpty()) {
@@ -345,7 +580,7 @@ void Lvk::Nlp::Cb2Engine::setPreSanitizer(Lvk::Nlp::Sanitizer *sanitizer)
 {
     QMutexLocker locker(m_mutex);
 
-    Nlp::GlobalTools::instance()->setPreSanitizer(sanitizer);
+    m_preSanitizer = QSharedPointer<Sanitizer>(sanitizer ? sanitizer : new NullSanitizer());
 
     m_dirty = true;
 }
@@ -356,7 +591,7 @@ void Lvk::Nlp::Cb2Engine::setLemmatizer(Lvk::Nlp::Lemmatizer *lemmatizer)
 {
     QMutexLocker locker(m_mutex);
 
-    Nlp::GlobalTools::instance()->setLemmatizer(lemmatizer);
+    m_lemmatizer = QSharedPointer<Lemmatizer>(lemmatizer ? lemmatizer : new NullLemmatizer());
 
     m_dirty = true;
 }
@@ -367,7 +602,7 @@ void Lvk::Nlp::Cb2Engine::setPostSanitizer(Lvk::Nlp::Sanitizer *sanitizer)
 {
     QMutexLocker locker(m_mutex);
 
-    Nlp::GlobalTools::instance()->setPostSanitizer(sanitizer);
+    m_postSanitizer = QSharedPointer<Sanitizer>(sanitizer ? sanitizer : new NullSanitizer());
 
     m_dirty = true;
 }
@@ -391,11 +626,11 @@ void Lvk::Nlp::Cb2Engine::setProperty(const QString &name, const QVariant &value
         QMutexLocker locker(m_mutex);
 
         if (value.toBool() == true && !m_preferCurTopic) {
-            qDebug() << "Cb2Engine: Enabled topics";
+            LOG_DEBUG(Engine) << "Cb2Engine: Enabled topics";
             m_preferCurTopic = true;
         }
         if (value.toBool() == false && m_preferCurTopic) {
-            qDebug() << "Cb2Engine: Disabled topics";
+            LOG_DEBUG(Engine) << "Cb2Engine: Disabled topics";
             m_preferCurTopic = false;
             m_topics.clear();
         }
@@ -411,6 +646,7 @@ void Lvk::Nlp::Cb2Engine::clear()
     m_dirty = true;
     m_rules.clear();
     m_trees.clear();
+    m_dirtyTrees.clear();
     m_topics.clear();
 }
 
@@ -23,9 +23,10 @@
 #define LVK_NLP_CB2ENGINE_H
 
 #include "nlp-engine/engine.h"
-#include "nlp-engine/tree.h"
+#include "nlp-engine/matcher.h"
 
 #include <QHash>
+#include <QSet>
 #include <QString>
 #include <QSharedPointer>
 #include <memory>
@@ -53,21 +54,22 @@ class Lemmatizer;
  * \brief The Cb2Engine class provides a custom NLP engine
  *
  * Optionally, sanitizers and lemmatizers can be provided at construction time to improve
- * rule matching.
+ * rule matching. Each engine owns its own tools, so several engines can live in the same
+ * process, even in different threads, without interfering with each other.
  */
 class Cb2Engine : public Engine
 {
 public:
 
     /**
-     * Construtcs a Cb2Engine object with NullSanitizer and NullLemmatizer.
+     * Constructs a Cb2Engine object with NullSanitizer and NullLemmatizer.
      *
      * \see NullSanitizer, NullLemmatizer
      */
     Cb2Engine();
 
     /**
-     * Construtcs a Cb2Engine object with the given \a sanitizer and NullLemmatizer.
+     * Constructs a Cb2Engine object with the given \a sanitizer and NullLemmatizer.
      * After construction, the object owns the given pointer.
      *
      * \see NullLemmatizer
@@ -75,7 +77,7 @@ public:
     Cb2Engine(Sanitizer *sanitizer);
 
     /**
-     * Construtcs a Cb2Engine object with the given sanitizers and lemmatizer.
+     * Constructs a Cb2Engine object with the given sanitizers and lemmatizer.
      * After construction, the object owns the given pointers.
      */
     Cb2Engine(Sanitizer *preSanitizer, Lemmatizer *lemmatizer, Sanitizer *postSanitizer);
@@ -100,6 +102,22 @@ public:
      */
     virtual void addRule(const Rule &rule);
 
+    /**
+     * \copydoc Engine::updateRule()
+     */
+    virtual void updateRule(const Rule &rule);
+
+    /**
+     * \copydoc Engine::removeRule()
+     */
+    virtual void removeRule(RuleId ruleId);
+
+    /**
+     * \copydoc Engine::updateRules()
+     */
+    virtual void updateRules(const RuleList &rules, const QList<int> &positions,
+                             const QList<RuleId> &removed);
+
     /**
      * \copydoc Engine::getResponse(const QString &, MatchList &)
      */
@@ -121,11 +139,26 @@ public:
     virtual QStringList getAllResponses(const QString &input, const QString &target,
                                         MatchList &matches);
 
+    /**
+     * \copydoc Engine::getAllResults()
+     */
+    virtual void getAllResults(const QString &input, const QString &target, ResultList &results);
+
+    /**
+     * \copydoc Engine::getBestResult()
+     */
+    virtual bool getBestResult(const QString &input, const QString &target, Result &result);
+
     /**
      * \copydoc Engine::getCurrentTopic()
      */
     virtual QString getCurrentTopic(const QString &target) const;
 
+    /**
+     * \copydoc Engine::memoryUsage()
+     */
+    virtual MemoryUsage memoryUsage(MemoryUsageMap *targets = 0);
+
     /**
      * \copydoc Engine::setPreSanitizer()
      *
@@ -170,26 +203,42 @@ public:
      */
     virtual void clear();
 
+protected:
+
+    /**
+     * Creates the structure used to match user inputs. By default, it creates a Tree.
+     * Subclasses can override this method to use a different matcher.
+     */
+    virtual Nlp::Matcher * createMatcher();
+
 private:
     Cb2Engine(Cb2Engine&);
     Cb2Engine& operator=(Cb2Engine&);
 
-    typedef QHash<QString, QSharedPointer<Nlp::Tree> > TreesMap;
+    typedef QHash<QString, QSharedPointer<Nlp::Matcher> > TreesMap;
     typedef QHash<QString, QString> TopicsMap;
 
     RuleList m_rules;
+    ResultList m_results;
     std::auto_ptr<QFile>      m_logFile;
     TreesMap                  m_trees;
     TopicsMap                 m_topics;
     QMutex *m_mutex;
     bool m_dirty;
+    QSet<QString> m_dirtyTrees;   // Trees to rebuild if m_dirty is not set
     bool m_preferCurTopic;
+    QSharedPointer<Sanitizer>  m_preSanitizer;
+    QSharedPointer<Lemmatizer> m_lemmatizer;    // Shared with the matchers
+    QSharedPointer<Sanitizer>  m_postSanitizer;
 
     void initLog();
     void getAllResponsesWithTree(const QString &treeName, const QString &input,
                                  Nlp::ResultList &results);
     void refresh();
-    Nlp::Tree * buildTree(const QString &target);
+    void refreshDirtyTrees();
+    void setTreesDirty(const Nlp::Rule &rule);
+    int indexOf(Nlp::RuleId ruleId) const;
+    Nlp::Matcher * buildTree(const QString &target);
     void reorderByTopic(const QString &topic, Nlp::ResultList &results);
     QString topicForRule(Nlp::RuleId ruleId);
     QString nextTopicForRule(Nlp::RuleId ruleId);
@@ -23,6 +23,7 @@
 #include "nlp-engine/varstack.h"
 #include "nlp-engine/predicate.h"
 #include "nlp-engine/parser.h"
+#include "nlp-engine/memoryusage.h"
 
 //--------------------------------------------------------------------------------------------------
 // CondOutput
@@ -55,6 +56,17 @@ bool Lvk::Nlp::CondOutput::eval(const Nlp::VarStack &varStack, QString &output)
 
 //--------------------------------------------------------------------------------------------------
 
+qint64 Lvk::Nlp::CondOutput::byteCount() const
+{
+    // Predicates are not accounted. They are small and shared between copies
+    qint64 b = sizeof(CondOutput) + Nlp::MemoryUsage::bytes(m_outputs) - sizeof(QStringList)
+            + m_predicates.size()*sizeof(QSharedPointer<Nlp::Predicate>);
+
+    return b;
+}
+
+//--------------------------------------------------------------------------------------------------
+
 Lvk::Nlp::CondOutput Lvk::Nlp::CondOutput::fromRawString(const QString &s)
 {
     CondOutput co;
@@ -62,6 +62,8 @@ public:
 
     static CondOutput fromRawString(const QString &s);
 
+    qint64 byteCount() const;
+
 private:
     QStringList m_outputs;
     QList< QSharedPointer<Nlp::Predicate> > m_predicates;
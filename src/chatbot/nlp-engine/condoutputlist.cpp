@@ -78,3 +78,14 @@ void Lvk::Nlp::CondOutputList::setRandomOutput(bool random)
     m_next = random ? -1 : 0;
 }
 
+//--------------------------------------------------------------------------------------------------
+
+qint64 Lvk::Nlp::CondOutputList::byteCount() const
+{
+    qint64 b = sizeof(CondOutputList);
+    for (int i = 0; i < size(); ++i) {
+        b += at(i).byteCount();
+    }
+    return b;
+}
+
@@ -65,6 +65,11 @@ public:
      */
     void setRandomOutput(bool random);
 
+    /**
+     * Returns the estimated amount of bytes used by the list and its outputs
+     */
+    qint64 byteCount() const;
+
 private:
     mutable int m_next;
 };
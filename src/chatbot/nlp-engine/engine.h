@@ -27,6 +27,8 @@
 #include <QPair>
 
 #include "nlp-engine/rule.h"
+#include "nlp-engine/result.h"
+#include "nlp-engine/memoryusage.h"
 
 namespace Lvk
 {
@@ -63,8 +65,9 @@ public:
 
     /**
      * MatchList provides a list of RuleMatch
+     *
+     * \see getAllResults(), getBestResult()
      */
-    // TODO replace MatchList with ResultList
     typedef QList<RuleMatch> MatchList;
 
     /**
@@ -82,6 +85,25 @@ public:
      */
     virtual void addRule(const Rule &rule) = 0;
 
+    /**
+     * Replaces the rule with the same ID as \a rule. If there is no such rule, \a rule is added.
+     */
+    virtual void updateRule(const Rule &rule) = 0;
+
+    /**
+     * Removes the rule with ID \a ruleId. If there is no such rule, it does nothing.
+     */
+    virtual void removeRule(RuleId ruleId) = 0;
+
+    /**
+     * Applies a batch of changes in a single pass. Removes the rules with IDs in \a removed and
+     * the rules with the same ID as any rule in \a rules. Then inserts each rule in \a rules at
+     * the index given by \a positions. Positions are indexes in the resulting list and must be
+     * in increasing order, so the result is the same list that setRules() would get.
+     */
+    virtual void updateRules(const RuleList &rules, const QList<int> &positions,
+                             const QList<RuleId> &removed) = 0;
+
     /**
      * Gets a response for the given \a input ignoring targets.
      *
@@ -124,12 +146,39 @@ public:
     virtual QStringList getAllResponses(const QString &input, const QString &target,
                                         MatchList &matches) = 0;
 
+    /**
+     * Gets all results for the given \a input and \a target sorted by priority.
+     * An empty \a target means any user.
+     *
+     * \a results is cleared before searching, so callers can reuse the same list across calls.
+     * Unlike getAllResponses(), this method does not build parallel lists of responses and
+     * matches.
+     */
+    virtual void getAllResults(const QString &input, const QString &target,
+                               ResultList &results) = 0;
+
+    /**
+     * Gets the result with the highest priority for the given \a input and \a target.
+     * An empty \a target means any user.
+     *
+     * Returns true if there is a match and sets \a result. Otherwise; returns false and
+     * \a result is cleared.
+     */
+    virtual bool getBestResult(const QString &input, const QString &target, Result &result) = 0;
+
     /**
      * Returns the current topic for \a target if topics are enabled. Otherwise returns an
      * empty string
      */
     virtual QString getCurrentTopic(const QString &target) const = 0;
 
+    /**
+     * Returns the memory footprint of the engine, i.e. the sum of the footprints of all the
+     * structures used to match user inputs. If \a targets is not null, it is filled with the
+     * footprint of each target. An empty target means any user.
+     */
+    virtual MemoryUsage memoryUsage(MemoryUsageMap *targets = 0) = 0;
+
     /**
      * Sets the pre-lemmatization \a sanitizer, i.e. the sanitizer to be executed before
      * lemmatization. The instance owns the given pointer.
@@ -21,6 +21,11 @@
 
 #include "nlp-engine/enginefactory.h"
 #include "nlp-engine/cb2engine.h"
+#include "nlp-engine/shiftandengine.h"
+#include "common/settings.h"
+#include "common/settingskeys.h"
+
+#include <QtDebug>
 
 //--------------------------------------------------------------------------------------------------
 // EngineFactory
@@ -28,5 +33,28 @@
 
 Lvk::Nlp::Engine * Lvk::Nlp::EngineFactory::createEngine()
 {
-    return new Nlp::Cb2Engine();
+    Cmn::Settings settings;
+    QString type = settings.value(SETTING_NLP_ENGINE).toString();
+
+    if (type == "shiftand") {
+        return createEngine(ShiftAndType);
+    } else {
+        if (type != "cb2") {
+            qWarning() << "createEngine() Unknown engine type" << type << "Using default";
+        }
+        return createEngine(Cb2Type);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+Lvk::Nlp::Engine * Lvk::Nlp::EngineFactory::createEngine(EngineType type)
+{
+    switch (type) {
+    case ShiftAndType:
+        return new Nlp::ShiftAndEngine();
+    case Cb2Type:
+    default:
+        return new Nlp::Cb2Engine();
+    }
 }
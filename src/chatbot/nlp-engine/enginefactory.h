@@ -46,9 +46,23 @@ class EngineFactory
 public:
 
     /**
-     * Creates a default NLP engine.
+     * Engine types
+     */
+    enum EngineType
+    {
+        Cb2Type,        ///< Cb2Engine, matches rules using a tree
+        ShiftAndType    ///< ShiftAndEngine, matches rules using a bit-parallel automaton
+    };
+
+    /**
+     * Creates a default NLP engine. The engine type is read from the application settings.
      */
     Engine* createEngine();
+
+    /**
+     * Creates a NLP engine of the given \a type.
+     */
+    Engine* createEngine(EngineType type);
 };
 
 /// @}
@@ -2,9 +2,17 @@
 #include "nlp-engine/sanitizerfactory.h"
 #include "common/settings.h"
 #include "common/settingskeys.h"
+#include "common/logger.h"
 
 #include <QFile>
 #include <QStringList>
+#include <QHash>
+#include <QWeakPointer>
+#include <QThreadStorage>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QWaitCondition>
+#include <QThread>
 #include <QtDebug>
 #include <list>
 #include <string>
@@ -66,7 +74,7 @@ inline void getFlConfigFiles(ConfigFilesMap &configFiles)
 
 //--------------------------------------------------------------------------------------------------
 
-inline bool exists(ConfigFilesMap &configFiles)
+inline bool exists(const ConfigFilesMap &configFiles)
 {
     ConfigFilesMap::const_iterator it;
 
@@ -82,14 +90,6 @@ inline bool exists(ConfigFilesMap &configFiles)
 
 //--------------------------------------------------------------------------------------------------
 
-template<class T>
-inline void init(T** p, const std::string &configFile)
-{
-    *p  = new T(configFile);
-}
-
-//--------------------------------------------------------------------------------------------------
-
 inline void init(maco** p, const ConfigFilesMap &configFiles)
 {
     maco_options opt(getLang());
@@ -174,31 +174,187 @@ inline void convert(const std::list<sentence> &ls, Lvk::Nlp::WordList &l)
 
 
 //--------------------------------------------------------------------------------------------------
-// Lemmatizer
+// FreelingLemmatizer::Data
 //--------------------------------------------------------------------------------------------------
 
-Lvk::Nlp::FreelingLemmatizer::FreelingLemmatizer()
-    : m_flInit(false), m_tk(0), m_sp(0), m_morpho(0), m_preSanitizer(0), m_postSanitizer(0)
+/*
+ * Freeling data of one language. Freeling analyzers keep internal state, so a thread needs an
+ * analyzer of its own while it uses it. The tokenizer and the splitter are small, so each thread
+ * builds its own. The morphological analyzer holds the dictionaries, so analyzers are kept in a
+ * pool that only grows when all of them are in use, up to one per core.
+ */
+class Lvk::Nlp::FreelingLemmatizer::Data
 {
-#ifdef ENABLE_FREELING_TRACES
-    traces::TraceLevel=4;
-    traces::TraceModule=0xFFFFF;
-#endif
+public:
+    Data(const ConfigFilesMap &configFiles)
+        : m_valid(false),
+          m_configFiles(configFiles),
+          m_morphoCount(0),
+          m_maxMorphoCount(qMax(QThread::idealThreadCount(), 1))
+    {
+        if (exists(configFiles)) {
+            LOG_DEBUG(Nlp) << "Initializing Freeling...";
+
+            maco *morpho = 0;
+            init(&morpho, configFiles);
+
+            if (morpho) {
+                m_freeMorpho.append(morpho);
+                m_morphoCount = 1;
+            }
+        }
 
+        m_valid = m_morphoCount > 0;
+    }
+
+    ~Data()
+    {
+        // Lemmatizers hold the data while they use an analyzer, so all of them are free
+        qDeleteAll(m_freeMorpho);
+    }
+
+    bool isValid() const
+    {
+        return m_valid;
+    }
+
+    void tokenize(const std::string &input, std::list<word> &lw)
+    {
+        threadTools()->tk->tokenize(input, lw);
+    }
+
+    void split(const std::list<word> &lw, std::list<sentence> &ls)
+    {
+        threadTools()->sp->split(lw, false, ls);
+    }
+
+    void analyze(std::list<sentence> &ls)
+    {
+        maco *morpho = acquireMorpho();
+        morpho->analyze(ls);
+        releaseMorpho(morpho);
+    }
+
+    // Returns the data for the current language settings, loading it if nobody else did
+    static QSharedPointer<Data> sharedData();
+
+private:
+    Data(const Data&);
+    Data & operator=(const Data&);
+
+    struct ThreadTools
+    {
+        ThreadTools(const std::string &tokenizerFile, const std::string &splitterFile)
+            : tk(new tokenizer(tokenizerFile)), sp(new splitter(splitterFile)) { }
+
+        ~ThreadTools()
+        {
+            delete sp;
+            delete tk;
+        }
+
+        tokenizer *tk;
+        splitter *sp;
+    };
+
+    bool m_valid;
+    ConfigFilesMap m_configFiles;
+    QList<maco *> m_freeMorpho;
+    int m_morphoCount;
+    int m_maxMorphoCount;
+    QMutex m_morphoMutex;
+    QWaitCondition m_morphoReleased;
+    QThreadStorage<ThreadTools *> m_threadTools;
+
+    ThreadTools *threadTools()
+    {
+        if (!m_threadTools.hasLocalData()) {
+            m_threadTools.setLocalData(new ThreadTools(m_configFiles.value(KEY_TOKENIZER_FILE),
+                                                       m_configFiles.value(KEY_SPLITTER_FILE)));
+        }
+        return m_threadTools.localData();
+    }
+
+    // Takes a free analyzer, loads a new one if all are in use, or waits if the pool is full
+    maco *acquireMorpho()
+    {
+        QMutexLocker locker(&m_morphoMutex);
+
+        while (m_freeMorpho.isEmpty() && m_morphoCount >= m_maxMorphoCount) {
+            m_morphoReleased.wait(&m_morphoMutex);
+        }
+
+        if (!m_freeMorpho.isEmpty()) {
+            return m_freeMorpho.takeLast();
+        }
+
+        ++m_morphoCount;
+        locker.unlock();
+
+        LOG_DEBUG(Nlp) << "Loading Freeling analyzer" << m_morphoCount << "of" << m_maxMorphoCount;
+
+        maco *morpho = 0;
+        init(&morpho, m_configFiles);
+
+        return morpho;
+    }
+
+    void releaseMorpho(maco *morpho)
+    {
+        QMutexLocker locker(&m_morphoMutex);
+
+        m_freeMorpho.append(morpho);
+        m_morphoReleased.wakeOne();
+    }
+
+    static QHash<QString, QWeakPointer<Data> > m_cache;
+    static QMutex *m_mutex;
+};
+
+//--------------------------------------------------------------------------------------------------
+
+QHash<QString, QWeakPointer<Lvk::Nlp::FreelingLemmatizer::Data> >
+    Lvk::Nlp::FreelingLemmatizer::Data::m_cache;
+
+QMutex * Lvk::Nlp::FreelingLemmatizer::Data::m_mutex = new QMutex();
+
+//--------------------------------------------------------------------------------------------------
+
+QSharedPointer<Lvk::Nlp::FreelingLemmatizer::Data>
+Lvk::Nlp::FreelingLemmatizer::Data::sharedData()
+{
     ConfigFilesMap configFiles;
 
     getFlConfigFiles(configFiles);
 
-    if (exists(configFiles)) {
-        qDebug() << "Initializing Freeling...";
-        init(&m_tk, configFiles[KEY_TOKENIZER_FILE]);
-        init(&m_sp, configFiles[KEY_SPLITTER_FILE]);
-        init(&m_morpho, configFiles);
+    // Data files depend on the language, so they identify the data
+    QString key = QString::fromStdString(configFiles[KEY_DICT_FILE]);
+
+    QMutexLocker locker(m_mutex);
+
+    QSharedPointer<Data> data = m_cache.value(key).toStrongRef();
+
+    if (!data) {
+        data = QSharedPointer<Data>(new Data(configFiles));
+        m_cache[key] = data;
     }
 
-    if (m_tk && m_sp && m_morpho) {
-        m_flInit = true;
-    } else {
+    return data;
+}
+
+//--------------------------------------------------------------------------------------------------
+// FreelingLemmatizer
+//--------------------------------------------------------------------------------------------------
+
+Lvk::Nlp::FreelingLemmatizer::FreelingLemmatizer()
+    : m_data(Data::sharedData()), m_preSanitizer(0), m_postSanitizer(0)
+{
+#ifdef ENABLE_FREELING_TRACES
+    traces::TraceLevel=4;
+    traces::TraceModule=0xFFFFF;
+#endif
+
+    if (!m_data->isValid()) {
         qCritical() << "Freeling could not be initialized. Lemmatization is disabled.";
     }
 
@@ -212,41 +368,37 @@ Lvk::Nlp::FreelingLemmatizer::~FreelingLemmatizer()
 {
     delete m_postSanitizer;
     delete m_preSanitizer;
-    delete m_morpho;
-    delete m_sp;
-    delete m_tk;
 }
 
 //--------------------------------------------------------------------------------------------------
 
 void Lvk::Nlp::FreelingLemmatizer::tokenize(const QString &input, QStringList &l)
 {
-    if (m_flInit) {
+    if (m_data->isValid()) {
         std::list<word> lw;
-        m_tk->tokenize(addFullStop(input).toStdString(), lw);
+        m_data->tokenize(addFullStop(input).toStdString(), lw);
 
         convert(lw, l);
     } else {
         qCritical() << "Freeling could not be initialized. Lemmatization is disabled.";
     }
 
-    qDebug() << "Tokenized:" << input << "->" << l;
+    LOG_DEBUG(Nlp) << "Tokenized:" << input << "->" << l;
 }
 
 //--------------------------------------------------------------------------------------------------
 
 void Lvk::Nlp::FreelingLemmatizer::lemmatize(const QString &input, Nlp::WordList &words)
 {
-    if (m_flInit) {
+    if (m_data->isValid()) {
         QString szInput = m_preSanitizer->sanitize(input);
 
         std::list<word> lw;
-        m_tk->tokenize(addFullStop(szInput).toStdString(), lw);
+        m_data->tokenize(addFullStop(szInput).toStdString(), lw);
 
         std::list<sentence> ls;
-        m_sp->split(lw, false, ls);
-
-        m_morpho->analyze(ls);
+        m_data->split(lw, ls);
+        m_data->analyze(ls);
 
         convert(ls, words);
 
@@ -257,5 +409,5 @@ void Lvk::Nlp::FreelingLemmatizer::lemmatize(const QString &input, Nlp::WordList
         qCritical() << "Freeling could not be initialized. Lemmatization is disabled.";
     }
 
-    qDebug() << "Lemmatized:" << input << "->" << words;
+    LOG_DEBUG(Nlp) << "Lemmatized:" << input << "->" << words;
 }
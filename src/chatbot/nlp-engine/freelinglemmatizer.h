@@ -4,9 +4,7 @@
 #include "nlp-engine/lemmatizer.h"
 #include "nlp-engine/sanitizer.h"
 
-class tokenizer;
-class splitter;
-class maco;
+#include <QSharedPointer>
 
 namespace Lvk
 {
@@ -26,6 +24,13 @@ namespace Nlp
  *        interface.
  *
  * The FreelingLemmatizer class uses Freeling to tokenize and lemmatize sentences.
+ *
+ * Freeling data is loaded once per language and shared by all FreelingLemmatizer objects, so
+ * creating one lemmatizer per engine is cheap. Tokenizers and sentence splitters are created
+ * per thread. Freeling analyzers cannot be used by two threads at once, and each morphological
+ * analyzer holds a copy of the dictionaries. Analyzers are shared through a pool that loads
+ * another one only when all are busy, up to one per core. Memory grows with the amount of
+ * threads that lemmatize at the same time, and the first concurrent calls wait for the load.
  */
 class FreelingLemmatizer : public Lemmatizer
 {
@@ -55,10 +60,9 @@ private:
     FreelingLemmatizer(const FreelingLemmatizer&);
     FreelingLemmatizer & operator=(const FreelingLemmatizer&);
 
-    bool m_flInit;
-    tokenizer *m_tk;
-    splitter *m_sp;
-    maco *m_morpho;
+    class Data;
+
+    QSharedPointer<Data> m_data;
     Sanitizer *m_preSanitizer;
     Sanitizer *m_postSanitizer;
 };
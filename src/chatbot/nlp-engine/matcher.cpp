@@ -0,0 +1,205 @@
+/*
+ * Copyright (C) 2012 Andres Pagliano, Gabriel Miretti, Gonzalo Buteler,
+ * Nestor Bustamante, Pablo Perez de Angelis
+ *
+ * This file is part of LVK Chatbot.
+ *
+ * LVK Chatbot is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LVK Chatbot is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LVK Chatbot.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "nlp-engine/matcher.h"
+#include "nlp-engine/nulllemmatizer.h"
+#include "common/tracer.h"
+#include "common/metrics.h"
+#include "common/logger.h"
+
+#include <QtDebug>
+
+//--------------------------------------------------------------------------------------------------
+// Helpers
+//--------------------------------------------------------------------------------------------------
+
+namespace
+{
+
+Lvk::Cmn::Histogram *g_lemmatizerLatency = Lvk::Cmn::Metrics::histogram(
+        "chatbot_lemmatizer_duration_seconds", "Time spent lemmatizing user inputs");
+
+} // namespace
+
+//--------------------------------------------------------------------------------------------------
+// Matcher
+//--------------------------------------------------------------------------------------------------
+
+Lvk::Nlp::Matcher::Matcher()
+    : m_lemmatizer(new NullLemmatizer())
+{
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::Nlp::Matcher::setLemmatizer(const QSharedPointer<Nlp::Lemmatizer> &lemmatizer)
+{
+    m_lemmatizer = lemmatizer ? lemmatizer : QSharedPointer<Nlp::Lemmatizer>(new NullLemmatizer());
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::Nlp::Matcher::getResponse(const QString &input, Nlp::Result &result)
+{
+    result.clear();
+
+    Nlp::ResultList results;
+    getResponses(input, results);
+
+    if (!results.isEmpty()) {
+        result = results.first();
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+QString Lvk::Nlp::Matcher::expandVars(const QString &output, bool *ok)
+{
+    TRACE_SPAN("matcher.expandVars");
+
+    // TODO a possible optimization is to have all outputs already splitted
+
+    QString newOutput;
+    QString varName;
+    QString varValue;
+    int offset = 0;
+    int i = 0;
+    bool recursive = false;
+
+    while (true) {
+        i = m_parser.parseVariable(output, &varName, &recursive, offset);
+        if (i != -1) {
+            varValue = m_searchCtx.stack().value(varName);
+
+            // if recursive variable
+            if (recursive) {
+                Nlp::Result result;
+                getResponse(varValue, result);
+
+                if (result.isValid()) {
+                    varValue = result.output;
+                } else {
+                    newOutput.clear();
+                    *ok = false;
+                    break;
+                }
+
+                i--;
+            }
+
+            newOutput += output.mid(offset, i - offset) + varValue;
+            offset =  i + varName.size() + (recursive ? 3 : 2);
+        } else {
+            newOutput += output.mid(offset);
+            *ok = true;
+            break;
+        }
+    }
+
+    return newOutput;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::Nlp::Matcher::parseRuleInput(const QString &input, Nlp::WordList &words)
+{
+    LOG_DEBUG(Engine) << "Nlp::Matcher: Parsing rule input" << input;
+
+    words.clear();
+
+    m_lemmatizer->lemmatize(input, words);
+
+    parseExactMatch(words);
+    filterSymbols(words);
+    checkSyntax(words);
+
+    LOG_DEBUG(Engine) << "Nlp::Matcher: Parsed rule input" << words;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::Nlp::Matcher::parseUserInput(const QString &input, Nlp::WordList &words)
+{
+    LOG_DEBUG(Engine) << "Nlp::Matcher: Parsing user input" << input;
+
+    words.clear();
+
+    QString szInput = input;
+    szInput.remove('\'');
+
+    {
+        TRACE_SPAN("nlp.lemmatize");
+        Cmn::ScopedLatency latency(g_lemmatizerLatency);
+        m_lemmatizer->lemmatize(szInput, words);
+    }
+
+    filterSymbols(words);
+
+    LOG_DEBUG(Engine) << "Nlp::Matcher: Parsed user input" << words;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::Nlp::Matcher::filterSymbols(Nlp::WordList &words)
+{
+    for (int i = 0; i < words.size();) {
+        if (words[i].isSymbol()) {
+            words.removeAt(i);
+        } else {
+            ++i;
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::Nlp::Matcher::checkSyntax(Nlp::WordList &/*words*/)
+{
+    // So far this method only checks for two or more consecutive star operators and only
+    // keeps one
+    //    bool isStar = false;
+    //    bool prevIsStar = false;
+    //
+    //    for (int i = 0; i < words.size();) {
+    //        isStar = words[i].isStar();
+    //        if (isStar && prevIsStar) {
+    //            words.removeAt(i);
+    //        } else {
+    //            ++i;
+    //        }
+    //        prevIsStar = isStar;
+    //    }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::Nlp::Matcher::parseExactMatch(Nlp::WordList &words)
+{
+    for (int i = 0; i < words.size(); ++i) {
+        QString &w = words[i].origWord;
+        if (w.size() >= 3 && w[0] == '\'' && w[w.size() - 1] == '\'') {
+            w = w.mid(1, w.size() - 2).toLower(); // TODO check if we want to normalize to lower
+            words[i].normWord = w;
+            words[i].lemma = "";
+            words[i].posTag = "";
+        }
+    }
+}
@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2012 Andres Pagliano, Gabriel Miretti, Gonzalo Buteler,
+ * Nestor Bustamante, Pablo Perez de Angelis
+ *
+ * This file is part of LVK Chatbot.
+ *
+ * LVK Chatbot is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LVK Chatbot is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LVK Chatbot.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef LVK_NLP_MATCHER_H
+#define LVK_NLP_MATCHER_H
+
+#include <QString>
+#include <QSharedPointer>
+
+#include "nlp-engine/word.h"
+#include "nlp-engine/result.h"
+#include "nlp-engine/parser.h"
+#include "nlp-engine/searchcontext.h"
+#include "nlp-engine/memoryusage.h"
+
+namespace Lvk
+{
+
+/// \addtogroup Lvk
+/// @{
+
+namespace Nlp
+{
+
+class Rule;
+class Lemmatizer;
+
+/// \ingroup Lvk
+/// \addtogroup Nlp
+/// @{
+
+/**
+ * \brief The Matcher class provides the abstract interface for all the structures used by
+ *        Cb2Engine to match user inputs against rules.
+ *
+ * Besides the interface, this class provides the parsing of rule and user inputs and the
+ * expansion of variables in outputs, so all matchers interpret the engine syntax the same way.
+ *
+ * \see Tree, ShiftAndMatcher
+ */
+class Matcher
+{
+public:
+
+    /**
+     * Constructs a Matcher that uses a NullLemmatizer
+     */
+    Matcher();
+
+    /**
+     * Destroys the object
+     */
+    virtual ~Matcher() { }
+
+    /**
+     * Sets the \a lemmatizer used to parse rule and user inputs. The lemmatizer must be set
+     * before adding rules. Passing a null pointer resets to a NullLemmatizer.
+     */
+    void setLemmatizer(const QSharedPointer<Nlp::Lemmatizer> &lemmatizer);
+
+    /**
+     * Adds NLP \a rule to the matcher
+     */
+    virtual void add(const Nlp::Rule &rule) = 0;
+
+    /**
+     * Gets the list of results for \a input sorted by score
+     */
+    virtual void getResponses(const QString &input, Nlp::ResultList &results) = 0;
+
+    /**
+     * Gets the results with the highest score for \a input
+     */
+    void getResponse(const QString &input, Nlp::Result &result);
+
+    /**
+     * Computes the memory footprint of the matcher and stores it in \a usage
+     */
+    virtual void memoryUsage(Nlp::MemoryUsage &usage) const = 0;
+
+protected:
+
+    Nlp::Parser m_parser;
+    Nlp::SearchContext m_searchCtx;
+    QSharedPointer<Nlp::Lemmatizer> m_lemmatizer;
+
+    /**
+     * Expands variables in \a output using the variable stack of the current search context.
+     * Recursive variables are expanded by calling getResponse(). \a ok is set to false if some
+     * recursive variable cannot be expanded.
+     */
+    QString expandVars(const QString &output, bool *ok);
+
+    /**
+     * Parses the rule input \a input and stores the result in \a words
+     */
+    void parseRuleInput(const QString &input, Nlp::WordList &words);
+
+    /**
+     * Parses the user input \a input and stores the result in \a words
+     */
+    void parseUserInput(const QString &input, Nlp::WordList &words);
+
+private:
+    void checkSyntax(Nlp::WordList &words);
+    void filterSymbols(Nlp::WordList &words);
+    void parseExactMatch(Nlp::WordList &words);
+};
+
+/// @}
+
+} // namespace Nlp
+
+/// @}
+
+} // namespace Lvk
+
+
+#endif // LVK_NLP_MATCHER_H
+
@@ -0,0 +1,170 @@
+/*
+ * Copyright (C) 2012 Andres Pagliano, Gabriel Miretti, Gonzalo Buteler,
+ * Nestor Bustamante, Pablo Perez de Angelis
+ *
+ * This file is part of LVK Chatbot.
+ *
+ * LVK Chatbot is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LVK Chatbot is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LVK Chatbot.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef LVK_NLP_MEMORYUSAGE_H
+#define LVK_NLP_MEMORYUSAGE_H
+
+#include <QString>
+#include <QStringList>
+#include <QMap>
+#include <QDebug>
+
+namespace Lvk
+{
+
+/// \addtogroup Lvk
+/// @{
+
+namespace Nlp
+{
+
+/// \ingroup Lvk
+/// \addtogroup Nlp
+/// @{
+
+/**
+ * \brief The MemoryUsage class provides the memory footprint of the structures used to match
+ *        user inputs.
+ *
+ * Counters are exact. Byte counters are estimations: they include the payload of the strings
+ * (the allocated capacity) and the size of the objects that own them, but not the overhead of
+ * the heap allocator.
+ *
+ * \see Matcher::memoryUsage(), Cb2Engine::memoryUsage()
+ */
+class MemoryUsage
+{
+public:
+    /**
+     * Constructs a MemoryUsage object with all counters set to zero
+     */
+    MemoryUsage()
+        : wordNodes(0), wildcardNodes(0), variableNodes(0), edges(0), distinctWords(0),
+          omapEntries(0), stringBytes(0), outputBytes(0) { }
+
+    int wordNodes;          ///< Amount of nodes that match a word
+    int wildcardNodes;      ///< Amount of nodes that match wildcards such as STAR_OP or PLUS_OP
+    int variableNodes;      ///< Amount of nodes that match variables
+    int edges;              ///< Amount of edges between nodes
+    int distinctWords;      ///< Amount of distinct words (original words and lemmas)
+    int omapEntries;        ///< Amount of entries in the output maps
+    qint64 stringBytes;     ///< Bytes used by strings in nodes such as words and variable names
+    qint64 outputBytes;     ///< Bytes used by outputs
+
+    /**
+     * Returns the total amount of nodes
+     */
+    int nodes() const
+    {
+        return wordNodes + wildcardNodes + variableNodes;
+    }
+
+    /**
+     * Returns the total amount of bytes
+     */
+    qint64 bytes() const
+    {
+        return stringBytes + outputBytes;
+    }
+
+    /**
+     * Adds the counters of \a other to \a this
+     */
+    MemoryUsage & operator+=(const MemoryUsage &other)
+    {
+        wordNodes += other.wordNodes;
+        wildcardNodes += other.wildcardNodes;
+        variableNodes += other.variableNodes;
+        edges += other.edges;
+        distinctWords += other.distinctWords;
+        omapEntries += other.omapEntries;
+        stringBytes += other.stringBytes;
+        outputBytes += other.outputBytes;
+
+        return *this;
+    }
+
+    /**
+     * Sets all counters to zero
+     */
+    void clear()
+    {
+        *this = MemoryUsage();
+    }
+
+    /**
+     * Returns the estimated amount of bytes used by string \a s
+     */
+    static qint64 bytes(const QString &s)
+    {
+        return sizeof(QString) + (s.isNull() ? 0 : s.capacity()*sizeof(QChar));
+    }
+
+    /**
+     * Returns the estimated amount of bytes used by the string list \a l
+     */
+    static qint64 bytes(const QStringList &l)
+    {
+        qint64 b = sizeof(QStringList);
+        foreach (const QString &s, l) {
+            b += bytes(s);
+        }
+        return b;
+    }
+};
+
+
+/**
+ * \brief This method adds support to print debug information of MemoryUsage objects
+ */
+inline QDebug& operator<<(QDebug& dbg, const MemoryUsage &u)
+{
+    dbg.nospace() << "MemoryUsage(nodes=" << u.nodes()
+                  << ", wordNodes=" << u.wordNodes
+                  << ", wildcardNodes=" << u.wildcardNodes
+                  << ", variableNodes=" << u.variableNodes
+                  << ", edges=" << u.edges
+                  << ", distinctWords=" << u.distinctWords
+                  << ", omapEntries=" << u.omapEntries
+                  << ", stringBytes=" << u.stringBytes
+                  << ", outputBytes=" << u.outputBytes
+                  << ")";
+
+    return dbg.space();
+}
+
+
+/**
+ * The MemoryUsageMap class provides a map (target, memory usage)
+ */
+typedef QMap<QString, MemoryUsage> MemoryUsageMap;
+
+/// @}
+
+} // namespace Nlp
+
+/// @}
+
+} // namespace Lvk
+
+
+#endif // LVK_NLP_MEMORYUSAGE_H
+
@@ -17,13 +17,18 @@ HEADERS += \
     $$PROJECT_PATH/nlp-engine/enginefactory.h \
     $$PROJECT_PATH/nlp-engine/nlpproperties.h \
     $$PROJECT_PATH/nlp-engine/cb2engine.h \
+    $$PROJECT_PATH/nlp-engine/matcher.h \
     $$PROJECT_PATH/nlp-engine/tree.h \
-    $$PROJECT_PATH/nlp-engine/globaltools.h \
+    $$PROJECT_PATH/nlp-engine/shiftandmatcher.h \
+    $$PROJECT_PATH/nlp-engine/shiftandengine.h \
+    $$PROJECT_PATH/nlp-engine/stringpool.h \
     $$PROJECT_PATH/nlp-engine/scoringalgorithm.h \
     $$PROJECT_PATH/nlp-engine/matchpolicy.h \
     $$PROJECT_PATH/nlp-engine/word.h \
     $$PROJECT_PATH/nlp-engine/node.h \
+    $$PROJECT_PATH/nlp-engine/nodearena.h \
     $$PROJECT_PATH/nlp-engine/result.h \
+    $$PROJECT_PATH/nlp-engine/memoryusage.h \
     $$PROJECT_PATH/nlp-engine/condoutput.h \
     $$PROJECT_PATH/nlp-engine/varstack.h \
     $$PROJECT_PATH/nlp-engine/predicate.h \
@@ -41,8 +46,12 @@ SOURCES += \
     $$PROJECT_PATH/nlp-engine/sanitizerfactory.cpp \
     $$PROJECT_PATH/nlp-engine/enginefactory.cpp \
     $$PROJECT_PATH/nlp-engine/cb2engine.cpp \
+    $$PROJECT_PATH/nlp-engine/matcher.cpp \
     $$PROJECT_PATH/nlp-engine/tree.cpp \
-    $$PROJECT_PATH/nlp-engine/globaltools.cpp \
+    $$PROJECT_PATH/nlp-engine/nodearena.cpp \
+    $$PROJECT_PATH/nlp-engine/shiftandmatcher.cpp \
+    $$PROJECT_PATH/nlp-engine/shiftandengine.cpp \
+    $$PROJECT_PATH/nlp-engine/stringpool.cpp \
     $$PROJECT_PATH/nlp-engine/scoringalgorithm.cpp \
     $$PROJECT_PATH/nlp-engine/matchpolicy.cpp \
     $$PROJECT_PATH/nlp-engine/condoutput.cpp \
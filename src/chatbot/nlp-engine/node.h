@@ -52,9 +52,10 @@ typedef QHash<quint64, CondOutputList> OutputMap;
 /**
  * \brief The Node class provides a node of a Tree
  *
- * Node is the base class for all nodes such as WordNode, WildcardNode and VariableNode
+ * Node is the base class for all nodes such as WordNode, WildcardNode and VariableNode.
+ * Nodes can be shared by several parents, so they are created and destroyed by a NodeArena.
  *
- * \see Tree, WordNode, WildcardNode and VariableNode
+ * \see Tree, NodeArena, WordNode, WildcardNode and VariableNode
  */
 class Node
 {
@@ -64,7 +65,7 @@ public:
      * Constructs a Node object with \a parent
      */
     Node(Node *parent = 0)
-        : parent(parent), m_useCount(0) { }
+        : parent(parent) { }
 
     Node *parent;           ///< The node's parent
     OutputMap omap;         ///< The node's output map
@@ -92,7 +93,6 @@ public:
     void appendChild(Node *node)
     {
         m_childs.append(node);
-        ++node->m_useCount;
     }
 
     /**
@@ -131,23 +131,15 @@ public:
     }
 
     /**
-     * Destroys the object and all child nodes not being used anymore
+     * Destroys the object. Child nodes are not destroyed since nodes are owned by the NodeArena
+     * that created them.
      */
-    virtual ~Node()
-    {
-        foreach (Node *child, m_childs) {
-            --child->m_useCount;
-            if (child->m_useCount == 0 && child != this) {
-                delete child;
-            }
-        }
-    }
+    virtual ~Node() { }
 
 private:
     Node(const Node&);
     Node& operator=(const Node&);
 
-    int m_useCount;
     QList<Node *> m_childs;
 };
 
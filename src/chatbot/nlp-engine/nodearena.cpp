@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2012 Andres Pagliano, Gabriel Miretti, Gonzalo Buteler,
+ * Nestor Bustamante, Pablo Perez de Angelis
+ *
+ * This file is part of LVK Chatbot.
+ *
+ * LVK Chatbot is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LVK Chatbot is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LVK Chatbot.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "nlp-engine/nodearena.h"
+#include "nlp-engine/node.h"
+
+#define FIRST_BLOCK_SIZE    4096
+#define MAX_BLOCK_SIZE      65536
+#define ALIGNMENT           16
+
+//--------------------------------------------------------------------------------------------------
+// Helpers
+//--------------------------------------------------------------------------------------------------
+
+namespace
+{
+
+inline size_t align(size_t size)
+{
+    return (size + ALIGNMENT - 1) & ~static_cast<size_t>(ALIGNMENT - 1);
+}
+
+} // namespace
+
+//--------------------------------------------------------------------------------------------------
+// NodeArena
+//--------------------------------------------------------------------------------------------------
+
+Lvk::Nlp::NodeArena::NodeArena()
+    : m_cur(0), m_end(0), m_firstBlockSize(0), m_nextBlockSize(FIRST_BLOCK_SIZE), m_capacity(0)
+{
+}
+
+//--------------------------------------------------------------------------------------------------
+
+Lvk::Nlp::NodeArena::~NodeArena()
+{
+    clear();
+
+    foreach (char *block, m_blocks) {
+        ::operator delete(block);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::Nlp::NodeArena::clear()
+{
+    // Nodes do not own their childs, so each destructor only releases the node's own members
+    for (int i = m_nodes.size() - 1; i >= 0; --i) {
+        m_nodes[i]->~Node();
+    }
+
+    m_nodes.clear();
+
+    // Keep the first block, release the rest
+    while (m_blocks.size() > 1) {
+        ::operator delete(m_blocks.takeLast());
+    }
+
+    if (!m_blocks.isEmpty()) {
+        m_cur = m_blocks.first();
+        m_end = m_cur + m_firstBlockSize;
+        m_capacity = m_firstBlockSize;
+    }
+
+    // m_nextBlockSize is not reset. Rebuilt trees tend to have the same size.
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void * Lvk::Nlp::NodeArena::allocate(size_t size)
+{
+    size = align(size);
+
+    if (static_cast<size_t>(m_end - m_cur) < size) {
+        addBlock(size);
+    }
+
+    void *p = m_cur;
+    m_cur += size;
+
+    return p;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::Nlp::NodeArena::addBlock(size_t minSize)
+{
+    size_t blockSize = qMax(m_nextBlockSize, minSize);
+
+    char *block = static_cast<char *>(::operator new(blockSize));
+
+    if (m_blocks.isEmpty()) {
+        m_firstBlockSize = blockSize;
+    }
+
+    m_blocks.append(block);
+    m_capacity += blockSize;
+
+    m_cur = block;
+    m_end = block + blockSize;
+
+    if (m_nextBlockSize < MAX_BLOCK_SIZE) {
+        m_nextBlockSize *= 2;
+    }
+}
+
@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2012 Andres Pagliano, Gabriel Miretti, Gonzalo Buteler,
+ * Nestor Bustamante, Pablo Perez de Angelis
+ *
+ * This file is part of LVK Chatbot.
+ *
+ * LVK Chatbot is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LVK Chatbot is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LVK Chatbot.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef LVK_NLP_NODEARENA_H
+#define LVK_NLP_NODEARENA_H
+
+#include <QList>
+#include <QVector>
+#include <new>
+
+namespace Lvk
+{
+
+/// \addtogroup Lvk
+/// @{
+
+namespace Nlp
+{
+
+class Node;
+
+/// \ingroup Lvk
+/// \addtogroup Nlp
+/// @{
+
+/**
+ * \brief The NodeArena class provides a monotonic allocator for the nodes of a Tree.
+ *
+ * Nodes are placed consecutively in memory blocks that grow geometrically. Nodes are never
+ * freed individually; all of them are destroyed at once with clear() or when the arena is
+ * destroyed. Building a tree with the arena requires a few allocations instead of one per
+ * node, and destroying it does not need to traverse the tree.
+ *
+ * \see Tree, Node
+ */
+class NodeArena
+{
+public:
+
+    /**
+     * Constructs an empty arena
+     */
+    NodeArena();
+
+    /**
+     * Destroys all the nodes created with the arena and releases its memory
+     */
+    ~NodeArena();
+
+    /**
+     * Creates a node of type \a T with the default constructor
+     */
+    template<class T>
+    T * create()
+    {
+        return track(new (allocate(sizeof(T))) T());
+    }
+
+    /**
+     * Creates a node of type \a T with constructor arguments \a a1 and \a a2
+     */
+    template<class T, class A1, class A2>
+    T * create(const A1 &a1, const A2 &a2)
+    {
+        return track(new (allocate(sizeof(T))) T(a1, a2));
+    }
+
+    /**
+     * Destroys all the nodes created with the arena. The first memory block is kept to be
+     * reused, the others are released.
+     */
+    void clear();
+
+    /**
+     * Returns the amount of nodes created with the arena
+     */
+    int size() const
+    {
+        return m_nodes.size();
+    }
+
+    /**
+     * Returns the amount of bytes reserved by the arena
+     */
+    qint64 capacity() const
+    {
+        return m_capacity;
+    }
+
+private:
+    NodeArena(const NodeArena&);
+    NodeArena& operator=(const NodeArena&);
+
+    QList<char *> m_blocks;
+    QVector<Nlp::Node *> m_nodes;
+    char *m_cur;
+    char *m_end;
+    size_t m_firstBlockSize;
+    size_t m_nextBlockSize;
+    qint64 m_capacity;
+
+    void * allocate(size_t size);
+    void addBlock(size_t minSize);
+
+    template<class T>
+    T * track(T *node)
+    {
+        m_nodes.append(node);
+        return node;
+    }
+};
+
+/// @}
+
+} // namespace Nlp
+
+/// @}
+
+} // namespace Lvk
+
+
+#endif // LVK_NLP_NODEARENA_H
+
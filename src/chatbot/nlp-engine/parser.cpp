@@ -21,6 +21,7 @@
 
 #include "nlp-engine/parser.h"
 #include "nlp-engine/syntax.h"
+#include "common/logger.h"
 
 #include <QObject>
 #include <QDebug>
@@ -73,7 +74,7 @@ int Lvk::Nlp::Parser::parseVariable(const QString &s, QString *varName, bool *re
     int i = m_varRegex.indexIn(s, offset);
 
     if (i != -1) {
-        qDebug() << "Parsed var" << m_ifRegex.cap(1);
+        LOG_DEBUG(Nlp) << "Parsed var" << m_ifRegex.cap(1);
 
         if (varName) {
             *varName = m_varRegex.cap(1).trimmed();
@@ -93,8 +94,8 @@ int Lvk::Nlp::Parser::parseIf(const QString &s, Nlp::Predicate **pred, QString *
     int i = m_ifRegex.indexIn(s, offset);
 
     if (i != -1) {
-        qDebug() << "Parsed if" << m_ifRegex.cap(1)  << m_ifRegex.cap(2)
-                 << m_ifRegex.cap(3) << m_ifRegex.cap(4);
+        LOG_DEBUG(Nlp) << "Parsed if" << m_ifRegex.cap(1)  << m_ifRegex.cap(2)
+                       << m_ifRegex.cap(3) << m_ifRegex.cap(4);
 
         if (pred) {
             *pred = parsePredicate(m_ifRegex.cap(1).trimmed(),
@@ -117,7 +118,7 @@ int Lvk::Nlp::Parser::parseElse(const QString &s, QString *body, int offset)
     int i = m_elseRegex.indexIn(s, offset);
 
     if (i != -1) {
-        qDebug() << "Parsed else" << m_ifRegex.cap(1);
+        LOG_DEBUG(Nlp) << "Parsed else" << m_ifRegex.cap(1);
 
         if (body) {
             *body = m_elseRegex.cap(1).trimmed();
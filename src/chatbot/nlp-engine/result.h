@@ -26,6 +26,7 @@
 
 #include <QString>
 #include <QList>
+#include <QDebug>
 
 namespace Lvk
 {
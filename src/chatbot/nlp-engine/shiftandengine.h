@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2012 Andres Pagliano, Gabriel Miretti, Gonzalo Buteler,
+ * Nestor Bustamante, Pablo Perez de Angelis
+ *
+ * This file is part of LVK Chatbot.
+ *
+ * LVK Chatbot is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LVK Chatbot is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LVK Chatbot.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef LVK_NLP_SHIFTANDENGINE_H
+#define LVK_NLP_SHIFTANDENGINE_H
+
+#include "nlp-engine/cb2engine.h"
+
+namespace Lvk
+{
+
+/// \addtogroup Lvk
+/// @{
+
+namespace Nlp
+{
+
+/// \ingroup Lvk
+/// \addtogroup Nlp
+/// @{
+
+/**
+ * \brief The ShiftAndEngine class provides a Cb2Engine that matches inputs with a
+ *        bit-parallel automaton instead of a tree
+ *
+ * The engine syntax, targets, topics and scores are the same as in Cb2Engine but the search
+ * is done with a ShiftAndMatcher. The matcher scans the user input once for all rules, so
+ * there is no backtracking even if rules have many wildcards.
+ *
+ * \see ShiftAndMatcher
+ */
+class ShiftAndEngine : public Cb2Engine
+{
+public:
+
+    /**
+     * Constructs a ShiftAndEngine object with NullSanitizer and NullLemmatizer.
+     *
+     * \see NullSanitizer, NullLemmatizer
+     */
+    ShiftAndEngine();
+
+    /**
+     * Constructs a ShiftAndEngine object with the given \a sanitizer and NullLemmatizer.
+     * After construction, the object owns the given pointer.
+     *
+     * \see NullLemmatizer
+     */
+    ShiftAndEngine(Sanitizer *sanitizer);
+
+    /**
+     * Constructs a ShiftAndEngine object with the given sanitizers and lemmatizer.
+     * After construction, the object owns the given pointers.
+     */
+    ShiftAndEngine(Sanitizer *preSanitizer, Lemmatizer *lemmatizer, Sanitizer *postSanitizer);
+
+protected:
+
+    /**
+     * Creates a ShiftAndMatcher
+     */
+    virtual Nlp::Matcher * createMatcher();
+
+private:
+    ShiftAndEngine(ShiftAndEngine&);
+    ShiftAndEngine& operator=(ShiftAndEngine&);
+};
+
+/// @}
+
+} // namespace Nlp
+
+/// @}
+
+} // namespace Lvk
+
+#endif // LVK_NLP_SHIFTANDENGINE_H
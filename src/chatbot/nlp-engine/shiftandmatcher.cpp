@@ -0,0 +1,541 @@
+/*
+ * Copyright (C) 2012 Andres Pagliano, Gabriel Miretti, Gonzalo Buteler,
+ * Nestor Bustamante, Pablo Perez de Angelis
+ *
+ * This file is part of LVK Chatbot.
+ *
+ * LVK Chatbot is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LVK Chatbot is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LVK Chatbot.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "nlp-engine/shiftandmatcher.h"
+#include "nlp-engine/word.h"
+#include "common/tracer.h"
+#include "common/logger.h"
+
+#include <QtAlgorithms>
+#include <QtDebug>
+
+#define WORD_BITS           64
+#define EXACT_MATCH_WEIGHT  1.0
+#define LEMMA_MATCH_WEIGHT  0.5
+#define ANY_MATCH_WEIGHT    0.001
+#define NO_MATCH            -1.0
+
+//--------------------------------------------------------------------------------------------------
+// Helpers
+//--------------------------------------------------------------------------------------------------
+
+namespace
+{
+
+typedef QVector<quint64> BitVector;
+
+inline bool highScoreFirst(const Lvk::Nlp::Result &r1, const Lvk::Nlp::Result &r2)
+{
+    return r1.score > r2.score;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+inline void setBit(BitVector &v, int bit)
+{
+    int w = bit / WORD_BITS;
+
+    if (w >= v.size()) {
+        v.resize(w + 1);
+    }
+
+    v[w] |= Q_UINT64_C(1) << (bit % WORD_BITS);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+inline bool testBit(const BitVector &v, int bit)
+{
+    int w = bit / WORD_BITS;
+
+    return w < v.size() && (v[w] & (Q_UINT64_C(1) << (bit % WORD_BITS)));
+}
+
+//--------------------------------------------------------------------------------------------------
+
+inline bool isZero(const BitVector &v)
+{
+    for (int w = 0; w < v.size(); ++w) {
+        if (v[w]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+// dst = (src << n) with carry between words. Requires 0 < n < WORD_BITS
+inline void shiftLeft(BitVector &dst, const BitVector &src, int n)
+{
+    for (int w = src.size() - 1; w > 0; --w) {
+        dst[w] = (src[w] << n) | (src[w - 1] >> (WORD_BITS - n));
+    }
+    if (!src.isEmpty()) {
+        dst[0] = src[0] << n;
+    }
+}
+
+} // namespace
+
+//--------------------------------------------------------------------------------------------------
+// ShiftAndMatcher
+//--------------------------------------------------------------------------------------------------
+
+Lvk::Nlp::ShiftAndMatcher::ShiftAndMatcher()
+{
+}
+
+//--------------------------------------------------------------------------------------------------
+
+Lvk::Nlp::ShiftAndMatcher::~ShiftAndMatcher()
+{
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::Nlp::ShiftAndMatcher::add(const Nlp::Rule &rule)
+{
+    Nlp::WordList words;
+
+    Nlp::CondOutputList outputs(rule.output(), rule.randomOutput());
+
+    for (int i = 0; i < rule.input().size(); ++i) {
+
+        LOG_DEBUG(Engine) << "Nlp::ShiftAndMatcher: Parsing rule id" << rule.id() << "input #" << i;
+        parseRuleInput(rule.input().at(i), words);
+
+        if (words.isEmpty()) {
+            continue;
+        }
+
+        Pattern p;
+        p.ruleId = rule.id();
+        p.inputIdx = i;
+        p.first = m_elements.size();
+        p.size = words.size();
+        p.outputs = outputs;
+
+        m_patterns.append(p);
+
+        int patternIdx = m_patterns.size() - 1;
+
+        foreach (const Nlp::Word &w, words) {
+            addElement(w, patternIdx);
+        }
+
+        int first = p.first;
+        int last = p.first + p.size - 1;
+
+        setBit(m_firstMask, first);
+        setBit(m_initMask, first);
+        setBit(m_acceptMask, last);
+
+        // A leading star can be skipped, so the second element can consume the first token
+        if (p.size > 1 && m_elements[first].type == Element::StarElement) {
+            setBit(m_initMask, first + 1);
+        }
+
+        // A trailing star can be skipped, so the previous element can consume the last token
+        if (p.size > 1 && m_elements[last].type == Element::StarElement) {
+            setBit(m_acceptMask, last - 1);
+        }
+
+        // A star in the middle can be skipped. As in the Tree class, only one star is skipped
+        for (int j = first + 1; j < last; ++j) {
+            if (m_elements[j].type == Element::StarElement) {
+                setBit(m_skipMask, j - 1);
+            }
+        }
+    }
+
+    // Keep all masks with the same amount of words
+    int size = (m_elements.size() + WORD_BITS - 1) / WORD_BITS;
+
+    m_anyMask.resize(size);
+    m_loopMask.resize(size);
+    m_skipMask.resize(size);
+    m_firstMask.resize(size);
+    m_initMask.resize(size);
+    m_acceptMask.resize(size);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::Nlp::ShiftAndMatcher::addElement(const Nlp::Word &word, int patternIdx)
+{
+    Element e;
+    int bit = m_elements.size();
+
+    if (word.isStar()) {
+        e.type = Element::StarElement;
+    } else if (word.isPlus()) {
+        e.type = Element::PlusElement;
+    } else if (word.isVariable()) {
+        e.type = Element::VariableElement;
+        e.varName = word.origWord.mid(1, word.origWord.size() - 2); // Remove square braces
+    } else {
+        e.type = Element::WordElement;
+        e.origWord = word.origWord;
+        e.lemma = word.lemma;
+    }
+
+    if (e.type == Element::WordElement) {
+        int origId = tokenId(e.origWord);
+        m_origBits[origId].append(bit);
+
+        if (!e.lemma.isEmpty()) {
+            int lemmaId = tokenId(e.lemma);
+            m_lemmaBits[lemmaId].append(bit);
+        }
+    } else {
+        setBit(m_anyMask, bit);
+        setBit(m_loopMask, bit);
+    }
+
+    m_elements.append(e);
+    m_owners.append(patternIdx);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+int Lvk::Nlp::ShiftAndMatcher::tokenId(const QString &token)
+{
+    QHash<QString, int>::const_iterator it = m_tokenIds.constFind(token);
+
+    if (it != m_tokenIds.constEnd()) {
+        return *it;
+    }
+
+    int id = m_tokenIds.size();
+
+    m_tokenIds.insert(token, id);
+    m_origBits.append(QVector<int>());
+    m_lemmaBits.append(QVector<int>());
+
+    return id;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::Nlp::ShiftAndMatcher::getResponses(const QString &input, Nlp::ResultList &results)
+{
+    Nlp::WordList words;
+    parseUserInput(input, words);
+
+    QList<int> matched;
+
+    {
+        TRACE_SPAN("shiftand.scan");
+        scan(words, matched);
+    }
+
+    m_searchCtx.push();
+
+    foreach (int patternIdx, matched) {
+        handleMatch(results, patternIdx, words);
+    }
+
+    qStableSort(results.begin(), results.end(), highScoreFirst);
+
+    m_searchCtx.pop();
+
+    if (m_searchCtx.isEmpty()) {
+        m_loopDetector.clear();
+    }
+
+    LOG_DEBUG(Engine) << "Nlp::ShiftAndMatcher: Results: " << results;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::Nlp::ShiftAndMatcher::memoryUsage(Nlp::MemoryUsage &usage) const
+{
+    usage.clear();
+
+    // Each element is a node entered from the previous element (or from the pattern start).
+    // Elements that consume several tokens also have an edge to themselves.
+    foreach (const Element &e, m_elements) {
+        switch (e.type) {
+        case Element::WordElement:
+            ++usage.wordNodes;
+            ++usage.edges;
+            break;
+        case Element::StarElement:
+        case Element::PlusElement:
+            ++usage.wildcardNodes;
+            usage.edges += 2;
+            break;
+        case Element::VariableElement:
+            ++usage.variableNodes;
+            usage.edges += 2;
+            break;
+        }
+
+        usage.stringBytes += Nlp::MemoryUsage::bytes(e.origWord) + Nlp::MemoryUsage::bytes(e.lemma)
+                + Nlp::MemoryUsage::bytes(e.varName);
+    }
+
+    QHash<QString, int>::const_iterator it;
+    for (it = m_tokenIds.constBegin(); it != m_tokenIds.constEnd(); ++it) {
+        usage.stringBytes += Nlp::MemoryUsage::bytes(it.key());
+    }
+
+    usage.distinctWords = m_tokenIds.size();
+    usage.omapEntries = m_patterns.size();
+
+    foreach (const Pattern &p, m_patterns) {
+        usage.outputBytes += sizeof(Pattern) - sizeof(Nlp::CondOutputList) + p.outputs.byteCount();
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::Nlp::ShiftAndMatcher::scan(const Nlp::WordList &words, QList<int> &matched)
+{
+    if (words.isEmpty() || m_elements.isEmpty()) {
+        return;
+    }
+
+    int size = m_firstMask.size();
+
+    BitVector state(size);
+    BitVector next(size);
+    BitVector shifted(size);
+    BitVector mask(size);
+
+    for (int t = 0; t < words.size(); ++t) {
+        charMask(words[t], mask);
+
+        if (t == 0) {
+            for (int w = 0; w < size; ++w) {
+                next[w] = m_initMask[w] & mask[w];
+            }
+        } else {
+            // Advance one element
+            shiftLeft(shifted, state, 1);
+            for (int w = 0; w < size; ++w) {
+                next[w] = (shifted[w] & ~m_firstMask[w]) | (state[w] & m_loopMask[w]);
+            }
+
+            // Advance two elements skipping a star
+            for (int w = 0; w < size; ++w) {
+                shifted[w] = state[w] & m_skipMask[w];
+            }
+            shiftLeft(shifted, shifted, 2);
+            for (int w = 0; w < size; ++w) {
+                next[w] = (next[w] | shifted[w]) & mask[w];
+            }
+        }
+
+        qSwap(state, next);
+
+        if (isZero(state)) {
+            return;
+        }
+    }
+
+    int lastPattern = -1;
+
+    for (int bit = 0; bit < m_elements.size(); ++bit) {
+        if (testBit(state, bit) && testBit(m_acceptMask, bit) && m_owners[bit] != lastPattern) {
+            lastPattern = m_owners[bit];
+            matched.append(lastPattern);
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::Nlp::ShiftAndMatcher::charMask(const Nlp::Word &word, BitVector &mask)
+{
+    // Copy word by word: assigning m_anyMask would share it and setBit() would detach it,
+    // allocating a new vector for every token
+    const int size = m_anyMask.size();
+    const quint64 *any = m_anyMask.constData();
+    quint64 *data = mask.data();
+    for (int w = 0; w < size; ++w) {
+        data[w] = any[w];
+    }
+
+    QHash<QString, int>::const_iterator it = m_tokenIds.constFind(word.origWord);
+    if (it != m_tokenIds.constEnd()) {
+        foreach (int bit, m_origBits[*it]) {
+            setBit(mask, bit);
+        }
+    }
+
+    if (!word.lemma.isEmpty()) {
+        it = m_tokenIds.constFind(word.lemma);
+        if (it != m_tokenIds.constEnd()) {
+            foreach (int bit, m_lemmaBits[*it]) {
+                setBit(mask, bit);
+            }
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::Nlp::ShiftAndMatcher::handleMatch(Nlp::ResultList &results, int patternIdx,
+                                            const Nlp::WordList &words)
+{
+    QPair<int, int> p(patternIdx, words.size() - 1);
+
+    if (m_loopDetector.contains(p)) {
+        LOG_DEBUG(Engine) << "Nlp::ShiftAndMatcher: Infinite loop detected!";
+        return;
+    }
+
+    const Pattern &pattern = m_patterns[patternIdx];
+
+    QVector<int> path;
+    float score = align(pattern, words, path);
+
+    if (score == NO_MATCH) {
+        return;
+    }
+
+    m_loopDetector.insert(p);
+
+    captureVars(pattern, words, path);
+
+    QString output = pattern.outputs.nextValidOutput(m_searchCtx.stack());
+
+    if (!output.isNull()) {
+        bool ok;
+        QString expOutput = expandVars(output, &ok);
+        if (ok) {
+            results.append(Nlp::Result(expOutput, pattern.ruleId, pattern.inputIdx, score));
+        } else {
+            LOG_DEBUG(Engine) << "Failed to expand output" << output;
+        }
+    }
+
+    m_loopDetector.remove(p);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+float Lvk::Nlp::ShiftAndMatcher::align(const Pattern &p, const Nlp::WordList &words,
+                                       QVector<int> &path)
+{
+    // Dynamic programming over the same automaton used by scan() to find the alignment with
+    // the highest score. best[t*m + i] is the best score when token t is consumed by element i
+
+    const Element *e = m_elements.constData() + p.first;
+    int m = p.size;
+    int n = words.size();
+
+    QVector<float> best(n*m, NO_MATCH);
+    QVector<int> prev(n*m, -1);
+
+    for (int t = 0; t < n; ++t) {
+        for (int i = 0; i < m; ++i) {
+            float w = weight(e[i], words[t]);
+            if (w <= 0) {
+                continue;
+            }
+
+            if (t == 0) {
+                if (i == 0 || (i == 1 && e[0].type == Element::StarElement)) {
+                    best[i] = w;
+                }
+                continue;
+            }
+
+            const float *row = best.constData() + (t - 1)*m;
+            float b = NO_MATCH;
+            int from = -1;
+
+            if (i > 0 && row[i - 1] > b) {
+                b = row[i - 1];
+                from = i - 1;
+            }
+            if (i > 1 && e[i - 1].type == Element::StarElement && row[i - 2] > b) {
+                b = row[i - 2];
+                from = i - 2;
+            }
+            if (e[i].type != Element::WordElement && row[i] > b) {
+                b = row[i];
+                from = i;
+            }
+
+            if (from != -1) {
+                best[t*m + i] = b + w;
+                prev[t*m + i] = from;
+            }
+        }
+    }
+
+    int end = m - 1;
+    const float *last = best.constData() + (n - 1)*m;
+
+    if (m > 1 && e[m - 1].type == Element::StarElement && last[m - 2] > last[m - 1]) {
+        end = m - 2;
+    }
+
+    if (last[end] == NO_MATCH) {
+        return NO_MATCH;
+    }
+
+    path.resize(n);
+    for (int t = n - 1, i = end; t >= 0; --t) {
+        path[t] = i;
+        i = prev[t*m + i];
+    }
+
+    return last[end];
+}
+
+//--------------------------------------------------------------------------------------------------
+
+float Lvk::Nlp::ShiftAndMatcher::weight(const Element &e, const Nlp::Word &w)
+{
+    // Same weights as MatchPolicy
+
+    if (e.type != Element::WordElement) {
+        return ANY_MATCH_WEIGHT;
+    } else if (e.origWord == w.origWord) {
+        return EXACT_MATCH_WEIGHT;
+    } else if (e.lemma.size() > 0 && e.lemma == w.lemma) {
+        return LEMMA_MATCH_WEIGHT;
+    } else {
+        return 0;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::Nlp::ShiftAndMatcher::captureVars(const Pattern &p, const Nlp::WordList &words,
+                                            const QVector<int> &path)
+{
+    // Replay the alignment as the Tree DFS would do when walking that path
+
+    Nlp::VarStack &stack = m_searchCtx.stack();
+    stack = Nlp::VarStack();
+
+    for (int t = 0; t < words.size(); ++t) {
+        const Element &e = m_elements[p.first + path[t]];
+        stack.update(e.type == Element::VariableElement ? e.varName : QString(), t);
+        stack.capture(words[t].origWord, t);
+    }
+}
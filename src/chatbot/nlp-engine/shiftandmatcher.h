@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2012 Andres Pagliano, Gabriel Miretti, Gonzalo Buteler,
+ * Nestor Bustamante, Pablo Perez de Angelis
+ *
+ * This file is part of LVK Chatbot.
+ *
+ * LVK Chatbot is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LVK Chatbot is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LVK Chatbot.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef LVK_NLP_SHIFTANDMATCHER_H
+#define LVK_NLP_SHIFTANDMATCHER_H
+
+#include <QString>
+#include <QList>
+#include <QVector>
+#include <QHash>
+#include <QSet>
+#include <QPair>
+
+#include "nlp-engine/matcher.h"
+#include "nlp-engine/rule.h"
+#include "nlp-engine/condoutputlist.h"
+
+namespace Lvk
+{
+
+/// \addtogroup Lvk
+/// @{
+
+namespace Nlp
+{
+
+/// \ingroup Lvk
+/// \addtogroup Nlp
+/// @{
+
+/**
+ * \brief The ShiftAndMatcher class provides a bit-parallel matcher for NLP rules
+ *
+ * Each rule input is compiled into a pattern of elements (words, wildcards and variables).
+ * All patterns are laid out in a single bit vector, one bit per element, and the user input is
+ * scanned once using an extended Shift-And automaton over token IDs. Bit \a i is set after
+ * reading token \a t if some prefix of the pattern that owns \a i matches tokens [0,t] and
+ * the last token was consumed by element \a i. Wildcards and variables have a self loop and
+ * a star can be skipped, as in the Tree class.
+ *
+ * Scanning is linear in the input size regardless of the amount of wildcards in the rules.
+ * Scores and variable captures are computed afterwards only for the patterns that matched.
+ *
+ * \see Tree
+ */
+class ShiftAndMatcher : public Matcher
+{
+public:
+
+    /**
+     * Constructs an empty matcher
+     */
+    ShiftAndMatcher();
+
+    /**
+     * Destroys the object
+     */
+    ~ShiftAndMatcher();
+
+    /**
+     * \copydoc Matcher::add()
+     */
+    virtual void add(const Nlp::Rule &rule);
+
+    /**
+     * \copydoc Matcher::getResponses()
+     */
+    virtual void getResponses(const QString &input, Nlp::ResultList &results);
+
+    /**
+     * \copydoc Matcher::memoryUsage()
+     */
+    virtual void memoryUsage(Nlp::MemoryUsage &usage) const;
+
+private:
+    ShiftAndMatcher(ShiftAndMatcher&);
+    ShiftAndMatcher& operator=(ShiftAndMatcher&);
+
+    typedef QVector<quint64> BitVector;
+
+    /// Pattern element
+    struct Element
+    {
+        enum Type { WordElement, StarElement, PlusElement, VariableElement };
+
+        Type type;
+        QString origWord;
+        QString lemma;
+        QString varName;
+    };
+
+    /// Compiled rule input
+    struct Pattern
+    {
+        RuleId ruleId;
+        int inputIdx;
+        int first;                  // Bit of the first element
+        int size;                   // Amount of elements
+        Nlp::CondOutputList outputs;
+    };
+
+    QVector<Element> m_elements;          // Indexed by bit
+    QVector<int> m_owners;                // Bit -> pattern index
+    QList<Pattern> m_patterns;
+    QHash<QString, int> m_tokenIds;
+    QVector< QVector<int> > m_origBits;   // Token ID -> bits of words with that original word
+    QVector< QVector<int> > m_lemmaBits;  // Token ID -> bits of words with that lemma
+    BitVector m_anyMask;                  // Elements that match any token
+    BitVector m_loopMask;                 // Elements that can consume several tokens
+    BitVector m_skipMask;                 // Elements followed by a star that can be skipped
+    BitVector m_firstMask;                // First element of each pattern
+    BitVector m_initMask;                 // Elements that can consume the first token
+    BitVector m_acceptMask;               // Elements that can consume the last token
+    QSet< QPair<int, int> > m_loopDetector;
+
+    int tokenId(const QString &token);
+    void addElement(const Nlp::Word &word, int patternIdx);
+    void scan(const Nlp::WordList &words, QList<int> &matched);
+    void charMask(const Nlp::Word &word, BitVector &mask);
+    float align(const Pattern &p, const Nlp::WordList &words, QVector<int> &path);
+    float weight(const Element &e, const Nlp::Word &w);
+    void captureVars(const Pattern &p, const Nlp::WordList &words, const QVector<int> &path);
+    void handleMatch(Nlp::ResultList &results, int patternIdx, const Nlp::WordList &words);
+};
+
+/// @}
+
+} // namespace Nlp
+
+/// @}
+
+} // namespace Lvk
+
+
+#endif // LVK_NLP_SHIFTANDMATCHER_H
+
@@ -0,0 +1,167 @@
+/*
+ * Copyright (C) 2012 Andres Pagliano, Gabriel Miretti, Gonzalo Buteler,
+ * Nestor Bustamante, Pablo Perez de Angelis
+ *
+ * This file is part of LVK Chatbot.
+ *
+ * LVK Chatbot is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LVK Chatbot is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LVK Chatbot.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "nlp-engine/stringpool.h"
+#include "nlp-engine/word.h"
+
+#include <QMutex>
+#include <QMutexLocker>
+
+// Pools smaller than this are not purged automatically
+#define MIN_PURGE_SIZE      4096
+
+//--------------------------------------------------------------------------------------------------
+// StringPool
+//--------------------------------------------------------------------------------------------------
+
+Lvk::Nlp::StringPool * Lvk::Nlp::StringPool::m_instance = 0;
+QMutex * Lvk::Nlp::StringPool::m_mutex = new QMutex();
+
+//--------------------------------------------------------------------------------------------------
+
+Lvk::Nlp::StringPool::StringPool()
+    : m_enabled(false),
+      m_purgeSize(MIN_PURGE_SIZE)
+{
+}
+
+//--------------------------------------------------------------------------------------------------
+
+Lvk::Nlp::StringPool * Lvk::Nlp::StringPool::instance()
+{
+    if (!m_instance) {
+        QMutexLocker locker(m_mutex);
+        if (!m_instance) {
+            m_instance = new StringPool();
+        }
+    }
+
+    return m_instance;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::Nlp::StringPool::setEnabled(bool enabled)
+{
+    QMutexLocker locker(m_mutex);
+
+    m_enabled = enabled;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool Lvk::Nlp::StringPool::isEnabled() const
+{
+    QMutexLocker locker(m_mutex);
+
+    return m_enabled;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+QString Lvk::Nlp::StringPool::intern(const QString &str)
+{
+    QMutexLocker locker(m_mutex);
+
+    if (!m_enabled || str.isEmpty()) {
+        return str;
+    }
+
+    QSet<QString>::const_iterator it = m_strings.constFind(str);
+
+    if (it != m_strings.constEnd()) {
+        return *it;
+    }
+
+    m_strings.insert(str);
+
+    // Amortized: each purge visits at most twice the strings inserted since the last one
+    if (m_strings.size() >= m_purgeSize) {
+        purgeUnlocked();
+        m_purgeSize = qMax(MIN_PURGE_SIZE, 2*m_strings.size());
+    }
+
+    return str;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::Nlp::StringPool::intern(Word &word)
+{
+    word.origWord = intern(word.origWord);
+    word.normWord = intern(word.normWord);
+    word.lemma    = intern(word.lemma);
+    word.posTag   = intern(word.posTag);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+int Lvk::Nlp::StringPool::size() const
+{
+    QMutexLocker locker(m_mutex);
+
+    return m_strings.size();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+int Lvk::Nlp::StringPool::purge()
+{
+    QMutexLocker locker(m_mutex);
+
+    int removed = purgeUnlocked();
+
+    m_purgeSize = qMax(MIN_PURGE_SIZE, 2*m_strings.size());
+
+    return removed;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+int Lvk::Nlp::StringPool::purgeUnlocked()
+{
+    int removed = 0;
+
+    // A detached string is not shared, so the pool holds its only reference. Nobody else can
+    // copy it concurrently because copies come from intern(), which holds the mutex.
+    QSet<QString>::iterator it = m_strings.begin();
+    while (it != m_strings.end()) {
+        if (it->isDetached()) {
+            it = m_strings.erase(it);
+            ++removed;
+        } else {
+            ++it;
+        }
+    }
+
+    return removed;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::Nlp::StringPool::clear()
+{
+    QMutexLocker locker(m_mutex);
+
+    m_strings.clear();
+    m_purgeSize = MIN_PURGE_SIZE;
+}
+
@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2012 Andres Pagliano, Gabriel Miretti, Gonzalo Buteler,
+ * Nestor Bustamante, Pablo Perez de Angelis
+ *
+ * This file is part of LVK Chatbot.
+ *
+ * LVK Chatbot is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LVK Chatbot is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LVK Chatbot.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef LVK_NLP_STRINGPOOL_H
+#define LVK_NLP_STRINGPOOL_H
+
+#include <QString>
+#include <QSet>
+
+class QMutex;
+
+namespace Lvk
+{
+
+/// \addtogroup Lvk
+/// @{
+
+namespace Nlp
+{
+
+/// \ingroup Lvk
+/// \addtogroup Nlp
+/// @{
+
+class Word;
+
+/**
+ * \brief The StringPool class provides a process-wide pool of interned strings.
+ *
+ * Interning a string returns the copy stored in the pool, so equal strings share their data
+ * through Qt implicit sharing. Trees intern the words of their nodes, so a process that hosts
+ * many chatbots keeps a single copy of each word, lemma and PoS tag.
+ *
+ * The pool is disabled by default, in that case intern() returns its argument. Strings that are
+ * only referenced by the pool, i.e. whose trees were destroyed, are released by purge(). The
+ * pool also purges itself each time its size doubles.
+ */
+class StringPool
+{
+public:
+
+    /**
+     * Returns the pool instance
+     */
+    static StringPool* instance();
+
+    /**
+     * Enables or disables the pool. Disabling the pool does not clear it.
+     */
+    void setEnabled(bool enabled);
+
+    /**
+     * Returns true if the pool is enabled. Otherwise; returns false.
+     */
+    bool isEnabled() const;
+
+    /**
+     * Returns the interned copy of \a str. If the pool is disabled, returns \a str.
+     */
+    QString intern(const QString &str);
+
+    /**
+     * Interns all strings of \a word.
+     */
+    void intern(Word &word);
+
+    /**
+     * Returns the amount of strings in the pool
+     */
+    int size() const;
+
+    /**
+     * Removes the strings that are not used outside the pool. Returns the amount of strings
+     * removed.
+     */
+    int purge();
+
+    /**
+     * Removes all strings from the pool
+     */
+    void clear();
+
+private:
+    StringPool();
+    StringPool(StringPool&);
+    StringPool& operator=(StringPool&);
+
+    static StringPool *m_instance;
+    static QMutex *m_mutex;
+
+    QSet<QString> m_strings;
+    bool m_enabled;
+    int m_purgeSize;            // Size that triggers the next automatic purge
+
+    int purgeUnlocked();
+};
+
+/// @}
+
+} // namespace Nlp
+
+/// @}
+
+} // namespace Lvk
+
+
+#endif // LVK_NLP_STRINGPOOL_H
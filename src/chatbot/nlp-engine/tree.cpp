@@ -21,10 +21,14 @@
 
 #include "nlp-engine/tree.h"
 #include "nlp-engine/node.h"
+#include "nlp-engine/nodearena.h"
 #include "nlp-engine/word.h"
-#include "nlp-engine/globaltools.h"
 #include "nlp-engine/matchpolicy.h"
 #include "nlp-engine/scoringalgorithm.h"
+#include "nlp-engine/memoryusage.h"
+#include "nlp-engine/stringpool.h"
+#include "common/tracer.h"
+#include "common/logger.h"
 
 #include <QtAlgorithms>
 
@@ -70,6 +74,16 @@ inline int getInputIndex(quint64 id)
     return id & INPUT_IDX_MASK;
 }
 
+//--------------------------------------------------------------------------------------------------
+
+inline qint64 wordBytes(const Lvk::Nlp::Word &w)
+{
+    typedef Lvk::Nlp::MemoryUsage MU;
+
+    return MU::bytes(w.origWord) + MU::bytes(w.normWord) + MU::bytes(w.lemma) + MU::bytes(w.posTag)
+            + MU::bytes(w.altSpells);
+}
+
 } // namespace
 
 //--------------------------------------------------------------------------------------------------
@@ -77,7 +91,7 @@ inline int getInputIndex(quint64 id)
 //--------------------------------------------------------------------------------------------------
 
 Lvk::Nlp::Tree::Tree()
-    : m_root(new Nlp::Node()),
+    : m_root(m_arena.create<Nlp::Node>()),
       m_matchPolicy(new Nlp::MatchPolicy())
 {
 }
@@ -87,7 +101,8 @@ Lvk::Nlp::Tree::Tree()
 Lvk::Nlp::Tree::~Tree()
 {
     delete m_matchPolicy;
-    delete m_root;
+
+    // Nodes are released by m_arena
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -102,7 +117,7 @@ void Lvk::Nlp::Tree::add(const Nlp::Rule &rule)
 
     for (int i = 0; i < rule.input().size(); ++i) {
 
-        qDebug() << "Nlp::Tree: Parsing rule id" << rule.id() << "input #" << i;
+        LOG_DEBUG(Engine) << "Nlp::Tree: Parsing rule id" << rule.id() << "input #" << i;
         parseRuleInput(rule.input().at(i), words);
 
         if (words.isEmpty()) {
@@ -183,14 +198,17 @@ Lvk::Nlp::Node * Lvk::Nlp::Tree::addNode(const Nlp::Word &word, Nlp::Node *paren
     Nlp::Node *newNode = 0;
 
     if (word.isWildcard()) {
-        newNode = new Nlp::WildcardNode(word.origWord, parent);
+        newNode = m_arena.create<Nlp::WildcardNode>(word.origWord, parent);
         newNode->appendChild(newNode); // Loop node (see engine documentation)
     } else if (word.isVariable()) {
         QString varName = word.origWord.mid(1, word.origWord.size() - 2); // Remove square braces
-        newNode = new Nlp::VariableNode(varName, parent);
+        newNode = m_arena.create<Nlp::VariableNode>(varName, parent);
         newNode->appendChild(newNode); // Loop node (see engine documentation)
     } else {
-        newNode = new Nlp::WordNode(word, parent);
+        // Equal words share their strings among all trees if the pool is enabled
+        Nlp::Word pooledWord = word;
+        Nlp::StringPool::instance()->intern(pooledWord);
+        newNode = m_arena.create<Nlp::WordNode>(pooledWord, parent);
     }
 
     parent->appendChild(newNode);
@@ -201,26 +219,13 @@ Lvk::Nlp::Node * Lvk::Nlp::Tree::addNode(const Nlp::Word &word, Nlp::Node *paren
         parent->parent->appendChild(newNode);
     }
 
-    qDebug() << "Nlp::Tree: Added new node" << *newNode << "with parent" << *parent;
+    LOG_DEBUG(Engine) << "Nlp::Tree: Added new node" << *newNode << "with parent" << *parent;
 
     return newNode;
 }
 
 //--------------------------------------------------------------------------------------------------
 
-void Lvk::Nlp::Tree::getResponse(const QString &input, Nlp::Result &result)
-{
-    result.clear();
-
-    Nlp::ResultList results;
-    getResponses(input, results);
-
-    if (!results.isEmpty()) {
-        result = results.first();
-    }
-}
-//--------------------------------------------------------------------------------------------------
-
 void Lvk::Nlp::Tree::getResponses(const QString &input, Nlp::ResultList &results)
 {
     Nlp::WordList words;
@@ -228,9 +233,12 @@ void Lvk::Nlp::Tree::getResponses(const QString &input, Nlp::ResultList &results
 
     m_searchCtx.push();
 
-    scoredDFS(results, m_root, words);
+    {
+        TRACE_SPAN("tree.scoredDFS");
+        scoredDFS(results, m_root, words);
+    }
 
-    qSort(results.begin(), results.end(), highScoreFirst);
+    qStableSort(results.begin(), results.end(), highScoreFirst);
 
     m_searchCtx.pop();
 
@@ -238,7 +246,7 @@ void Lvk::Nlp::Tree::getResponses(const QString &input, Nlp::ResultList &results
         m_loopDetector.clear();
     }
 
-    qDebug() << "Nlp::Tree: Results: " << results;
+    LOG_DEBUG(Engine) << "Nlp::Tree: Results: " << results;
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -300,6 +308,58 @@ void Lvk::Nlp::Tree::handleEndWord(Nlp::ResultList &results, const Nlp::Node *no
 
 //--------------------------------------------------------------------------------------------------
 
+void Lvk::Nlp::Tree::memoryUsage(Nlp::MemoryUsage &usage) const
+{
+    usage.clear();
+
+    // Nodes can be shared and can have themselves as child, so we keep track of visited nodes.
+    // The root node is not accounted because it's always present and it has no payload
+    QSet<const Nlp::Node *> visited;
+    QSet<QString> words;
+    QList<const Nlp::Node *> pending;
+
+    visited.insert(m_root);
+    pending.append(m_root);
+
+    while (!pending.isEmpty()) {
+        const Nlp::Node *node = pending.takeLast();
+
+        if (const Nlp::WordNode *wnode = node->to<Nlp::WordNode>()) {
+            ++usage.wordNodes;
+            usage.stringBytes += wordBytes(wnode->word);
+            words.insert(wnode->word.origWord);
+            if (!wnode->word.lemma.isEmpty()) {
+                words.insert(wnode->word.lemma);
+            }
+        } else if (node->is<Nlp::WildcardNode>()) {
+            ++usage.wildcardNodes;
+        } else if (const Nlp::VariableNode *vnode = node->to<Nlp::VariableNode>()) {
+            ++usage.variableNodes;
+            usage.stringBytes += Nlp::MemoryUsage::bytes(vnode->varName);
+        }
+
+        usage.omapEntries += node->omap.size();
+
+        Nlp::OutputMap::const_iterator it;
+        for (it = node->omap.constBegin(); it != node->omap.constEnd(); ++it) {
+            usage.outputBytes += sizeof(quint64) + it.value().byteCount();
+        }
+
+        usage.edges += node->childs().size();
+
+        foreach (const Nlp::Node *child, node->childs()) {
+            if (!visited.contains(child)) {
+                visited.insert(child);
+                pending.append(child);
+            }
+        }
+    }
+
+    usage.distinctWords = words.size();
+}
+
+//--------------------------------------------------------------------------------------------------
+
 Lvk::Nlp::ResultList Lvk::Nlp::Tree::getResultsForNode(const Nlp::Node *node)
 {
     Nlp::ResultList results;
@@ -328,7 +388,7 @@ Lvk::Nlp::ResultList Lvk::Nlp::Tree::getResultsForNode(const Nlp::Node *node)
         if (ok) {
             results.append(Nlp::Result(expOutput, ruleId, inputIdx, score));
         } else {
-            qDebug() << "Failed to expand output" << output << ". Trying with next output";
+            LOG_DEBUG(Engine) << "Failed to expand output" << output << ". Trying with next output";
         }
 
     }
@@ -336,130 +396,3 @@ Lvk::Nlp::ResultList Lvk::Nlp::Tree::getResultsForNode(const Nlp::Node *node)
     return results;
 }
 
-//--------------------------------------------------------------------------------------------------
-
-QString Lvk::Nlp::Tree::expandVars(const QString &output, bool *ok)
-{
-    // TODO a possible optimization is to have all outputs already splitted
-
-    QString newOutput;
-    QString varName;
-    QString varValue;
-    int offset = 0;
-    int i = 0;
-    bool recursive = false;
-
-    while (true) {
-        i = m_parser.parseVariable(output, &varName, &recursive, offset);
-        if (i != -1) {
-            varValue = m_searchCtx.stack().value(varName);
-
-            // if recursive variable
-            if (recursive) {
-                Nlp::Result result;
-                getResponse(varValue, result);
-
-                if (result.isValid()) {
-                    varValue = result.output;
-                } else {
-                    newOutput.clear();
-                    *ok = false;
-                    break;
-                }
-
-                i--;
-            }
-
-            newOutput += output.mid(offset, i - offset) + varValue;
-            offset =  i + varName.size() + (recursive ? 3 : 2);
-        } else {
-            newOutput += output.mid(offset);
-            *ok = true;
-            break;
-        }
-    }
-
-    return newOutput;
-}
-
-//--------------------------------------------------------------------------------------------------
-
-void Lvk::Nlp::Tree::parseRuleInput(const QString &input, Nlp::WordList &words)
-{
-    qDebug() << "Nlp::Tree: Parsing rule input" << input;
-
-    words.clear();
-
-    Nlp::GlobalTools::instance()->lemmatizer()->lemmatize(input, words);
-
-    parseExactMatch(words);
-    filterSymbols(words);
-    checkSyntax(words);
-
-    qDebug() << "Nlp::Tree: Parsed rule input" << words;
-}
-
-//--------------------------------------------------------------------------------------------------
-
-void Lvk::Nlp::Tree::parseUserInput(const QString &input, Nlp::WordList &words)
-{
-    qDebug() << "Nlp::Tree: Parsing user input" << input;
-
-    words.clear();
-
-    QString szInput = input;
-    szInput.remove('\'');
-    Nlp::GlobalTools::instance()->lemmatizer()->lemmatize(szInput, words);
-
-    filterSymbols(words);
-
-    qDebug() << "Nlp::Tree: Parsed user input" << words;
-}
-
-//--------------------------------------------------------------------------------------------------
-
-void Lvk::Nlp::Tree::filterSymbols(Nlp::WordList &words)
-{
-    for (int i = 0; i < words.size();) {
-        if (words[i].isSymbol()) {
-            words.removeAt(i);
-        } else {
-            ++i;
-        }
-    }
-}
-
-//--------------------------------------------------------------------------------------------------
-
-void Lvk::Nlp::Tree::checkSyntax(Nlp::WordList &/*words*/)
-{
-    // So far this method only checks for two or more consecutive star operators and only
-    // keeps one
-    //    bool isStar = false;
-    //    bool prevIsStar = false;
-    //
-    //    for (int i = 0; i < words.size();) {
-    //        isStar = words[i].isStar();
-    //        if (isStar && prevIsStar) {
-    //            words.removeAt(i);
-    //        } else {
-    //            ++i;
-    //        }
-    //        prevIsStar = isStar;
-    //    }
-}
-
-//--------------------------------------------------------------------------------------------------
-
-void Lvk::Nlp::Tree::parseExactMatch(Nlp::WordList &words)
-{
-    for (int i = 0; i < words.size(); ++i) {
-        QString &w = words[i].origWord;
-        if (w.size() >= 3 && w[0] == '\'' && w[w.size() - 1] == '\'') {
-            w = w.mid(1, w.size() - 2).toLower(); // TODO check if we want to normalize to lower
-            words[i].normWord = w;
-            words[i].lemma = "";
-            words[i].posTag = "";
-        }
-    }
-}
@@ -28,11 +28,10 @@
 #include <QList>
 #include <QSet>
 
-#include "nlp-engine/engine.h"
+#include "nlp-engine/matcher.h"
 #include "nlp-engine/word.h"
 #include "nlp-engine/result.h"
-#include "nlp-engine/parser.h"
-#include "nlp-engine/searchcontext.h"
+#include "nlp-engine/nodearena.h"
 
 namespace Lvk
 {
@@ -55,7 +54,7 @@ class ScoringAlgorithm;
 /**
  * \brief The Tree class provides tree to perform NLP searches
  */
-class Tree
+class Tree : public Matcher
 {
 public:
 
@@ -72,17 +71,17 @@ public:
     /**
      * Adds NLP \a rule to the tree
      */
-    void add(const Nlp::Rule &rule);
+    virtual void add(const Nlp::Rule &rule);
 
     /**
      * Gets the list of results for \a input
      */
-    void getResponses(const QString &input, Nlp::ResultList &results);
+    virtual void getResponses(const QString &input, Nlp::ResultList &results);
 
     /**
-     * Gets the results with the highest score for \a input
+     * \copydoc Matcher::memoryUsage()
      */
-    void getResponse(const QString &input, Nlp::Result &result);
+    virtual void memoryUsage(Nlp::MemoryUsage &usage) const;
 
 private:
     Tree(Tree&);
@@ -90,10 +89,9 @@ private:
 
     typedef QPair<int, Nlp::Node *> PairedNode; // pair (input idx, node)
 
+    Nlp::NodeArena m_arena;     // Must be declared before m_root
     Node *m_root;
     MatchPolicy *m_matchPolicy;
-    Nlp::Parser m_parser;
-    Nlp::SearchContext m_searchCtx;
     QSet< QPair<const Nlp::Node*, int> > m_loopDetector;
 
     Nlp::Node * addNode(const Nlp::Word &word, Nlp::Node *parent);
@@ -102,12 +100,6 @@ private:
                    int offset = 0);
     void handleEndWord(Nlp::ResultList &results, const Nlp::Node *node, int offset);
     Nlp::ResultList getResultsForNode(const Nlp::Node *node);
-    QString expandVars(const QString &output, bool *ok);
-    void parseRuleInput(const QString &input, Nlp::WordList &words);
-    void parseUserInput(const QString &input, Nlp::WordList &words);
-    void checkSyntax(Nlp::WordList &words);
-    void filterSymbols(Nlp::WordList &words);
-    void parseExactMatch(Nlp::WordList &words);
 };
 
 /// @}
@@ -0,0 +1,285 @@
+/*
+ * Copyright (C) 2012 Andres Pagliano, Gabriel Miretti, Gonzalo Buteler,
+ * Nestor Bustamante, Pablo Perez de Angelis
+ *
+ * This file is part of LVK Chatbot.
+ *
+ * LVK Chatbot is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LVK Chatbot is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LVK Chatbot.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef LVK_STATS_HASHSET64_H
+#define LVK_STATS_HASHSET64_H
+
+#include <QVector>
+#include <QDataStream>
+
+namespace Lvk
+{
+
+/// \addtogroup Lvk
+/// @{
+
+namespace Stats
+{
+
+/// \ingroup Lvk
+/// \addtogroup Stats
+/// @{
+
+/**
+ * \brief The HashSet64 class provides a compact set of 64-bit hashes.
+ *
+ * Keys are stored in a flat open-addressing table with linear probing. The table holds at
+ * most half of its capacity so lookups stay short. The zero key is reserved as the empty slot
+ * marker, hence it is tracked separately.
+ *
+ * The streaming format is the same as QSet<quint64>.
+ */
+class HashSet64
+{
+public:
+
+    /**
+     * Constructs an empty set
+     */
+    HashSet64()
+        : m_size(0), m_hasZero(false)
+    {
+    }
+
+    /**
+     * Returns the amount of keys in the set
+     */
+    int size() const
+    {
+        return m_size;
+    }
+
+    /**
+     * Returns true if the set has no keys. Otherwise; returns false.
+     */
+    bool isEmpty() const
+    {
+        return m_size == 0;
+    }
+
+    /**
+     * Returns true if the set contains \a key. Otherwise; returns false.
+     */
+    bool contains(quint64 key) const
+    {
+        if (key == 0) {
+            return m_hasZero;
+        }
+        if (m_table.isEmpty()) {
+            return false;
+        }
+
+        const quint64 *t = m_table.constData();
+        int mask = m_table.size() - 1;
+
+        for (int i = slot(key, mask); t[i] != 0; i = (i + 1) & mask) {
+            if (t[i] == key) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    /**
+     * Inserts \a key in the set. Returns true if the key was not already in the set.
+     */
+    bool insert(quint64 key)
+    {
+        if (key == 0) {
+            if (m_hasZero) {
+                return false;
+            }
+            m_hasZero = true;
+            ++m_size;
+            return true;
+        }
+
+        if ((m_size + 1)*2 > m_table.size()) {
+            rehash(m_table.isEmpty() ? MIN_CAPACITY : m_table.size()*2);
+        }
+
+        if (!insertKey(m_table.data(), m_table.size() - 1, key)) {
+            return false;
+        }
+
+        ++m_size;
+        return true;
+    }
+
+    /**
+     * Ensures the set can hold \a n keys without growing
+     */
+    void reserve(int n)
+    {
+        int capacity = MIN_CAPACITY;
+        while (capacity < n*2) {
+            capacity *= 2;
+        }
+        if (capacity > m_table.size()) {
+            rehash(capacity);
+        }
+    }
+
+    /**
+     * Inserts all keys of \a other in this set
+     */
+    HashSet64 &unite(const HashSet64 &other)
+    {
+        reserve(m_size + other.m_size);
+
+        if (other.m_hasZero) {
+            insert(0);
+        }
+        foreach (quint64 key, other.m_table) {
+            if (key != 0) {
+                insert(key);
+            }
+        }
+
+        return *this;
+    }
+
+    /**
+     * Returns the keys of the set in an arbitrary order
+     */
+    QVector<quint64> values() const
+    {
+        QVector<quint64> keys;
+        keys.reserve(m_size);
+
+        if (m_hasZero) {
+            keys.append(0);
+        }
+        foreach (quint64 key, m_table) {
+            if (key != 0) {
+                keys.append(key);
+            }
+        }
+
+        return keys;
+    }
+
+    /**
+     * Removes all keys and releases memory
+     */
+    void clear()
+    {
+        m_table.clear();
+        m_size = 0;
+        m_hasZero = false;
+    }
+
+    friend QDataStream &operator<<(QDataStream &stream, const HashSet64 &set);
+    friend QDataStream &operator>>(QDataStream &stream, HashSet64 &set);
+
+private:
+
+    static const int MIN_CAPACITY = 16;
+
+    QVector<quint64> m_table;
+    int m_size;
+    bool m_hasZero;
+
+    static int slot(quint64 key, int mask)
+    {
+        // Fold the high bits, FNV-1a low bits alone are poorly distributed
+        return static_cast<int>((key ^ (key >> 32) ^ (key >> 17)) & mask);
+    }
+
+    static bool insertKey(quint64 *t, int mask, quint64 key)
+    {
+        int i = slot(key, mask);
+        for (; t[i] != 0; i = (i + 1) & mask) {
+            if (t[i] == key) {
+                return false;
+            }
+        }
+        t[i] = key;
+        return true;
+    }
+
+    void rehash(int capacity)
+    {
+        QVector<quint64> table(capacity, 0);
+
+        foreach (quint64 key, m_table) {
+            if (key != 0) {
+                insertKey(table.data(), capacity - 1, key);
+            }
+        }
+
+        m_table = table;
+    }
+};
+
+/**
+ * Writes \a set to \a stream
+ */
+inline QDataStream &operator<<(QDataStream &stream, const HashSet64 &set)
+{
+    stream << static_cast<quint32>(set.m_size);
+
+    if (set.m_hasZero) {
+        stream << quint64(0);
+    }
+    foreach (quint64 key, set.m_table) {
+        if (key != 0) {
+            stream << key;
+        }
+    }
+
+    return stream;
+}
+
+/**
+ * Reads \a set from \a stream
+ */
+inline QDataStream &operator>>(QDataStream &stream, HashSet64 &set)
+{
+    set.clear();
+
+    quint32 n = 0;
+    stream >> n;
+
+    if (stream.status() == QDataStream::Ok) {
+        set.reserve(qMin(n, quint32(1 << 20))); // do not trust n blindly
+    }
+
+    for (quint32 i = 0; i < n && stream.status() == QDataStream::Ok; ++i) {
+        quint64 key;
+        stream >> key;
+        set.insert(key);
+    }
+
+    return stream;
+}
+
+/// @}
+
+} // namespace Stats
+
+/// @}
+
+} // namespace Lvk
+
+
+#endif // LVK_STATS_HASHSET64_H
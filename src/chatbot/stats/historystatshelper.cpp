@@ -20,8 +20,10 @@
  */
 
 #include "stats/historystatshelper.h"
+#include "common/hash.h"
 #include "common/globalstrings.h"
 
+#include <QDataStream>
 #include <QtDebug>
 
 //--------------------------------------------------------------------------------------------------
@@ -31,6 +33,9 @@
 static const unsigned MAX_INACTIVITY = 60*15; // Max period of inactivity allowed. In seconds.
 static const unsigned MIN_CONV_LEN = 20;      // Minimum conversation entries to score a contact
 
+static const quint32 AGGREGATES_MAGIC   = 0x48535441; // "HSTA"
+static const quint32 AGGREGATES_VERSION = 2;
+
 // Tracks chatbot conversations. If the conversation has at least MIN_CONV_LEN entries and
 // it was not interfered by the user, adds username to the score contacts set
 void Lvk::Stats::HistoryStatsHelper::trackConversation(const Lvk::Cmn::Conversation::Entry &entry)
@@ -45,6 +50,7 @@ void Lvk::Stats::HistoryStatsHelper::trackConversation(const Lvk::Cmn::Conversat
     }
 
     ConversationInfo &info = m_convTracker[user];
+    quint64 responseHash = Cmn::hash64(entry.response);
 
     // If inactivity period surpassed. i.e. new conversation
     if (entry.dateTime.toTime_t() - info.last.toTime_t() >= MAX_INACTIVITY) {
@@ -56,7 +62,7 @@ void Lvk::Stats::HistoryStatsHelper::trackConversation(const Lvk::Cmn::Conversat
     } else {
         if (interfered) {
             info.entries = 0;
-        } else if (!m_convDiffLines[user].contains(entry.response)) {
+        } else if (!m_convDiffLines[user].contains(responseHash)) {
             info.entries = info.entries + 1;
         }
         info.interfered |= interfered;
@@ -70,9 +76,9 @@ void Lvk::Stats::HistoryStatsHelper::trackConversation(const Lvk::Cmn::Conversat
             m_scoreContacts.insert(user);
         }
 
-        m_cbDiffLines.insert(entry.response);
-        m_convDiffLines[user].insert(entry.response);
-        updateLexicon(splitSentence(entry.response), m_cbLexicon);
+        m_cbDiffLines.insert(responseHash);
+        m_convDiffLines[user].insert(responseHash);
+        updateLexicon(entry.response, m_cbLexicon);
         ++m_cbLinesCount;
     }
 }
@@ -91,3 +97,106 @@ unsigned Lvk::Stats::HistoryStatsHelper::liveConvDiffLinesCount() const
     return count;
 }
 
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::Stats::HistoryStatsHelper::merge(const HistoryStatsHelper &other)
+{
+    StatsHelper::merge(other);
+
+    m_cbDiffLines.unite(other.m_cbDiffLines);
+    m_cbLexicon.unite(other.m_cbLexicon);
+    m_scoreContacts.unite(other.m_scoreContacts);
+    m_entriesCount += other.m_entriesCount;
+    m_cbLinesCount += other.m_cbLinesCount;
+    m_deadConvDiffLinesCount += other.m_deadConvDiffLinesCount;
+
+    ConversationTracker::const_iterator it;
+    for (it = other.m_convTracker.begin(); it != other.m_convTracker.end(); ++it) {
+        const QString &user = it.key();
+        const HashSet64 &otherLines = other.m_convDiffLines.value(user);
+
+        if (!m_convTracker.contains(user)) {
+            m_convTracker[user] = it.value();
+            m_convDiffLines[user] = otherLines;
+        } else if (m_convTracker[user].last < it.value().last) {
+            m_deadConvDiffLinesCount += m_convDiffLines[user].size();
+            m_convTracker[user] = it.value();
+            m_convDiffLines[user] = otherLines;
+        } else {
+            m_deadConvDiffLinesCount += otherLines.size();
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+QByteArray Lvk::Stats::HistoryStatsHelper::toByteArray() const
+{
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_4_7);
+
+    stream << AGGREGATES_MAGIC << AGGREGATES_VERSION;
+
+    StatsHelper::save(stream);
+
+    stream << m_entriesCount << m_cbLinesCount << m_deadConvDiffLinesCount;
+    stream << m_cbDiffLines << m_cbLexicon << m_scoreContacts;
+
+    stream << static_cast<quint32>(m_convTracker.size());
+
+    ConversationTracker::const_iterator it;
+    for (it = m_convTracker.begin(); it != m_convTracker.end(); ++it) {
+        stream << it.key() << static_cast<quint32>(it.value().last.toTime_t())
+               << it.value().entries << it.value().interfered
+               << m_convDiffLines.value(it.key());
+    }
+
+    return data;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool Lvk::Stats::HistoryStatsHelper::fromByteArray(const QByteArray &data)
+{
+    clear();
+
+    QDataStream stream(data);
+    stream.setVersion(QDataStream::Qt_4_7);
+
+    quint32 magic = 0;
+    quint32 version = 0;
+
+    stream >> magic >> version;
+
+    if (magic != AGGREGATES_MAGIC || version != AGGREGATES_VERSION) {
+        return false;
+    }
+
+    StatsHelper::load(stream);
+
+    stream >> m_entriesCount >> m_cbLinesCount >> m_deadConvDiffLinesCount;
+    stream >> m_cbDiffLines >> m_cbLexicon >> m_scoreContacts;
+
+    quint32 users = 0;
+    stream >> users;
+
+    for (quint32 i = 0; i < users && stream.status() == QDataStream::Ok; ++i) {
+        QString user;
+        quint32 last;
+        ConversationInfo info;
+
+        stream >> user >> last >> info.entries >> info.interfered >> m_convDiffLines[user];
+
+        info.last.setTime_t(last);
+        m_convTracker[user] = info;
+    }
+
+    if (stream.status() != QDataStream::Ok) {
+        clear();
+        return false;
+    }
+
+    return true;
+}
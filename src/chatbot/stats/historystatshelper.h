@@ -27,6 +27,7 @@
 #include "common/globalstrings.h"
 
 #include <QHash>
+#include <QByteArray>
 #include <functional>
 #include <algorithm>
 
@@ -46,6 +47,11 @@ namespace Stats
 /**
  * \brief The HistoryStatsHelper class provides chat history statistics such as total words,
  *        total lines and lexicon size.
+ *
+ * Statistics are updated incrementally with each new entry. Lines and words are stored as
+ * 64-bit hashes, so the aggregates can be persisted with toByteArray() and restored with
+ * fromByteArray() without scanning the history again. Aggregates of different histories can
+ * be combined with merge().
  */
 class HistoryStatsHelper : public StatsHelper
 {
@@ -55,7 +61,7 @@ public:
      * Constructs a emtpy HistoryStatsHelper
      */
     HistoryStatsHelper()
-        : m_cbLinesCount(0), m_deadConvDiffLinesCount(0)
+        : m_entriesCount(0), m_cbLinesCount(0), m_deadConvDiffLinesCount(0)
     {
     }
 
@@ -64,11 +70,19 @@ public:
      * \a conv.
      */
     HistoryStatsHelper(const Lvk::Cmn::Conversation &conv)
-        : m_cbLinesCount(0), m_deadConvDiffLinesCount(0)
+        : m_entriesCount(0), m_cbLinesCount(0), m_deadConvDiffLinesCount(0)
     {
         count(conv);
     }
 
+    /**
+     * Returns the total amount of history entries counted
+     */
+    unsigned entries() const
+    {
+        return m_entriesCount;
+    }
+
     /**
      * Returns the total amount of lines in history produced by the chatbot
      */
@@ -139,10 +153,29 @@ public:
         m_scoreContacts.clear();
         m_cbDiffLines.clear();
         m_cbLexicon.clear();
+        m_entriesCount = 0;
         m_cbLinesCount = 0;
         m_deadConvDiffLinesCount = 0;
     }
 
+    /**
+     * Adds the statistics of \a other to this object. Lexicon and line sets are merged exactly.
+     * If both objects track a conversation with the same user, the most recent one is kept
+     * alive and the other one is considered finished.
+     */
+    void merge(const HistoryStatsHelper &other);
+
+    /**
+     * Returns the aggregates serialized in a compact binary form
+     */
+    QByteArray toByteArray() const;
+
+    /**
+     * Restores the aggregates serialized with toByteArray(). Returns true on success. Otherwise;
+     * returns false and the object is cleared.
+     */
+    bool fromByteArray(const QByteArray &data);
+
 protected:
 
     /**
@@ -161,6 +194,8 @@ protected:
      */
     void count(const Lvk::Cmn::Conversation::Entry &entry)
     {
+        ++m_entriesCount;
+
         StatsHelper::count(entry.msg);
         StatsHelper::count(entry.response);
 
@@ -182,16 +217,17 @@ private:
 
     // username -> ConversationInfo
     typedef QHash<QString, ConversationInfo> ConversationTracker;
-    // username -> Conversation diff lines
-    typedef QHash<QString, QSet<QString> > ConversationDiffLines;
+    // username -> Conversation diff lines (hashed)
+    typedef QHash<QString, HashSet64> ConversationDiffLines;
 
     ConversationTracker m_convTracker;
     ConversationDiffLines m_convDiffLines;
     QSet<QString> m_scoreContacts;
 
     // chatbot stats
-    QSet<QString> m_cbDiffLines;
-    QSet<QString> m_cbLexicon;
+    HashSet64 m_cbDiffLines;
+    HashSet64 m_cbLexicon;
+    unsigned m_entriesCount;
     unsigned m_cbLinesCount;
     unsigned m_deadConvDiffLinesCount;
 
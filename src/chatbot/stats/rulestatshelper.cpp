@@ -0,0 +1,320 @@
+/*
+ * Copyright (C) 2012 Andres Pagliano, Gabriel Miretti, Gonzalo Buteler,
+ * Nestor Bustamante, Pablo Perez de Angelis
+ *
+ * This file is part of LVK Chatbot.
+ *
+ * LVK Chatbot is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LVK Chatbot is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LVK Chatbot.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "stats/rulestatshelper.h"
+#include "common/hash.h"
+
+#include <QSet>
+
+//--------------------------------------------------------------------------------------------------
+// Helpers
+//--------------------------------------------------------------------------------------------------
+
+namespace
+{
+
+inline quint64 mix(quint64 h, quint64 v)
+{
+    return (h ^ v) * Q_UINT64_C(1099511628211);
+}
+
+} // namespace
+
+
+//--------------------------------------------------------------------------------------------------
+// RuleStatsHelper
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::Stats::RuleStatsHelper::updateRule(const Lvk::BE::Rule *rule)
+{
+    if (!isCounted(rule)) {
+        removeRule(rule);
+        return;
+    }
+
+    RuleInfoHash::iterator it = m_ruleInfo.find(rule);
+
+    if (it != m_ruleInfo.end()) {
+        it->generation = m_generation;
+
+        if (it->revision == rule->revision()) {
+            return;
+        }
+
+        remove(*it);
+        m_ruleInfo.erase(it);
+    }
+
+    RuleInfo info = count(rule);
+    info.revision = rule->revision();
+    info.generation = m_generation;
+
+    add(info);
+    m_ruleInfo.insert(rule, info);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::Stats::RuleStatsHelper::removeRule(const Lvk::BE::Rule *rule)
+{
+    RuleInfoHash::iterator it = m_ruleInfo.find(rule);
+
+    if (it != m_ruleInfo.end()) {
+        remove(*it);
+        m_ruleInfo.erase(it);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::Stats::RuleStatsHelper::update(const Lvk::BE::Rule *root)
+{
+    if (!root) {
+        clear();
+        return;
+    }
+
+    ++m_generation;
+
+    QList<const Lvk::BE::Rule *> orphans;
+
+    if (isCounted(root)) {
+        updateRule(root);
+    }
+
+    visit(root, orphans);
+
+    // Former children that were not visited again were removed from the tree
+    foreach (const Lvk::BE::Rule *rule, orphans) {
+        removeOrphan(rule);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::Stats::RuleStatsHelper::visit(const Lvk::BE::Rule *node,
+                                        QList<const Lvk::BE::Rule *> &orphans)
+{
+    NodeInfoHash::iterator it = m_nodes.find(node);
+
+    // Any change in a subtree, including moving rules in or out, changes its revision
+    if (it != m_nodes.end() && it->subtreeRevision == node->subtreeRevision()) {
+        return;
+    }
+
+    QList<const Lvk::BE::Rule *> children;
+    foreach (const Lvk::BE::Rule *child, node->children()) {
+        children.append(child);
+    }
+
+    if (it != m_nodes.end()) {
+        QSet<const Lvk::BE::Rule *> current = children.toSet();
+        foreach (const Lvk::BE::Rule *child, it->children) {
+            if (!current.contains(child)) {
+                orphans.append(child);
+            }
+        }
+    }
+
+    foreach (const Lvk::BE::Rule *child, children) {
+        if (isCounted(child)) {
+            updateRule(child);
+        } else {
+            removeRule(child);
+        }
+
+        if (child->childCount() > 0) {
+            visit(child, orphans);
+        } else if (m_nodes.contains(child)) {
+            orphans.append(m_nodes.take(child).children);
+        }
+    }
+
+    NodeInfo &info = m_nodes[node];
+    info.subtreeRevision = node->subtreeRevision();
+    info.generation = m_generation;
+    info.children = children;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::Stats::RuleStatsHelper::removeOrphan(const Lvk::BE::Rule *rule)
+{
+    // Rules are not dereferenced since they can be already deleted. Rules moved to another
+    // parent were visited in this update.
+
+    RuleInfoHash::iterator it = m_ruleInfo.find(rule);
+    if (it != m_ruleInfo.end() && it->generation != m_generation) {
+        remove(*it);
+        m_ruleInfo.erase(it);
+    }
+
+    NodeInfoHash::iterator nit = m_nodes.find(rule);
+    if (nit != m_nodes.end() && nit->generation != m_generation) {
+        QList<const Lvk::BE::Rule *> children = nit->children;
+        m_nodes.erase(nit);
+
+        foreach (const Lvk::BE::Rule *child, children) {
+            removeOrphan(child);
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool Lvk::Stats::RuleStatsHelper::isCounted(const Lvk::BE::Rule *rule)
+{
+    return rule->isComplete() && rule->type() != Lvk::BE::Rule::ContainerRule;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+Lvk::Stats::RuleStatsHelper::RuleInfo
+Lvk::Stats::RuleStatsHelper::count(const Lvk::BE::Rule *rule)
+{
+    RuleInfo info;
+    HashSet64 lexicon;
+
+    foreach (const QString &input, rule->input()) {
+        info.words += updateLexicon(input, lexicon);
+    }
+    foreach (const QString &output, rule->output()) {
+        info.words += updateLexicon(output, lexicon);
+    }
+
+    info.lines = rule->input().size() + rule->output().size();
+    info.lexicon = lexicon.values();
+
+    // To calculate points Only using first non-empty output
+
+    QString output;
+    foreach (const QString &o, rule->output()) {
+        if (o.trimmed().size() > 0) {
+            output = o;
+            break;
+        }
+    }
+
+    if (!output.isEmpty()) {
+        quint64 outputHash = Cmn::hash64(output);
+        HashSet64 pairs;
+
+        foreach (const QString &input, rule->input()) {
+            if (input.isEmpty()) {
+                continue;
+            }
+
+            quint64 pair = mix(Cmn::hash64(input), outputHash);
+
+            // Classify new pairs only. Parsing is the expensive part.
+            if (pairs.insert(pair) && !m_pairs.contains(pair)) {
+                m_pairs[pair].kind = pairKind(input, output);
+            }
+        }
+
+        info.pairs = pairs.values();
+    }
+
+    return info;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::Stats::RuleStatsHelper::add(const RuleInfo &info)
+{
+    m_words += info.words;
+    m_lines += info.lines;
+
+    foreach (quint64 w, info.lexicon) {
+        ++m_lexicon[w];
+    }
+
+    foreach (quint64 p, info.pairs) {
+        PairInfo &pair = m_pairs[p];
+
+        if (pair.refs++ == 0) {
+            m_points += pair.kind;
+
+            switch (pair.kind) {
+            case RegexPair:       ++m_regexRules; break;
+            case VariablePair:    ++m_varRules;   break;
+            case ConditionalPair: ++m_condRules;  break;
+            default:                              break;
+            }
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::Stats::RuleStatsHelper::remove(const RuleInfo &info)
+{
+    m_words -= info.words;
+    m_lines -= info.lines;
+
+    foreach (quint64 w, info.lexicon) {
+        QHash<quint64, unsigned>::iterator it = m_lexicon.find(w);
+        if (it != m_lexicon.end() && --(*it) == 0) {
+            m_lexicon.erase(it);
+        }
+    }
+
+    foreach (quint64 p, info.pairs) {
+        QHash<quint64, PairInfo>::iterator it = m_pairs.find(p);
+        if (it == m_pairs.end() || --it->refs > 0) {
+            continue;
+        }
+
+        m_points -= it->kind;
+
+        switch (it->kind) {
+        case RegexPair:       --m_regexRules; break;
+        case VariablePair:    --m_varRules;   break;
+        case ConditionalPair: --m_condRules;  break;
+        default:                              break;
+        }
+
+        m_pairs.erase(it);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+// Returns the kind of the pair (input, output). See RuleStatsHelper::points()
+Lvk::Stats::RuleStatsHelper::PairKind
+Lvk::Stats::RuleStatsHelper::pairKind(const QString &input, const QString &output)
+{
+    if (input.isEmpty() || output.isEmpty()) {
+        return NoPoints;
+    } else if (m_parser.parseVariable(input) != -1) {
+        if (m_parser.parseIf(output) != -1) {
+            return ConditionalPair;
+        } else if (m_parser.parseVariable(output) != -1) {
+            return VariablePair;
+        } else {
+            return SimplePair;
+        }
+    } else if (input.contains(STAR_OP) || input.contains(PLUS_OP)) {
+        return RegexPair;
+    } else {
+        return SimplePair;
+    }
+}
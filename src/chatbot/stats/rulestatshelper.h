@@ -27,9 +27,9 @@
 #include "nlp-engine/parser.h"
 #include "nlp-engine/syntax.h"
 
-#include <QSet>
-#include <QPair>
-#include <memory>
+#include <QHash>
+#include <QList>
+#include <QVector>
 
 namespace Lvk
 {
@@ -47,6 +47,12 @@ namespace Stats
 /**
  * \brief The RuleStatsHelper class provides rule statistics such as total words,
  *        total rules, lexicon size and rule points.
+ *
+ * Statistics are maintained incrementally. The contribution of each rule (words, lexicon
+ * and input/output pairs) is recorded and shared words and pairs are reference counted, so
+ * adding, updating or removing a rule only recounts that rule. update() uses rule revisions
+ * to skip subtrees that did not change since the last update. See updateRule(), removeRule()
+ * and update().
  */
 class RuleStatsHelper : public StatsHelper
 {
@@ -56,7 +62,8 @@ public:
      * Constructs an emtpy RuleStatsHelper
      */
     RuleStatsHelper()
-        : m_rules(0), m_points(0), m_regexRules(0), m_varRules(0), m_condRules(0)
+        : m_words(0), m_lines(0), m_points(0), m_regexRules(0), m_varRules(0), m_condRules(0),
+          m_generation(0)
     {
     }
 
@@ -64,11 +71,10 @@ public:
      * Constructs a RuleStatsHelper and provides statistics for the given \a root rule.
      */
     RuleStatsHelper(const Lvk::BE::Rule *root)
-        : m_rules(0), m_points(0), m_regexRules(0), m_varRules(0), m_condRules(0)
+        : m_words(0), m_lines(0), m_points(0), m_regexRules(0), m_varRules(0), m_condRules(0),
+          m_generation(0)
     {
-        if (root) {
-            rcount(root);
-        }
+        update(root);
     }
 
     /**
@@ -76,7 +82,31 @@ public:
      */
     unsigned rulesCount() const
     {
-        return m_rules;
+        return m_ruleInfo.size();
+    }
+
+    /**
+     * Returns the total amount of input and output strings
+     */
+    unsigned lines() const
+    {
+        return m_lines;
+    }
+
+    /**
+     * Returns the total amount of words in inputs and outputs
+     */
+    unsigned words() const
+    {
+        return m_words;
+    }
+
+    /**
+     * Returns the lexicon size. i.e. the total amount of different words.
+     */
+    unsigned lexiconSize() const
+    {
+        return m_lexicon.size();
     }
 
     /**
@@ -119,15 +149,34 @@ public:
         return m_condRules;
     }
 
+    /**
+     * Updates stats with the given added or modified \a rule. Children are not visited.
+     * If the rule revision did not change since it was last counted, this is a no-op.
+     */
+    void updateRule(const Lvk::BE::Rule *rule);
+
+    /**
+     * Removes the given \a rule from stats. Only the rule address is used, hence \a rule
+     * can be already deleted.
+     */
+    void removeRule(const Lvk::BE::Rule *rule);
+
+    /**
+     * Updates stats with the current state of the tree given by \a root. Rules added, modified
+     * or removed since the last update are recounted. Subtrees whose revision did not change
+     * are not visited.
+     *
+     * \see BE::Rule::subtreeRevision()
+     */
+    void update(const Lvk::BE::Rule *root);
+
     /**
      * Resets stats with the given new \a root
      */
     void reset(const Lvk::BE::Rule *root)
     {
         clear();
-        if (root) {
-            rcount(root);
-        }
+        update(root);
     }
 
     /**
@@ -136,114 +185,86 @@ public:
     void clear()
     {
         StatsHelper::clear();
-        m_ioPairs.clear();
-        m_rules = 0;
+        m_ruleInfo.clear();
+        m_nodes.clear();
+        m_lexicon.clear();
+        m_pairs.clear();
+        m_words = 0;
+        m_lines = 0;
         m_points = 0;
         m_regexRules = 0;
         m_varRules = 0;
         m_condRules = 0;
     }
 
-protected:
+private:
+    RuleStatsHelper(RuleStatsHelper&);
+    RuleStatsHelper& operator=(RuleStatsHelper&);
 
-    /**
-     * Counts all words in the given rule \a rule and gets statistics. If the rule has children
-     * it counts recursively.
-     */
-    void rcount(const Lvk::BE::Rule *rule)
-    {
-        Lvk::BE::Rule::const_iterator it;
-        for (it = rule->begin(); it != rule->end(); ++it) {
-            const Lvk::BE::Rule *rule = *it;
-            if (rule->isComplete() && rule->type() != Lvk::BE::Rule::ContainerRule) {
-                count(rule);
-                m_rules++;
-                m_points += points(rule);
-            }
-        }
-    }
+    // Points of an input/output pair. See points()
+    enum PairKind {
+        NoPoints        = 0,
+        SimplePair      = 1,
+        RegexPair       = 2,
+        VariablePair    = 3,
+        ConditionalPair = 4
+    };
 
-    /**
-     * Counts all words in the given rule \a rule and gets statistics
-     */
-    void count(const Lvk::BE::Rule *rule)
+    struct PairInfo
     {
-       StatsHelper::count(rule->input());
-       StatsHelper::count(rule->output());
-    }
+        PairInfo() : refs(0), kind(NoPoints) { }
 
-    /**
-     * Returns the points of the given \a rule
-     */
-    unsigned points(const Lvk::BE::Rule *rule)
-    {
-        unsigned p = 0;
-
-        // To calculate points Only using first non-empty output
-
-        QString output;
-        foreach (const QString &o, rule->output()) {
-            if (o.trimmed().size() > 0) {
-                output = o;
-                break;
-            }
-        }
-        foreach (const QString &input, rule->input()) {
-            // Count only unique pairs (input, output)
-            IOPair pair(input, output);
-            if (!m_ioPairs.contains(pair)) {
-                m_ioPairs.insert(pair);
-                p += points(input, output);
-            }
-        }
-
-        return p;
-    }
+        unsigned refs;
+        PairKind kind;
+    };
 
-    /**
-     * Returns the points of the pair \a (input, output).
-     * <ul>
-     *   <li>1 point simple rules</li>
-     *   <li>2 points rules with operators</li>
-     *   <li>3 points rules with variables</li>
-     *   <li>4 points rules with conditionals</li>
-     * </ul>
-     */
-    unsigned points(const QString &input, const QString &output)
+    // Contribution of a single rule
+    struct RuleInfo
     {
-        if (input.isEmpty() || output.isEmpty()) {
-            return 0;
-        } else if (m_parser.parseVariable(input) != -1) {
-            if (m_parser.parseIf(output) != -1) {
-                ++m_condRules;
-                return 4;
-            } else if (m_parser.parseVariable(output) != -1) {
-                ++m_varRules;
-                return 3;
-            } else {
-                return 1;
-            }
-        } else if (input.contains(STAR_OP) || input.contains(PLUS_OP)) {
-            ++m_regexRules;
-            return 2;
-        } else {
-            return 1;
-        }
-    }
+        RuleInfo() : revision(0), words(0), lines(0), generation(0) { }
+
+        quint64 revision;
+        unsigned words;
+        unsigned lines;
+        unsigned generation;
+        QVector<quint64> lexicon;   // Different words (hashed)
+        QVector<quint64> pairs;     // Different input/output pairs (hashed)
+    };
+
+    // Rule with children as seen in the last update
+    struct NodeInfo
+    {
+        NodeInfo() : subtreeRevision(0), generation(0) { }
 
-private:
-    RuleStatsHelper(RuleStatsHelper&);
-    RuleStatsHelper& operator=(RuleStatsHelper&);
+        quint64 subtreeRevision;
+        unsigned generation;
+        QList<const Lvk::BE::Rule *> children;
+    };
+
+    typedef QHash<const Lvk::BE::Rule *, RuleInfo> RuleInfoHash;
+    typedef QHash<const Lvk::BE::Rule *, NodeInfo> NodeInfoHash;
 
-    typedef QPair<QString, QString> IOPair;
-    QSet<IOPair> m_ioPairs;
+    RuleInfoHash m_ruleInfo;
+    NodeInfoHash m_nodes;
+    QHash<quint64, unsigned> m_lexicon;     // word hash -> #rules
+    QHash<quint64, PairInfo> m_pairs;       // pair hash -> #rules and kind
 
-    unsigned m_rules;
+    unsigned m_words;
+    unsigned m_lines;
     unsigned m_points;
     unsigned m_regexRules;
     unsigned m_varRules;
     unsigned m_condRules;
+    unsigned m_generation;
     Nlp::Parser m_parser;
+
+    static bool isCounted(const Lvk::BE::Rule *rule);
+    void visit(const Lvk::BE::Rule *node, QList<const Lvk::BE::Rule *> &orphans);
+    void removeOrphan(const Lvk::BE::Rule *rule);
+    RuleInfo count(const Lvk::BE::Rule *rule);
+    void add(const RuleInfo &info);
+    void remove(const RuleInfo &info);
+    PairKind pairKind(const QString &input, const QString &output);
 };
 
 /// @}
@@ -35,7 +35,7 @@
 #include <cassert>
 
 #define STAT_MAGIC_NUMBER            (('s'<<0) | ('t'<<8) | ('a'<<16) | ('t'<<24))
-#define STAT_FILE_FORMAT_VERSION     1
+#define STAT_FILE_FORMAT_VERSION     2
 
 
 enum
@@ -91,6 +91,7 @@ void Lvk::Stats::SecureStatsFile::newInterval()
 
     ++m_curInterv;
     m_history.clear();
+    m_historyStats.clear();
     m_scoreStart = QDateTime::currentDateTime();
     m_elapsedTime = 0;
 }
@@ -239,6 +240,7 @@ void Lvk::Stats::SecureStatsFile::close()
     m_elapsedTime = 0;
     m_contacts.clear();
     m_history.clear();
+    m_historyStats.clear();
 }
 
 
@@ -265,6 +267,7 @@ void Lvk::Stats::SecureStatsFile::clear()
     m_elapsedTime = 0;
     m_contacts.clear();
     m_history.clear();
+    m_historyStats.clear();
 
     if (m_filename.size() > 0) {
         QFile::remove(m_filename);
@@ -281,6 +284,7 @@ bool Lvk::Stats::SecureStatsFile::isEmpty() const
             m_curInterv == 1 &&
             m_contacts.isEmpty() &&
             m_history.isEmpty() &&
+            m_historyStats.isEmpty() &&
             m_curScore.isNull() &&
             m_bestScore.isNull() &&
             m_scoreStart.isNull() &&
@@ -303,6 +307,7 @@ inline void Lvk::Stats::SecureStatsFile::serialize(QByteArray &data)
     ostream << m_elapsedTime;
     ostream << m_contacts;
     ostream << m_history;
+    ostream << m_historyStats;
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -336,6 +341,12 @@ inline bool Lvk::Stats::SecureStatsFile::deserialize(const QByteArray &data)
     istream >> m_contacts;
     istream >> m_history;
 
+    // Version 1 files do not have history aggregates
+    m_historyStats.clear();
+    if (version >= 2) {
+        istream >> m_historyStats;
+    }
+
     if (istream.status() != QDataStream::Ok) {
         qCritical("SecureStatsFile: Cannot read stat file: Invalid file format");
         return false;
@@ -494,3 +505,21 @@ void Lvk::Stats::SecureStatsFile::appendChatEntry(const Cmn::Conversation::Entry
 
     m_history.append(entry);
 }
+
+//--------------------------------------------------------------------------------------------------
+
+QByteArray Lvk::Stats::SecureStatsFile::historyStats() const
+{
+    QMutexLocker locker(m_mutex);
+
+    return m_historyStats;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::Stats::SecureStatsFile::setHistoryStats(const QByteArray &data)
+{
+    QMutexLocker locker(m_mutex);
+
+    m_historyStats = data;
+}
@@ -149,6 +149,16 @@ public:
      */
     virtual void appendChatEntry(const Cmn::Conversation::Entry &entry);
 
+    /**
+     * \copydoc StatsFile::historyStats()
+     */
+    virtual QByteArray historyStats() const;
+
+    /**
+     * \copydoc StatsFile::setHistoryStats()
+     */
+    virtual void setHistoryStats(const QByteArray &data);
+
     /**
      * \copydoc StatsFile::load()
      */
@@ -195,6 +205,7 @@ private:
     int m_elapsedTime;
     QSet<QString> m_contacts;
     Cmn::Conversation m_history;
+    QByteArray m_historyStats;
 
     inline void serialize(QByteArray &data);
     inline bool deserialize(const QByteArray &data);
@@ -15,9 +15,11 @@ HEADERS += \
     $$PROJECT_PATH/stats/rulestatshelper.h \
     $$PROJECT_PATH/stats/historystatshelper.h \
     $$PROJECT_PATH/stats/statshelper.h \
+    $$PROJECT_PATH/stats/hashset64.h \
 
 SOURCES += \
     $$PROJECT_PATH/stats/statsmanager.cpp \
     $$PROJECT_PATH/stats/history.cpp \
     $$PROJECT_PATH/stats/securestatsfile.cpp \
     $$PROJECT_PATH/stats/historystatshelper.cpp \
+    $$PROJECT_PATH/stats/rulestatshelper.cpp \
@@ -30,6 +30,7 @@
 #include <QSet>
 #include <QString>
 #include <QDateTime>
+#include <QByteArray>
 
 namespace Lvk
 {
@@ -141,6 +142,18 @@ public:
      */
     virtual void appendChatEntry(const Cmn::Conversation::Entry &entry) = 0;
 
+    /**
+     * Returns the serialized chat history aggregates for the current interval. Returns an empty
+     * array if the aggregates were never set.
+     */
+    virtual QByteArray historyStats() const = 0;
+
+    /**
+     * Sets the serialized chat history aggregates \a data for the current interval.
+     * This information is cleared on new intervals.
+     */
+    virtual void setHistoryStats(const QByteArray &data) = 0;
+
     /**
      * Loads statistics from \a filename
      */
@@ -23,9 +23,12 @@
 #define LVK_STATS_STATSHELPER_H
 
 #include "nlp-engine/defaultsanitizer.h" // TODO use factories
+#include "stats/hashset64.h"
+#include "common/hash.h"
 
 #include <QSet>
 #include <QStringList>
+#include <QDataStream>
 
 namespace Lvk
 {
@@ -46,6 +49,9 @@ namespace Stats
  *
  * Given a string or a list of strings. the StatsHelper class counts total words, different words
  * (i.e. lexicon size) and lines. Words are sanitized.
+ *
+ * Strings are tokenized in place and the lexicon only stores 64-bit hashes of the sanitized
+ * words, so counting does not allocate per word.
  */
 class StatsHelper
 {
@@ -130,6 +136,32 @@ public:
         m_lexicon.clear();
     }
 
+    /**
+     * Adds the statistics of \a other to this object
+     */
+    void merge(const StatsHelper &other)
+    {
+        m_lines += other.m_lines;
+        m_words += other.m_words;
+        m_lexicon.unite(other.m_lexicon);
+    }
+
+    /**
+     * Writes the statistics to \a stream
+     */
+    void save(QDataStream &stream) const
+    {
+        stream << m_lexicon << m_words << m_lines;
+    }
+
+    /**
+     * Reads the statistics from \a stream
+     */
+    void load(QDataStream &stream)
+    {
+        stream >> m_lexicon >> m_words >> m_lines;
+    }
+
 protected:
 
     /**
@@ -147,37 +179,73 @@ protected:
      */
     void count(const QString &s)
     {
-        QStringList words = splitSentence(s);
-
         m_lines += 1;
-        m_words += words.size();
-        updateLexicon(words, m_lexicon);
+        m_words += updateLexicon(s, m_lexicon);
     }
 
     /**
-     * Splits sentence \a s and returns the list of words
+     * Splits sentence \a s on whitespace and updates \a lexicon with each word. Each word is
+     * sanitized and lowercased before hashing. Returns the amount of words.
+     *
+     * The amount of words is the same as <tt>s.split(QRegExp("\\s+")).size()</tt>, i.e. leading
+     * or trailing whitespace counts as an empty word. Empty words are not added to the lexicon.
      */
-    QStringList splitSentence(const QString &s) const
+    unsigned updateLexicon(const QString &s, HashSet64 &lexicon) const
     {
-        return s.split(QRegExp("\\s+"));
+        const QChar *p = s.constData();
+        const int n = s.size();
+
+        unsigned words = 1;
+        int i = 0;
+
+        while (i < n) {
+            int start = i;
+            while (i < n && !p[i].isSpace()) {
+                ++i;
+            }
+            if (i > start) {
+                updateLexicon(p + start, i - start, lexicon);
+            }
+            if (i < n) {
+                while (i < n && p[i].isSpace()) {
+                    ++i;
+                }
+                ++words;
+            }
+        }
+
+        return words;
     }
 
-    /**
-     * Updates \a lexicon with the given list of words \a words. Each word is sanitized before
-     * inserting.
-     */
-    void updateLexicon(const QStringList &words, QSet<QString> &lexicon) const
+private:
+    // Updates lexicon with the word of length n pointed by w
+    void updateLexicon(const QChar *w, int n, HashSet64 &lexicon) const
     {
-        foreach (const QString &w, words) {
-            QString szw = m_sanitizer.sanitize(w).toLower();
+        if (isSanitized(w, n)) {
+            lexicon.insert(Cmn::hash64(w, n, true));
+        } else {
+            QString szw = m_sanitizer.sanitize(QString::fromRawData(w, n));
             if (!szw.isEmpty()) {
-                lexicon.insert(szw);
+                lexicon.insert(Cmn::hash64(szw.constData(), szw.size(), true));
             }
         }
     }
 
-private:
-    QSet<QString> m_lexicon;
+    // Returns true if the DefaultSanitizer would leave the word unchanged. This is the case
+    // for ASCII letters and digits without repeated letters, which covers most words.
+    static bool isSanitized(const QChar *w, int n)
+    {
+        for (int i = 0; i < n; ++i) {
+            ushort c = w[i].unicode();
+            bool alnum = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9');
+            if (!alnum || (i > 0 && c > '9' && (c | 0x20) == (w[i-1].unicode() | 0x20))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    HashSet64 m_lexicon;
     unsigned m_words;
     unsigned m_lines;
     Lvk::Nlp::DefaultSanitizer m_sanitizer;
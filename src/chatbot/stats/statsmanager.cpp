@@ -21,6 +21,7 @@
 
 #include "stats/statsmanager.h"
 #include "stats/securestatsfile.h"
+#include "common/tracer.h"
 
 #include <QMutex>
 #include <QMutexLocker>
@@ -77,7 +78,7 @@ void Lvk::Stats::StatsManager::setFilename(const QString &filename)
 
     if (!m_statsFile->filename().isEmpty()) {
         if (!m_statsFile->isEmpty()) {
-            m_statsFile->save();
+            saveStatsFile();
         }
         m_statsFile->close();
         m_elapsedTime = 0;
@@ -89,16 +90,42 @@ void Lvk::Stats::StatsManager::setFilename(const QString &filename)
         m_statsFile->load(filename);
         m_elapsedTime = m_statsFile->scoreElapsedTime();
 
-        Cmn::Conversation h;
-        m_statsFile->chatHistory(h);
+        loadHistoryStats();
+        m_ruleStats.clear(); // FIXME init
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Lvk::Stats::StatsManager::loadHistoryStats()
+{
+    TRACE_SPAN("stats.loadHistoryStats");
+
+    Cmn::Conversation h;
+    m_statsFile->chatHistory(h);
+
+    // Use the persisted aggregates if they are up to date with the history. Otherwise, for
+    // instance with files saved by older versions, rebuild them once.
+    if (!m_histStats.fromByteArray(m_statsFile->historyStats()) ||
+            m_histStats.entries() != static_cast<unsigned>(h.size())) {
+        qDebug() << "StatsManager: Rebuilding history stats";
 
         m_histStats = Stats::HistoryStatsHelper(h);
-        m_ruleStats.clear(); // FIXME init
     }
 }
 
 //--------------------------------------------------------------------------------------------------
 
+void Lvk::Stats::StatsManager::saveStatsFile()
+{
+    QMutexLocker locker(m_scoreMutex);
+
+    m_statsFile->setHistoryStats(m_histStats.toByteArray());
+    m_statsFile->save();
+}
+
+//--------------------------------------------------------------------------------------------------
+
 void Lvk::Stats::StatsManager::setMetric(Stats::Metric m, const QVariant &value)
 {
     return m_statsFile->setMetric(m, value);
@@ -193,7 +220,7 @@ void Lvk::Stats::StatsManager::updateBestScore()
         best = current;
 
         m_statsFile->setBestScore(best);
-        m_statsFile->save();
+        saveStatsFile();
     }
 }
 
@@ -245,7 +272,7 @@ void Lvk::Stats::StatsManager::onScoreTick()
 
     // Save every minute
     if (m_elapsedTime % 60 == 0) {
-        m_statsFile->save();
+        saveStatsFile();
     }
 
     emit scoreRemainingTime(scoreRemainingTime());
@@ -262,15 +289,19 @@ int Lvk::Stats::StatsManager::scoreRemainingTime() const
 
 void Lvk::Stats::StatsManager::updateScoreWith(const BE::Rule *root)
 {
+    TRACE_SPAN("stats.updateScoreWithRules");
+
     QMutexLocker locker(m_scoreMutex);
 
-    m_ruleStats.reset(root);
+    m_ruleStats.update(root);
 }
 
 //--------------------------------------------------------------------------------------------------
 
 void Lvk::Stats::StatsManager::updateScoreWith(const Cmn::Conversation::Entry &entry)
 {
+    TRACE_SPAN("stats.updateScoreWith");
+
     QMutexLocker locker(m_scoreMutex);
 
     int size = m_histStats.scoreContacts().size();
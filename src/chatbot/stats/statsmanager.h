@@ -152,7 +152,8 @@ public slots:
     void updateScoreWith(const Cmn::Conversation::Entry &entry);
 
     /**
-     * Updates the current score with a new \a root rule
+     * Updates the current score with a new \a root rule. Only rules added, modified or removed
+     * since the last call are recounted.
      */
     void updateScoreWith(const BE::Rule *root);
 
@@ -183,6 +184,8 @@ private:
 
     void updateBestScore();
     void setRuleMetrics();
+    void loadHistoryStats();
+    void saveStatsFile();
 
 private slots:
     void onScoreTick();
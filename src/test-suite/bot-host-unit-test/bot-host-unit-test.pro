@@ -0,0 +1,37 @@
+#-------------------------------------------------
+#
+# BotHost and HostedBot unit tests. Bots try to connect to their chat servers, connection
+# errors do not affect the tests.
+#
+#-------------------------------------------------
+
+QT       += testlib
+
+TARGET = botHostUnitTest
+CONFIG   += console qxmpp
+CONFIG   -= app_bundle
+
+TEMPLATE = app
+
+INCLUDEPATH += \
+    ../../chatbot \
+
+HEADERS += \
+    ../../chatbot/main/bothost.h \
+
+SOURCES += \
+    bothosttest.cpp \
+    ../../chatbot/main/bothost.cpp \
+
+PROJECT_PATH = ../../chatbot
+
+include($$PROJECT_PATH/common/common.pri)
+include($$PROJECT_PATH/nlp-engine/nlp-engine.pri)
+include($$PROJECT_PATH/back-end/back-end.pri)
+include($$PROJECT_PATH/chat-adapter/chat-adapter.pri)
+include($$PROJECT_PATH/crypto/crypto.pri)
+include($$PROJECT_PATH/stats/stats.pri)
+include($$PROJECT_PATH/da-server/da-server.pri)
+include($$PROJECT_PATH/3rd-party.pri)
+
+DEFINES += SRCDIR=\\\"$$PWD/\\\"
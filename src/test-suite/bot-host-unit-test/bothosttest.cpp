@@ -0,0 +1,198 @@
+#include <QtCore/QString>
+#include <QtTest/QtTest>
+
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QTime>
+
+#include "main/bothost.h"
+#include "back-end/hostedbot.h"
+#include "back-end/chatbotrulesfile.h"
+#include "back-end/rule.h"
+#include "nlp-engine/engine.h"
+#include "common/globalstrings.h"
+
+#define HOST_FILENAME       "test_host.ini"
+#define RULES_A_FILENAME    "test_bot_a.crf"
+#define RULES_B_FILENAME    "test_bot_b.crf"
+#define RULES_C_FILENAME    "test_bot_c.crf"
+#define RELOAD_TIMEOUT      10*1000
+
+using namespace Lvk;
+
+//--------------------------------------------------------------------------------------------------
+// Helpers
+//--------------------------------------------------------------------------------------------------
+
+namespace
+{
+
+// Writes a rules file that answers "Hi" with \a output
+bool writeRules(const QString &filename, const QString &output)
+{
+    BE::ChatbotRulesFile file;
+
+    BE::Rule *cat = new BE::Rule("Greetings", BE::Rule::ContainerRule);
+    file.rootRule()->appendChild(cat);
+    cat->appendChild(new BE::Rule("", BE::Rule::OrdinaryRule, QStringList() << "Hi",
+                                  QStringList() << output));
+
+    return file.saveAs(filename);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+// Changes the output of the rule written by writeRules()
+bool editRules(const QString &filename, const QString &output)
+{
+    BE::ChatbotRulesFile file;
+
+    if (!file.load(filename)) {
+        return false;
+    }
+
+    file.rootRule()->child(0)->child(0)->setOutput(QStringList() << output);
+
+    return file.save();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool writeHost(const QStringList &bots)
+{
+    QFile file(HOST_FILENAME);
+
+    if (!file.open(QFile::WriteOnly | QFile::Truncate)) {
+        return false;
+    }
+
+    foreach (const QString &bot, bots) {
+        QString group = "[" + bot + "]\nfile=test_bot_" + bot + ".crf\npassword=secret\n\n";
+        file.write(group.toUtf8());
+    }
+
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+QString response(BotHost &host, const QString &name)
+{
+    BE::HostedBot *bot = host.bot(name);
+    Nlp::Engine::MatchList matches;
+
+    return bot ? bot->nlpEngine()->getResponse("Hi", matches) : QString();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+QStringList sorted(QStringList list)
+{
+    list.sort();
+    return list;
+}
+
+} // namespace
+
+
+//--------------------------------------------------------------------------------------------------
+// BotHostTest
+//--------------------------------------------------------------------------------------------------
+
+class BotHostTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    BotHostTest();
+
+private Q_SLOTS:
+    void testLoadAndReload();
+    void cleanupTestCase();
+};
+
+//--------------------------------------------------------------------------------------------------
+
+BotHostTest::BotHostTest()
+{
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void BotHostTest::testLoadAndReload()
+{
+    QVERIFY(writeRules(RULES_A_FILENAME, "A"));
+    QVERIFY(writeRules(RULES_B_FILENAME, "B"));
+    QVERIFY(writeRules(RULES_C_FILENAME, "C"));
+    QVERIFY(writeHost(QStringList() << "a" << "b"));
+
+    BotHost host(HOST_FILENAME);
+
+    QVERIFY(host.start());
+    QCOMPARE(sorted(host.botNames()), QStringList() << "a" << "b");
+    QCOMPARE(response(host, "a"), QString("A"));
+    QCOMPARE(response(host, "b"), QString("B"));
+
+    BE::HostedBot *botB = host.bot("b");
+
+    // Remove a bot and add another one. Bots whose settings did not change keep running.
+
+    QVERIFY(writeHost(QStringList() << "b" << "c"));
+
+    QTime timer;
+    timer.start();
+
+    while (host.bot("c") == 0 && timer.elapsed() < RELOAD_TIMEOUT) {
+        QTest::qWait(100);
+    }
+
+    QCOMPARE(sorted(host.botNames()), QStringList() << "b" << "c");
+    QVERIFY(host.bot("b") == botB);
+    QCOMPARE(response(host, "c"), QString("C"));
+
+    // Change the rules of a bot, it reloads them without restarting
+
+    QVERIFY(editRules(RULES_B_FILENAME, "B changed"));
+
+    timer.restart();
+
+    while (response(host, "b") == "B" && timer.elapsed() < RELOAD_TIMEOUT) {
+        QTest::qWait(100);
+    }
+
+    QCOMPARE(response(host, "b"), QString("B changed"));
+    QVERIFY(host.bot("b") == botB);
+    QVERIFY(!botB->isOutdated());
+
+    // A file that cannot be loaded keeps the current rules
+
+    QVERIFY(!botB->load("missing_file.crf"));
+    QCOMPARE(response(host, "b"), QString("B changed"));
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void BotHostTest::cleanupTestCase()
+{
+    QFile::remove(HOST_FILENAME);
+
+    foreach (const QString &filename, QStringList() << RULES_A_FILENAME << RULES_B_FILENAME
+                                                    << RULES_C_FILENAME) {
+        QFile::remove(filename);
+        QFile::remove(BE::ChatbotRulesFile::journalFilename(filename));
+
+        // Created by the bots for their chat history
+        QDir extras(QFileInfo(filename).baseName() + EXTRAS_DIR_SUFFIX);
+        foreach (const QString &name, extras.entryList(QDir::Files)) {
+            extras.remove(name);
+        }
+        QDir().rmdir(extras.path());
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+QTEST_MAIN(BotHostTest)
+
+#include "bothosttest.moc"
@@ -0,0 +1,181 @@
+/*
+ * Copyright (C) 2012 Andres Pagliano, Gabriel Miretti, Gonzalo Buteler,
+ * Nestor Bustamante, Pablo Perez de Angelis
+ *
+ * This file is part of LVK Chatbot.
+ *
+ * LVK Chatbot is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LVK Chatbot is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LVK Chatbot.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "benchutils.h"
+
+#include <new>
+#include <cstdlib>
+
+#ifdef Q_OS_UNIX
+# include <sys/resource.h>
+#endif
+
+#if defined(Q_OS_LINUX) && defined(__GLIBC__)
+# define COUNT_MALLOC
+#endif
+
+//--------------------------------------------------------------------------------------------------
+// Allocation hooks
+//--------------------------------------------------------------------------------------------------
+
+namespace
+{
+
+qint64 g_allocs = 0;
+qint64 g_allocBytes = 0;
+
+inline void countAlloc(size_t size)
+{
+    ++g_allocs;
+    g_allocBytes += size;
+}
+
+} // namespace
+
+#ifdef COUNT_MALLOC
+
+// glibc exports its allocator with the __libc_ prefix, so we can interpose malloc() and
+// friends and count the allocations made by Qt containers too. Operator new uses malloc().
+
+extern "C"
+{
+
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t n, size_t size);
+void *__libc_realloc(void *p, size_t size);
+void __libc_free(void *p);
+
+void *malloc(size_t size) __THROW
+{
+    countAlloc(size);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t n, size_t size) __THROW
+{
+    countAlloc(n*size);
+    return __libc_calloc(n, size);
+}
+
+void *realloc(void *p, size_t size) __THROW
+{
+    countAlloc(size);
+    return __libc_realloc(p, size);
+}
+
+void free(void *p) __THROW
+{
+    __libc_free(p);
+}
+
+} // extern "C"
+
+#else
+
+void *operator new(size_t size) throw(std::bad_alloc)
+{
+    countAlloc(size);
+
+    void *p = std::malloc(size ? size : 1);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void *p) throw()
+{
+    std::free(p);
+}
+
+#endif // COUNT_MALLOC
+
+//--------------------------------------------------------------------------------------------------
+// BenchTimer
+//--------------------------------------------------------------------------------------------------
+
+BenchTimer::BenchTimer()
+{
+    m_timer.start();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void BenchTimer::start()
+{
+    m_timer.start();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+qint64 BenchTimer::nsecsElapsed() const
+{
+#if QT_VERSION >= 0x040800
+    return m_timer.nsecsElapsed();
+#else
+    return m_timer.elapsed()*Q_INT64_C(1000000);
+#endif
+}
+
+//--------------------------------------------------------------------------------------------------
+// AllocCounter
+//--------------------------------------------------------------------------------------------------
+
+qint64 AllocCounter::allocations()
+{
+    return g_allocs;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+qint64 AllocCounter::bytes()
+{
+    return g_allocBytes;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool AllocCounter::countsMalloc()
+{
+#ifdef COUNT_MALLOC
+    return true;
+#else
+    return false;
+#endif
+}
+
+//--------------------------------------------------------------------------------------------------
+// Peak RSS
+//--------------------------------------------------------------------------------------------------
+
+qint64 peakRss()
+{
+#if defined(Q_OS_MAC)
+    struct rusage usage;
+    return getrusage(RUSAGE_SELF, &usage) == 0 ? usage.ru_maxrss/1024 : -1;
+#elif defined(Q_OS_UNIX)
+    struct rusage usage;
+    return getrusage(RUSAGE_SELF, &usage) == 0 ? usage.ru_maxrss : -1;
+#else
+    return -1;
+#endif
+}
+
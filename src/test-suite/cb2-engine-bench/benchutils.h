@@ -0,0 +1,50 @@
+#ifndef BENCHUTILS_H
+#define BENCHUTILS_H
+
+#include <QElapsedTimer>
+#include <QtGlobal>
+
+/**
+ * \brief The BenchTimer class provides a monotonic timer with nanoseconds resolution when
+ *        available.
+ */
+class BenchTimer
+{
+public:
+    BenchTimer();
+
+    void start();
+
+    qint64 nsecsElapsed() const;
+
+private:
+    QElapsedTimer m_timer;
+};
+
+
+/**
+ * \brief The AllocCounter class counts heap allocations made by the current process.
+ *
+ * On Linux with glibc all malloc() calls are counted, including the ones made by Qt
+ * containers. Otherwise only operator new is counted.
+ */
+class AllocCounter
+{
+public:
+    static qint64 allocations();
+
+    static qint64 bytes();
+
+    /**
+     * Returns true if allocations made with malloc() are also counted
+     */
+    static bool countsMalloc();
+};
+
+
+/**
+ * Returns the peak resident set size of the process in KiB or -1 if not available
+ */
+qint64 peakRss();
+
+#endif // BENCHUTILS_H
@@ -0,0 +1,353 @@
+/*
+ * Copyright (C) 2012 Andres Pagliano, Gabriel Miretti, Gonzalo Buteler,
+ * Nestor Bustamante, Pablo Perez de Angelis
+ *
+ * This file is part of LVK Chatbot.
+ *
+ * LVK Chatbot is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LVK Chatbot is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LVK Chatbot.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <QCoreApplication>
+#include <QStringList>
+#include <QFile>
+#include <QTextStream>
+#include <QDebug>
+#include <iostream>
+#include <cstdlib>
+
+#include "nlp-engine/cb2engine.h"
+#include "nlp-engine/shiftandengine.h"
+#include "nlp-engine/nulllemmatizer.h"
+#include "nlp-engine/sanitizerfactory.h"
+#include "nlp-engine/memoryusage.h"
+#include "common/latencyhistogram.h"
+
+#ifdef FREELING_SUPPORT
+# include "nlp-engine/freelinglemmatizer.h"
+#endif
+
+#include "rulegenerator.h"
+#include "benchutils.h"
+
+#define DEFAULT_RULES       1000
+#define DEFAULT_MESSAGES    10000
+#define DEFAULT_TARGETS     50
+#define DEFAULT_SEED        12345
+
+struct BenchOptions
+{
+    bool valid;
+    int rules;
+    int messages;
+    int targets;
+    quint32 seed;
+    QList<RuleGenerator::Shape> shapes;
+    QStringList lemmatizers;
+    QString engine;
+    QString corpusFilename;
+};
+
+void getBenchOptions(BenchOptions &opt);
+void showSyntax();
+bool readCorpus(const QString &filename, QStringList &inputs, QStringList &targets);
+Lvk::Nlp::Engine *createEngine(const QString &engine, const QString &lemmatizer);
+void runBench(const BenchOptions &opt, RuleGenerator::Shape shape, const QString &lemmatizer);
+void print(const QString &s);
+void silentMsgHandler(QtMsgType type, const char *msg);
+
+//--------------------------------------------------------------------------------------------------
+// main
+//--------------------------------------------------------------------------------------------------
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    // The engine logs every step with qDebug(). Production builds filter those messages, so
+    // we drop them too in order to measure the engine and not the console.
+    qInstallMsgHandler(silentMsgHandler);
+
+    BenchOptions opt;
+    getBenchOptions(opt);
+
+    if (!opt.valid) {
+        showSyntax();
+        return 1;
+    }
+
+    foreach (const QString &lemmatizer, opt.lemmatizers) {
+        foreach (RuleGenerator::Shape shape, opt.shapes) {
+            runBench(opt, shape, lemmatizer);
+        }
+    }
+
+    return 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Helpers
+//--------------------------------------------------------------------------------------------------
+
+void getBenchOptions(BenchOptions &opt)
+{
+    opt.valid = true;
+    opt.rules = DEFAULT_RULES;
+    opt.messages = DEFAULT_MESSAGES;
+    opt.targets = DEFAULT_TARGETS;
+    opt.seed = DEFAULT_SEED;
+    opt.engine = "cb2";
+
+    QStringList args = QCoreApplication::arguments();
+
+    for (int i = 1; i < args.size() && opt.valid; ++i) {
+        QString arg = args[i];
+        QString value = arg.section("=", 1);
+
+        if (arg.startsWith("--rules=")) {
+            opt.rules = value.toInt(&opt.valid);
+        } else if (arg.startsWith("--messages=")) {
+            opt.messages = value.toInt(&opt.valid);
+        } else if (arg.startsWith("--targets=")) {
+            opt.targets = value.toInt(&opt.valid);
+        } else if (arg.startsWith("--seed=")) {
+            opt.seed = value.toUInt(&opt.valid);
+        } else if (arg.startsWith("--shape=")) {
+            foreach (const QString &name, value.split(",")) {
+                RuleGenerator::Shape shape;
+                opt.valid = opt.valid && RuleGenerator::parseShape(name, shape);
+                opt.shapes.append(shape);
+            }
+        } else if (arg.startsWith("--lemmatizer=")) {
+            opt.lemmatizers = value.split(",");
+            foreach (const QString &name, opt.lemmatizers) {
+#ifdef FREELING_SUPPORT
+                opt.valid = opt.valid && (name == "null" || name == "freeling");
+#else
+                opt.valid = opt.valid && name == "null";
+#endif
+            }
+        } else if (arg.startsWith("--engine=")) {
+            opt.engine = value;
+            opt.valid = value == "cb2" || value == "shiftand";
+        } else if (arg.startsWith("--corpus=")) {
+            opt.corpusFilename = value;
+        } else {
+            opt.valid = false;
+        }
+    }
+
+    if (opt.shapes.isEmpty()) {
+        for (int s = RuleGenerator::LiteralShape; s <= RuleGenerator::MixedShape; ++s) {
+            opt.shapes.append(static_cast<RuleGenerator::Shape>(s));
+        }
+    }
+
+    if (opt.lemmatizers.isEmpty()) {
+        opt.lemmatizers.append("null");
+#ifdef FREELING_SUPPORT
+        opt.lemmatizers.append("freeling");
+#endif
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void showSyntax()
+{
+    QString appname = QCoreApplication::arguments().first();
+
+    std::cerr << "Error: Invalid command line arguments." << std::endl;
+    std::cout << "Syntax: " << std::endl;
+    std::cout << "   " << appname.toUtf8().data() << " [options]" << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "   --rules=N                 Amount of rules. Default: " << DEFAULT_RULES
+              << std::endl;
+    std::cout << "   --messages=N              Amount of messages. Default: " << DEFAULT_MESSAGES
+              << std::endl;
+    std::cout << "   --targets=N               Amount of targets. Default: " << DEFAULT_TARGETS
+              << std::endl;
+    std::cout << "   --seed=N                  Random seed. Default: " << DEFAULT_SEED
+              << std::endl;
+    std::cout << "   --shape=S1,S2,...         literal, wildcard, variable, targets or mixed. "
+                 "Default: all" << std::endl;
+    std::cout << "   --lemmatizer=L1,L2,...    null or freeling. Default: all available"
+              << std::endl;
+    std::cout << "   --engine=E                cb2 or shiftand. Default: cb2" << std::endl;
+    std::cout << "   --corpus=FILE             Replay inputs from FILE instead of generating them."
+              << std::endl;
+    std::cout << "                             One input per line, optionally prefixed by"
+                 " \"target<TAB>\"." << std::endl;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool readCorpus(const QString &filename, QStringList &inputs, QStringList &targets)
+{
+    QFile file(filename);
+
+    if (!file.open(QFile::ReadOnly)) {
+        return false;
+    }
+
+    QTextStream stream(&file);
+    stream.setCodec("UTF-8");
+
+    while (!stream.atEnd()) {
+        QString line = stream.readLine();
+        if (line.trimmed().isEmpty()) {
+            continue;
+        }
+
+        int tab = line.indexOf('\t');
+        targets.append(tab != -1 ? line.left(tab) : QString());
+        inputs.append(tab != -1 ? line.mid(tab + 1) : line);
+    }
+
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+Lvk::Nlp::Engine *createEngine(const QString &engine, const QString &lemmatizer)
+{
+    Lvk::Nlp::Lemmatizer *lem = 0;
+
+#ifdef FREELING_SUPPORT
+    if (lemmatizer == "freeling") {
+        lem = new Lvk::Nlp::FreelingLemmatizer();
+    }
+#endif
+    if (!lem) {
+        lem = new Lvk::Nlp::NullLemmatizer();
+    }
+
+    Lvk::Nlp::Sanitizer *preSanitizer = Lvk::Nlp::SanitizerFactory().createPreSanitizer();
+    Lvk::Nlp::Sanitizer *postSanitizer = Lvk::Nlp::SanitizerFactory().createPostSanitizer();
+
+    if (engine == "shiftand") {
+        return new Lvk::Nlp::ShiftAndEngine(preSanitizer, lem, postSanitizer);
+    } else {
+        return new Lvk::Nlp::Cb2Engine(preSanitizer, lem, postSanitizer);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void runBench(const BenchOptions &opt, RuleGenerator::Shape shape, const QString &lemmatizer)
+{
+    print(QString("==== shape=%1 lemmatizer=%2 engine=%3 rules=%4 seed=%5 ====")
+          .arg(RuleGenerator::shapeName(shape), lemmatizer, opt.engine)
+          .arg(opt.rules).arg(opt.seed));
+
+    RuleGenerator generator(shape, opt.seed, opt.targets);
+
+    Lvk::Nlp::RuleList rules;
+    generator.generateRules(opt.rules, rules);
+
+    QStringList inputs;
+    QStringList targets;
+
+    if (!opt.corpusFilename.isEmpty()) {
+        if (!readCorpus(opt.corpusFilename, inputs, targets)) {
+            print("Error: Cannot read corpus " + opt.corpusFilename);
+            return;
+        }
+    } else {
+        generator.generateInputs(rules, opt.messages, inputs, targets);
+    }
+
+    Lvk::Nlp::Engine *engine = createEngine(opt.engine, lemmatizer);
+
+    // Build. Trees are built lazily, so we need a first query to build them.
+
+    BenchTimer timer;
+    qint64 allocs = AllocCounter::allocations();
+
+    engine->setRules(rules);
+    Lvk::Nlp::Result result;
+    engine->getBestResult("", "", result);
+
+    qint64 buildNsecs = timer.nsecsElapsed();
+    qint64 buildAllocs = AllocCounter::allocations() - allocs;
+
+    // Replay
+
+    Lvk::Cmn::LatencyHistogram histogram;
+    int matched = 0;
+
+    allocs = AllocCounter::allocations();
+    qint64 allocBytes = AllocCounter::bytes();
+
+    for (int i = 0; i < inputs.size(); ++i) {
+        timer.start();
+        if (engine->getBestResult(inputs[i], targets[i], result)) {
+            ++matched;
+        }
+        histogram.add(timer.nsecsElapsed());
+    }
+
+    allocs = AllocCounter::allocations() - allocs;
+    allocBytes = AllocCounter::bytes() - allocBytes;
+
+    Lvk::Nlp::MemoryUsage usage = engine->memoryUsage();
+
+    int n = qMax(1, histogram.count());
+    double totalSecs = histogram.total()/1e9;
+
+    print(QString("Build time:       %1 ms (%2 rules/s, %3 allocations)")
+          .arg(buildNsecs/1e6, 0, 'f', 2)
+          .arg(rules.size()/qMax(buildNsecs/1e9, 1e-9), 0, 'f', 0)
+          .arg(buildAllocs));
+    print(QString("Engine memory:    %1 nodes, %2 edges, %3 bytes")
+          .arg(usage.nodes()).arg(usage.edges).arg(usage.bytes()));
+    print(QString("Messages:         %1 (%2 matched)").arg(histogram.count()).arg(matched));
+    print(QString("Throughput:       %1 messages/s")
+          .arg(histogram.count()/qMax(totalSecs, 1e-9), 0, 'f', 0));
+    print(QString("Latency (us):     p50=%1 p90=%2 p99=%3 max=%4")
+          .arg(histogram.percentile(50)/1e3, 0, 'f', 1)
+          .arg(histogram.percentile(90)/1e3, 0, 'f', 1)
+          .arg(histogram.percentile(99)/1e3, 0, 'f', 1)
+          .arg(histogram.max()/1e3, 0, 'f', 1));
+    print(QString("Allocations:      %1 per message, %2 bytes per message%3")
+          .arg(static_cast<double>(allocs)/n, 0, 'f', 1)
+          .arg(static_cast<double>(allocBytes)/n, 0, 'f', 0)
+          .arg(AllocCounter::countsMalloc() ? "" : " (operator new only)"));
+    print(QString("Peak RSS:         %1 KiB (whole process)").arg(peakRss()));
+    print("Latency histogram:");
+    print(histogram.toString());
+    print("");
+
+    delete engine;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void print(const QString &s)
+{
+    std::cout << s.toUtf8().data() << std::endl;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void silentMsgHandler(QtMsgType type, const char *msg)
+{
+    if (type != QtDebugMsg) {
+        std::cerr << msg << std::endl;
+    }
+    if (type == QtFatalMsg) {
+        abort();
+    }
+}
+
@@ -0,0 +1,264 @@
+/*
+ * Copyright (C) 2012 Andres Pagliano, Gabriel Miretti, Gonzalo Buteler,
+ * Nestor Bustamante, Pablo Perez de Angelis
+ *
+ * This file is part of LVK Chatbot.
+ *
+ * LVK Chatbot is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LVK Chatbot is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LVK Chatbot.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "rulegenerator.h"
+
+#define VOCABULARY_SIZE     2000
+#define MATCHING_PERCENT    80
+
+//--------------------------------------------------------------------------------------------------
+// Helpers
+//--------------------------------------------------------------------------------------------------
+
+namespace
+{
+
+const char *SYLLABLES[] = { "ca", "sa", "lo", "me", "ti", "ra", "no", "pe",
+                            "du", "fi", "go", "la", "mu", "ne", "so", "ta" };
+
+const int SYLLABLES_SIZE = sizeof(SYLLABLES)/sizeof(SYLLABLES[0]);
+
+// Builds a pronounceable word from number n
+QString makeWord(int n)
+{
+    QString w;
+    do {
+        w.append(SYLLABLES[n % SYLLABLES_SIZE]);
+        n /= SYLLABLES_SIZE;
+    } while (n > 0 || w.size() < 4);
+
+    return w;
+}
+
+} // namespace
+
+//--------------------------------------------------------------------------------------------------
+// RuleGenerator
+//--------------------------------------------------------------------------------------------------
+
+RuleGenerator::RuleGenerator(Shape shape, quint32 seed, int targets)
+    : m_shape(shape), m_state(seed ? seed : 1), m_targets(qMax(1, targets))
+{
+    for (int i = 0; i < VOCABULARY_SIZE; ++i) {
+        m_vocabulary.append(makeWord(i));
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+quint32 RuleGenerator::next()
+{
+    // xorshift32
+    m_state ^= m_state << 13;
+    m_state ^= m_state >> 17;
+    m_state ^= m_state << 5;
+
+    return m_state;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+int RuleGenerator::nextInt(int min, int max)
+{
+    return min + next() % (max - min + 1);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+QString RuleGenerator::randomWord()
+{
+    return m_vocabulary[nextInt(0, m_vocabulary.size() - 1)];
+}
+
+//--------------------------------------------------------------------------------------------------
+
+QString RuleGenerator::randomWords(int min, int max)
+{
+    QStringList words;
+    int n = nextInt(min, max);
+
+    for (int i = 0; i < n; ++i) {
+        words.append(randomWord());
+    }
+
+    return words.join(" ");
+}
+
+//--------------------------------------------------------------------------------------------------
+
+QString RuleGenerator::randomTarget()
+{
+    return QString("user%1@bench.example.com").arg(nextInt(1, m_targets));
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void RuleGenerator::generateRules(int count, Lvk::Nlp::RuleList &rules)
+{
+    rules.clear();
+
+    for (int i = 0; i < count; ++i) {
+        Shape shape = m_shape;
+        if (shape == MixedShape) {
+            shape = static_cast<Shape>(nextInt(LiteralShape, TargetsShape));
+        }
+        rules.append(makeRule(i + 1, shape));
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+Lvk::Nlp::Rule RuleGenerator::makeRule(Lvk::Nlp::RuleId id, Shape shape)
+{
+    QStringList input;
+    QStringList output;
+    QStringList target;
+
+    int inputs = nextInt(1, 3);
+
+    for (int i = 0; i < inputs; ++i) {
+        switch (shape) {
+        case WildcardShape:
+            switch (nextInt(0, 3)) {
+            case 0:
+                input.append("* " + randomWords(1, 3) + " *");
+                break;
+            case 1:
+                input.append(randomWords(1, 2) + " *");
+                break;
+            case 2:
+                input.append("* " + randomWords(1, 2));
+                break;
+            default:
+                input.append(randomWords(1, 2) + " + " + randomWords(1, 2));
+                break;
+            }
+            break;
+        case VariableShape:
+            input.append(randomWords(1, 3) + " [v1] " + randomWords(0, 2));
+            break;
+        default:
+            input.append(randomWords(2, 6));
+            break;
+        }
+    }
+
+    if (shape == VariableShape) {
+        output.append(QString("{if [v1] == %1} %2 {else} %3 [v1]")
+                      .arg(randomWord(), randomWords(2, 5), randomWords(2, 5)));
+    } else {
+        int outputs = nextInt(1, 2);
+        for (int i = 0; i < outputs; ++i) {
+            output.append(randomWords(2, 8));
+        }
+    }
+
+    if (shape == TargetsShape) {
+        int targets = nextInt(1, 3);
+        for (int i = 0; i < targets; ++i) {
+            target.append(randomTarget());
+        }
+    }
+
+    return Lvk::Nlp::Rule(id, input, output, target);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void RuleGenerator::generateInputs(const Lvk::Nlp::RuleList &rules, int count,
+                                   QStringList &inputs, QStringList &targets)
+{
+    inputs.clear();
+    targets.clear();
+
+    for (int i = 0; i < count; ++i) {
+        if (!rules.isEmpty() && nextInt(1, 100) <= MATCHING_PERCENT) {
+            const Lvk::Nlp::Rule &rule = rules[nextInt(0, rules.size() - 1)];
+            const QStringList &ruleInputs = rule.input();
+            const QStringList &ruleTargets = rule.target();
+
+            inputs.append(instantiate(ruleInputs[nextInt(0, ruleInputs.size() - 1)]));
+            targets.append(ruleTargets.isEmpty() ? QString()
+                                                 : ruleTargets[nextInt(0, ruleTargets.size() - 1)]);
+        } else {
+            inputs.append(randomWords(3, 8));
+            targets.append(m_shape == TargetsShape || m_shape == MixedShape ? randomTarget()
+                                                                            : QString());
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+QString RuleGenerator::instantiate(const QString &ruleInput)
+{
+    QStringList words;
+
+    foreach (const QString &token, ruleInput.split(" ", QString::SkipEmptyParts)) {
+        if (token == "*") {
+            QString w = randomWords(0, 2);
+            if (!w.isEmpty()) {
+                words.append(w);
+            }
+        } else if (token == "+") {
+            words.append(randomWords(1, 2));
+        } else if (token.startsWith("[")) {
+            words.append(randomWord());
+        } else {
+            words.append(token);
+        }
+    }
+
+    return words.join(" ");
+}
+
+//--------------------------------------------------------------------------------------------------
+
+QString RuleGenerator::shapeName(Shape shape)
+{
+    switch (shape) {
+    case LiteralShape:
+        return "literal";
+    case WildcardShape:
+        return "wildcard";
+    case VariableShape:
+        return "variable";
+    case TargetsShape:
+        return "targets";
+    case MixedShape:
+        return "mixed";
+    }
+    return QString();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool RuleGenerator::parseShape(const QString &name, Shape &shape)
+{
+    for (int s = LiteralShape; s <= MixedShape; ++s) {
+        if (name == shapeName(static_cast<Shape>(s))) {
+            shape = static_cast<Shape>(s);
+            return true;
+        }
+    }
+    return false;
+}
+
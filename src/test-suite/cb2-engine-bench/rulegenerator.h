@@ -0,0 +1,68 @@
+#ifndef RULEGENERATOR_H
+#define RULEGENERATOR_H
+
+#include <QString>
+#include <QStringList>
+
+#include "nlp-engine/rule.h"
+
+/**
+ * \brief The RuleGenerator class generates synthetic rule sets and user inputs that match them.
+ *
+ * Generation is deterministic for a given seed so runs can be compared against each other.
+ */
+class RuleGenerator
+{
+public:
+
+    /**
+     * Shape of the generated rules
+     */
+    enum Shape
+    {
+        LiteralShape,       ///< Rules with words only
+        WildcardShape,      ///< Rules with words and wildcards
+        VariableShape,      ///< Rules with variables and conditional outputs
+        TargetsShape,       ///< Rules with words restricted to several targets
+        MixedShape          ///< Rules of all the shapes above
+    };
+
+    /**
+     * Constructs a generator of rules with \a shape. \a targets is the amount of different
+     * targets used by TargetsShape rules.
+     */
+    RuleGenerator(Shape shape, quint32 seed, int targets);
+
+    /**
+     * Generates \a count rules and stores them in \a rules
+     */
+    void generateRules(int count, Lvk::Nlp::RuleList &rules);
+
+    /**
+     * Generates \a count user inputs for \a rules and stores them in \a inputs. The target of
+     * each input is stored in \a targets. Most of the inputs match some rule, the rest are
+     * random sentences.
+     */
+    void generateInputs(const Lvk::Nlp::RuleList &rules, int count, QStringList &inputs,
+                        QStringList &targets);
+
+    static QString shapeName(Shape shape);
+
+    static bool parseShape(const QString &name, Shape &shape);
+
+private:
+    Shape m_shape;
+    quint32 m_state;
+    int m_targets;
+    QStringList m_vocabulary;
+
+    quint32 next();
+    int nextInt(int min, int max);
+    QString randomWord();
+    QString randomWords(int min, int max);
+    QString randomTarget();
+    QString instantiate(const QString &ruleInput);
+    Lvk::Nlp::Rule makeRule(Lvk::Nlp::RuleId id, Shape shape);
+};
+
+#endif // RULEGENERATOR_H
@@ -2,14 +2,28 @@
 #include <QtTest/QtTest>
 
 #include "nlp-engine/cb2engine.h"
+#include "nlp-engine/shiftandengine.h"
 #include "nlp-engine/lemmatizerfactory.h"
 #include "common/settingskeys.h"
 #include "common/settings.h"
 
 #include "ruledef.h"
+#ifdef ENGINE_PARITY_TEST
+# include "parityengine.h"
+#endif
 
 #define UTF8        QString::fromUtf8
 
+// The same test cases are used to verify ShiftAndEngine (see shiftand-engine-full-test) and
+// that both engines give the same results (see engine-parity-full-test)
+#ifdef SHIFTAND_ENGINE_TEST
+# define TestEngine Nlp::ShiftAndEngine
+#elif defined(ENGINE_PARITY_TEST)
+# define TestEngine ParityEngine
+#else
+# define TestEngine Nlp::Cb2Engine
+#endif
+
 using namespace Lvk;
 
 //--------------------------------------------------------------------------------------------------
@@ -43,7 +57,7 @@ Cb2EnginefullTest::Cb2EnginefullTest()
 {
     Cmn::Settings().setValue(SETTING_APP_LANGUAGE, "es_AR");
 
-    m_engine = new Nlp::Cb2Engine();
+    m_engine = new TestEngine();
     m_engine->setLemmatizer(Nlp::LemmatizerFactory().createLemmatizer());
 }
 
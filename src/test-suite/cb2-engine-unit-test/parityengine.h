@@ -0,0 +1,187 @@
+#ifndef PARITYENGINE_H
+#define PARITYENGINE_H
+
+#include "nlp-engine/cb2engine.h"
+#include "nlp-engine/shiftandengine.h"
+#include "nlp-engine/lemmatizer.h"
+#include "nlp-engine/sanitizer.h"
+#include "nlp-engine/nulllemmatizer.h"
+#include "nlp-engine/nullsanitizer.h"
+#include "common/random.h"
+
+#include <QtTest/QtTest>
+
+/**
+ * ParityEngine is a ShiftAndEngine that also feeds every rule, property, sanitizer and lemmatizer
+ * to a reference Cb2Engine. Every query is answered by both engines and the test fails if their
+ * results differ. Each engine is queried with the same random seed so random outputs match.
+ *
+ * Used by engine-parity-unit-test and engine-parity-full-test to run the Cb2Engine test cases
+ * on both engines.
+ */
+class ParityEngine : public Lvk::Nlp::ShiftAndEngine
+{
+public:
+    ParityEngine()
+        : m_seed(0)
+    {
+    }
+
+    ParityEngine(Lvk::Nlp::Sanitizer *sanitizer)
+        : Lvk::Nlp::ShiftAndEngine(sanitizer),
+          m_reference(new SanitizerProxy(sanitizer), new Lvk::Nlp::NullLemmatizer(),
+                      new Lvk::Nlp::NullSanitizer()),
+          m_seed(0)
+    {
+    }
+
+    virtual void setRules(const Lvk::Nlp::RuleList &rules)
+    {
+        m_reference.setRules(rules);
+        Lvk::Nlp::ShiftAndEngine::setRules(rules);
+    }
+
+    virtual void addRule(const Lvk::Nlp::Rule &rule)
+    {
+        m_reference.addRule(rule);
+        Lvk::Nlp::ShiftAndEngine::addRule(rule);
+    }
+
+    virtual void updateRule(const Lvk::Nlp::Rule &rule)
+    {
+        m_reference.updateRule(rule);
+        Lvk::Nlp::ShiftAndEngine::updateRule(rule);
+    }
+
+    virtual void removeRule(Lvk::Nlp::RuleId ruleId)
+    {
+        m_reference.removeRule(ruleId);
+        Lvk::Nlp::ShiftAndEngine::removeRule(ruleId);
+    }
+
+    virtual void updateRules(const Lvk::Nlp::RuleList &rules, const QList<int> &positions,
+                             const QList<Lvk::Nlp::RuleId> &removed)
+    {
+        m_reference.updateRules(rules, positions, removed);
+        Lvk::Nlp::ShiftAndEngine::updateRules(rules, positions, removed);
+    }
+
+    virtual void getAllResults(const QString &input, const QString &target,
+                               Lvk::Nlp::ResultList &results)
+    {
+        // Both engines must draw the same random numbers
+        ++m_seed;
+
+        Lvk::Nlp::ResultList expected;
+        Lvk::Cmn::Random::setSeed(m_seed);
+        m_reference.getAllResults(input, target, expected);
+
+        Lvk::Cmn::Random::setSeed(m_seed);
+        Lvk::Nlp::ShiftAndEngine::getAllResults(input, target, results);
+
+        QVERIFY2(results.size() == expected.size(), qPrintable("Input: " + input));
+
+        // Results with equal score can be found in a different order
+        Lvk::Nlp::ResultList actual = results;
+        qStableSort(actual.begin(), actual.end(), &ParityEngine::resultLessThan);
+        qStableSort(expected.begin(), expected.end(), &ParityEngine::resultLessThan);
+
+        for (int i = 0; i < actual.size(); ++i) {
+            QCOMPARE(actual[i].ruleId, expected[i].ruleId);
+            QCOMPARE(actual[i].inputIdx, expected[i].inputIdx);
+            QCOMPARE(actual[i].output, expected[i].output);
+            QCOMPARE(actual[i].score, expected[i].score);
+        }
+    }
+
+    virtual void setPreSanitizer(Lvk::Nlp::Sanitizer *sanitizer)
+    {
+        // The reference drops its proxy before the real sanitizer is deleted
+        m_reference.setPreSanitizer(sanitizer ? new SanitizerProxy(sanitizer) : 0);
+        Lvk::Nlp::ShiftAndEngine::setPreSanitizer(sanitizer);
+    }
+
+    virtual void setLemmatizer(Lvk::Nlp::Lemmatizer *lemmatizer)
+    {
+        m_reference.setLemmatizer(lemmatizer ? new LemmatizerProxy(lemmatizer) : 0);
+        Lvk::Nlp::ShiftAndEngine::setLemmatizer(lemmatizer);
+    }
+
+    virtual void setPostSanitizer(Lvk::Nlp::Sanitizer *sanitizer)
+    {
+        m_reference.setPostSanitizer(sanitizer ? new SanitizerProxy(sanitizer) : 0);
+        Lvk::Nlp::ShiftAndEngine::setPostSanitizer(sanitizer);
+    }
+
+    virtual void setProperty(const QString &name, const QVariant &value)
+    {
+        m_reference.setProperty(name, value);
+        Lvk::Nlp::ShiftAndEngine::setProperty(name, value);
+    }
+
+    virtual void clear()
+    {
+        m_reference.clear();
+        Lvk::Nlp::ShiftAndEngine::clear();
+    }
+
+private:
+    ParityEngine(const ParityEngine&);
+    ParityEngine & operator=(const ParityEngine&);
+
+    /// Sanitizer shared with the tested engine, which owns it
+    class SanitizerProxy : public Lvk::Nlp::Sanitizer
+    {
+    public:
+        SanitizerProxy(Lvk::Nlp::Sanitizer *sanitizer) : m_sanitizer(sanitizer) { }
+
+        virtual QString sanitize(const QString &str) const
+        {
+            return m_sanitizer->sanitize(str);
+        }
+
+        virtual QStringList sanitize(const QStringList &list) const
+        {
+            return m_sanitizer->sanitize(list);
+        }
+
+    private:
+        Lvk::Nlp::Sanitizer *m_sanitizer;
+    };
+
+    /// Lemmatizer shared with the tested engine, which owns it
+    class LemmatizerProxy : public Lvk::Nlp::Lemmatizer
+    {
+    public:
+        LemmatizerProxy(Lvk::Nlp::Lemmatizer *lemmatizer) : m_lemmatizer(lemmatizer) { }
+
+        virtual void tokenize(const QString &input, QStringList &l)
+        {
+            m_lemmatizer->tokenize(input, l);
+        }
+
+        virtual void lemmatize(const QString &input, Lvk::Nlp::WordList &l)
+        {
+            m_lemmatizer->lemmatize(input, l);
+        }
+
+    private:
+        Lvk::Nlp::Lemmatizer *m_lemmatizer;
+    };
+
+    static bool resultLessThan(const Lvk::Nlp::Result &r1, const Lvk::Nlp::Result &r2)
+    {
+        if (r1.score != r2.score) {
+            return r1.score > r2.score;
+        }
+        if (r1.ruleId != r2.ruleId) {
+            return r1.ruleId < r2.ruleId;
+        }
+        return r1.inputIdx < r2.inputIdx;
+    }
+
+    Lvk::Nlp::Cb2Engine m_reference;
+    unsigned int m_seed;
+};
+
+#endif // PARITYENGINE_H
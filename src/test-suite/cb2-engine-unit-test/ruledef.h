@@ -125,6 +125,15 @@
 #define RULE_22_INPUT_2                      "Solamente [var]"
 #define RULE_22_OUTPUT_1                     "R[var]"
 
+#define RULE_23_ID                          23
+#define RULE_23_INPUT_1                     "hello"
+#define RULE_23_INPUT_2                     "hi *"
+#define RULE_23_OUTPUT_1                    "Hi!"
+
+#define RULE_24_ID                          24
+#define RULE_24_INPUT_1                     "my name is [name]"
+#define RULE_24_OUTPUT_1                    "Hi [name]!"
+
 //--------------------------------------------------------------------------------------------------
 
 inline void setRules1(Lvk::Nlp::Engine *engine)
@@ -385,4 +394,23 @@ inline void setRules8(Lvk::Nlp::Engine *engine)
     engine->setRules(rules);
 }
 
+//--------------------------------------------------------------------------------------------------
+
+inline void setRules9(Lvk::Nlp::Engine *engine)
+{
+    Lvk::Nlp::RuleList rules;
+
+    rules << Lvk::Nlp::Rule(RULE_23_ID,
+                            QStringList() << RULE_23_INPUT_1 << RULE_23_INPUT_2,
+                            QStringList() << RULE_23_OUTPUT_1,
+                            QStringList());
+
+    rules << Lvk::Nlp::Rule(RULE_24_ID,
+                            QStringList() << RULE_24_INPUT_1,
+                            QStringList() << RULE_24_OUTPUT_1,
+                            QStringList() << TARGET_USER_1);
+
+    engine->setRules(rules);
+}
+
 #endif // RULEDEF_H
@@ -28,15 +28,20 @@
 #include <iostream>
 
 #include "nlp-engine/cb2engine.h"
+#include "nlp-engine/shiftandengine.h"
 #include "nlp-engine/rule.h"
 #include "nlp-engine/nlpproperties.h"
 #include "nlp-engine/defaultsanitizer.h"
 #include "nlp-engine/nullsanitizer.h"
 #include "nlp-engine/nulllemmatizer.h"
 #include "nlp-engine/sanitizerfactory.h"
+#include "nlp-engine/stringpool.h"
 
 #include "ruledef.h"
 #include "mocklemmatizer.h"
+#ifdef ENGINE_PARITY_TEST
+# include "parityengine.h"
+#endif
 
 #define EnableTestMatchWithSingleOutput
 #define EnableTestMatchWithSingleOutputWithLemmatizer
@@ -47,6 +52,22 @@
 #define EnableTestMatchWithTopic
 #define EnableTestMatchWithNextTopic
 #define EnableTestInfiniteLoopDetection
+#define EnableTestBestResult
+#define EnableTestMemoryUsage
+#define EnableTestUpdateAndRemoveRule
+#define EnableTestStringPool
+#define EnableTestToolsPerEngine
+#define EnableTestIncrementalUpdateOrder
+
+// The same test cases are used to verify ShiftAndEngine (see shiftand-engine-unit-test) and
+// that both engines give the same results (see engine-parity-unit-test)
+#ifdef SHIFTAND_ENGINE_TEST
+# define TestEngine     Lvk::Nlp::ShiftAndEngine
+#elif defined(ENGINE_PARITY_TEST)
+# define TestEngine     ParityEngine
+#else
+# define TestEngine     Lvk::Nlp::Cb2Engine
+#endif
 
 #define USER_INPUT_1a                       "Hello"
 #define USER_INPUT_1b                       "hello"
@@ -133,6 +154,19 @@ private Q_SLOTS:
     void testInfiniteLoopDetection();
     void testInfiniteLoopDetection_data();
 
+    void testBestResult_data();
+    void testBestResult();
+
+    void testMemoryUsage();
+
+    void testUpdateAndRemoveRule();
+
+    void testStringPool();
+
+    void testToolsPerEngine();
+
+    void testIncrementalUpdateOrder();
+
     void cleanupTestCase();
 
 private:
@@ -154,7 +188,7 @@ TestCb2Engine::TestCb2Engine()
 
 void TestCb2Engine::initTestCase()
 {
-    m_engine = new Lvk::Nlp::Cb2Engine(new Lvk::Nlp::NullSanitizer());
+    m_engine = new TestEngine(new Lvk::Nlp::NullSanitizer());
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -255,8 +289,6 @@ void TestCb2Engine::testMatchWithSingleOutput()
 
 //--------------------------------------------------------------------------------------------------
 
-//--------------------------------------------------------------------------------------------------
-
 void TestCb2Engine::testMatchWithSingleOutputWithLemmatizer_data()
 {
     QTest::addColumn<QString>("userInput");
@@ -630,6 +662,302 @@ void TestCb2Engine::testInfiniteLoopDetection()
     }
 }
 
+void TestCb2Engine::testBestResult_data()
+{
+    testMatchWithSingleOutputWithLemmatizer_data();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void TestCb2Engine::testBestResult()
+{
+#ifndef EnableTestBestResult
+    QSKIP("Skip macro on", SkipAll);
+#endif
+
+    QFETCH(QString, userInput);
+    QFETCH(QString, expectedOutput);
+    QFETCH(int, ruleId);
+    QFETCH(int, ruleInputNumber);
+
+    m_engine->setLemmatizer(new MockLemmatizer());
+
+    setRules1(m_engine);
+
+    Lvk::Nlp::Result result;
+    bool matched = m_engine->getBestResult(userInput, "", result);
+
+    Lvk::Nlp::ResultList results;
+    m_engine->getAllResults(userInput, "", results);
+
+    if (!expectedOutput.isNull()) {
+        QVERIFY(matched);
+        QCOMPARE(result.output, expectedOutput);
+        QCOMPARE(result.ruleId, static_cast<Lvk::Nlp::RuleId>(ruleId));
+        QCOMPARE(result.inputIdx, ruleInputNumber);
+        QVERIFY(!results.isEmpty());
+        QCOMPARE(results.first().ruleId, result.ruleId);
+    } else {
+        QVERIFY(!matched);
+        QVERIFY(result.output.isEmpty());
+        QVERIFY(results.isEmpty());
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void TestCb2Engine::testMemoryUsage()
+{
+#ifndef EnableTestMemoryUsage
+    QSKIP("Skip macro on", SkipAll);
+#endif
+
+    m_engine->setLemmatizer(new Lvk::Nlp::NullLemmatizer());
+
+    setRules9(m_engine);
+
+    Lvk::Nlp::MemoryUsageMap targets;
+    Lvk::Nlp::MemoryUsage total = m_engine->memoryUsage(&targets);
+
+    QCOMPARE(targets.size(), 2);
+    QVERIFY(targets.contains(""));
+    QVERIFY(targets.contains(TARGET_USER_1));
+
+    // "hello" and "hi *"
+    const Lvk::Nlp::MemoryUsage &anyUser = targets[""];
+    QCOMPARE(anyUser.wordNodes, 2);
+    QCOMPARE(anyUser.wildcardNodes, 1);
+    QCOMPARE(anyUser.variableNodes, 0);
+    QCOMPARE(anyUser.edges, 4);
+    QCOMPARE(anyUser.distinctWords, 2);
+    QVERIFY(anyUser.omapEntries >= 2);
+    QVERIFY(anyUser.stringBytes > 0);
+    QVERIFY(anyUser.outputBytes > 0);
+
+    // "my name is [name]"
+    const Lvk::Nlp::MemoryUsage &user1 = targets[TARGET_USER_1];
+    QCOMPARE(user1.wordNodes, 3);
+    QCOMPARE(user1.wildcardNodes, 0);
+    QCOMPARE(user1.variableNodes, 1);
+    QCOMPARE(user1.edges, 5);
+    QCOMPARE(user1.distinctWords, 3);
+    QCOMPARE(user1.omapEntries, 1);
+
+    QCOMPARE(total.nodes(), anyUser.nodes() + user1.nodes());
+    QCOMPARE(total.edges, anyUser.edges + user1.edges);
+    QCOMPARE(total.bytes(), anyUser.bytes() + user1.bytes());
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void TestCb2Engine::testUpdateAndRemoveRule()
+{
+#ifndef EnableTestUpdateAndRemoveRule
+    QSKIP("Skip macro on", SkipAll);
+#endif
+
+    m_engine->setLemmatizer(new MockLemmatizer());
+
+    setRules4(m_engine);
+
+    Lvk::Nlp::Engine::MatchList matches;
+
+    QCOMPARE(m_engine->getResponse(USER_INPUT_1a, TARGET_USER_1, matches),
+             QString(RULE_1_OUTPUT_1));
+
+    // Only the trees of the old and new targets are rebuilt
+
+    m_engine->updateRule(Lvk::Nlp::Rule(RULE_1_ID,
+                                        QStringList() << RULE_1_INPUT_1,
+                                        QStringList() << RULE_1_OUTPUT_2,
+                                        QStringList() << TARGET_USER_3));
+
+    QVERIFY(m_engine->getResponse(USER_INPUT_1a, TARGET_USER_1, matches).isEmpty());
+    QCOMPARE(m_engine->getResponse(USER_INPUT_1a, TARGET_USER_3, matches),
+             QString(RULE_1_OUTPUT_2));
+    QCOMPARE(m_engine->getResponse(USER_INPUT_1a, TARGET_USER_2, matches),
+             QString(RULE_1_OUTPUT_1));
+    QCOMPARE(m_engine->rules().size(), 5);
+
+    m_engine->removeRule(RULE_7_ID);
+
+    QVERIFY(m_engine->getResponse(USER_INPUT_8c, TARGET_USER_1, matches).isEmpty());
+    QCOMPARE(m_engine->rules().size(), 4);
+
+    // Unknown rules are added
+
+    m_engine->updateRule(Lvk::Nlp::Rule(RULE_7_ID,
+                                        QStringList() << RULE_7_INPUT_1,
+                                        QStringList() << RULE_7_OUTPUT_1));
+
+    QCOMPARE(m_engine->getResponse(USER_INPUT_8c, TARGET_USER_1, matches),
+             QString(RULE_7_OUTPUT_1));
+    QCOMPARE(matches.size(), 1);
+    QCOMPARE(matches[0].first, static_cast<Lvk::Nlp::RuleId>(RULE_7_ID));
+    QCOMPARE(m_engine->rules().size(), 5);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void TestCb2Engine::testStringPool()
+{
+#ifndef EnableTestStringPool
+    QSKIP("Skip macro on", SkipAll);
+#endif
+
+    Lvk::Nlp::StringPool *pool = Lvk::Nlp::StringPool::instance();
+
+    QString str1 = QString("hel") + "lo";
+    QString str2 = QString("hell") + "o";
+
+    // Disabled pools do not intern
+
+    QCOMPARE(pool->intern(str1).constData(), str1.constData());
+    QCOMPARE(pool->size(), 0);
+
+    pool->setEnabled(true);
+
+    QCOMPARE(pool->intern(str1).constData(), str1.constData());
+    QCOMPARE(pool->intern(str2).constData(), str1.constData());
+    QCOMPARE(pool->size(), 1);
+
+    // Engines with interned words match as usual
+
+    m_engine->setLemmatizer(new MockLemmatizer());
+
+    setRules4(m_engine);
+
+    QVERIFY(pool->size() > 1);
+
+    Lvk::Nlp::Engine::MatchList matches;
+
+    QCOMPARE(m_engine->getResponse(USER_INPUT_1a, TARGET_USER_1, matches),
+             QString(RULE_1_OUTPUT_1));
+
+    // Purging releases the words of destroyed trees but keeps strings still in use
+
+    m_engine->clear();
+
+    QVERIFY(pool->purge() > 0);
+    QCOMPARE(pool->size(), 1);
+    QCOMPARE(pool->intern(str2).constData(), str1.constData());
+
+    pool->setEnabled(false);
+    pool->clear();
+
+    QCOMPARE(pool->size(), 0);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void TestCb2Engine::testToolsPerEngine()
+{
+#ifndef EnableTestToolsPerEngine
+    QSKIP("Skip macro on", SkipAll);
+#endif
+
+    m_engine->setLemmatizer(new MockLemmatizer());
+
+    // Engines created later must not change the tools of other engines
+
+    Lvk::Nlp::Cb2Engine engine2(new Lvk::Nlp::NullSanitizer(), new Lvk::Nlp::NullLemmatizer(),
+                                new Lvk::Nlp::NullSanitizer());
+
+    setRules1(m_engine);
+    setRules1(&engine2);
+
+    Lvk::Nlp::Engine::MatchList matches;
+
+    QCOMPARE(m_engine->getResponse(USER_INPUT_1b, matches), QString(RULE_1_OUTPUT_1));
+    QVERIFY(engine2.getResponse(USER_INPUT_1b, matches).isEmpty());
+
+    engine2.setLemmatizer(new MockLemmatizer());
+    m_engine->setLemmatizer(0);
+
+    QVERIFY(m_engine->getResponse(USER_INPUT_1b, matches).isEmpty());
+    QCOMPARE(engine2.getResponse(USER_INPUT_1b, matches), QString(RULE_1_OUTPUT_1));
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void TestCb2Engine::testIncrementalUpdateOrder()
+{
+#ifndef EnableTestIncrementalUpdateOrder
+    QSKIP("Skip macro on", SkipAll);
+#endif
+
+    m_engine->setLemmatizer(new MockLemmatizer());
+
+    // Rules with overlapping inputs, so the order of the rules matters
+
+    Lvk::Nlp::Rule r1(1001, QStringList() << "hello", QStringList() << "R1");
+    Lvk::Nlp::Rule r2(1002, QStringList() << "hello", QStringList() << "R2");
+    Lvk::Nlp::Rule r3(1003, QStringList() << "hello *", QStringList() << "R3");
+    Lvk::Nlp::Rule r4(1004, QStringList() << "* hello", QStringList() << "R4");
+    Lvk::Nlp::Rule r5(1005, QStringList() << "hi", QStringList() << "R5");
+    Lvk::Nlp::Rule r3b(1003, QStringList() << "hello *", QStringList() << "R3b");
+
+    QStringList inputs;
+    inputs << "hello" << "hello there" << "well hello" << "hi";
+
+    QList<Lvk::Nlp::RuleList> expected;
+    QList<Lvk::Nlp::RuleList> updated;
+    QList<QList<int> > positions;
+    QList<QList<Lvk::Nlp::RuleId> > removed;
+
+    // Add at the front and in the middle
+    expected.append(Lvk::Nlp::RuleList() << r4 << r1 << r5 << r2 << r3);
+    updated.append(Lvk::Nlp::RuleList() << r4 << r5);
+    positions.append(QList<int>() << 0 << 2);
+    removed.append(QList<Lvk::Nlp::RuleId>());
+
+    // Move r2 before r1
+    expected.append(Lvk::Nlp::RuleList() << r4 << r2 << r1 << r5 << r3);
+    updated.append(Lvk::Nlp::RuleList() << r2);
+    positions.append(QList<int>() << 1);
+    removed.append(QList<Lvk::Nlp::RuleId>());
+
+    // Remove r1, change r3 and move it to the front
+    expected.append(Lvk::Nlp::RuleList() << r3b << r4 << r2 << r5);
+    updated.append(Lvk::Nlp::RuleList() << r3b);
+    positions.append(QList<int>() << 0);
+    removed.append(QList<Lvk::Nlp::RuleId>() << r1.id());
+
+    // Add r1 back at the end and move r5 before r4
+    expected.append(Lvk::Nlp::RuleList() << r3b << r5 << r4 << r2 << r1);
+    updated.append(Lvk::Nlp::RuleList() << r5 << r1);
+    positions.append(QList<int>() << 1 << 4);
+    removed.append(QList<Lvk::Nlp::RuleId>());
+
+    m_engine->setRules(Lvk::Nlp::RuleList() << r1 << r2 << r3);
+
+    Lvk::Nlp::Engine::MatchList matches;
+    Lvk::Nlp::Engine::MatchList expectedMatches;
+
+    for (int i = 0; i < expected.size(); ++i) {
+        m_engine->updateRules(updated[i], positions[i], removed[i]);
+
+        // Must behave exactly as an engine with all rules set at once
+
+        TestEngine engine2(new Lvk::Nlp::NullSanitizer());
+        engine2.setLemmatizer(new MockLemmatizer());
+        engine2.setRules(expected[i]);
+
+        Lvk::Nlp::RuleList rules = m_engine->rules();
+
+        QCOMPARE(rules.size(), expected[i].size());
+        for (int j = 0; j < rules.size(); ++j) {
+            QCOMPARE(rules[j].id(), expected[i][j].id());
+        }
+
+        foreach (const QString &input, inputs) {
+            QCOMPARE(m_engine->getResponse(input, matches),
+                     engine2.getResponse(input, expectedMatches));
+            QCOMPARE(matches, expectedMatches);
+        }
+    }
+}
+
 //--------------------------------------------------------------------------------------------------
 // Test entry point
 //--------------------------------------------------------------------------------------------------
@@ -0,0 +1,37 @@
+#-------------------------------------------------
+#
+# ChatCorpus unit tests
+#
+#-------------------------------------------------
+
+QT       += testlib
+
+QT       -= gui
+
+TARGET = chatCorpusUnitTest
+CONFIG   += console
+CONFIG   -= app_bundle
+
+TEMPLATE = app
+
+INCLUDEPATH += \
+    ../../chatbot \
+
+HEADERS += \
+    ../../chatbot/chat-adapter/chatcorpus.h \
+    ../../chatbot/common/csvrow.h \
+    ../../chatbot/common/csvreader.h \
+    ../../chatbot/common/settings.h \
+    ../../chatbot/common/metrics.h \
+    ../../chatbot/common/fileutils.h \
+
+SOURCES += \
+    chatcorpustest.cpp \
+    ../../chatbot/chat-adapter/chatcorpus.cpp \
+    ../../chatbot/common/csvrow.cpp \
+    ../../chatbot/common/csvreader.cpp \
+    ../../chatbot/common/settings.cpp \
+    ../../chatbot/common/metrics.cpp \
+    ../../chatbot/common/fileutils.cpp \
+
+DEFINES += SRCDIR=\\\"$$PWD/\\\"
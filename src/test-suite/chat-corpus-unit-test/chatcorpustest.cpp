@@ -0,0 +1,194 @@
+#include <QtCore/QString>
+#include <QtTest/QtTest>
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+
+#include "chat-adapter/chatcorpus.h"
+#include "common/csvrow.h"
+#include "common/settings.h"
+#include "common/settingskeys.h"
+#include "common/globalstrings.h"
+
+#define DATA_PATH           "chat_corpus_test_data"
+#define CORPUS_FILE         DATA_PATH "/corpus.dat"
+#define OLD_SEGMENT         DATA_PATH "/corpus.20000101-000000000.dat"
+#define BUFFER_SIZE         256
+#define MAX_FILE_SIZE       4096
+#define OLD_ENTRIES         3
+#define ENTRIES             500
+
+typedef Lvk::CA::ChatCorpus::CorpusEntry CorpusEntry;
+
+//--------------------------------------------------------------------------------------------------
+// ChatCorpusTest
+//--------------------------------------------------------------------------------------------------
+
+class ChatCorpusTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    ChatCorpusTest();
+
+private Q_SLOTS:
+    void initTestCase();
+    void testBufferedAppend();
+    void testRotateAndRead();
+    void testReadCompressed();
+    void cleanupTestCase();
+
+private:
+    QStringList files(const QString &filter);
+    void removeData();
+    void verifyEntries();
+};
+
+//--------------------------------------------------------------------------------------------------
+
+ChatCorpusTest::ChatCorpusTest()
+{
+}
+
+//--------------------------------------------------------------------------------------------------
+
+QStringList ChatCorpusTest::files(const QString &filter)
+{
+    return QDir(DATA_PATH).entryList(QStringList() << filter, QDir::Files, QDir::Name);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void ChatCorpusTest::removeData()
+{
+    foreach (const QString &name, files("*")) {
+        QFile::remove(QString(DATA_PATH) + "/" + name);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void ChatCorpusTest::initTestCase()
+{
+    // Settings are read once, before the corpus is used for the first time
+    Lvk::Cmn::Settings settings;
+    settings.setValue(SETTING_DATA_PATH, DATA_PATH);
+    settings.setValue(SETTING_CORPUS_BUFFER_SIZE, BUFFER_SIZE);
+    settings.setValue(SETTING_CORPUS_FLUSH_INTERVAL, 60*1000);
+    settings.setValue(SETTING_CORPUS_MAX_SIZE, MAX_FILE_SIZE);
+    settings.setValue(SETTING_CORPUS_COMPRESS, true);
+    settings.sync();
+
+    QVERIFY(QDir().mkpath(DATA_PATH));
+    removeData();
+
+    // A segment rotated but not compressed before the application stopped
+    QFile old(OLD_SEGMENT);
+    QVERIFY(old.open(QFile::WriteOnly));
+
+    for (int i = 0; i < OLD_ENTRIES; ++i) {
+        Lvk::Cmn::CsvRow row;
+        row.append(QDateTime(QDate(2000, 1, 1)).toString(STR_CHAT_CORPUS_DATE_TIME_FORMAT));
+        row.append("thread");
+        row.append("old user");
+        row.append(QString("old %1").arg(i));
+
+        old.write(row.toString().toUtf8() + "\n");
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void ChatCorpusTest::testBufferedAppend()
+{
+    Lvk::CA::ChatCorpus corpus;
+
+    QVERIFY(QFile::exists(CORPUS_FILE));
+
+    corpus.add("user", "0", "thread");
+
+    // Not written until the buffer is full or flushed
+    QCOMPARE(QFileInfo(CORPUS_FILE).size(), Q_INT64_C(0));
+
+    corpus.flush();
+
+    QVERIFY(QFileInfo(CORPUS_FILE).size() > 0);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void ChatCorpusTest::verifyEntries()
+{
+    Lvk::CA::ChatCorpus::Reader reader;
+    CorpusEntry entry;
+
+    for (int i = 0; i < OLD_ENTRIES; ++i) {
+        QVERIFY(reader.read(&entry));
+        QCOMPARE(entry.username, QString("old user"));
+        QCOMPARE(entry.message, QString("old %1").arg(i));
+    }
+
+    for (int i = 0; i < ENTRIES; ++i) {
+        QVERIFY2(reader.read(&entry), qPrintable(QString("Missing entry %1").arg(i)));
+        QCOMPARE(entry.username, QString("user %1").arg(i % 7));
+        QCOMPARE(entry.message, QString::number(i));
+        QCOMPARE(entry.thread, QString("thread"));
+        QVERIFY(entry.timestamp.isValid());
+    }
+
+    QVERIFY(!reader.read(&entry));
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void ChatCorpusTest::testRotateAndRead()
+{
+    Lvk::CA::ChatCorpus corpus;
+
+    // Entry "0" was added by testBufferedAppend
+    for (int i = 1; i < ENTRIES; ++i) {
+        corpus.add(QString("user %1").arg(i % 7), QString::number(i), "thread");
+    }
+
+    // Segments may still be being compressed while they are read
+    verifyEntries();
+
+    QVERIFY(QFileInfo(CORPUS_FILE).size() < MAX_FILE_SIZE);
+    QVERIFY(files("corpus.*.dat*").size() > 2);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void ChatCorpusTest::testReadCompressed()
+{
+    Lvk::CA::ChatCorpus().sync();
+
+    QVERIFY(files("corpus.*.dat").isEmpty());
+    QVERIFY(files("*.tmp").isEmpty());
+    QVERIFY(files("corpus.*.dat.z").size() > 2);
+    QVERIFY(files("corpus.*.dat.z").contains(QFileInfo(OLD_SEGMENT).fileName() + ".z"));
+
+    verifyEntries();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void ChatCorpusTest::cleanupTestCase()
+{
+    removeData();
+    QDir().rmdir(DATA_PATH);
+
+    Lvk::Cmn::Settings settings;
+    settings.remove(SETTING_DATA_PATH);
+    settings.remove(SETTING_CORPUS_BUFFER_SIZE);
+    settings.remove(SETTING_CORPUS_FLUSH_INTERVAL);
+    settings.remove(SETTING_CORPUS_MAX_SIZE);
+    settings.remove(SETTING_CORPUS_COMPRESS);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+QTEST_APPLESS_MAIN(ChatCorpusTest)
+
+#include "chatcorpustest.moc"
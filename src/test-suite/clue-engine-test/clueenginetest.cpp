@@ -5,8 +5,6 @@
 #include "common/settings.h"
 #include "common/settingskeys.h"
 #include "nlp-engine/rule.h"
-#include "nlp-engine/globaltools.h"
-#include "nlp-engine/lemmatizerfactory.h"
 #include "da-clue/clueengine.h"
 #include "da-clue/script.h"
 #include "da-clue/analyzedscript.h"
@@ -109,8 +107,6 @@ ClueEngineTest::ClueEngineTest()
 void ClueEngineTest::initTestCase()
 {
     Cmn::Settings().setValue(SETTING_APP_LANGUAGE, "es_AR");
-
-    Nlp::GlobalTools::instance()->setLemmatizer(Nlp::LemmatizerFactory().createLemmatizer());
 }
 
 //--------------------------------------------------------------------------------------------------
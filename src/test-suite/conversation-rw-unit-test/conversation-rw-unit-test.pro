@@ -21,8 +21,16 @@ HEADERS += \
     ../../chatbot/common/conversation.h \
     ../../chatbot/common/conversationreader.h \
     ../../chatbot/common/conversationwriter.h \
+    ../../chatbot/common/conversationrecord.h \
+    ../../chatbot/common/conversationindex.h \
     ../../chatbot/common/csvrow.h \
-    ../../chatbot/common/csvdocument.h
+    ../../chatbot/common/csvreader.h \
+    ../../chatbot/common/csvdocument.h \
+    ../../chatbot/common/settings.h \
+    ../../chatbot/common/tracer.h \
+    ../../chatbot/common/metrics.h \
+    ../../chatbot/common/fileutils.h \
+    ../../chatbot/chat-adapter/historyhelper.h
 
 
 SOURCES += \
@@ -30,8 +38,16 @@ SOURCES += \
     ../../chatbot/common/conversation.cpp \
     ../../chatbot/common/conversationreader.cpp \
     ../../chatbot/common/conversationwriter.cpp \
+    ../../chatbot/common/conversationrecord.cpp \
+    ../../chatbot/common/conversationindex.cpp \
     ../../chatbot/common/csvrow.cpp \
-    ../../chatbot/common/csvdocument.cpp
+    ../../chatbot/common/csvreader.cpp \
+    ../../chatbot/common/csvdocument.cpp \
+    ../../chatbot/common/settings.cpp \
+    ../../chatbot/common/tracer.cpp \
+    ../../chatbot/common/metrics.cpp \
+    ../../chatbot/common/fileutils.cpp \
+    ../../chatbot/chat-adapter/historyhelper.cpp
 
 
 DEFINES += SRCDIR=\\\"$$PWD/\\\"
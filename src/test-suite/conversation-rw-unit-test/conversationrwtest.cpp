@@ -2,12 +2,16 @@
 #include <QtTest/QtTest>
 
 #include <QFile>
+#include <QFileInfo>
 #include <QString>
 #include <QList>
 
 #include "common/conversation.h"
 #include "common/conversationreader.h"
 #include "common/conversationwriter.h"
+#include "common/conversationrecord.h"
+#include "common/conversationindex.h"
+#include "chat-adapter/historyhelper.h"
 
 typedef QList<Lvk::Cmn::Conversation::Entry> EntryList;
 
@@ -31,6 +35,20 @@ private Q_SLOTS:
     void testReadWriteConversation();
     void testReadWriteConversationEntry_data();
     void testReadWriteConversationEntry();
+    void testReadWriteBinary_data();
+    void testReadWriteBinary();
+    void testFormatSniffing();
+    void testIndexLookup();
+    void testBinaryTruncatedTail();
+    void testGroupCommit_data();
+    void testGroupCommit();
+    void testHistoryQueries();
+    void testHistoryRemove();
+    void testHistoryRemoveBinary();
+
+private:
+    Lvk::Cmn::Conversation::Entry makeEntry(const QDateTime &dateTime, const QString &from,
+                                            const QString &msg);
 };
 
 //--------------------------------------------------------------------------------------------------
@@ -41,6 +59,24 @@ ConversationRwTest::ConversationRwTest()
 
 //--------------------------------------------------------------------------------------------------
 
+Lvk::Cmn::Conversation::Entry ConversationRwTest::makeEntry(const QDateTime &dateTime,
+                                                            const QString &from,
+                                                            const QString &msg)
+{
+    Lvk::Cmn::Conversation::Entry entry;
+    entry.dateTime = dateTime;
+    entry.from     = from;
+    entry.to       = "chatbot";
+    entry.msg      = msg;
+    entry.response = "Response to " + msg;
+    entry.match    = true;
+    entry.ruleId   = 42;
+
+    return entry;
+}
+
+//--------------------------------------------------------------------------------------------------
+
 void ConversationRwTest::testReadWriteConversation_data()
 {
     QTest::addColumn<Lvk::Cmn::Conversation>("conv");
@@ -223,6 +259,494 @@ void ConversationRwTest::testReadWriteConversationEntry()
 
 //--------------------------------------------------------------------------------------------------
 
+void ConversationRwTest::testReadWriteBinary_data()
+{
+    QTest::addColumn<Lvk::Cmn::Conversation>("conv");
+    QTest::addColumn<bool>("ioDevCtor");    // Use QIODevice constructor
+
+    QDateTime now = QDateTime::currentDateTime();
+
+    Lvk::Cmn::Conversation conv1;
+    Lvk::Cmn::Conversation conv2;
+
+    conv2.append(makeEntry(now, "user A", "Hey there!"));
+    conv2.append(makeEntry(now, "user A", "Multi\nline,\"quoted\" message"));
+    conv2.append(makeEntry(now, QString::fromUtf8("usuario \xc3\xb1"), ""));
+
+    QTest::newRow("conv 1 - io") << conv1 << true;
+    QTest::newRow("conv 1 - fn") << conv1 << false;
+    QTest::newRow("conv 2 - io") << conv2 << true;
+    QTest::newRow("conv 2 - fn") << conv2 << false;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void ConversationRwTest::testReadWriteBinary()
+{
+    QFETCH(Lvk::Cmn::Conversation, conv);
+    QFETCH(bool, ioDevCtor);
+
+    const QString CONV_FILENAME = "chat_conv_test_bin.hist";
+
+    QFile::remove(CONV_FILENAME);
+    QFile::remove(Lvk::Cmn::ConversationIndex::indexFilename(CONV_FILENAME));
+
+    Lvk::Cmn::ConversationWriter *writer = 0;
+
+    if (ioDevCtor) {
+        writer = new Lvk::Cmn::ConversationWriter(new QFile(CONV_FILENAME),
+                                                  Lvk::Cmn::ConversationWriter::BinaryFormat);
+    } else {
+        writer = new Lvk::Cmn::ConversationWriter(CONV_FILENAME,
+                                                  Lvk::Cmn::ConversationWriter::BinaryFormat);
+    }
+
+    QVERIFY(writer->write(conv));
+
+    delete writer;
+
+    QFile file(CONV_FILENAME);
+    QVERIFY(file.open(QFile::ReadOnly));
+    QVERIFY(Lvk::Cmn::ConversationRecord::isBinary(&file));
+    file.close();
+
+    Lvk::Cmn::ConversationReader reader(CONV_FILENAME);
+    Lvk::Cmn::Conversation convRead;
+
+    QVERIFY(reader.read(&convRead));
+    QVERIFY(reader.atEnd());
+    QCOMPARE(conv, convRead);
+
+    QFile::remove(CONV_FILENAME);
+    QFile::remove(Lvk::Cmn::ConversationIndex::indexFilename(CONV_FILENAME));
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void ConversationRwTest::testFormatSniffing()
+{
+    const QString CONV_FILENAME = "chat_conv_test_sniff.hist";
+
+    QFile::remove(CONV_FILENAME);
+
+    QDateTime now = QDateTime::currentDateTime();
+    Lvk::Cmn::Conversation::Entry entry1 = makeEntry(now, "user A", "first");
+    Lvk::Cmn::Conversation::Entry entry2 = makeEntry(now, "user A", "second");
+
+    {
+        Lvk::Cmn::ConversationWriter writer(CONV_FILENAME, Lvk::Cmn::ConversationWriter::CsvFormat);
+        QVERIFY(writer.write(entry1));
+    }
+
+    // Existing CSV files must remain CSV files
+    {
+        Lvk::Cmn::ConversationWriter writer(CONV_FILENAME,
+                                            Lvk::Cmn::ConversationWriter::BinaryFormat);
+        QVERIFY(writer.write(entry2));
+        QCOMPARE(writer.format(), Lvk::Cmn::ConversationWriter::CsvFormat);
+    }
+
+    Lvk::Cmn::ConversationReader reader(CONV_FILENAME);
+    Lvk::Cmn::Conversation convRead;
+
+    QVERIFY(reader.read(&convRead));
+    QCOMPARE(convRead.entries().size(), 2);
+    QCOMPARE(convRead.entries()[0], entry1);
+    QCOMPARE(convRead.entries()[1], entry2);
+
+    QVERIFY(!QFile::exists(Lvk::Cmn::ConversationIndex::indexFilename(CONV_FILENAME)));
+
+    QFile::remove(CONV_FILENAME);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void ConversationRwTest::testIndexLookup()
+{
+    const QString CONV_FILENAME = "chat_conv_test_index.hist";
+    const QString IDX_FILENAME = Lvk::Cmn::ConversationIndex::indexFilename(CONV_FILENAME);
+
+    QFile::remove(CONV_FILENAME);
+    QFile::remove(IDX_FILENAME);
+
+    QDateTime day1(QDate(2012, 5, 1), QTime(10, 0));
+    QDateTime day2(QDate(2012, 5, 2), QTime(10, 0));
+
+    {
+        Lvk::Cmn::ConversationWriter writer(CONV_FILENAME,
+                                            Lvk::Cmn::ConversationWriter::BinaryFormat);
+        QVERIFY(writer.write(makeEntry(day1, "user A", "1")));
+        QVERIFY(writer.write(makeEntry(day1, "user B", "2")));
+        QVERIFY(writer.write(makeEntry(day2, "user A", "3")));
+        QVERIFY(writer.write(makeEntry(day1.addSecs(60), "user A", "4")));
+    }
+
+    Lvk::Cmn::ConversationIndex index(CONV_FILENAME);
+    QVERIFY(index.load());
+    QCOMPARE(index.size(), 4);
+
+    for (int pass = 0; pass < 2; ++pass) {
+        // Second pass without index, the reader must fall back to a full scan
+        if (pass == 1) {
+            QVERIFY(QFile::remove(IDX_FILENAME));
+        }
+
+        Lvk::Cmn::Conversation conv;
+
+        QVERIFY(Lvk::Cmn::ConversationReader(CONV_FILENAME).read(&conv, day1.date()));
+        QCOMPARE(conv.entries().size(), 3);
+
+        QVERIFY(Lvk::Cmn::ConversationReader(CONV_FILENAME).read(&conv, day1.date(), "user A"));
+        QCOMPARE(conv.entries().size(), 2);
+        QCOMPARE(conv.entries()[0].msg, QString("1"));
+        QCOMPARE(conv.entries()[1].msg, QString("4"));
+
+        QVERIFY(Lvk::Cmn::ConversationReader(CONV_FILENAME).read(&conv, day2.date(), "user B"));
+        QCOMPARE(conv.entries().size(), 0);
+    }
+
+    // Reopening the log for writing rebuilds the missing index
+    {
+        Lvk::Cmn::ConversationWriter writer(CONV_FILENAME,
+                                            Lvk::Cmn::ConversationWriter::BinaryFormat);
+        QVERIFY(writer.write(makeEntry(day2, "user B", "5")));
+    }
+
+    QVERIFY(index.load());
+    QCOMPARE(index.size(), 5);
+
+    QFile::remove(CONV_FILENAME);
+    QFile::remove(IDX_FILENAME);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void ConversationRwTest::testBinaryTruncatedTail()
+{
+    const QString CONV_FILENAME = "chat_conv_test_trunc.hist";
+    const QString IDX_FILENAME = Lvk::Cmn::ConversationIndex::indexFilename(CONV_FILENAME);
+
+    QFile::remove(CONV_FILENAME);
+    QFile::remove(IDX_FILENAME);
+
+    QDateTime now = QDateTime::currentDateTime();
+    Lvk::Cmn::Conversation::Entry entry1 = makeEntry(now, "user A", "complete");
+
+    {
+        Lvk::Cmn::ConversationWriter writer(CONV_FILENAME,
+                                            Lvk::Cmn::ConversationWriter::BinaryFormat);
+        QVERIFY(writer.write(entry1));
+        QVERIFY(writer.write(makeEntry(now, "user A", "partially written")));
+    }
+
+    // Simulate a crash in the middle of the last record
+    QFile file(CONV_FILENAME);
+    QVERIFY(file.resize(file.size() - 5));
+
+    Lvk::Cmn::ConversationIndex index(CONV_FILENAME);
+    QVERIFY(!index.load());
+
+    Lvk::Cmn::ConversationReader reader(CONV_FILENAME);
+    Lvk::Cmn::Conversation::Entry entryRead;
+
+    QVERIFY(reader.read(&entryRead));
+    QCOMPARE(entryRead, entry1);
+    QVERIFY(!reader.read(&entryRead));
+    QVERIFY(reader.atEnd());
+
+    // Writers cut the torn record before appending, so new records are not hidden behind it
+
+    Lvk::Cmn::Conversation::Entry entry2 = makeEntry(now, "user B", "after crash");
+
+    {
+        Lvk::Cmn::ConversationWriter writer(CONV_FILENAME,
+                                            Lvk::Cmn::ConversationWriter::BinaryFormat);
+        QVERIFY(writer.write(entry2));
+    }
+
+    Lvk::Cmn::ConversationReader reader2(CONV_FILENAME);
+
+    QVERIFY(reader2.read(&entryRead));
+    QCOMPARE(entryRead, entry1);
+    QVERIFY(reader2.read(&entryRead));
+    QCOMPARE(entryRead, entry2);
+    QVERIFY(!reader2.read(&entryRead));
+    QVERIFY(reader2.atEnd());
+
+    QVERIFY(index.load());
+    QCOMPARE(index.size(), 2);
+    QCOMPARE(index.find(now.date(), "user B").size(), 1);
+
+    QFile::remove(CONV_FILENAME);
+    QFile::remove(IDX_FILENAME);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void ConversationRwTest::testGroupCommit_data()
+{
+    QTest::addColumn<int>("format");
+
+    QTest::newRow("csv")    << static_cast<int>(Lvk::Cmn::ConversationWriter::CsvFormat);
+    QTest::newRow("binary") << static_cast<int>(Lvk::Cmn::ConversationWriter::BinaryFormat);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void ConversationRwTest::testGroupCommit()
+{
+    QFETCH(int, format);
+
+    const QString CONV_FILENAME = "chat_conv_test_group.hist";
+    const QString IDX_FILENAME = Lvk::Cmn::ConversationIndex::indexFilename(CONV_FILENAME);
+
+    QFile::remove(CONV_FILENAME);
+    QFile::remove(IDX_FILENAME);
+
+    QDateTime now = QDateTime::currentDateTime();
+    Lvk::Cmn::Conversation conv;
+    conv.append(makeEntry(now, "user A", "1"));
+    conv.append(makeEntry(now, "user B", "2"));
+    conv.append(makeEntry(now, "user A", "3"));
+
+    Lvk::Cmn::ConversationWriter *writer =
+            new Lvk::Cmn::ConversationWriter(CONV_FILENAME,
+                                             static_cast<Lvk::Cmn::ConversationWriter::Format>(format));
+
+    writer->setGroupCommit(1024*1024, 60*60*1000);
+    writer->setSyncPolicy(Lvk::Cmn::ConversationWriter::SyncOnCommit);
+
+    QVERIFY(writer->write(conv.entries()[0]));
+    qint64 committedSize = QFileInfo(CONV_FILENAME).size();
+
+    // Pending entries are not written until commit
+    QVERIFY(writer->write(conv.entries()[1]));
+    QVERIFY(writer->write(conv.entries()[2]));
+    QCOMPARE(QFileInfo(CONV_FILENAME).size(), committedSize);
+
+    QVERIFY(writer->commit());
+    QVERIFY(QFileInfo(CONV_FILENAME).size() > committedSize);
+
+    Lvk::Cmn::Conversation convRead;
+    QVERIFY(Lvk::Cmn::ConversationReader(CONV_FILENAME).read(&convRead));
+    QCOMPARE(convRead, conv);
+
+    // Pending entries are written on destruction
+    Lvk::Cmn::Conversation::Entry entry4 = makeEntry(now, "user B", "4");
+    conv.append(entry4);
+    QVERIFY(writer->write(entry4));
+
+    delete writer;
+
+    QVERIFY(Lvk::Cmn::ConversationReader(CONV_FILENAME).read(&convRead));
+    QCOMPARE(convRead, conv);
+
+    // Entries are written when the buffer is full
+    writer = new Lvk::Cmn::ConversationWriter(CONV_FILENAME);
+    writer->setGroupCommit(1, 60*60*1000);
+    committedSize = QFileInfo(CONV_FILENAME).size();
+    QVERIFY(writer->write(makeEntry(now, "user A", "5")));
+    QVERIFY(QFileInfo(CONV_FILENAME).size() > committedSize);
+    delete writer;
+
+    QFile::remove(CONV_FILENAME);
+    QFile::remove(IDX_FILENAME);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void ConversationRwTest::testHistoryQueries()
+{
+    const QString CONV_FILENAME = "chat_conv_test_history1.txt";
+    const QString IDX_FILENAME = Lvk::Cmn::ConversationIndex::indexFilename(CONV_FILENAME);
+
+    QFile::remove(CONV_FILENAME);
+    QFile::remove(IDX_FILENAME);
+
+    QDateTime day1(QDate(2012, 5, 1), QTime(10, 0));
+    QDateTime day2(QDate(2012, 5, 2), QTime(10, 0));
+
+    Lvk::Cmn::Conversation::Entry e1 = makeEntry(day1, "user A", "1");
+    Lvk::Cmn::Conversation::Entry e2 = makeEntry(day1.addSecs(60), "user B", "2");
+    Lvk::Cmn::Conversation::Entry e3 = makeEntry(day1.addSecs(120), "user A", "3");
+    Lvk::Cmn::Conversation::Entry e4 = makeEntry(day2, "user B", "4");
+    Lvk::Cmn::Conversation::Entry e5 = makeEntry(day2.addSecs(60), "user B", "5");
+
+    {
+        Lvk::CA::HistoryHelper history(CONV_FILENAME);
+        history.append(e1);
+        history.append(e2);
+        history.append(e3);
+        history.append(e4);
+        history.append(e5);
+
+        // Pending entries are visible to queries
+
+        Lvk::Cmn::Conversation conv = history.history(day1.date());
+        QCOMPARE(conv.size(), 3);
+
+        conv = history.history(day1.date(), "user A");
+        QCOMPARE(conv.size(), 2);
+        QCOMPARE(conv.entries()[0], e1);
+        QCOMPARE(conv.entries()[1], e3);
+
+        QCOMPARE(history.history(day2.date(), "user A").size(), 0);
+        QCOMPARE(history.history(QDate(2012, 5, 3)).size(), 0);
+
+        // Range and paging
+
+        conv = history.history(day1.addSecs(60), day2.addSecs(60));
+        QCOMPARE(conv.size(), 3);
+        QCOMPARE(conv.entries()[0], e2);
+        QCOMPARE(conv.entries()[2], e4);
+
+        conv = history.history(QDateTime(), QDateTime(), 1, 2);
+        QCOMPARE(conv.size(), 2);
+        QCOMPARE(conv.entries()[0], e2);
+        QCOMPARE(conv.entries()[1], e3);
+
+        conv = history.history(QDateTime(), QDateTime(), 4, 2);
+        QCOMPARE(conv.size(), 1);
+        QCOMPARE(conv.entries()[0], e5);
+
+        QCOMPARE(history.history(QDateTime(), QDateTime(), 5).size(), 0);
+        QCOMPARE(history.history(QDateTime(), QDateTime(), 0, 0).size(), 0);
+        QCOMPARE(history.history(day2, QDateTime()).size(), 2);
+
+        // Date and contact of each conversation, in order of first appearance
+
+        Lvk::Cmn::Conversation::DateContactList list = history.dateContacts();
+        QCOMPARE(list.size(), 3);
+        QCOMPARE(list[0], Lvk::Cmn::Conversation::DateContact(day1.date(), "user A"));
+        QCOMPARE(list[1], Lvk::Cmn::Conversation::DateContact(day1.date(), "user B"));
+        QCOMPARE(list[2], Lvk::Cmn::Conversation::DateContact(day2.date(), "user B"));
+    }
+
+    // Queries read the history file
+
+    Lvk::CA::HistoryHelper history(CONV_FILENAME);
+    QCOMPARE(history.history(day1.date(), "user B").size(), 1);
+    QCOMPARE(history.dateContacts().size(), 3);
+
+    history.clear();
+
+    QCOMPARE(history.history(day1.date()).size(), 0);
+    QCOMPARE(history.dateContacts().size(), 0);
+
+    QFile::remove(CONV_FILENAME);
+    QFile::remove(IDX_FILENAME);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void ConversationRwTest::testHistoryRemove()
+{
+    const QString CONV_FILENAME = "chat_conv_test_history2.txt";
+    const QString IDX_FILENAME = Lvk::Cmn::ConversationIndex::indexFilename(CONV_FILENAME);
+
+    QFile::remove(CONV_FILENAME);
+    QFile::remove(IDX_FILENAME);
+
+    QDateTime day1(QDate(2012, 5, 1), QTime(10, 0));
+    QDateTime day2(QDate(2012, 5, 2), QTime(10, 0));
+
+    Lvk::Cmn::Conversation::Entry e1 = makeEntry(day1, "user A", "1");
+    Lvk::Cmn::Conversation::Entry e2 = makeEntry(day1.addSecs(60), "user B", "2");
+    Lvk::Cmn::Conversation::Entry e3 = makeEntry(day1.addSecs(120), "user A", "3");
+    Lvk::Cmn::Conversation::Entry e4 = makeEntry(day2, "user A", "4");
+
+    Lvk::CA::HistoryHelper history(CONV_FILENAME);
+    history.append(e1);
+    history.append(e2);
+    history.append(e3);
+    history.append(e4);
+
+    history.remove(day1.date(), "user A");
+
+    QVERIFY(QFile::exists(CONV_FILENAME));
+    QVERIFY(!QFile::exists(CONV_FILENAME + ".tmp"));
+    QVERIFY(!QFile::exists(Lvk::Cmn::ConversationIndex::indexFilename(CONV_FILENAME + ".tmp")));
+
+    Lvk::Cmn::Conversation conv = history.history(QDateTime(), QDateTime());
+    QCOMPARE(conv.size(), 2);
+    QCOMPARE(conv.entries()[0], e2);
+    QCOMPARE(conv.entries()[1], e4);
+
+    QCOMPARE(history.history(day1.date(), "user A").size(), 0);
+    QCOMPARE(history.history(day2.date(), "user A").size(), 1);
+    QCOMPARE(history.dateContacts().size(), 2);
+
+    // Removing entries that do not exist keeps the file
+
+    history.remove(QDate(2012, 5, 3), "user A");
+    QCOMPARE(history.history(QDateTime(), QDateTime()).size(), 2);
+
+    // New entries are appended after the remaining ones
+
+    Lvk::Cmn::Conversation::Entry e5 = makeEntry(day2.addSecs(60), "user B", "5");
+    history.append(e5);
+
+    conv = history.history(QDateTime(), QDateTime());
+    QCOMPARE(conv.size(), 3);
+    QCOMPARE(conv.entries()[2], e5);
+    QCOMPARE(history.history(day2.date()).size(), 2);
+
+    history.clear();
+
+    QFile::remove(CONV_FILENAME);
+    QFile::remove(IDX_FILENAME);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void ConversationRwTest::testHistoryRemoveBinary()
+{
+    const QString CONV_FILENAME = "chat_conv_test_history3.dat";
+    const QString IDX_FILENAME = Lvk::Cmn::ConversationIndex::indexFilename(CONV_FILENAME);
+    const QString TMP_FILENAME = CONV_FILENAME + ".tmp";
+
+    QFile::remove(CONV_FILENAME);
+    QFile::remove(IDX_FILENAME);
+
+    QDateTime day1(QDate(2012, 5, 1), QTime(10, 0));
+    QDateTime day2(QDate(2012, 5, 2), QTime(10, 0));
+
+    Lvk::Cmn::Conversation::Entry e1 = makeEntry(day1, "user A", "1");
+    Lvk::Cmn::Conversation::Entry e2 = makeEntry(day1.addSecs(60), "user B", "2");
+    Lvk::Cmn::Conversation::Entry e3 = makeEntry(day2, "user A", "3");
+
+    {
+        Lvk::Cmn::ConversationWriter writer(CONV_FILENAME,
+                                            Lvk::Cmn::ConversationWriter::BinaryFormat);
+        QVERIFY(writer.write(e1));
+        QVERIFY(writer.write(e2));
+        QVERIFY(writer.write(e3));
+    }
+
+    {
+        Lvk::CA::HistoryHelper history(CONV_FILENAME);
+        history.remove(day1.date(), "user A");
+
+        QCOMPARE(history.history(day1.date()).size(), 1);
+        QCOMPARE(history.history(day2.date(), "user A").size(), 1);
+    }
+
+    // The index of the new file replaces the old one and no temporary file is left behind
+
+    QVERIFY(!QFile::exists(TMP_FILENAME));
+    QVERIFY(!QFile::exists(Lvk::Cmn::ConversationIndex::indexFilename(TMP_FILENAME)));
+
+    Lvk::Cmn::ConversationIndex index(CONV_FILENAME);
+    QVERIFY(index.load());
+    QCOMPARE(index.size(), 2);
+    QCOMPARE(index.find(day1.date()).size(), 1);
+
+    QFile::remove(CONV_FILENAME);
+    QFile::remove(IDX_FILENAME);
+}
+
+//--------------------------------------------------------------------------------------------------
+
 QTEST_APPLESS_MAIN(ConversationRwTest)
 
 #include "conversationrwtest.moc"
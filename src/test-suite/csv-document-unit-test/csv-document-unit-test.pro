@@ -22,12 +22,14 @@ INCLUDEPATH += \
 HEADERS += \
     ../../chatbot/common/csvrow.h \
     ../../chatbot/common/csvdocument.h \
+    ../../chatbot/common/csvreader.h \
 
 
 SOURCES += \
     csvdocumenttest.cpp\
     ../../chatbot/common/csvrow.cpp \
     ../../chatbot/common/csvdocument.cpp \
+    ../../chatbot/common/csvreader.cpp \
 
 
 DEFINES += SRCDIR=\\\"$$PWD/\\\"
@@ -3,6 +3,9 @@
 
 #include "common/csvrow.h"
 #include "common/csvdocument.h"
+#include "common/csvreader.h"
+
+#include <QBuffer>
 
 Q_DECLARE_METATYPE(Lvk::Cmn::CsvRow)
 Q_DECLARE_METATYPE(Lvk::Cmn::CsvDocument)
@@ -22,6 +25,9 @@ private Q_SLOTS:
 
     void testToFromStrings_data();
     void testToFromStrings();
+    void testCsvReader_data();
+    void testCsvReader();
+    void testCsvReaderMalformed();
 };
 
 //--------------------------------------------------------------------------------------------------
@@ -113,6 +119,65 @@ void CsvDocumentTest::testToFromStrings()
 
 //--------------------------------------------------------------------------------------------------
 
+void CsvDocumentTest::testCsvReader_data()
+{
+    testToFromStrings_data();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void CsvDocumentTest::testCsvReader()
+{
+    QFETCH(QString, csvString);
+    QFETCH(Lvk::Cmn::CsvDocument, expectedCsvDoc);
+
+    QByteArray data = csvString.toUtf8();
+    QBuffer buffer(&data);
+    QVERIFY(buffer.open(QIODevice::ReadOnly));
+
+    // Small chunks to split rows and quoted cells between reads
+    Lvk::Cmn::CsvReader reader(&buffer, 7);
+    Lvk::Cmn::CsvRow row;
+
+    foreach (const Lvk::Cmn::CsvRow &expectedRow, expectedCsvDoc.rows()) {
+        QVERIFY(!reader.atEnd());
+        QVERIFY(reader.readRow(row));
+        QCOMPARE(row, expectedRow);
+    }
+
+    QVERIFY(!reader.readRow(row));
+    QVERIFY(reader.atEnd());
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void CsvDocumentTest::testCsvReaderMalformed()
+{
+    QByteArray data = "a,b\r\n"
+                      "   \n"
+                      "\"quoted\" tail,\"unclosed,cell\n"
+                      "\"\",,\n";
+
+    QBuffer buffer(&data);
+    QVERIFY(buffer.open(QIODevice::ReadOnly));
+
+    Lvk::Cmn::CsvReader reader(&buffer);
+    Lvk::Cmn::CsvRow row;
+
+    QVERIFY(reader.readRow(row));
+    QCOMPARE(row, Lvk::Cmn::CsvRow(QStringList() << "a" << "b"));
+
+    QVERIFY(reader.readRow(row));
+    QCOMPARE(row, Lvk::Cmn::CsvRow(QStringList() << "quoted tail" << "unclosed,cell"));
+
+    QVERIFY(reader.readRow(row));
+    QCOMPARE(row, Lvk::Cmn::CsvRow(QStringList() << "" << "" << ""));
+
+    QVERIFY(!reader.readRow(row));
+}
+
+//--------------------------------------------------------------------------------------------------
+
 QTEST_APPLESS_MAIN(CsvDocumentTest)
 
 #include "csvdocumenttest.moc"
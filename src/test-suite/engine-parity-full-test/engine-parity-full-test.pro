@@ -0,0 +1,50 @@
+#-------------------------------------------------
+#
+# Runs the cb2-engine-full-test test cases with ShiftAndEngine and Cb2Engine
+# and verifies that both engines give the same results
+#
+#-------------------------------------------------
+
+QT       += testlib
+QT       -= gui
+TARGET = engineParityFullTest
+CONFIG   += console freeling
+CONFIG   -= app_bundle
+
+TEMPLATE = app
+
+DEFINES += ENGINE_PARITY_TEST
+
+INCLUDEPATH += \
+    ../../chatbot \
+    ../cb2-engine-full-test \
+    ../cb2-engine-unit-test
+
+DEFINES += SRCDIR=\\\"$$PWD/\\\"
+
+HEADERS += \
+    ../cb2-engine-full-test/ruledef.h \
+    ../cb2-engine-unit-test/parityengine.h
+
+SOURCES += \
+    ../cb2-engine-full-test/cb2enginefulltest.cpp
+
+PROJECT_PATH = ../../chatbot
+
+include($$PROJECT_PATH/nlp-engine/nlp-engine.pri)
+include($$PROJECT_PATH/common/common.pri)
+include($$PROJECT_PATH/3rd-party.pri)
+
+FL_DATA_PATH += \
+    ../../../third-party/Freeling/data/es/
+
+win32 {
+    warning(This test needs manual setup)
+    warning(Copy freeling data in the directory where the test is executed)
+    # TODO copy files automatically
+} else {
+    copyfiles.commands = mkdir -p ./data/freeling/; cp -Rf $$FL_DATA_PATH ./data/freeling/
+}
+
+QMAKE_EXTRA_TARGETS += copyfiles
+POST_TARGETDEPS += copyfiles
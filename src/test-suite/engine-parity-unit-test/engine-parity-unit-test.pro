@@ -0,0 +1,36 @@
+#-------------------------------------------------
+#
+# Runs the cb2-engine-unit-test test cases with ShiftAndEngine and Cb2Engine
+# and verifies that both engines give the same results
+#
+#-------------------------------------------------
+
+QT       += testlib
+
+QT       -= gui
+
+TARGET = engineParityUnitTest
+CONFIG   += console
+CONFIG   -= app_bundle
+
+TEMPLATE = app
+
+DEFINES += ENGINE_PARITY_TEST
+
+INCLUDEPATH += \
+    ../../chatbot \
+    ../cb2-engine-unit-test
+
+HEADERS += \
+    ../cb2-engine-unit-test/mocklemmatizer.h \
+    ../cb2-engine-unit-test/ruledef.h \
+    ../cb2-engine-unit-test/parityengine.h
+
+SOURCES += \
+    ../cb2-engine-unit-test/testcb2engine.cpp\
+    ../cb2-engine-unit-test/mocklemmatizer.cpp
+
+PROJECT_PATH = ../../chatbot
+
+include($$PROJECT_PATH/nlp-engine/nlp-engine.pri)
+include($$PROJECT_PATH/common/common.pri)
@@ -0,0 +1,23 @@
+QT       += testlib
+
+QT       -= gui
+
+TARGET = metricsUnitTest
+CONFIG   += console
+CONFIG   -= app_bundle
+
+TEMPLATE = app
+
+INCLUDEPATH += \
+    ../../chatbot \
+
+HEADERS += \
+    ../../chatbot/common/metrics.h \
+    ../../chatbot/common/fileutils.h \
+
+SOURCES += \
+    tst_metricsunittest.cpp \
+    ../../chatbot/common/metrics.cpp \
+    ../../chatbot/common/fileutils.cpp \
+
+DEFINES += SRCDIR=\\\"$$PWD/\\\"
@@ -0,0 +1,185 @@
+#include <QtCore/QString>
+#include <QtCore/QThread>
+#include <QtTest/QtTest>
+
+#include "common/metrics.h"
+
+using namespace Lvk::Cmn;
+
+#define THREAD_COUNT        4
+#define INCS_PER_THREAD     100000
+
+//--------------------------------------------------------------------------------------------------
+// Helpers
+//--------------------------------------------------------------------------------------------------
+
+class IncThread : public QThread
+{
+public:
+    IncThread(Counter *counter, Gauge *gauge) : m_counter(counter), m_gauge(gauge) { }
+
+protected:
+    void run()
+    {
+        for (int i = 0; i < INCS_PER_THREAD; ++i) {
+            m_counter->inc();
+            m_gauge->inc();
+            m_gauge->dec();
+        }
+    }
+
+private:
+    Counter *m_counter;
+    Gauge *m_gauge;
+};
+
+//--------------------------------------------------------------------------------------------------
+// MetricsUnitTest
+//--------------------------------------------------------------------------------------------------
+
+class MetricsUnitTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    MetricsUnitTest();
+
+private Q_SLOTS:
+    void testRegistry();
+    void testConcurrentUpdates();
+    void testHistogram();
+    void testPrometheusText();
+    void testWriteToFile();
+};
+
+//--------------------------------------------------------------------------------------------------
+
+MetricsUnitTest::MetricsUnitTest()
+{
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void MetricsUnitTest::testRegistry()
+{
+    Counter *c1 = Metrics::counter("test_registry_total", "Test counter");
+    Counter *c2 = Metrics::counter("test_registry_total", "Test counter");
+
+    QVERIFY(c1 != 0);
+    QVERIFY(c1 == c2);
+
+    c1->inc();
+    c2->inc(2);
+    QCOMPARE(c1->value(), Q_INT64_C(3));
+
+    Gauge *g = Metrics::gauge("test_registry_gauge", "Test gauge");
+    g->set(10);
+    g->add(-4);
+    QCOMPARE(g->value(), Q_INT64_C(6));
+
+    // Same name with another type must not alias the counter
+    Gauge *g2 = Metrics::gauge("test_registry_total", "Test gauge");
+    QVERIFY(static_cast<void *>(g2) != static_cast<void *>(c1));
+
+    // Nor allocate a new metric each time
+    QVERIFY(Metrics::gauge("test_registry_total", "Test gauge") == g2);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void MetricsUnitTest::testConcurrentUpdates()
+{
+    Counter *counter = Metrics::counter("test_concurrent_total", "Test counter");
+    Gauge *gauge = Metrics::gauge("test_concurrent_gauge", "Test gauge");
+
+    QList<IncThread *> threads;
+    for (int i = 0; i < THREAD_COUNT; ++i) {
+        threads.append(new IncThread(counter, gauge));
+    }
+    foreach (IncThread *t, threads) {
+        t->start();
+    }
+    foreach (IncThread *t, threads) {
+        t->wait();
+    }
+    qDeleteAll(threads);
+
+    QCOMPARE(counter->value(), qint64(THREAD_COUNT)*INCS_PER_THREAD);
+    QCOMPARE(gauge->value(), Q_INT64_C(0));
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void MetricsUnitTest::testHistogram()
+{
+    Histogram *h = Metrics::histogram("test_histogram_seconds", "Test histogram");
+
+    h->observe(50000);              // 50 us  -> first bucket
+    h->observe(100000);             // 100 us -> first bucket (bounds are inclusive)
+    h->observe(3000000);            // 3 ms   -> 5 ms bucket
+    h->observe(Q_INT64_C(60000000000));  // 60 s -> +Inf bucket
+
+    QCOMPARE(h->count(), Q_INT64_C(4));
+    QCOMPARE(h->sum(), Q_INT64_C(60003150000));
+    QCOMPARE(h->bucket(0), Q_INT64_C(2));
+    QCOMPARE(h->bucket(5), Q_INT64_C(1));
+    QCOMPARE(h->bucket(Histogram::BucketCount - 1), Q_INT64_C(1));
+    QCOMPARE(Histogram::upperBound(5), Q_INT64_C(5000000));
+    QCOMPARE(Histogram::upperBound(Histogram::BucketCount - 1), Q_INT64_C(-1));
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void MetricsUnitTest::testPrometheusText()
+{
+    Metrics::counter("test_text_total", "Help with \\ and\nnewline")->inc(7);
+    Metrics::histogram("test_text_seconds", "Test histogram")->observe(2000000);
+
+    QString text = Metrics::toPrometheusText();
+
+    QVERIFY(text.contains("# HELP test_text_total Help with \\\\ and\\nnewline\n"));
+    QVERIFY(text.contains("# TYPE test_text_total counter\ntest_text_total 7\n"));
+    QVERIFY(text.contains("# TYPE test_text_seconds histogram\n"));
+    QVERIFY(text.contains("test_text_seconds_bucket{le=\"0.001\"} 0\n"));
+    QVERIFY(text.contains("test_text_seconds_bucket{le=\"0.0025\"} 1\n"));
+    QVERIFY(text.contains("test_text_seconds_bucket{le=\"+Inf\"} 1\n"));
+    QVERIFY(text.contains("test_text_seconds_sum 0.002\n"));
+    QVERIFY(text.contains("test_text_seconds_count 1\n"));
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void MetricsUnitTest::testWriteToFile()
+{
+    const QString METRICS_FILENAME = "metrics_test.prom";
+
+    QFile::remove(METRICS_FILENAME);
+
+    Metrics::counter("test_file_total", "Test counter")->inc();
+    QVERIFY(Metrics::writeToFile(METRICS_FILENAME));
+
+    // Existing files are replaced
+
+    Metrics::counter("test_file_total", "Test counter")->inc();
+    QVERIFY(Metrics::writeToFile(METRICS_FILENAME));
+
+    QFile file(METRICS_FILENAME);
+    QVERIFY(file.open(QFile::ReadOnly));
+    QVERIFY(QString::fromUtf8(file.readAll()).contains("test_file_total 2\n"));
+    file.close();
+
+    QVERIFY(!QFile::exists(METRICS_FILENAME + ".tmp"));
+
+    // Failed writes do not leave the temporary file behind
+
+    QVERIFY(!Metrics::writeToFile("no-such-dir/metrics_test.prom"));
+    QVERIFY(!QFile::exists("no-such-dir/metrics_test.prom.tmp"));
+
+    QFile::remove(METRICS_FILENAME);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+QTEST_APPLESS_MAIN(MetricsUnitTest)
+
+#include "tst_metricsunittest.moc"
@@ -0,0 +1,42 @@
+#-------------------------------------------------
+#
+# Rule unit test
+#
+#-------------------------------------------------
+
+QT       += testlib gui
+
+TARGET = ruleUnitTest
+CONFIG   += console
+CONFIG   -= app_bundle
+
+TEMPLATE = app
+
+
+INCLUDEPATH += \
+    ../../chatbot \
+    ../../third-party
+
+HEADERS += \
+    ../../chatbot/back-end/rule.h \
+    ../../chatbot/back-end/target.h \
+    ../../chatbot/back-end/chatbotrulesfile.h \
+    ../../chatbot/back-end/compactrulesfile.h \
+    ../../chatbot/back-end/nlpsync.h \
+
+
+SOURCES += \
+    ruletest.cpp\
+    ../../chatbot/back-end/rule.cpp \
+    ../../chatbot/back-end/chatbotrulesfile.cpp \
+    ../../chatbot/back-end/compactrulesfile.cpp \
+    ../../chatbot/back-end/nlpsync.cpp \
+
+
+PROJECT_PATH = ../../chatbot
+
+include($$PROJECT_PATH/nlp-engine/nlp-engine.pri)
+include($$PROJECT_PATH/common/common.pri)
+
+DEFINES += SRCDIR=\\\"$$PWD/\\\"
+
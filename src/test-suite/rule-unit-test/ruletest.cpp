@@ -0,0 +1,556 @@
+#include <QtCore/QString>
+#include <QtTest/QtTest>
+
+#include "back-end/rule.h"
+#include "back-end/chatbotrulesfile.h"
+#include "back-end/nlpsync.h"
+#include "nlp-engine/cb2engine.h"
+
+#include <QFile>
+#include <QDataStream>
+
+#define RULES_FILENAME          "test_rules.crf"
+#define JOURNAL_FILENAME        "test_rules.crf.journal"
+#define CRF_MAGIC_NUMBER        (('c'<<0) | ('r'<<8) | ('f'<<16) | ('\0'<<24))
+
+using namespace Lvk;
+
+//--------------------------------------------------------------------------------------------------
+// Helpers
+//--------------------------------------------------------------------------------------------------
+
+inline BE::Rule *newRule(quint64 id, BE::Rule *parent)
+{
+    BE::Rule *rule = new BE::Rule(QString::number(id));
+    rule->setId(id);
+    parent->appendChild(rule);
+
+    return rule;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+inline BE::Rule *newRuleTree()
+{
+    BE::Rule *root = new BE::Rule();
+    BE::Rule *cat = newRule(1, root);
+    cat->setType(BE::Rule::ContainerRule);
+
+    BE::Rule *rule = new BE::Rule("", BE::Rule::OrdinaryRule,
+                                  QStringList() << "Hi" << "Hello",
+                                  QStringList() << "Hi there!" << QString::fromUtf8("\xc2\xa1Hola!"));
+    rule->setId(2);
+    rule->setNextCategory(1);
+    rule->setTarget(BE::TargetList() << BE::Target("john@chat.com", "John")
+                                     << BE::Target("jane@chat.com", ""));
+    cat->appendChild(rule);
+
+    BE::Rule *evasive = new BE::Rule("", BE::Rule::EvasiveRule, QStringList(),
+                                     QStringList() << "Hello" << "");
+    evasive->setId(3);
+    root->appendChild(evasive);
+
+    return root;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+inline void compareTrees(const BE::Rule *r1, const BE::Rule *r2)
+{
+    BE::Rule::const_iterator it1 = r1->begin();
+    BE::Rule::const_iterator it2 = r2->begin();
+
+    for (; it1 != r1->end() && it2 != r2->end(); ++it1, ++it2) {
+        QVERIFY(**it1 == **it2);
+        QCOMPARE((*it1)->childCount(), (*it2)->childCount());
+    }
+
+    QVERIFY(it1 == r1->end());
+    QVERIFY(it2 == r2->end());
+}
+
+//--------------------------------------------------------------------------------------------------
+
+inline QList<quint64> traversal(const BE::Rule *root)
+{
+    QList<quint64> ids;
+    for (BE::Rule::const_iterator it = root->begin(); it != root->end(); ++it) {
+        ids.append((*it)->id());
+    }
+    return ids;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+// Checks that syncing incrementally gives the same engine rules as syncing all rules at once
+inline void compareSync(BE::ChatbotRulesFile &file, Nlp::Engine *engine, BE::NlpSync &sync)
+{
+    QVERIFY(sync.sync(file, engine));
+    QVERIFY(!sync.sync(file, engine));
+
+    Nlp::Cb2Engine engine2;
+    BE::NlpSync sync2;
+    QVERIFY(sync2.sync(file, &engine2));
+
+    Nlp::RuleList rules = engine->rules();
+    Nlp::RuleList expected = engine2.rules();
+
+    QCOMPARE(rules.size(), expected.size());
+    for (int i = 0; i < rules.size(); ++i) {
+        QCOMPARE(rules[i].id(), expected[i].id());
+        QCOMPARE(rules[i].topic(), expected[i].topic());
+        QCOMPARE(rules[i].output(), expected[i].output());
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+// RuleTest
+//--------------------------------------------------------------------------------------------------
+
+class RuleTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    RuleTest();
+
+private Q_SLOTS:
+
+    void testIteratorAndRows();
+    void testFindById();
+    void testRevisions();
+    void testNlpSync();
+    void testNlpSyncReset();
+    void testRulesFileRoundTrip();
+    void testRulesFileOldFormat();
+    void testRulesFileCorrupted();
+    void testRulesFileJournal();
+    void testRulesFileJournalTornTail();
+    void cleanupTestCase();
+};
+
+//--------------------------------------------------------------------------------------------------
+
+RuleTest::RuleTest()
+{
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void RuleTest::testIteratorAndRows()
+{
+    BE::Rule root;
+    BE::Rule *cat1 = newRule(1, &root);
+    BE::Rule *cat2 = newRule(2, &root);
+    newRule(11, cat1);
+    newRule(12, cat1);
+    newRule(21, cat2);
+
+    QCOMPARE(traversal(&root), QList<quint64>() << 0 << 1 << 11 << 12 << 2 << 21);
+    QCOMPARE(cat2->row(), 1);
+    QCOMPARE(cat1->child(1)->row(), 1);
+
+    // Insert, remove and move keep rows consistent
+
+    QVERIFY(cat1->insertChildren(0, 2));
+    cat1->child(0)->setId(10);
+    cat1->child(1)->setId(13);
+    QCOMPARE(traversal(&root), QList<quint64>() << 0 << 1 << 10 << 13 << 11 << 12 << 2 << 21);
+
+    QVERIFY(cat1->removeChildren(1, 1));
+    QCOMPARE(traversal(&root), QList<quint64>() << 0 << 1 << 10 << 11 << 12 << 2 << 21);
+
+    QVERIFY(cat1->moveChildren(1, 1, cat2));
+    QCOMPARE(traversal(&root), QList<quint64>() << 0 << 1 << 10 << 12 << 2 << 21 << 11);
+
+    for (int i = 0; i < cat2->childCount(); ++i) {
+        QCOMPARE(cat2->child(i)->row(), i);
+    }
+
+    // Rows are recovered if the list was modified directly
+
+    cat2->children().swap(0, 1);
+    QCOMPARE(cat2->child(0)->row(), 0);
+    QCOMPARE(traversal(&root), QList<quint64>() << 0 << 1 << 10 << 12 << 2 << 11 << 21);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void RuleTest::testFindById()
+{
+    BE::Rule root;
+    BE::Rule *cat1 = newRule(1, &root);
+    BE::Rule *rule11 = newRule(11, cat1);
+
+    QVERIFY(root.findById(0) == 0);
+    QVERIFY(root.findById(1) == cat1);
+    QVERIFY(root.findById(11) == rule11);
+    QVERIFY(rule11->findById(1) == cat1);
+    QVERIFY(root.findById(99) == 0);
+
+    // Index is updated on append, setId, move and remove
+
+    BE::Rule *cat2 = newRule(2, &root);
+    BE::Rule *rule21 = newRule(21, cat2);
+    QVERIFY(root.findById(21) == rule21);
+
+    rule21->setId(22);
+    QVERIFY(root.findById(21) == 0);
+    QVERIFY(root.findById(22) == rule21);
+
+    QVERIFY(cat1->moveAllChildren(cat2));
+    QVERIFY(root.findById(11) == rule11);
+
+    QVERIFY(root.removeChildren(1, 1));
+    QVERIFY(root.findById(2) == 0);
+    QVERIFY(root.findById(11) == 0);
+    QVERIFY(root.findById(22) == 0);
+    QVERIFY(root.findById(1) == cat1);
+
+    // Subtrees with their own index
+
+    BE::Rule *other = new BE::Rule("other");
+    BE::Rule *rule31 = newRule(31, other);
+    QVERIFY(other->findById(31) == rule31);
+
+    root.appendChild(other);
+    QVERIFY(root.findById(31) == rule31);
+
+    const BE::Rule &croot = root;
+    QVERIFY(croot.findById(31) == rule31);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void RuleTest::testRevisions()
+{
+    QScopedPointer<BE::Rule> root(newRuleTree());
+    BE::Rule *cat = root->child(0);
+    BE::Rule *rule = cat->child(0);
+    BE::Rule *evasive = root->child(1);
+
+    quint64 rootRev = root->subtreeRevision();
+    quint64 catRev = cat->revision();
+    quint64 evasiveRev = evasive->revision();
+
+    QVERIFY(rule->revision() != 0);
+    QVERIFY(rule->revision() != evasiveRev);
+
+    // Reading does not change revisions
+    const BE::Rule *constRule = rule;
+    QCOMPARE(constRule->input().size(), 2);
+    QCOMPARE(root->subtreeRevision(), rootRev);
+
+    rule->setOutput(QStringList() << "Bye");
+    QCOMPARE(cat->subtreeRevision(), rule->revision());
+    QCOMPARE(root->subtreeRevision(), rule->revision());
+    QCOMPARE(cat->revision(), catRev);
+    QCOMPARE(evasive->revision(), evasiveRev);
+
+    rootRev = root->subtreeRevision();
+    QVERIFY(cat->removeChildren(0, 1));
+    QVERIFY(root->subtreeRevision() != rootRev);
+    QCOMPARE(cat->revision(), catRev);
+
+    rootRev = root->subtreeRevision();
+    QVERIFY(root->moveChildren(1, 1, cat));
+    QVERIFY(evasive->revision() != evasiveRev);
+    QVERIFY(root->subtreeRevision() != rootRev);
+    QCOMPARE(cat->revision(), catRev);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void RuleTest::testNlpSync()
+{
+    BE::ChatbotRulesFile file;
+    BE::Rule *root = file.rootRule();
+    BE::Rule *cat1 = newRule(1, root);
+    BE::Rule *cat2 = newRule(2, root);
+    cat1->setType(BE::Rule::ContainerRule);
+    cat2->setType(BE::Rule::ContainerRule);
+    newRule(11, cat1);
+    newRule(12, cat1);
+    newRule(21, cat2);
+    newRule(22, cat2);
+
+    Nlp::Cb2Engine engine;
+    BE::NlpSync sync;
+
+    compareSync(file, &engine, sync);
+    QCOMPARE(engine.rules().size(), 4);
+
+    // Add rules at the end and in the middle
+    newRule(13, cat1);
+    QVERIFY(cat2->insertChildren(0, 1));
+    cat2->child(0)->setId(20);
+    compareSync(file, &engine, sync);
+
+    // Change a rule
+    cat1->child(1)->setOutput(QStringList() << "Changed");
+    compareSync(file, &engine, sync);
+
+    // Move a rule to another category
+    QVERIFY(cat1->moveChildren(0, 1, cat2));
+    compareSync(file, &engine, sync);
+
+    // Move a whole category, its rules do not change but their order does
+    BE::Rule *cat3 = newRule(3, root);
+    cat3->setType(BE::Rule::ContainerRule);
+    newRule(31, cat3);
+    QVERIFY(root->moveChildren(0, 1, cat3));
+    compareSync(file, &engine, sync);
+
+    // Remove rules and a category
+    QVERIFY(cat2->removeChildren(1, 2));
+    compareSync(file, &engine, sync);
+    QVERIFY(root->removeChildren(0, 1));
+    compareSync(file, &engine, sync);
+    QCOMPARE(engine.rules().size(), 3);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void RuleTest::testNlpSyncReset()
+{
+    BE::ChatbotRulesFile file;
+    BE::Rule *cat = newRule(1, file.rootRule());
+    cat->setType(BE::Rule::ContainerRule);
+    newRule(11, cat);
+    newRule(12, cat);
+
+    Nlp::Cb2Engine engine;
+    BE::NlpSync sync;
+
+    QVERIFY(sync.sync(file, &engine));
+    QCOMPARE(engine.rules().size(), 2);
+
+    // After a reset all rules are replaced, even by an empty file
+    BE::ChatbotRulesFile emptyFile;
+
+    sync.reset();
+    QVERIFY(sync.sync(emptyFile, &engine));
+    QCOMPARE(engine.rules().size(), 0);
+    QVERIFY(!sync.sync(emptyFile, &engine));
+
+    sync.reset();
+    QVERIFY(sync.sync(file, &engine));
+    QCOMPARE(engine.rules().size(), 2);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void RuleTest::testRulesFileRoundTrip()
+{
+    QScopedPointer<BE::Rule> tree(newRuleTree());
+
+    {
+        BE::ChatbotRulesFile file;
+        tree->moveAllChildren(file.rootRule());
+        file.setMetadata("key", QVariant(QStringList() << "a" << "b"));
+        file.nextRuleId();
+        QVERIFY(file.saveAs(RULES_FILENAME));
+    }
+
+    BE::ChatbotRulesFile file;
+    QVERIFY(file.load(RULES_FILENAME));
+    QCOMPARE(file.metadata("key").toStringList(), QStringList() << "a" << "b");
+    QVERIFY(!file.hasUnsavedChanges());
+
+    QScopedPointer<BE::Rule> expected(newRuleTree());
+    compareTrees(file.rootRule(), expected.data());
+    QVERIFY(!file.hasUnsavedChanges());
+    QCOMPARE(file.nextRuleId(), quint64(2));
+
+    // Saving changes
+
+    file.rootRule()->child(0)->child(0)->setInput(QStringList() << "Bye");
+    QVERIFY(file.hasUnsavedChanges());
+    QVERIFY(file.save());
+
+    // Saving over the mapped file before rules are materialized
+
+    {
+        BE::ChatbotRulesFile file2;
+        QVERIFY(file2.load(RULES_FILENAME));
+        file2.setMetadata("key2", 1);
+        QVERIFY(file2.save());
+    }
+
+    BE::ChatbotRulesFile file3;
+    QVERIFY(file3.load(RULES_FILENAME));
+    QCOMPARE(file3.chatbotId(), file.chatbotId());
+    QCOMPARE(file3.metadata("key2").toInt(), 1);
+    QCOMPARE(file3.rootRule()->child(0)->child(0)->input(), QStringList() << "Bye");
+    QCOMPARE(file3.rootRule()->childCount(), 2);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void RuleTest::testRulesFileOldFormat()
+{
+    QScopedPointer<BE::Rule> tree(newRuleTree());
+    QHash<QString, QVariant> metadata;
+    metadata["key"] = QString("value");
+
+    {
+        QFile f(RULES_FILENAME);
+        QVERIFY(f.open(QFile::WriteOnly));
+        QDataStream ostream(&f);
+        ostream.setVersion(QDataStream::Qt_4_7);
+        ostream << (quint32)CRF_MAGIC_NUMBER << (quint32)2 << QString("some-id") << *tree
+                << metadata << quint64(10);
+    }
+
+    BE::ChatbotRulesFile file;
+    QVERIFY(file.load(RULES_FILENAME));
+    QCOMPARE(file.chatbotId(), QString("some-id"));
+    QCOMPARE(file.metadata("key").toString(), QString("value"));
+    QCOMPARE(file.nextRuleId(), quint64(10));
+    compareTrees(file.rootRule(), tree.data());
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void RuleTest::testRulesFileCorrupted()
+{
+    QScopedPointer<BE::Rule> tree(newRuleTree());
+
+    {
+        BE::ChatbotRulesFile file;
+        tree->moveAllChildren(file.rootRule());
+        QVERIFY(file.saveAs(RULES_FILENAME));
+    }
+
+    QFile f(RULES_FILENAME);
+    QVERIFY(f.open(QFile::ReadWrite));
+    QByteArray data = f.readAll();
+
+    // Truncated
+    QVERIFY(f.resize(data.size()/2));
+    f.close();
+
+    BE::ChatbotRulesFile file;
+    QVERIFY(!file.load(RULES_FILENAME));
+
+    // Rule count out of range
+    data[8 + 8] = 0x7f;
+    QVERIFY(f.open(QFile::WriteOnly));
+    f.write(data);
+    f.close();
+
+    QVERIFY(!file.load(RULES_FILENAME));
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void RuleTest::testRulesFileJournal()
+{
+    QScopedPointer<BE::Rule> tree(newRuleTree());
+
+    {
+        BE::ChatbotRulesFile file;
+        file.setJournalEnabled(true);
+        tree->moveAllChildren(file.rootRule());
+        QVERIFY(file.saveAs(RULES_FILENAME));
+        QVERIFY(!QFile::exists(JOURNAL_FILENAME));
+    }
+
+    BE::ChatbotRulesFile file;
+    file.setJournalEnabled(true);
+    QVERIFY(file.load(RULES_FILENAME));
+
+    BE::Rule *cat = file.rootRule()->child(0);
+    cat->child(0)->setInput(QStringList() << "Bye");
+    QVERIFY(file.save());
+    QVERIFY(QFile::exists(JOURNAL_FILENAME));
+
+    // Add, move and remove rules
+
+    newRule(10, cat)->setOutput(QStringList() << "New");
+    QVERIFY(file.rootRule()->moveChildren(1, 1, cat));
+    QVERIFY(cat->removeChildren(0, 1));
+    file.setMetadata("key", 5);
+    QVERIFY(file.save());
+
+    // Only the subtree of the edited rule is diffed
+
+    cat->child(1)->setOutput(QStringList() << "Edited");
+    QVERIFY(file.save());
+
+    // Nothing changed
+    qint64 journalSize = QFileInfo(JOURNAL_FILENAME).size();
+    QVERIFY(file.save());
+    QCOMPARE(QFileInfo(JOURNAL_FILENAME).size(), journalSize);
+
+    {
+        BE::ChatbotRulesFile file2;
+        QVERIFY(file2.load(RULES_FILENAME));
+        QCOMPARE(file2.metadata("key").toInt(), 5);
+        QCOMPARE(traversal(file2.rootRule()), QList<quint64>() << 0 << 1 << 10 << 3);
+        compareTrees(file2.rootRule(), file.rootRule());
+
+        // Full saves merge the journal into the file
+        file2.setMetadata("key", 6);
+        QVERIFY(file2.save());
+        QVERIFY(!QFile::exists(JOURNAL_FILENAME));
+    }
+
+    BE::ChatbotRulesFile file3;
+    QVERIFY(file3.load(RULES_FILENAME));
+    QCOMPARE(file3.metadata("key").toInt(), 6);
+    compareTrees(file3.rootRule(), file.rootRule());
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void RuleTest::testRulesFileJournalTornTail()
+{
+    QScopedPointer<BE::Rule> tree(newRuleTree());
+
+    {
+        BE::ChatbotRulesFile file;
+        file.setJournalEnabled(true);
+        tree->moveAllChildren(file.rootRule());
+        QVERIFY(file.saveAs(RULES_FILENAME));
+
+        file.rootRule()->child(1)->setOutput(QStringList() << "First");
+        QVERIFY(file.save());
+        file.rootRule()->child(1)->setOutput(QStringList() << "Second");
+        QVERIFY(file.save());
+    }
+
+    // Simulate a crash while appending the last change
+    QFile f(JOURNAL_FILENAME);
+    QVERIFY(f.open(QFile::ReadWrite));
+    QVERIFY(f.resize(f.size() - 3));
+    f.close();
+
+    BE::ChatbotRulesFile file;
+    file.setJournalEnabled(true);
+    QVERIFY(file.load(RULES_FILENAME));
+    QCOMPARE(file.rootRule()->child(1)->output(), QStringList() << "First");
+
+    // A damaged journal is not appended
+    file.rootRule()->child(1)->setOutput(QStringList() << "Third");
+    QVERIFY(file.save());
+    QVERIFY(!QFile::exists(JOURNAL_FILENAME));
+
+    BE::ChatbotRulesFile file2;
+    QVERIFY(file2.load(RULES_FILENAME));
+    QCOMPARE(file2.rootRule()->child(1)->output(), QStringList() << "Third");
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void RuleTest::cleanupTestCase()
+{
+    QFile::remove(RULES_FILENAME);
+    QFile::remove(JOURNAL_FILENAME);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+QTEST_APPLESS_MAIN(RuleTest)
+
+#include "ruletest.moc"
@@ -5,7 +5,8 @@ project_dir=..
 log_file=run.log
 
 unit_tests=`find -iname "*-unit-test" -type d | grep -v test-suite-shadow-build | cut -c 3- | tr "\n" " "`
-sys_tests="user-auth-test cb2-engine-full-test stats-manager-test clue-engine-test"
+sys_tests="user-auth-test cb2-engine-full-test shiftand-engine-full-test engine-parity-full-test stats-manager-test clue-engine-test"
+benchmarks="cb2-engine-bench"
 
 show_usage()
 {
@@ -13,6 +14,7 @@ show_usage()
   echo "   $0 -u        # Run unit tests"
   echo "   $0 -s        # Run system tests"
   echo "   $0 -a        # Run all tests"
+  echo "   $0 -b        # Run benchmarks"
   echo "   $0 test_name # Run only specified tests"
 }
 
@@ -22,6 +24,8 @@ elif [ "$1" == "-s" ]; then
   tests="$sys_tests"
 elif [ "$1" == "-a" ]; then
   tests="$unit_tests $sys_tests"
+elif [ "$1" == "-b" ]; then
+  tests="$benchmarks"
 elif [ "$1" == "" ]; then
   show_usage
   exit 1
@@ -47,7 +51,7 @@ qmake $project_dir "SUBDIRS=$tests"
 make
 
 for t in $tests; do
-  ( cd $t && find . -name "*Test" -executable -exec ./{} \; | tee -a ../$log_file )
+  ( cd $t && find . \( -name "*Test" -o -name "*Bench" \) -executable -exec ./{} \; | tee -a ../$log_file )
 done
 
 
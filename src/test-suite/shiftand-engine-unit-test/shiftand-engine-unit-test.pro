@@ -0,0 +1,34 @@
+#-------------------------------------------------
+#
+# Runs the cb2-engine-unit-test test cases with ShiftAndEngine
+#
+#-------------------------------------------------
+
+QT       += testlib
+
+QT       -= gui
+
+TARGET = shiftAndEngineUnitTest
+CONFIG   += console
+CONFIG   -= app_bundle
+
+TEMPLATE = app
+
+DEFINES += SHIFTAND_ENGINE_TEST
+
+INCLUDEPATH += \
+    ../../chatbot \
+    ../cb2-engine-unit-test
+
+HEADERS += \
+    ../cb2-engine-unit-test/mocklemmatizer.h \
+    ../cb2-engine-unit-test/ruledef.h
+
+SOURCES += \
+    ../cb2-engine-unit-test/testcb2engine.cpp\
+    ../cb2-engine-unit-test/mocklemmatizer.cpp
+
+PROJECT_PATH = ../../chatbot
+
+include($$PROJECT_PATH/nlp-engine/nlp-engine.pri)
+include($$PROJECT_PATH/common/common.pri)
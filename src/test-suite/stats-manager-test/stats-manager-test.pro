@@ -20,6 +20,8 @@ HEADERS += \
     ../../chatbot/common/settings.h \
     ../../chatbot/stats/statsmanager.h \
     ../../chatbot/stats/statshelper.h \
+    ../../chatbot/stats/hashset64.h \
+    ../../chatbot/common/hash.h \
     ../../chatbot/stats/historystatshelper.h \
     ../../chatbot/stats/rulestatshelper.h \
 
@@ -27,19 +29,23 @@ SOURCES += \
     ../../chatbot/stats/statsmanager.cpp \
     ../../chatbot/stats/securestatsfile.cpp \
     ../../chatbot/stats/historystatshelper.cpp \
+    ../../chatbot/stats/rulestatshelper.cpp \
     ../../chatbot/crypto/cipher.cpp \
     ../../chatbot/crypto/keymanagerfactory.cpp \
     ../../chatbot/common/settings.cpp \
     ../../chatbot/common/conversation.cpp \
     ../../chatbot/common/conversationreader.cpp \
+    ../../chatbot/common/conversationrecord.cpp \
+    ../../chatbot/common/conversationindex.cpp \
     ../../chatbot/common/logger.cpp \
+    ../../chatbot/common/logwriter.cpp \
     ../../chatbot/common/csvrow.cpp \
+    ../../chatbot/common/csvreader.cpp \
     ../../chatbot/common/csvdocument.cpp \
     ../../chatbot/common/random.cpp \
     ../../chatbot/nlp-engine/defaultsanitizer.cpp \
     ../../chatbot/nlp-engine/parser.cpp \
     ../../chatbot/nlp-engine/varstack.cpp \
-    ../../chatbot/nlp-engine/globaltools.cpp \
     ../../chatbot/back-end/rule.cpp \
     statsmanagertest.cpp
 
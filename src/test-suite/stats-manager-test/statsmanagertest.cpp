@@ -7,6 +7,9 @@
 #include "stats/statsmanager.h"
 #include "stats/metric.h"
 #include "stats/securestatsfile.h"
+#include "stats/historystatshelper.h"
+#include "stats/hashset64.h"
+#include "stats/rulestatshelper.h"
 #include "common/conversationreader.h"
 
 Q_DECLARE_METATYPE(Lvk::BE::Rule *)
@@ -162,6 +165,12 @@ private Q_SLOTS:
     void testScoreAlgorithm_data();
     void testScoreAlgorithm();
     void testBestScoreAndIntervals();
+    void testHistoryStatsPersistence();
+    void testHistoryStatsMerge();
+    void testStatsHelperWords_data();
+    void testStatsHelperWords();
+    void testHashSet64();
+    void testIncrementalRuleStats();
 };
 
 //--------------------------------------------------------------------------------------------------
@@ -619,6 +628,273 @@ void StatsManagerTest::testBestScoreAndIntervals()
 
 //--------------------------------------------------------------------------------------------------
 
+void StatsManagerTest::testHistoryStatsPersistence()
+{
+    Cmn::Conversation conv = readConversation(CONV_LONG_FILENAME);
+    QVERIFY(!conv.isEmpty());
+
+    // Serialization round trip
+
+    Stats::HistoryStatsHelper full(conv);
+    Stats::HistoryStatsHelper restored;
+
+    QVERIFY(restored.fromByteArray(full.toByteArray()));
+    QCOMPARE(restored.entries(), full.entries());
+    QCOMPARE(restored.chatbotLines(), full.chatbotLines());
+    QCOMPARE(restored.chatbotDiffLines(), full.chatbotDiffLines());
+    QCOMPARE(restored.chatbotDiffConvLines(), full.chatbotDiffConvLines());
+    QCOMPARE(restored.chatbotLexiconSize(), full.chatbotLexiconSize());
+    QCOMPARE(restored.scoreContacts(), full.scoreContacts());
+
+    QVERIFY(!restored.fromByteArray(QByteArray("garbage")));
+    QCOMPARE(restored.entries(), 0u);
+
+    // Persisted aggregates are used when the stats file is opened again
+
+    manager()->setFilename(STAT_FILENAME_1);
+    manager()->clear();
+
+    foreach (const Cmn::Conversation::Entry &e, conv.entries()) {
+        manager()->updateScoreWith(e);
+    }
+
+    Stats::Score score = manager()->currentScore();
+    QVERIFY(score == Stats::Score(0, CONV_LONG_CONT_SCORE, CONV_LONG_CONV_SCORE));
+
+    manager()->setFilename("");
+    manager()->setFilename(STAT_FILENAME_1);
+
+    QVERIFY(manager()->currentScore() == score);
+    QCOMPARE(manager()->m_histStats.entries(), static_cast<unsigned>(conv.size()));
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void StatsManagerTest::testHistoryStatsMerge()
+{
+    Cmn::Conversation conv1 = readConversation(CONV_LONG_FILENAME);
+    Cmn::Conversation conv2 = readConversation(CONV_INACT_FILENAME);
+    QVERIFY(!conv1.isEmpty());
+    QVERIFY(!conv2.isEmpty());
+
+    Cmn::Conversation both = conv1;
+    foreach (const Cmn::Conversation::Entry &e, conv2.entries()) {
+        both.append(e);
+    }
+
+    Stats::HistoryStatsHelper full(both);
+    Stats::HistoryStatsHelper merged(conv1);
+    merged.merge(Stats::HistoryStatsHelper(conv2));
+
+    QCOMPARE(merged.entries(), full.entries());
+    QCOMPARE(merged.chatbotLines(), full.chatbotLines());
+    QCOMPARE(merged.chatbotDiffLines(), full.chatbotDiffLines());
+    QCOMPARE(merged.chatbotLexiconSize(), full.chatbotLexiconSize());
+    QVERIFY(merged.scoreContacts().contains(full.scoreContacts()));
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void StatsManagerTest::testStatsHelperWords_data()
+{
+    QTest::addColumn<QString>("sentence");
+    QTest::addColumn<unsigned>("words");
+    QTest::addColumn<unsigned>("lexicon");
+
+    // Word counts must match QString::split(QRegExp("\\s+"))
+    QTest::newRow("empty")       << QString("") << 1u << 0u;
+    QTest::newRow("one")         << QString("hola") << 1u << 1u;
+    QTest::newRow("spaces")      << QString("  hola   que  tal ") << 5u << 3u;
+    QTest::newRow("tabs")        << QString("hola\tque\n\ntal") << 3u << 3u;
+    QTest::newRow("case")        << QString("Hola hola HOLA") << 3u << 1u;
+    QTest::newRow("punct")       << QString("hola, hola! hola?") << 3u << 1u;
+    QTest::newRow("only punct")  << QString("hola ! ?") << 3u << 1u;
+    QTest::newRow("dup chars")   << QString("holaaa hola") << 2u << 1u;
+    QTest::newRow("diacritic")   << QString::fromUtf8("qu\xc3\xa9 que") << 2u << 1u;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void StatsManagerTest::testStatsHelperWords()
+{
+    QFETCH(QString, sentence);
+    QFETCH(unsigned, words);
+    QFETCH(unsigned, lexicon);
+
+    Stats::StatsHelper stats(sentence);
+
+    QCOMPARE(stats.words(), words);
+    QCOMPARE(stats.words(), static_cast<unsigned>(sentence.split(QRegExp("\\s+")).size()));
+    QCOMPARE(stats.lexiconSize(), lexicon);
+    QCOMPARE(stats.lines(), 1u);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void StatsManagerTest::testHashSet64()
+{
+    Stats::HashSet64 set;
+
+    QVERIFY(set.isEmpty());
+    QVERIFY(!set.contains(0));
+
+    for (quint64 i = 0; i < 1000; ++i) {
+        QVERIFY(set.insert(i*Q_UINT64_C(0x9E3779B97F4A7C15)));
+    }
+    QVERIFY(!set.insert(0));
+    QVERIFY(!set.insert(Q_UINT64_C(0x9E3779B97F4A7C15)));
+    QCOMPARE(set.size(), 1000);
+
+    for (quint64 i = 0; i < 1000; ++i) {
+        QVERIFY(set.contains(i*Q_UINT64_C(0x9E3779B97F4A7C15)));
+    }
+    QVERIFY(!set.contains(1));
+
+    // Same streaming format as QSet<quint64>
+
+    QByteArray data;
+    {
+        QDataStream out(&data, QIODevice::WriteOnly);
+        out << set;
+    }
+
+    QSet<quint64> qset;
+    {
+        QDataStream in(data);
+        in >> qset;
+    }
+    QCOMPARE(qset.size(), 1000);
+    QVERIFY(qset.contains(0));
+
+    Stats::HashSet64 copy;
+    {
+        QDataStream in(data);
+        in >> copy;
+    }
+    QCOMPARE(copy.size(), set.size());
+
+    Stats::HashSet64 other;
+    other.insert(1);
+    other.insert(2);
+    copy.unite(other);
+    QCOMPARE(copy.size(), 1002);
+
+    copy.clear();
+    QVERIFY(copy.isEmpty());
+    QVERIFY(!copy.contains(1));
+}
+
+//--------------------------------------------------------------------------------------------------
+
+#define COMPARE_RULE_STATS(a, b) \
+    QCOMPARE((a).rulesCount(), (b).rulesCount()); \
+    QCOMPARE((a).points(), (b).points()); \
+    QCOMPARE((a).words(), (b).words()); \
+    QCOMPARE((a).lines(), (b).lines()); \
+    QCOMPARE((a).lexiconSize(), (b).lexiconSize()); \
+    QCOMPARE((a).regexRules(), (b).regexRules()); \
+    QCOMPARE((a).variableRules(), (b).variableRules()); \
+    QCOMPARE((a).conditionalRules(), (b).conditionalRules())
+
+void StatsManagerTest::testIncrementalRuleStats()
+{
+    BE::Rule *root = newRuleTree2();
+    BE::Rule *dup = newOrdinaryRule(QStringList() << "Hi *", QStringList() << "Hello", root);
+
+    Stats::RuleStatsHelper stats(root);
+
+    {
+        Stats::RuleStatsHelper full(root);
+        COMPARE_RULE_STATS(stats, full);
+        QCOMPARE(stats.points(), static_cast<unsigned>(ruleTree2Score()));
+    }
+
+    // Update a rule
+
+    root->child(1)->setInput(QStringList() << "Do you like [sth]?");
+    root->child(1)->setOutput(QStringList() << "{if [sth] == soccer}Yes{else}No");
+    stats.update(root);
+
+    {
+        Stats::RuleStatsHelper full(root);
+        COMPARE_RULE_STATS(stats, full);
+        QCOMPARE(stats.conditionalRules(), 2u);
+    }
+
+    // Remove a duplicated rule. The pair is still used by another rule
+
+    root->removeChildren(root->children().indexOf(dup), 1);
+    stats.removeRule(dup);
+
+    {
+        Stats::RuleStatsHelper full(root);
+        COMPARE_RULE_STATS(stats, full);
+        QCOMPARE(stats.regexRules(), 1u);
+    }
+
+    // Add a rule and remove another one
+
+    newOrdinaryRule(QStringList() << "Bye" << "Good bye", QStringList() << "See you", root);
+    root->removeChildren(0, 1);
+    stats.update(root);
+
+    {
+        Stats::RuleStatsHelper full(root);
+        COMPARE_RULE_STATS(stats, full);
+        QCOMPARE(stats.regexRules(), 0u);
+    }
+
+    // Incomplete rules are not counted
+
+    root->child(0)->setOutput(QStringList());
+    stats.updateRule(root->child(0));
+
+    {
+        Stats::RuleStatsHelper full(root);
+        COMPARE_RULE_STATS(stats, full);
+    }
+
+    // Rules in a removed category are removed, rules moved out of it are kept
+
+    BE::Rule *cat = new BE::Rule("", BE::Rule::ContainerRule);
+    root->appendChild(cat);
+    newOrdinaryRule(QStringList() << "Cats", QStringList() << "Meow", cat);
+    newOrdinaryRule(QStringList() << "Do you like [x]?", QStringList() << "I like [x]", cat);
+    stats.update(root);
+
+    {
+        Stats::RuleStatsHelper full(root);
+        COMPARE_RULE_STATS(stats, full);
+    }
+
+    QVERIFY(cat->moveChildren(1, 1, root));
+    root->removeChildren(root->children().indexOf(cat), 1);
+    stats.update(root);
+
+    {
+        Stats::RuleStatsHelper full(root);
+        COMPARE_RULE_STATS(stats, full);
+    }
+
+    // Unchanged trees give the same stats
+
+    stats.update(root);
+
+    {
+        Stats::RuleStatsHelper full(root);
+        COMPARE_RULE_STATS(stats, full);
+    }
+
+    delete root;
+
+    stats.update(0);
+    QCOMPARE(stats.rulesCount(), 0u);
+    QCOMPARE(stats.points(), 0u);
+    QCOMPARE(stats.lexiconSize(), 0u);
+}
+
+//--------------------------------------------------------------------------------------------------
+
 QTEST_APPLESS_MAIN(StatsManagerTest)
 
 #include "statsmanagertest.moc"
@@ -5,14 +5,21 @@ CONFIG += ordered
 unit_tests {
     SUBDIRS += \
         json-unit-test \
+        metrics-unit-test \
         default-sanitizer-unit-test \
         cb2-engine-unit-test \
+        shiftand-engine-unit-test \
+        engine-parity-unit-test \
         csv-document-unit-test \
         conversation-rw-unit-test \
+        chat-corpus-unit-test \
+        xmpp-chatbot-unit-test \
+        bot-host-unit-test \
         secure-stats-file-unit-test \
         cipher-unit-test \
         updater-unit-test \
-        script-manager-unit-test
+        script-manager-unit-test \
+        rule-unit-test
 }
 
 end_to_end_tests {
@@ -20,8 +27,15 @@ end_to_end_tests {
         stats-manager-test \
         user-auth-test \
         cb2-engine-full-test \
+        shiftand-engine-full-test \
+        engine-parity-full-test \
         clue-engine-test
 }
 
+benchmarks {
+    SUBDIRS += \
+        cb2-engine-bench
+}
+
 OTHER_FILES += run-test-suite.sh
 
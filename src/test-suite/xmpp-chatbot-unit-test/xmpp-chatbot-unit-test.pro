@@ -0,0 +1,35 @@
+#-------------------------------------------------
+#
+# XmppChatbot unit tests. Messages are injected without a chat server.
+#
+#-------------------------------------------------
+
+QT       += xml network testlib
+
+QT       -= gui
+
+TARGET = xmppChatbotUnitTest
+CONFIG   += console qxmpp
+CONFIG   -= app_bundle
+
+TEMPLATE = app
+
+INCLUDEPATH += ../../chatbot
+
+HEADERS += \
+    ../../chatbot/chat-adapter/chatbot.h \
+    ../../chatbot/chat-adapter/chatbotai.h \
+    ../../chatbot/chat-adapter/contactinfo.h \
+    ../../chatbot/chat-adapter/historyhelper.h \
+    ../../chatbot/chat-adapter/xmppchatbot.h
+
+SOURCES += \
+    xmppchatbottest.cpp \
+    ../../chatbot/chat-adapter/chatbot.cpp \
+    ../../chatbot/chat-adapter/historyhelper.cpp \
+    ../../chatbot/chat-adapter/xmppchatbot.cpp
+
+PROJECT_PATH = ../../chatbot
+
+include($$PROJECT_PATH/common/common.pri)
+include($$PROJECT_PATH/3rd-party.pri)
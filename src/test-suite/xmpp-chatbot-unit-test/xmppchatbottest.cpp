@@ -0,0 +1,245 @@
+#include <QtCore/QString>
+#include <QtTest/QtTest>
+#include <QtCore/QCoreApplication>
+#include <QThreadPool>
+#include <QAtomicInt>
+#include <QHash>
+#include <QTime>
+
+#include "chat-adapter/xmppchatbot.h"
+#include "chat-adapter/chatbotai.h"
+#include "chat-adapter/contactinfo.h"
+#include "common/metrics.h"
+
+#include "QXmppMessage.h"
+
+#define CONTACTS            4
+#define MESSAGES            100
+#define REPLY_TIMEOUT       10*1000
+#define SLOW_AI_DELAY       50
+
+using namespace Lvk;
+
+//--------------------------------------------------------------------------------------------------
+// Helpers
+//--------------------------------------------------------------------------------------------------
+
+namespace
+{
+
+// Echoes the input after a delay and counts its calls
+class MockAI : public CA::ChatbotAI
+{
+public:
+    MockAI(QAtomicInt *calls, int delay)
+        : m_calls(calls), m_delay(delay) { }
+
+    virtual Cmn::Conversation::Entry getEntry(const QString &input,
+                                              const CA::ContactInfo &contact)
+    {
+        m_calls->ref();
+
+        // Uneven delays so workers finish in a different order than they started
+        QTest::qSleep(m_delay + qHash(input) % 3);
+
+        return Cmn::Conversation::Entry(QDateTime::currentDateTime(), contact.username, "bot",
+                                        input, "Re: " + input, true);
+    }
+
+private:
+    QAtomicInt *m_calls;
+    int m_delay;
+};
+
+//--------------------------------------------------------------------------------------------------
+
+// Injects messages as if they were received from the chat server
+class TestChatbot : public CA::XmppChatbot
+{
+public:
+    TestChatbot() : CA::XmppChatbot("") { }
+
+    void receive(const QString &from, const QString &body)
+    {
+        QXmppMessage msg(from + "/res", "bot@example.com/res", body);
+        msg.setType(QXmppMessage::Chat);
+
+        onMessageReceived(msg);
+    }
+};
+
+//--------------------------------------------------------------------------------------------------
+
+inline QString contact(int i)
+{
+    return QString("user%1@example.com").arg(i % CONTACTS);
+}
+
+} // namespace
+
+
+//--------------------------------------------------------------------------------------------------
+// XmppChatbotTest
+//--------------------------------------------------------------------------------------------------
+
+class XmppChatbotTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    XmppChatbotTest();
+
+private Q_SLOTS:
+    void testRepliesInOrder();
+    void testShutdownWithQueuedMessages();
+    void testBusyChatbotUsesOneWorker();
+
+    void onEntry(const Cmn::Conversation::Entry &entry)
+    {
+        m_entries.append(entry);
+    }
+
+private:
+    QList<Cmn::Conversation::Entry> m_entries;
+    Cmn::Gauge *m_queued;
+};
+
+//--------------------------------------------------------------------------------------------------
+
+XmppChatbotTest::XmppChatbotTest()
+    : m_queued(Cmn::Metrics::gauge("chatbot_messages_queued", "Chat messages waiting for a worker"))
+{
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void XmppChatbotTest::testRepliesInOrder()
+{
+    m_entries.clear();
+
+    QAtomicInt calls;
+
+    TestChatbot chatbot;
+    chatbot.setAI(new MockAI(&calls, 0));
+
+    connect(&chatbot, SIGNAL(newConversationEntry(Cmn::Conversation::Entry)),
+            SLOT(onEntry(Cmn::Conversation::Entry)));
+
+    for (int i = 0; i < MESSAGES; ++i) {
+        chatbot.receive(contact(i), QString::number(i));
+    }
+
+    QTime timer;
+    timer.start();
+
+    while (m_entries.size() < MESSAGES && timer.elapsed() < REPLY_TIMEOUT) {
+        QTest::qWait(10);
+    }
+
+    QCOMPARE(m_entries.size(), MESSAGES);
+    QCOMPARE((int)calls, MESSAGES);
+    QCOMPARE(m_queued->value(), Q_INT64_C(0));
+
+    // Contacts take turns, but each one is answered in the order it wrote
+
+    QHash<QString, int> last;
+
+    foreach (const Cmn::Conversation::Entry &entry, m_entries) {
+        int i = entry.msg.toInt();
+
+        QCOMPARE(entry.from, contact(i));
+        QCOMPARE(entry.response, "Re: " + entry.msg);
+        QVERIFY2(i > last.value(entry.from, -1), qPrintable("Out of order: " + entry.msg));
+
+        last[entry.from] = i;
+    }
+
+    QCOMPARE(last.size(), CONTACTS);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void XmppChatbotTest::testShutdownWithQueuedMessages()
+{
+    m_entries.clear();
+
+    QAtomicInt calls;
+
+    TestChatbot *chatbot = new TestChatbot();
+    chatbot->setAI(new MockAI(&calls, SLOW_AI_DELAY));
+
+    connect(chatbot, SIGNAL(newConversationEntry(Cmn::Conversation::Entry)),
+            SLOT(onEntry(Cmn::Conversation::Entry)));
+
+    for (int i = 0; i < MESSAGES; ++i) {
+        chatbot->receive(contact(i), QString::number(i));
+    }
+
+    QVERIFY(m_queued->value() > 0);
+
+    // Pending messages are dropped, the running tasks are waited for
+    delete chatbot;
+
+    int callsAtShutdown = calls;
+
+    QVERIFY(callsAtShutdown < MESSAGES);
+    QCOMPARE(m_queued->value(), Q_INT64_C(0));
+
+    // No task uses the chatbot or its AI after it is destroyed
+
+    QThreadPool::globalInstance()->waitForDone();
+    QTest::qWait(100);
+
+    QCOMPARE((int)calls, callsAtShutdown);
+    QVERIFY(m_entries.isEmpty());
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void XmppChatbotTest::testBusyChatbotUsesOneWorker()
+{
+    m_entries.clear();
+
+    QAtomicInt slowCalls;
+    QAtomicInt fastCalls;
+
+    TestChatbot *slow = new TestChatbot();
+    slow->setAI(new MockAI(&slowCalls, SLOW_AI_DELAY));
+
+    for (int i = 0; i < MESSAGES; ++i) {
+        slow->receive(contact(i), QString::number(i));
+    }
+
+    QTest::qWait(SLOW_AI_DELAY);
+
+    QCOMPARE(QThreadPool::globalInstance()->activeThreadCount(), 1);
+
+    // Another chatbot is answered while the busy one still has messages queued
+
+    TestChatbot fast;
+    fast.setAI(new MockAI(&fastCalls, 0));
+
+    connect(&fast, SIGNAL(newConversationEntry(Cmn::Conversation::Entry)),
+            SLOT(onEntry(Cmn::Conversation::Entry)));
+
+    fast.receive(contact(0), "hello");
+
+    QTime timer;
+    timer.start();
+
+    while (m_entries.isEmpty() && timer.elapsed() < REPLY_TIMEOUT) {
+        QTest::qWait(10);
+    }
+
+    QCOMPARE(m_entries.size(), 1);
+    QCOMPARE(m_entries.first().response, QString("Re: hello"));
+    QVERIFY((int)slowCalls < MESSAGES);
+
+    delete slow;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+QTEST_MAIN(XmppChatbotTest)
+
+#include "xmppchatbottest.moc"